@@ -0,0 +1,109 @@
+#ifndef ARPEGGIATOR_H
+#define ARPEGGIATOR_H
+
+#include <stdint.h>
+
+// --- PER-TRACK ARPEGGIATOR ---
+// A trig on an arp track opens the arp for the step's note length instead of
+// playing one note. While open, the arp is clocked once per MIDI tick and emits a
+// hit every `rate` ticks, walking a note set: the notes held on MIDI input, or a
+// chord built on the step's note. Hits go through the same legato / gate logic as
+// step notes (see SimpleSequencer::renderArp()).
+//
+// tick() is constant time whatever the set size or mode: the walk position maps
+// straight to a note index and octave, so no sorting, searching or allocation
+// happens on the clock path. Sets are kept sorted as notes arrive (ArpNotes::add),
+// which only happens on MIDI input or when a trig builds its chord.
+
+enum ArpMode : uint8_t {
+  ARP_OFF = 0,
+  ARP_UP,
+  ARP_DOWN,
+  ARP_RANDOM,
+  ARP_ORDER,    // order the notes were played in
+  ARP_NUM_MODES
+};
+
+enum ArpSource : uint8_t {
+  ARP_SRC_CHORD = 0, // chord on the step's note
+  ARP_SRC_HELD,      // notes held on MIDI input (DIN or USB, any channel)
+  ARP_NUM_SOURCES
+};
+
+enum ArpChord : uint8_t {
+  ARP_CHORD_MAJ = 0,
+  ARP_CHORD_MIN,
+  ARP_CHORD_SUS4,
+  ARP_CHORD_MAJ7,
+  ARP_CHORD_MIN7,
+  ARP_CHORD_DOM7,
+  ARP_CHORD_DIM,
+  ARP_CHORD_OCT,     // the step's note only; the octave range does the rest
+  ARP_NUM_CHORDS
+};
+
+static const uint8_t ARP_CHORD_NOTES = 4;
+// Semitones above the step's note, 0xFF = unused
+static const uint8_t ARP_CHORD_INTERVALS[ARP_NUM_CHORDS][ARP_CHORD_NOTES] = {
+  { 0, 4, 7, 0xFF },
+  { 0, 3, 7, 0xFF },
+  { 0, 5, 7, 0xFF },
+  { 0, 4, 7, 11 },
+  { 0, 3, 7, 10 },
+  { 0, 4, 7, 10 },
+  { 0, 3, 6, 0xFF },
+  { 0, 0xFF, 0xFF, 0xFF },
+};
+
+// Hit spacing in ticks (24 PPQN): 1/48 .. 1/4. Two ticks is the floor so a step
+// renders at most three hits per track (see RENDER_STEP_MAX_EVENTS).
+static const uint8_t ARP_RATE_TICKS[] = { 2, 3, 4, 6, 8, 12, 16, 24 };
+static const uint8_t ARP_NUM_RATES = sizeof(ARP_RATE_TICKS) / sizeof(ARP_RATE_TICKS[0]);
+static const uint8_t ARP_MAX_OCTAVES = 4;
+static const uint8_t ARP_MAX_NOTES = 16;
+
+struct ArpParams {
+  uint8_t mode;     // ArpMode
+  uint8_t source;   // ArpSource
+  uint8_t octaves;  // 1 .. ARP_MAX_OCTAVES
+  uint8_t rateIdx;  // ARP_RATE_TICKS
+  uint8_t chord;    // ArpChord
+};
+
+static const ArpParams ARP_DEFAULT_PARAMS = {ARP_OFF, ARP_SRC_CHORD, 1, 3, ARP_CHORD_MAJ};
+
+// Note set in two orders: ascending pitch (UP / DOWN / RANDOM) and arrival (ORDER)
+class ArpNotes {
+  public:
+    void clear() { count = 0; }
+    bool add(uint8_t note, uint8_t vel);   // false if full or already held
+    void remove(uint8_t note);
+
+    uint8_t count = 0;
+    uint8_t sorted[ARP_MAX_NOTES];
+    uint8_t sortedVel[ARP_MAX_NOTES];
+    uint8_t order[ARP_MAX_NOTES];
+    uint8_t orderVel[ARP_MAX_NOTES];
+};
+
+struct ArpHit {
+  uint8_t note;
+  uint8_t vel;
+};
+
+// Walk state of one track. The settings belong to the pattern (see Pattern.h) and
+// are passed to tick(), so a pattern switch never restarts a running walk.
+class Arpeggiator {
+  public:
+    // First hit on the next tick, walk from the start
+    void restart();
+    // One MIDI tick. True when a hit falls on it.
+    bool tick(const ArpParams& params, const ArpNotes& set, ArpHit& hit);
+
+  private:
+    uint8_t countdown = 0;  // ticks until the next hit
+    uint8_t pos = 0;        // walk position, 0 .. count * octaves - 1
+    uint32_t rnd = 1;       // xorshift state for ARP_RANDOM
+};
+
+#endif
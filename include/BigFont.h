@@ -0,0 +1,154 @@
+#ifndef BIGFONT_H
+#define BIGFONT_H
+
+#include <stdint.h>
+#include "MemPlacement.h"
+
+// --- BIG OLED TEXT ---
+// The full-screen value views print at text size 2-4. Adafruit_GFX scales its 5x7
+// font at run time with one fillRect per font pixel (up to 16 drawPixel calls
+// each). Here the characters those views use are scaled at compile time instead:
+// each glyph column at size S is one 32-bit word, bit r = row r of the 8*S-row cell.
+// bigFontBlit() shifts a column word to the text's row offset and ORs it into the
+// SH1106 page buffer (bit y & 7 of byte x + (y / 8) * width), one byte per page, so
+// a size-4 character is 20 column words instead of up to 35 fillRects of 16 pixels.
+//
+// Output is pixel-identical to GFX print() with a transparent background: same
+// glyphs, 6*S advance, left and top edges at the cursor. Characters outside
+// BIG_FONT_CHARS are left for GFX (see SimpleSequencer::drawBig()).
+
+static const uint8_t BIG_FONT_MIN_SIZE = 2;
+static const uint8_t BIG_FONT_MAX_SIZE = 4;     // 8 * 4 rows fit one column word
+static const uint8_t BIG_FONT_GLYPH_COLS = 5;   // font columns; the sixth is spacing
+
+static const char BIG_FONT_CHARS[] = " !#%+-/0123456789:ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const uint8_t BIG_FONT_GLYPHS = sizeof(BIG_FONT_CHARS) - 1;
+
+// The same characters from the Adafruit_GFX classic 5x7 font, column bytes, bit 0 on top
+static constexpr uint8_t BIG_FONT_5X7[BIG_FONT_GLYPHS][BIG_FONT_GLYPH_COLS] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+  {0x00, 0x00, 0x5F, 0x00, 0x00}, // '!'
+  {0x14, 0x7F, 0x14, 0x7F, 0x14}, // '#'
+  {0x23, 0x13, 0x08, 0x64, 0x62}, // '%'
+  {0x08, 0x08, 0x3E, 0x08, 0x08}, // '+'
+  {0x08, 0x08, 0x08, 0x08, 0x08}, // '-'
+  {0x20, 0x10, 0x08, 0x04, 0x02}, // '/'
+  {0x3E, 0x51, 0x49, 0x45, 0x3E}, // '0'
+  {0x00, 0x42, 0x7F, 0x40, 0x00}, // '1'
+  {0x72, 0x49, 0x49, 0x49, 0x46}, // '2'
+  {0x21, 0x41, 0x49, 0x4D, 0x33}, // '3'
+  {0x18, 0x14, 0x12, 0x7F, 0x10}, // '4'
+  {0x27, 0x45, 0x45, 0x45, 0x39}, // '5'
+  {0x3C, 0x4A, 0x49, 0x49, 0x31}, // '6'
+  {0x41, 0x21, 0x11, 0x09, 0x07}, // '7'
+  {0x36, 0x49, 0x49, 0x49, 0x36}, // '8'
+  {0x46, 0x49, 0x49, 0x29, 0x1E}, // '9'
+  {0x00, 0x00, 0x14, 0x00, 0x00}, // ':'
+  {0x7C, 0x12, 0x11, 0x12, 0x7C}, // 'A'
+  {0x7F, 0x49, 0x49, 0x49, 0x36}, // 'B'
+  {0x3E, 0x41, 0x41, 0x41, 0x22}, // 'C'
+  {0x7F, 0x41, 0x41, 0x41, 0x3E}, // 'D'
+  {0x7F, 0x49, 0x49, 0x49, 0x41}, // 'E'
+  {0x7F, 0x09, 0x09, 0x09, 0x01}, // 'F'
+  {0x3E, 0x41, 0x41, 0x51, 0x73}, // 'G'
+  {0x7F, 0x08, 0x08, 0x08, 0x7F}, // 'H'
+  {0x00, 0x41, 0x7F, 0x41, 0x00}, // 'I'
+  {0x20, 0x40, 0x41, 0x3F, 0x01}, // 'J'
+  {0x7F, 0x08, 0x14, 0x22, 0x41}, // 'K'
+  {0x7F, 0x40, 0x40, 0x40, 0x40}, // 'L'
+  {0x7F, 0x02, 0x1C, 0x02, 0x7F}, // 'M'
+  {0x7F, 0x04, 0x08, 0x10, 0x7F}, // 'N'
+  {0x3E, 0x41, 0x41, 0x41, 0x3E}, // 'O'
+  {0x7F, 0x09, 0x09, 0x09, 0x06}, // 'P'
+  {0x3E, 0x41, 0x51, 0x21, 0x5E}, // 'Q'
+  {0x7F, 0x09, 0x19, 0x29, 0x46}, // 'R'
+  {0x26, 0x49, 0x49, 0x49, 0x32}, // 'S'
+  {0x03, 0x01, 0x7F, 0x01, 0x03}, // 'T'
+  {0x3F, 0x40, 0x40, 0x40, 0x3F}, // 'U'
+  {0x1F, 0x20, 0x40, 0x20, 0x1F}, // 'V'
+  {0x3F, 0x40, 0x38, 0x40, 0x3F}, // 'W'
+  {0x63, 0x14, 0x08, 0x14, 0x63}, // 'X'
+  {0x03, 0x04, 0x78, 0x04, 0x03}, // 'Y'
+  {0x61, 0x59, 0x49, 0x4D, 0x43}, // 'Z'
+};
+
+// ASCII -> glyph index, -1 = not cached
+struct BigFontMap {
+  int8_t index[128];
+};
+
+constexpr BigFontMap makeBigFontMap() {
+  BigFontMap m{};
+  for (uint8_t c = 0; c < 128; c++) m.index[c] = -1;
+  for (uint8_t g = 0; g < BIG_FONT_GLYPHS; g++) m.index[(uint8_t)BIG_FONT_CHARS[g]] = (int8_t)g;
+  return m;
+}
+
+static constexpr BigFontMap BIG_FONT_MAP = makeBigFontMap();
+
+template <uint8_t S>
+struct BigFontTable {
+  uint32_t col[BIG_FONT_GLYPHS][BIG_FONT_GLYPH_COLS * S];
+};
+
+// Every font pixel becomes an S x S block: column c of the scaled glyph is font
+// column c / S with each of its bits repeated S times
+template <uint8_t S>
+constexpr BigFontTable<S> makeBigFontTable() {
+  BigFontTable<S> t{};
+  for (uint8_t g = 0; g < BIG_FONT_GLYPHS; g++) {
+    for (uint8_t c = 0; c < BIG_FONT_GLYPH_COLS * S; c++) {
+      uint8_t src = BIG_FONT_5X7[g][c / S];
+      uint32_t w = 0;
+      for (uint8_t r = 0; r < 8; r++) {
+        if (src & (1 << r)) w |= ((1UL << S) - 1) << (r * S);
+      }
+      t.col[g][c] = w;
+    }
+  }
+  return t;
+}
+
+// 7.7 KB together: flash, not DTCM (see MemPlacement.h)
+static constexpr BigFontTable<2> BIG_FONT_2 PROGMEM = makeBigFontTable<2>();
+static constexpr BigFontTable<3> BIG_FONT_3 PROGMEM = makeBigFontTable<3>();
+static constexpr BigFontTable<4> BIG_FONT_4 PROGMEM = makeBigFontTable<4>();
+
+static_assert(BIG_FONT_4.col[7][0] == 0x00FFFFF0UL, "'0' left column: font rows 1-5 at size 4");
+
+static inline bool bigFontHas(char c) {
+  return (uint8_t)c < 128 && BIG_FONT_MAP.index[(uint8_t)c] >= 0;
+}
+
+// Column words of glyph `g` at `size` (BIG_FONT_MIN_SIZE .. BIG_FONT_MAX_SIZE)
+static inline const uint32_t* bigFontColumns(uint8_t g, uint8_t size) {
+  if (size == 2) return BIG_FONT_2.col[g];
+  if (size == 3) return BIG_FONT_3.col[g];
+  return BIG_FONT_4.col[g];
+}
+
+// OR one cached character into a page-major 1-bit buffer (width x height pixels),
+// clipped to it. Returns false, drawing nothing, if `c` is not cached.
+static inline bool bigFontBlit(uint8_t* buf, int16_t width, int16_t height,
+                               int16_t x, int16_t y, char c, uint8_t size) {
+  if (!bigFontHas(c) || size < BIG_FONT_MIN_SIZE || size > BIG_FONT_MAX_SIZE) return false;
+  const uint32_t* col = bigFontColumns(BIG_FONT_MAP.index[(uint8_t)c], size);
+  int16_t cols = BIG_FONT_GLYPH_COLS * size;
+  // the shifted column spans `pages` pages from `page`; pages off the buffer are skipped
+  int16_t page = y >> 3;
+  uint8_t shift = y & 7;
+  uint8_t pages = (8 * size + shift + 7) >> 3;
+  for (int16_t i = 0; i < cols; i++) {
+    int16_t px = x + i;
+    if (px < 0 || px >= width) continue;
+    uint64_t w = (uint64_t)col[i] << shift;
+    for (uint8_t k = 0; k < pages; k++) {
+      int16_t p = page + k;
+      uint8_t bits = (uint8_t)(w >> (8 * k));
+      if (bits && p >= 0 && p < (height >> 3)) buf[px + p * width] |= bits;
+    }
+  }
+  return true;
+}
+
+#endif
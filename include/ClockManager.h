@@ -0,0 +1,112 @@
+#ifndef CLOCKMANAGER_H
+#define CLOCKMANAGER_H
+
+#include <stdint.h>
+
+// --- CLOCK SOURCES ---
+// 24 PPQN clock can come from DIN (Serial8 RX), USB device MIDI or the internal
+// timer. Sources are ranked by a priority preset; the highest-ranked source that is
+// locked drives the engine, the internal timer is always the last resort.
+//
+// Every external source keeps its own tick window, so its tempo is known before it
+// is needed. When the active source misses a tick (nothing within an eighth of a
+// period of when it was due) the manager fails over at once: the missed tick is
+// played immediately and the next source continues on the grid of the last estimate
+// (lastTick + n * period), so no step is lost and the tempo stays phase-continuous.
+// A tick from the new source that lands within half a period of the previous
+// engine tick is taken as the same tick and swallowed, so a switch never doubles
+// a tick either.
+//
+// Start plays tick 0 at once. The first clock after it is that same tick 0 (a master
+// sends it right behind the Start byte, as this one does), so it is not counted again.
+
+enum ClockSourceId : uint8_t { CLOCK_SRC_DIN = 0, CLOCK_SRC_USB, CLOCK_SRC_INTERNAL, CLOCK_NUM_SOURCES };
+
+struct ClockPriority {
+  const char* name;
+  uint8_t rank[CLOCK_NUM_SOURCES]; // 0 = highest; CLOCK_RANK_OFF = ignored
+};
+
+static const uint8_t CLOCK_RANK_OFF = 255;
+static const ClockPriority CLOCK_PRIORITIES[] = {
+  { "DIN>USB>INT", { 0, 1, 2 } },
+  { "USB>DIN>INT", { 1, 0, 2 } },
+  { "DIN>INT",     { 0, CLOCK_RANK_OFF, 2 } },
+  { "USB>INT",     { CLOCK_RANK_OFF, 0, 2 } },
+  { "INT only",    { CLOCK_RANK_OFF, CLOCK_RANK_OFF, 2 } },
+};
+static const uint8_t CLOCK_NUM_PRIORITIES = sizeof(CLOCK_PRIORITIES) / sizeof(CLOCK_PRIORITIES[0]);
+
+static const uint8_t CLOCK_WINDOW = 49;             // 49 timestamps = 48 gaps (2 beats)
+static const uint8_t CLOCK_LOCK_TICKS = 3;          // steady ticks before a source may take over
+static const uint32_t CLOCK_MAX_PERIOD_US = 125000; // 20 BPM; longer gaps break the lock
+static const uint32_t CLOCK_MIN_GRACE_US = 2000;    // DIN/USB are polled at 1 ms
+
+class ClockManager {
+  public:
+    enum Event : uint8_t { CLK_NONE = 0, CLK_TICK, CLK_START, CLK_CONTINUE, CLK_STOP, CLK_SEEK };
+
+    void begin(uint8_t priority);
+    void setPriority(uint8_t p);
+    uint8_t priority() const { return prio; }
+    uint8_t active() const { return activeSrc; }
+    bool external() const { return activeSrc != CLOCK_SRC_INTERNAL; }
+    // An external source is in charge and still ticking
+    bool running(uint32_t nowMicros) const { return external() && alive(activeSrc, nowMicros); }
+
+    // Realtime byte (0xF8..0xFF) from an external source; returns what the engine
+    // should do with it. Bytes from lower-ranked sources only update their window.
+    Event onRealtime(uint8_t src, uint8_t b, uint32_t nowMicros);
+    // Song Position Pointer (0xF2): CLK_SEEK when the source may move the transport
+    Event onSongPosition(uint8_t src, uint32_t nowMicros);
+    // Internal timer tick (or a tick started locally)
+    void onInternalTick(uint32_t nowMicros) { lastEngineTickUs = nowMicros; }
+    // Checks the active external source for a missed tick. Returns true when it was
+    // dropped: the caller plays the missed tick now and, if active() is now
+    // internal, restarts its timer at nextTickDueUs().
+    bool poll(uint32_t nowMicros);
+
+    // Tick period of the active source (0 until it has a window; internal: 0)
+    uint32_t periodUs() const;
+    // Whole window measured (a stable tempo for the BPM display)
+    bool settled() const;
+    // Grid time of the tick after the last failover fill tick
+    uint32_t nextTickDueUs() const { return gridUs + fillPeriodUs; }
+    uint32_t fillPeriod() const { return fillPeriodUs; }
+    bool locked(uint8_t src) const { return src < CLOCK_SRC_INTERNAL && srcs[src].valid >= CLOCK_LOCK_TICKS; }
+
+    // Failover measurements, printed by the 'k' command
+    uint32_t failovers = 0;
+    uint32_t swallowed = 0;       // ticks dropped as duplicates right after a switch
+    uint32_t lastGapUs = 0;       // last real tick of the dropped source -> fill tick
+    uint32_t lastPhaseErrUs = 0;  // fill tick vs. the grid of the last estimate
+    uint32_t maxPhaseErrUs = 0;
+    uint8_t lastLost = CLOCK_SRC_INTERNAL;
+
+  private:
+    struct Source {
+      uint32_t stamps[CLOCK_WINDOW];
+      uint8_t index = 0;
+      uint8_t valid = 0;      // consecutive ticks no further apart than CLOCK_MAX_PERIOD_US
+      uint32_t lastUs = 0;
+    };
+    Source srcs[CLOCK_SRC_INTERNAL];
+    uint8_t prio = 0;
+    uint8_t activeSrc = CLOCK_SRC_INTERNAL;
+    volatile uint32_t lastEngineTickUs = 0;
+    uint32_t activeSinceUs = 0;
+    bool switchGuard = false;
+    bool startTick = false;   // the next clock of the active source is tick 0
+    uint32_t gridUs = 0;
+    uint32_t fillPeriodUs = 0;
+
+    uint8_t rank(uint8_t src) const { return CLOCK_PRIORITIES[prio].rank[src]; }
+    uint32_t sourcePeriod(const Source& s) const;
+    bool alive(uint8_t src, uint32_t nowMicros) const;
+    static uint32_t grace(uint32_t period) { return period / 8 > CLOCK_MIN_GRACE_US ? period / 8 : CLOCK_MIN_GRACE_US; }
+    void record(Source& s, uint32_t nowMicros);
+    void takeOver(uint8_t src, uint32_t nowMicros);
+    bool controlsTransport(uint8_t src, uint32_t nowMicros);
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+// CRC-16/CCITT (poly 0x1021, init 0xFFFF). Shared by the save records and the
+// USB serial link, and by the host tools, so it only needs <stdint.h>.
+static inline uint16_t crc16Update(uint16_t crc, uint8_t b) {
+  crc ^= (uint16_t)b << 8;
+  for (uint8_t i = 0; i < 8; i++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  return crc;
+}
+
+static inline uint16_t crc16(const uint8_t* data, uint16_t len, uint16_t crc = 0xFFFF) {
+  for (uint16_t i = 0; i < len; i++) crc = crc16Update(crc, data[i]);
+  return crc;
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef CYCLESTAT_H
+#define CYCLESTAT_H
+
+#include <stdint.h>
+
+// --- CYCLE PROFILING ---
+// Running count / total / max of CPU cycles for one code path, fed from the
+// DWT cycle counter (ARM_DWT_CYCCNT on the Teensy 4). Printed by the 'f' command.
+
+struct CycleStat {
+  volatile uint32_t count = 0;
+  volatile uint32_t total = 0;   // wraps after ~7 s of continuous load at 600 MHz; reset() between reads
+  volatile uint32_t max = 0;
+
+  void add(uint32_t cycles) {
+    count++;
+    total += cycles;
+    if (cycles > max) max = cycles;
+  }
+  uint32_t avg() const { return count ? total / count : 0; }
+  void reset() { count = 0; total = 0; max = 0; }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef EUCLIDTABLES_H
+#define EUCLIDTABLES_H
+
+#include <stdint.h>
+
+// --- EUCLIDEAN RHYTHM TABLES ---
+// Every (pulses, length) pair up to EUCLID_MAX_STEPS is generated at compile time
+// as a packed bitmask (bit i = step i). Changing pulses or offset at runtime is a
+// table read plus one bit-rotate.
+
+static const uint8_t EUCLID_MAX_STEPS = 64;
+
+enum EuclidMode : uint8_t {
+  EUCLID_BRESENHAM = 0, // original line-drawing distribution (first hit late)
+  EUCLID_BJORKLUND,     // Bjorklund / Toussaint distribution (first hit on step 1)
+  EUCLID_NUM_MODES
+};
+
+// Entries for lengths 1..n, pulses 0..length
+constexpr uint16_t euclidIndex(uint8_t pulses, uint8_t length) {
+  return (uint16_t)(length * (length + 1) / 2 - 1 + pulses);
+}
+static const uint16_t EUCLID_TABLE_SIZE = euclidIndex(EUCLID_MAX_STEPS, EUCLID_MAX_STEPS) + 1;
+
+constexpr uint64_t euclidMask(uint8_t length) {
+  return length >= 64 ? ~0ULL : ((1ULL << length) - 1);
+}
+
+// Bresenham: step j is a hit when floor((j+1)k/n) > floor(jk/n)
+constexpr uint64_t euclidBresenham(uint8_t k, uint8_t n) {
+  uint64_t p = 0;
+  for (uint8_t j = 0; j < n; j++) {
+    if (((j + 1) * k) / n > (j * k) / n) p |= 1ULL << j;
+  }
+  return p;
+}
+
+// Bjorklund: repeatedly pair the "1" groups with the "0" groups until at most one
+// remainder group is left. All groups of a kind are identical, so only one
+// pattern + count is tracked per kind.
+constexpr uint64_t euclidBjorklund(uint8_t k, uint8_t n) {
+  if (k == 0) return 0;
+  if (k >= n) return euclidMask(n);
+  uint64_t a = 1, b = 0;        // group patterns
+  uint8_t aLen = 1, bLen = 1;   // group lengths
+  uint8_t aCnt = k, bCnt = n - k;
+  while (bCnt > 1 && aCnt > 0) {
+    uint8_t m = aCnt < bCnt ? aCnt : bCnt;
+    uint64_t joined = a | (b << aLen);
+    uint8_t joinedLen = aLen + bLen;
+    if (aCnt > bCnt) { b = a; bLen = aLen; bCnt = aCnt - m; }
+    else { bCnt = bCnt - m; }
+    a = joined; aLen = joinedLen; aCnt = m;
+  }
+  uint64_t p = 0;
+  uint8_t pos = 0;
+  for (uint8_t i = 0; i < aCnt; i++) { p |= a << pos; pos += aLen; }
+  for (uint8_t i = 0; i < bCnt; i++) { p |= b << pos; pos += bLen; }
+  return p;
+}
+
+struct EuclidTable {
+  uint64_t bits[EUCLID_TABLE_SIZE];
+};
+
+constexpr EuclidTable makeEuclidTable(EuclidMode mode) {
+  EuclidTable t{};
+  for (uint8_t n = 1; n <= EUCLID_MAX_STEPS; n++) {
+    for (uint8_t k = 0; k <= n; k++) {
+      t.bits[euclidIndex(k, n)] = (mode == EUCLID_BJORKLUND) ? euclidBjorklund(k, n) : euclidBresenham(k, n);
+    }
+  }
+  return t;
+}
+
+// Compile-time checks against known rhythms (Toussaint, "The Euclidean Algorithm
+// Generates Traditional Musical Rhythms"), LSB = first step
+static_assert(euclidBjorklund(3, 8) == 0b01001001, "E(3,8) tresillo");
+static_assert(euclidBjorklund(5, 8) == 0b01101101, "E(5,8) cinquillo");
+static_assert(euclidBjorklund(2, 5) == 0b00101, "E(2,5)");
+static_assert(euclidBjorklund(4, 12) == 0b001001001001, "E(4,12)");
+static_assert(euclidBjorklund(7, 16) == 0x54A9, "E(7,16) samba");
+static_assert(euclidBresenham(4, 16) == 0x8888, "matches legacy updateEuclid()");
+
+// Flash-resident tables (defined in EuclidTables.cpp)
+extern const EuclidTable euclidTables[EUCLID_NUM_MODES];
+
+inline uint64_t euclidLookup(uint8_t mode, uint8_t pulses, uint8_t length) {
+  if (length == 0) return 0;
+  if (length > EUCLID_MAX_STEPS) length = EUCLID_MAX_STEPS;
+  if (pulses > length) pulses = length;
+  return euclidTables[mode < EUCLID_NUM_MODES ? mode : 0].bits[euclidIndex(pulses, length)];
+}
+
+// Rotate towards later steps by `offset` within a `length`-step ring
+inline uint64_t euclidRotate(uint64_t p, uint8_t offset, uint8_t length) {
+  if (length == 0) return 0;
+  offset %= length;
+  if (offset == 0) return p;
+  return ((p << offset) | (p >> (length - offset))) & euclidMask(length);
+}
+
+#endif
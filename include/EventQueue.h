@@ -0,0 +1,83 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <Arduino.h>
+
+// --- PRE-RENDERED EVENT QUEUE ---
+// loop() renders upcoming steps into timestamped MIDI events; the clock and
+// engine ISRs only pop the head while it is due. Events are kept sorted by
+// (tick, delayUs) and equal times keep their insertion order, so a note-off
+// rendered before a note-on at the same instant still goes out first.
+//
+// Producer side (push, cancel, clear) runs with interrupts disabled; the ISR
+// pops from `head` in O(1). Space freed at the front is reclaimed by the
+// producer when it runs out of room at the back.
+
+enum SeqEventType : uint8_t {
+  EV_NOTE_ON = 0,
+  EV_NOTE_OFF,
+  EV_CC,
+  EV_ENV_TRIG,  // retrigger the track's modulation envelope
+  EV_RATCHET_ON // note-on of a ratchet repeat (sent like EV_NOTE_ON, traced apart)
+};
+
+struct SeqEvent {
+  uint32_t tick;     // clock tick the event belongs to
+  uint32_t delayUs;  // extra delay after that tick (latency compensation remainder)
+  uint8_t type;      // SeqEventType
+  uint8_t ch;
+  uint8_t d1;        // note / CC number
+  uint8_t d2;        // velocity / CC value
+};
+
+static const uint16_t EVENT_QUEUE_CAPACITY = 256;
+
+class EventQueue {
+  public:
+    void clear() { head = tail = 0; }
+    uint16_t size() const { return tail - head; }
+    uint16_t space() const { return EVENT_QUEUE_CAPACITY - size(); }
+    bool empty() const { return head == tail; }
+    const SeqEvent& front() const { return events[head]; }
+    void pop() { if (head < tail) head++; }
+
+    bool push(const SeqEvent& e) {
+      if (tail >= EVENT_QUEUE_CAPACITY) compact();
+      if (tail >= EVENT_QUEUE_CAPACITY) return false;
+      // Scan from the back: events are rendered roughly in time order
+      uint16_t i = tail;
+      while (i > head && later(events[i - 1], e)) i--;
+      memmove(&events[i + 1], &events[i], (tail - i) * sizeof(SeqEvent));
+      events[i] = e;
+      tail++;
+      return true;
+    }
+
+    // Drop pending events of one type on a channel that fall after `after`
+    // (e.g. a note-off superseded by a legato / retriggered note)
+    void cancelAfter(uint8_t ch, uint8_t type, const SeqEvent& after) {
+      uint16_t w = head;
+      for (uint16_t r = head; r < tail; r++) {
+        if (events[r].ch == ch && events[r].type == type && later(events[r], after)) continue;
+        events[w++] = events[r];
+      }
+      tail = w;
+    }
+
+  private:
+    SeqEvent events[EVENT_QUEUE_CAPACITY];
+    volatile uint16_t head = 0;
+    uint16_t tail = 0;
+
+    static bool later(const SeqEvent& a, const SeqEvent& b) {
+      return a.tick > b.tick || (a.tick == b.tick && a.delayUs > b.delayUs);
+    }
+    void compact() {
+      if (head == 0) return;
+      memmove(&events[0], &events[head], (tail - head) * sizeof(SeqEvent));
+      tail -= head;
+      head = 0;
+    }
+};
+
+#endif
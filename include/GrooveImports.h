@@ -0,0 +1,10 @@
+#ifndef GROOVEIMPORTS_H
+#define GROOVEIMPORTS_H
+
+// Generated by tools/groove2h.cpp, do not edit:
+//   groove2h -o include/GrooveImports.h
+// Appended to grooveTables[] after the built-in swings (see GrooveTables.h).
+
+#define GROOVE_IMPORTS
+
+#endif
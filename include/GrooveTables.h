@@ -0,0 +1,54 @@
+#ifndef GROOVETABLES_H
+#define GROOVETABLES_H
+
+#include <stdint.h>
+
+// --- GROOVE TEMPLATES ---
+// A groove moves each step of a track by a fraction of a step and scales its
+// velocity, like MPC / DAW groove templates. Templates come from two places, both
+// compiled into one table in flash: swing presets built here at compile time, and
+// grooves extracted from reference MIDI files by tools/groove2h.cpp into
+// GrooveImports.h. A track picks a template and an amount. When a step is
+// rendered, template position step % length is a table read, plus one multiply
+// for the offset and one for the velocity (see SimpleSequencer::renderChannel()).
+// The offset moves every event of the step (CC locks, note, ratchets, gate) as a
+// microsecond delay on its tick, so it is not limited to the 24 PPQN grid.
+
+static const uint8_t GROOVE_MAX_STEPS = 16;
+static const uint8_t GROOVE_MAX_TEMPLATES = 32;     // saved as a 5-bit index
+static const uint8_t GROOVE_BUILTINS = 6;           // OFF + swings, before the imports
+static const uint8_t GROOVE_NAME_LEN = 10;          // including the terminator
+static const int16_t GROOVE_UNITS_PER_STEP = 192;   // offset unit: 0.65 ms at 120 BPM
+
+struct GrooveTemplate {
+  char name[GROOVE_NAME_LEN];
+  uint8_t length;                      // steps before it repeats, 1..GROOVE_MAX_STEPS
+  int8_t offset[GROOVE_MAX_STEPS];     // 1/GROOVE_UNITS_PER_STEP of a step, + = late
+  uint8_t velocity[GROOVE_MAX_STEPS];  // percent of the step's velocity
+};
+
+// Straight template: no offsets, velocities unchanged
+constexpr GrooveTemplate makeGroove(const char* name, uint8_t length) {
+  GrooveTemplate g{};
+  for (uint8_t i = 0; i < GROOVE_NAME_LEN - 1 && name[i]; i++) g.name[i] = name[i];
+  g.length = length;
+  for (uint8_t i = 0; i < GROOVE_MAX_STEPS; i++) g.velocity[i] = 100;
+  return g;
+}
+
+// MPC-style swing: the second 16th of each 8th lands at `percent` of the 8th
+// (50 = straight, 66 = triplet feel, 75 = dotted)
+constexpr GrooveTemplate makeSwing(const char* name, uint8_t percent) {
+  GrooveTemplate g = makeGroove(name, 2);
+  g.offset[1] = (int8_t)((percent - 50) * 2 * GROOVE_UNITS_PER_STEP / 100);
+  return g;
+}
+
+static_assert(makeSwing("", 66).offset[1] == 61, "66% swing: second 16th 0.32 step late");
+static_assert(makeSwing("", 75).offset[1] == GROOVE_UNITS_PER_STEP / 2, "75% swing: half a step late");
+
+// Entry 0 is "OFF"
+extern const GrooveTemplate grooveTables[];
+extern const uint8_t grooveCount;
+
+#endif
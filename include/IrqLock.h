@@ -0,0 +1,38 @@
+#ifndef IRQLOCK_H
+#define IRQLOCK_H
+
+#include <stdint.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// --- NESTABLE INTERRUPT MASKING ---
+// noInterrupts() / interrupts() always leave interrupts on, which is wrong for a
+// caller that already had them off: an ISR, or code inside a critical section of
+// its own. irqSave() masks and returns the previous PRIMASK; irqRestore() puts it
+// back, so sections nest and an ISR stays an ISR.
+//
+//   uint32_t m = irqSave();
+//   ...
+//   irqRestore(m);
+//
+// tools/hostsim keeps a simulated mask; other host builds have nothing to mask.
+
+#if defined(ARDUINO) && defined(__arm__)
+static inline uint32_t irqSave() {
+  uint32_t primask;
+  __asm__ volatile("mrs %0, primask\n\tcpsid i" : "=r"(primask) :: "memory");
+  return primask;
+}
+static inline void irqRestore(uint32_t primask) {
+  __asm__ volatile("msr primask, %0" :: "r"(primask) : "memory");
+}
+#elif defined(ARDUINO)
+static inline uint32_t irqSave() { return hostsimIrqSave(); }
+static inline void irqRestore(uint32_t primask) { hostsimIrqRestore(primask); }
+#else
+static inline uint32_t irqSave() { return 0; }
+static inline void irqRestore(uint32_t) {}
+#endif
+
+#endif
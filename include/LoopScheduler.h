@@ -0,0 +1,80 @@
+#ifndef LOOPSCHEDULER_H
+#define LOOPSCHEDULER_H
+
+#include <stdint.h>
+
+// --- COOPERATIVE LOOP SCHEDULER ---
+// Runs the UI-side work of loop() (input, look-ahead rendering, serial, storage,
+// display) as periodic tasks instead of one fixed pass followed by delay(1).
+// Tasks are ranked by the order they are added, first = highest priority, and
+// never preempt each other: runOnce() starts the highest-priority task that is
+// due, or waits in the idle hook until the next one is.
+//
+// Each task has a period, a budget (longest run it is expected to take) and a
+// deadline (how late after its release it may start). A due task is held back
+// while its budget would push a higher-priority task past that task's deadline,
+// so a long display refresh waits for a gap instead of delaying the renderer;
+// once the held task is past its own deadline it runs anyway, so it can't
+// starve. Missed releases are dropped, not caught up in a burst.
+//
+// Per task: runs, time used, longest run, budget overruns, start lateness and
+// deadline misses; plus time spent idle. Times come from the clock given to
+// begin() (micros() on the Teensy), so ISR time is charged to whatever it
+// interrupted. Host builds can drive it from a simulated clock.
+
+static const uint8_t SCHED_MAX_TASKS = 8;
+
+struct SchedTaskStats {
+  uint32_t runs = 0;
+  uint32_t totalUs = 0;     // wraps after ~71 min busy; resetStats() between reads
+  uint32_t maxUs = 0;
+  uint32_t overBudget = 0;  // runs longer than the budget
+  uint32_t maxLateUs = 0;   // start - release
+  uint32_t missed = 0;      // started past the deadline
+  uint32_t held = 0;        // releases held back for a higher-priority task
+};
+
+class LoopScheduler {
+  public:
+    typedef uint32_t (*ClockFn)();
+    typedef void (*TaskFn)(void* ctx);
+    typedef void (*IdleFn)();
+
+    void begin(ClockFn clock, IdleFn idle);
+    // Index of the new task, -1 if full. First release is one period from now.
+    int8_t addTask(const char* name, TaskFn fn, void* ctx, uint32_t periodUs, uint32_t budgetUs, uint32_t deadlineUs);
+    // Run one task, or idle until one is due
+    void runOnce();
+
+    uint8_t taskCount() const { return count; }
+    const char* taskName(uint8_t i) const { return tasks[i % SCHED_MAX_TASKS].name; }
+    uint32_t taskPeriod(uint8_t i) const { return tasks[i % SCHED_MAX_TASKS].periodUs; }
+    uint32_t taskBudget(uint8_t i) const { return tasks[i % SCHED_MAX_TASKS].budgetUs; }
+    const SchedTaskStats& stats(uint8_t i) const { return tasks[i % SCHED_MAX_TASKS].stats; }
+    uint32_t idleUs() const { return idleTotalUs; }
+    // Time covered by the stats (since begin() or the last resetStats())
+    uint32_t windowUs() const { return now() - windowStart; }
+    void resetStats();
+
+  private:
+    struct Task {
+      const char* name;
+      TaskFn fn;
+      void* ctx;
+      uint32_t periodUs, budgetUs, deadlineUs;
+      uint32_t nextDue;
+      bool heldNow;   // this release has been held back at least once
+      SchedTaskStats stats;
+    };
+    Task tasks[SCHED_MAX_TASKS];
+    uint8_t count = 0;
+    ClockFn now = nullptr;
+    IdleFn idle = nullptr;
+    uint32_t idleTotalUs = 0;
+    uint32_t windowStart = 0;
+
+    bool fits(uint8_t i, uint32_t t) const;
+    void run(Task& task, uint32_t t);
+};
+
+#endif
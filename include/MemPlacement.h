@@ -0,0 +1,35 @@
+#ifndef MEMPLACEMENT_H
+#define MEMPLACEMENT_H
+
+// --- MEMORY PLACEMENT (Teensy 4) ---
+// RAM1 (512 KB, tightly coupled, no wait states) holds all code by default (ITCM,
+// allocated in 32 KB banks) and all variables, const tables included (DTCM); the
+// rest of RAM1 is stack. Everything else is slower: flash and RAM2 go through the
+// 32 KB caches.
+//   FASTRUN   ISR paths. ITCM is the default already; marking them keeps them
+//             there and lets tools/memreport.py check it.
+//   FLASHMEM  cold code (setup, console, reports, display drawing). It runs from
+//             flash through the I-cache and leaves ITCM banks to DTCM.
+//   PROGMEM   large const tables, read from flash through the D-cache.
+//   DMAMEM    large buffers that are written often but rarely read (RAM2). NOT
+//             zeroed or initialised at boot: the owner clears them in begin().
+// Host builds (tools/) get empty definitions.
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#ifndef FASTRUN
+#define FASTRUN
+#endif
+#ifndef FLASHMEM
+#define FLASHMEM
+#endif
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef DMAMEM
+#define DMAMEM
+#endif
+
+#endif
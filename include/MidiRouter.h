@@ -0,0 +1,228 @@
+#ifndef MIDIROUTER_H
+#define MIDIROUTER_H
+
+#include <stdint.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// --- MULTI-PORT MIDI OUTPUT ---
+// Tracks are routed to (port, channel). Each port has its own message queue and
+// clock-output flag, so a full DIN UART never holds back USB and vice versa:
+// send() writes straight through when the port has room and otherwise queues;
+// service() (engine ISR, every 1 ms) moves queued messages on as room frees up.
+// Realtime bytes (clock, start, stop) go ahead of queued channel messages.
+//
+// Backends are small adapters over HardwareSerial, usbMIDI, or (for host builds)
+// a simulated port with a fixed byte rate, so routing throughput and per-port
+// latency can be measured without hardware.
+//
+// Soft thru: channel messages from the MIDI inputs are passed to thru(), which
+// filters by input channel, remaps the channel (or takes a track's route) and
+// queues the message on the output ports. Each port drains realtime bytes first,
+// then thru messages, then sequencer messages; queues hold whole messages, so the
+// streams merge at message boundaries. Thru goes ahead of queued sequencer output
+// because a late played note is heard, a queued step note is already late. See
+// tools/thrubench.cpp for the latency this adds.
+
+static const uint8_t MIDI_MAX_PORTS = 4;
+static const uint8_t MIDI_MAX_TRACKS = 16;      // routes kept for up to 16 tracks
+static const uint8_t MIDI_PORT_QUEUE = 64;      // channel messages per port
+static const uint8_t MIDI_RT_QUEUE = 8;         // pending realtime bytes per port
+static const uint8_t MIDI_THRU_QUEUE = 16;      // pending thru messages per port
+
+enum MidiPortId : uint8_t { MIDI_PORT_DIN = 0, MIDI_PORT_USB, MIDI_NUM_DEFAULT_PORTS };
+
+class MidiPortBackend {
+  public:
+    virtual ~MidiPortBackend() {}
+    virtual int availableForWrite() = 0;
+    // Only called with len <= availableForWrite(); must not block
+    virtual void write(const uint8_t* b, uint8_t len) = 0;
+    virtual void flush() {}
+};
+
+// Bytes a UART port lets the router put ahead of the wire: 2.56 ms at 31250 baud,
+// more than the 1 ms between service() calls, so the line never idles, while
+// realtime and thru bytes wait behind at most this much instead of a full buffer
+static const uint8_t UART_MIDI_WINDOW = 8;
+
+#ifdef ARDUINO
+// DIN (or any other 31250-baud UART)
+class UartMidiPort : public MidiPortBackend {
+  public:
+    explicit UartMidiPort(HardwareSerial& s) : serial(s) {}
+    int availableForWrite() override {
+      // the buffer size is the most free space ever seen (an idle port)
+      int free = serial.availableForWrite();
+      if (free > capacity) capacity = free;
+      int room = UART_MIDI_WINDOW - (capacity - free);
+      return room > 0 ? room : 0;
+    }
+    void write(const uint8_t* b, uint8_t len) override { for (uint8_t i = 0; i < len; i++) serial.write(b[i]); }
+  private:
+    HardwareSerial& serial;
+    int capacity = 0;
+};
+
+// USB device MIDI (needs a MIDI USB type, see platformio.ini)
+class UsbMidiPort : public MidiPortBackend {
+  public:
+    int availableForWrite() override { return 64; } // packets are buffered by the USB stack
+    void write(const uint8_t* b, uint8_t len) override {
+      if (b[0] >= 0xF8) usbMIDI.sendRealTime(b[0]);
+      else if (b[0] == 0xF2) usbMIDI.sendSongPosition(b[1] | (b[2] << 7));
+      else usbMIDI.send(b[0] & 0xF0, b[1], len > 2 ? b[2] : 0, (b[0] & 0x0F) + 1, 0);
+    }
+    void flush() override { usbMIDI.send_now(); }
+};
+#endif
+
+// Simulated port: drains `bytesPerSec` from a `bufferBytes` TX buffer, on a clock
+// advanced by the caller
+class FakeMidiPort : public MidiPortBackend {
+  public:
+    FakeMidiPort(uint32_t bytesPerSec, uint16_t bufferBytes) : rate(bytesPerSec), capacity(bufferBytes) {}
+    void advance(uint32_t nowMicros) {
+      uint32_t drained = (uint32_t)((uint64_t)(nowMicros - lastMicros) * rate / 1000000UL);
+      if (drained == 0) return;
+      fill = drained >= fill ? 0 : fill - drained;
+      lastMicros = nowMicros;
+    }
+    int availableForWrite() override { return capacity - fill; }
+    void write(const uint8_t* b, uint8_t len) override { fill += len; bytes += len; (void)b; }
+    uint32_t bytes = 0;
+  private:
+    uint32_t rate;
+    uint16_t capacity;
+    uint16_t fill = 0;
+    uint32_t lastMicros = 0;
+};
+
+enum MidiThruMode : uint8_t {
+  MIDI_THRU_OFF = 0,
+  MIDI_THRU_ON,      // to `ports`, channel remapped by `remap`
+  MIDI_THRU_TRACK,   // to the port and channel of a track (the selected one)
+  MIDI_THRU_NUM_MODES
+};
+
+struct MidiThruConfig {
+  uint8_t mode = MIDI_THRU_OFF;
+  uint8_t sources = 1 << MIDI_PORT_DIN;  // inputs forwarded, bit per MidiPortId
+  uint8_t ports = 1 << MIDI_PORT_DIN;    // MIDI_THRU_ON outputs
+  uint16_t channels = 0xFFFF;            // input channels passed, bit per channel
+  uint8_t remap[16];                     // output channel per input channel, 0xFF = same
+  MidiThruConfig() { for (uint8_t c = 0; c < 16; c++) remap[c] = 0xFF; }
+};
+
+struct MidiThruStats {
+  uint32_t forwarded = 0;
+  uint32_t filtered = 0;    // channel not passed
+  uint32_t dropped = 0;     // an output queue was full
+};
+
+// Data bytes after a status byte; 0 for realtime, sysex and undefined
+static inline uint8_t midiDataBytes(uint8_t status) {
+  if (status < 0xF0) return ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 1 : 2;
+  if (status == 0xF1 || status == 0xF3) return 1;
+  if (status == 0xF2) return 2;
+  return 0;
+}
+
+// Whole messages out of a MIDI byte stream: running status, realtime bytes
+// interleaved anywhere, sysex skipped
+class MidiInParser {
+  public:
+    // Length of the message `b` completes (copied to msg[0..2]), 0 if none yet
+    uint8_t feed(uint8_t b, uint8_t* msg);
+    void reset() { status = 0; count = 0; }
+  private:
+    uint8_t status = 0;   // running status, 0xF0 inside sysex
+    uint8_t data[2];
+    uint8_t count = 0;
+};
+
+// Outcome of play()
+enum MidiPlayResult : uint8_t { MIDI_PLAY_DROPPED = 0, MIDI_PLAY_WRITTEN, MIDI_PLAY_QUEUED };
+
+struct MidiMsg {
+  uint8_t len;
+  uint8_t b[3];
+  uint32_t queuedMicros;
+};
+
+struct TrackRoute {
+  uint8_t port;     // MidiPortId
+  uint8_t channel;  // 0-15
+};
+
+struct MidiPortStats {
+  uint32_t sent = 0;        // messages written to the backend
+  uint32_t queued = 0;      // of those, how many had to wait in the queue
+  uint32_t dropped = 0;     // queue full
+  uint32_t maxLatencyUs = 0;
+  uint32_t totalLatencyUs = 0;
+  uint8_t maxDepth = 0;
+};
+
+class MidiRouter {
+  public:
+    typedef uint32_t (*ClockFn)();
+
+    TrackRoute route[MIDI_MAX_TRACKS];
+
+    void begin(ClockFn clock);
+    bool addPort(uint8_t id, MidiPortBackend* backend, bool clockOut);
+    bool hasPort(uint8_t id) const { return id < MIDI_MAX_PORTS && ports[id].backend; }
+    void setClockOut(uint8_t id, bool on) { if (id < MIDI_MAX_PORTS) ports[id].clockOut = on; }
+    bool clockOut(uint8_t id) const { return id < MIDI_MAX_PORTS && ports[id].clockOut; }
+
+    // Channel voice message for a track (status = 0x80..0xE0, channel from the route)
+    bool send(uint8_t track, uint8_t status, uint8_t d1, uint8_t d2);
+    // Low priority: only written when the port is idle with `minFree` bytes to spare
+    bool sendIfIdle(uint8_t track, uint8_t status, uint8_t d1, uint8_t d2, uint8_t minFree);
+    // Clock / start / stop to every port with clock output enabled
+    void sendRealtime(uint8_t b);
+    // Song Position Pointer to the same ports, queued in order with channel messages
+    void sendSongPosition(uint16_t beats);
+    void service();
+    // Soft thru for a channel message that came in on port `src`. `track` gives
+    // the route for MIDI_THRU_TRACK. False if not forwarded.
+    bool thru(uint8_t src, const uint8_t* msg, uint8_t len, uint8_t track);
+    MidiThruConfig thruConfig;
+    // Channel message played live on a track's route (pad play): takes the thru lane,
+    // so it goes ahead of queued sequencer output. Says whether it went straight out.
+    uint8_t play(uint8_t track, uint8_t status, uint8_t d1, uint8_t d2);
+    const MidiThruStats& thruStats() const { return thruStat; }
+
+    const MidiPortStats& stats(uint8_t id) const { return ports[id % MIDI_MAX_PORTS].stats; }
+    uint8_t depth(uint8_t id) const { return (uint8_t)(ports[id % MIDI_MAX_PORTS].tail - ports[id % MIDI_MAX_PORTS].head); }
+    void resetStats();
+
+  private:
+    struct Port {
+      MidiPortBackend* backend = nullptr;
+      bool clockOut = false;
+      MidiMsg queue[MIDI_PORT_QUEUE];
+      volatile uint8_t head = 0, tail = 0;       // free-running, masked on access
+      uint8_t rt[MIDI_RT_QUEUE];
+      volatile uint8_t rtHead = 0, rtTail = 0;
+      MidiMsg thruQ[MIDI_THRU_QUEUE];
+      volatile uint8_t thruHead = 0, thruTail = 0;
+      MidiPortStats stats;
+    };
+    Port ports[MIDI_MAX_PORTS];
+    ClockFn now = nullptr;
+    MidiThruStats thruStat;
+
+    void pump(Port& p);
+    bool put(Port& p, const MidiMsg& m);
+    uint8_t putThru(Port& p, const MidiMsg& m);
+    void written(Port& p, const MidiMsg& m, bool waited);
+};
+
+static_assert((MIDI_PORT_QUEUE & (MIDI_PORT_QUEUE - 1)) == 0, "queue size must be a power of two");
+static_assert((MIDI_RT_QUEUE & (MIDI_RT_QUEUE - 1)) == 0, "queue size must be a power of two");
+static_assert((MIDI_THRU_QUEUE & (MIDI_THRU_QUEUE - 1)) == 0, "queue size must be a power of two");
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef MODULATION_H
+#define MODULATION_H
+
+#include <stdint.h>
+#include "SeqConfig.h"
+
+// --- TICK-RATE MODULATION ---
+// One LFO and one AD envelope per track, advanced on every MIDI clock tick
+// (24 PPQN) in Q15 fixed point. Outputs go to a CC or pitch bend on the track's
+// channel, change-only, and through a byte budget so modulation stays inside a
+// fixed share of the 31250-baud wire and never queues ahead of note-ons.
+
+enum LfoShape : uint8_t { LFO_SINE = 0, LFO_TRIANGLE, LFO_SAW, LFO_SQUARE, LFO_RANDOM, LFO_NUM_SHAPES };
+
+static const uint8_t MOD_DEST_PITCHBEND = 128;
+static const uint8_t MOD_DEST_OFF = 255;
+// Destinations cycled by the UI
+static const uint8_t MOD_DESTS[] = { MOD_DEST_OFF, 74, 71, 1, 10, MOD_DEST_PITCHBEND };
+static const uint8_t MOD_NUM_DESTS = sizeof(MOD_DESTS) / sizeof(MOD_DESTS[0]);
+
+// One of MOD_DESTS (save records are checked against it)
+static inline bool modDestValid(uint8_t dest) {
+  for (uint8_t i = 0; i < MOD_NUM_DESTS; i++) if (MOD_DESTS[i] == dest) return true;
+  return false;
+}
+
+// LFO period in ticks: 1/16 .. 8 bars
+static const uint16_t MOD_LFO_TICKS[] = { 6, 12, 24, 48, 96, 192, 384, 768 };
+static const uint8_t MOD_NUM_LFO_RATES = sizeof(MOD_LFO_TICKS) / sizeof(MOD_LFO_TICKS[0]);
+// Envelope stage lengths in ticks
+static const uint16_t MOD_ENV_TICKS[] = { 0, 1, 3, 6, 12, 24, 48, 96 };
+static const uint8_t MOD_NUM_ENV_TIMES = sizeof(MOD_ENV_TICKS) / sizeof(MOD_ENV_TICKS[0]);
+
+// Wire budget: DIN MIDI carries 3125 bytes/s; modulation may use this share
+static const uint32_t MIDI_WIRE_BYTES_PER_SEC = 3125;
+static const uint8_t MOD_WIRE_SHARE_PCT = 30;
+static const uint8_t MOD_BURST_BYTES = 24;     // bucket depth: 8 messages
+// Only send while the port is idle with at least this much TX buffer free, so a
+// note-on written later in the tick waits for at most one modulation message
+static const uint8_t MOD_TX_MIN_FREE = 24;
+
+struct LfoParams {
+  uint8_t shape;   // LfoShape
+  uint8_t rateIdx; // MOD_LFO_TICKS
+  uint8_t depth;   // 0-127
+  uint8_t dest;    // CC number, MOD_DEST_PITCHBEND or MOD_DEST_OFF
+};
+
+struct EnvParams {
+  uint8_t attackIdx; // MOD_ENV_TICKS
+  uint8_t decayIdx;  // MOD_ENV_TICKS
+  uint8_t depth;     // 0-127
+  uint8_t dest;
+};
+
+// Settings of a fresh pattern: both off
+static const LfoParams LFO_DEFAULT_PARAMS = {LFO_SINE, 4, 0, MOD_DEST_OFF};
+static const EnvParams ENV_DEFAULT_PARAMS = {0, 4, 0, MOD_DEST_OFF};
+
+// The settings belong to the pattern (see Pattern.h) and are passed in on every
+// call, so switching patterns switches them without touching LFO phases.
+class ModEngine {
+  public:
+    // Returns false when the output port has no headroom; the value is retried next tick
+    typedef bool (*SendFn)(uint8_t track, uint8_t dest, uint16_t value);
+
+    void init();
+    void reset();                      // transport start: phases to 0
+    // song position: phases as if `ticks` had run
+    void seek(const LfoParams* lfo, uint32_t ticks);
+    void noteOn(uint8_t track);        // retrigger the track's envelope
+    // transport stop: re-centre pitch bend
+    void park(const LfoParams* lfo, const EnvParams* env, SendFn send);
+    void tick(const LfoParams* lfo, const EnvParams* env, uint32_t nowMicros, SendFn send);
+
+    // Stats for the wire report
+    uint32_t bytesSent = 0;
+    uint32_t deferred = 0;             // changed values held back by the budget
+
+  private:
+    uint32_t phase[NUM_CHANNELS];
+    uint32_t rnd[NUM_CHANNELS];        // S&H state (xorshift)
+    int16_t rndHeld[NUM_CHANNELS];
+    uint16_t envTick[NUM_CHANNELS];    // ticks since note-on, 0xFFFF = idle
+    int32_t lastSent[NUM_CHANNELS][2]; // [track][0 = lfo dest, 1 = env dest]
+    uint32_t budgetMicros = 0;         // token bucket, in byte-microseconds
+    uint32_t lastMicros = 0;
+    uint8_t rrStart = 0;
+
+    int16_t lfoValue(const LfoParams& l, uint8_t t);  // Q15 bipolar
+    int16_t envValue(const EnvParams& e, uint8_t t);  // Q15 unipolar
+    bool spend(uint8_t bytes);
+};
+
+#endif
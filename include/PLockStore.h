@@ -0,0 +1,143 @@
+#ifndef PLOCKSTORE_H
+#define PLOCKSTORE_H
+
+#include <stdint.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+// host tools (through SaveFormat.h) have no interrupts to mask
+static inline void noInterrupts() {}
+static inline void interrupts() {}
+#endif
+#include "SeqConfig.h"
+
+// --- SPARSE PARAMETER LOCKS ---
+// Locks are kept as a sorted list of (track, step, param, value) entries plus a
+// per-track bitmask of steps that hold any lock. renderChannel() checks the mask
+// (one AND) and only then binary-searches the list, so unlocked steps cost nothing.
+//
+// Memory per lockable parameter, dense [tracks][steps] uint8_t vs sparse:
+//   4 x 16:  dense 64 B    | sparse 32 B masks + 4 B per lock (shared by all params)
+//   16 x 64: dense 1024 B  | sparse 128 B masks + 4 B per lock
+// e.g. 8 CC lanes at 16 x 64 cost 8 KB dense; 32 sparse locks cost 256 B.
+// printSaveReport() prints these figures for the current build.
+
+static const uint8_t PLOCK_CAPACITY = 32;   // per pattern; bounded by the save slot size
+static const uint8_t PLOCK_CC_MAX = 119;    // params 0-119 are MIDI CC numbers
+
+struct PLock {
+  uint8_t track;
+  uint8_t step;
+  uint8_t param;
+  uint8_t value;
+};
+
+constexpr uint32_t plockDenseBytes(uint32_t tracks, uint32_t steps, uint32_t params) {
+  return tracks * steps * params;
+}
+constexpr uint32_t plockSparseBytes(uint32_t tracks, uint32_t locks) {
+  return tracks * sizeof(uint64_t) + locks * sizeof(PLock);
+}
+
+class PLockStore {
+  public:
+    void clear() {
+      count = 0;
+      for (uint8_t t = 0; t < NUM_CHANNELS; t++) stepMask[t] = 0;
+    }
+    uint8_t size() const { return count; }
+    const PLock& at(uint8_t i) const { return locks[i]; }
+    bool hasLocks(uint8_t track, uint8_t step) const { return (stepMask[track] >> step) & 1; }
+
+    // First entry for (track, step) and how many follow it
+    uint8_t findStep(uint8_t track, uint8_t step, uint8_t& n) const {
+      n = 0;
+      if (!hasLocks(track, step)) return 0;
+      uint8_t i = lowerBound(track, step, 0);
+      while (i + n < count && locks[i + n].track == track && locks[i + n].step == step) n++;
+      return i;
+    }
+
+    int get(uint8_t track, uint8_t step, uint8_t param) const {
+      if (!hasLocks(track, step)) return -1;
+      uint8_t i = lowerBound(track, step, param);
+      if (i < count && matches(locks[i], track, step, param)) return locks[i].value;
+      return -1;
+    }
+
+    // Insert or replace. Returns false when the table is full.
+    bool set(uint8_t track, uint8_t step, uint8_t param, uint8_t value) {
+      uint8_t i = lowerBound(track, step, param);
+      if (i < count && matches(locks[i], track, step, param)) { locks[i].value = value; return true; }
+      if (count >= PLOCK_CAPACITY) return false;
+      noInterrupts();
+      memmove(&locks[i + 1], &locks[i], (count - i) * sizeof(PLock));
+      locks[i] = PLock{track, step, param, value};
+      count++;
+      stepMask[track] |= (1ULL << step);
+      interrupts();
+      return true;
+    }
+
+    bool remove(uint8_t track, uint8_t step, uint8_t param) {
+      uint8_t i = lowerBound(track, step, param);
+      if (i >= count || !matches(locks[i], track, step, param)) return false;
+      noInterrupts();
+      eraseRange(i, 1);
+      refreshMask(track, step);
+      interrupts();
+      return true;
+    }
+
+    void clearStep(uint8_t track, uint8_t step) {
+      uint8_t n;
+      uint8_t i = findStep(track, step, n);
+      if (n == 0) return;
+      noInterrupts();
+      eraseRange(i, n);
+      stepMask[track] &= ~(1ULL << step);
+      interrupts();
+    }
+
+    void clearTrack(uint8_t track) {
+      uint8_t first = lowerBound(track, 0, 0);
+      uint8_t last = first;
+      while (last < count && locks[last].track == track) last++;
+      noInterrupts();
+      eraseRange(first, last - first);
+      stepMask[track] = 0;
+      interrupts();
+    }
+
+  private:
+    PLock locks[PLOCK_CAPACITY];
+    uint8_t count = 0;
+    uint64_t stepMask[NUM_CHANNELS] = {};
+
+    static uint32_t key(uint8_t track, uint8_t step, uint8_t param) {
+      return ((uint32_t)track << 16) | ((uint32_t)step << 8) | param;
+    }
+    static bool matches(const PLock& l, uint8_t track, uint8_t step, uint8_t param) {
+      return l.track == track && l.step == step && l.param == param;
+    }
+    uint8_t lowerBound(uint8_t track, uint8_t step, uint8_t param) const {
+      uint32_t k = key(track, step, param);
+      uint8_t lo = 0, hi = count;
+      while (lo < hi) {
+        uint8_t mid = (lo + hi) >> 1;
+        if (key(locks[mid].track, locks[mid].step, locks[mid].param) < k) lo = mid + 1;
+        else hi = mid;
+      }
+      return lo;
+    }
+    void eraseRange(uint8_t i, uint8_t n) {
+      memmove(&locks[i], &locks[i + n], (count - i - n) * sizeof(PLock));
+      count -= n;
+    }
+    void refreshMask(uint8_t track, uint8_t step) {
+      uint8_t i = lowerBound(track, step, 0);
+      if (i >= count || locks[i].track != track || locks[i].step != step) stepMask[track] &= ~(1ULL << step);
+    }
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SeqConfig.h"
+#include "Scales.h"
+#include "EuclidTables.h"
+#include "TrigCondition.h"
+#include "PLockStore.h"
+#include "Modulation.h"
+#include "Arpeggiator.h"
+#include "MidiRouter.h"
+
+// --- PATTERN DATA ---
+// Everything a save record holds about what plays: steps, per-step parameters,
+// per-track settings and the tables derived from them. The sequencer keeps two
+// and plays the one `pat` points at. A load is decoded into the other one and
+// becomes live by swapping the pointer, so a record is never applied half-way and
+// a cued pattern costs the engine nothing at the bar boundary.
+//
+// Tempo, output routing and clock priority are rig settings, not pattern data:
+// they travel in the same record (SaveRig) but stay put while a pattern is
+// swapped in during playback.
+
+struct Pattern {
+  bool steps[NUM_CHANNELS][NUM_STEPS];
+  uint8_t pitch[NUM_CHANNELS][NUM_STEPS];        // MIDI note, 255 = channelPitch
+  uint8_t noteLen[NUM_CHANNELS][NUM_STEPS];      // index into noteLenTicks, 255 = noteLenIdx
+  uint8_t stepRatchet[NUM_CHANNELS][NUM_STEPS];  // 0 = off
+  uint8_t stepVelocity[NUM_CHANNELS][NUM_STEPS]; // 255 = channelVelocity
+  bool stepSlide[NUM_CHANNELS][NUM_STEPS];
+  uint8_t stepProb[NUM_CHANNELS][NUM_STEPS];     // 0-100 %, 100 = always
+  uint8_t stepCond[NUM_CHANNELS][NUM_STEPS];     // TrigCondition
+  // 0 = normal, 1 = fill (plays only when Fill held), 2 = anti-fill (never plays)
+  uint8_t fillState[NUM_CHANNELS][NUM_STEPS];
+  uint32_t patternSeed;                          // replays the same random trigs
+  PLockStore plocks;
+  uint8_t noteLenIdx;                            // default length index
+
+  // per track
+  uint8_t channelPitch[NUM_CHANNELS];
+  uint8_t channelVelocity[NUM_CHANNELS];
+  bool muted[NUM_CHANNELS];
+  bool euclidEnabled[NUM_CHANNELS];
+  uint8_t euclidMode[NUM_CHANNELS];              // EuclidMode: Bresenham or Bjorklund
+  uint8_t pulses[NUM_CHANNELS];
+  uint8_t euclidOffset[NUM_CHANNELS];
+  uint8_t euclidScaleMode[NUM_CHANNELS];         // ScaleMode
+  uint8_t scaleRoot[NUM_CHANNELS];               // pitch class the scale is built on
+  uint16_t userScaleMask[NUM_CHANNELS];          // SCALE_USER pitch classes (bit i = root + i)
+  bool quantizeEnabled[NUM_CHANNELS];            // snap notes to the scale in renderChannel()
+  int8_t trackDelayMs[NUM_CHANNELS];             // latency compensation, negative = earlier
+  uint8_t trackGroove[NUM_CHANNELS];             // index into grooveTables, 0 = off
+  uint8_t grooveAmount[NUM_CHANNELS];            // percent of the template's offsets and accents
+  LfoParams lfo[NUM_CHANNELS];
+  EnvParams env[NUM_CHANNELS];
+  ArpParams arp[NUM_CHANNELS];
+
+  // derived, rebuilt by SimpleSequencer::updateEuclid() / makeScale()
+  uint64_t euclidPattern[NUM_CHANNELS];          // packed: bit s = step s
+  ScaleInfo userScale[NUM_CHANNELS];             // tables built from userScaleMask
+
+  // A blank pattern
+  void init() {
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      for (uint8_t s = 0; s < NUM_STEPS; s++) {
+        steps[c][s] = false;
+        pitch[c][s] = 255;
+        noteLen[c][s] = 255;
+        stepRatchet[c][s] = 0;
+        stepVelocity[c][s] = 255;
+        stepSlide[c][s] = false;
+        stepProb[c][s] = 100;
+        stepCond[c][s] = TRIG_ALWAYS;
+        fillState[c][s] = 0;
+      }
+      channelPitch[c] = 36;      // C2
+      channelVelocity[c] = 96;
+      muted[c] = false;
+      euclidEnabled[c] = false;
+      euclidMode[c] = EUCLID_BRESENHAM;
+      pulses[c] = 4;
+      euclidOffset[c] = 0;
+      euclidScaleMode[c] = SCALE_OFF;
+      scaleRoot[c] = 0;
+      userScaleMask[c] = SCALE_MASK_CHROMATIC;
+      quantizeEnabled[c] = false;
+      trackDelayMs[c] = 0;
+      trackGroove[c] = 0;
+      grooveAmount[c] = 100;
+      lfo[c] = LFO_DEFAULT_PARAMS;
+      env[c] = ENV_DEFAULT_PARAMS;
+      arp[c] = ARP_DEFAULT_PARAMS;
+      euclidPattern[c] = 0;
+      userScale[c] = makeScale(userScaleMask[c]);
+    }
+    patternSeed = 0x23A5F00DUL;
+    plocks.clear();
+    noteLenIdx = 4;              // 1/16: short gates avoid envelope collisions
+  }
+};
+
+// The rig settings a save record carries alongside the pattern
+struct SaveRig {
+  uint32_t bpm;
+  TrackRoute route[NUM_CHANNELS];
+  bool clockOut[MIDI_MAX_PORTS];
+  uint8_t clockPriority;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef PROJECTSTORE_H
+#define PROJECTSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ARDUINO
+#include <SD.h>
+#else
+#include <stdio.h>
+#endif
+
+// --- SD PROJECT FILES ---
+// A project is a flat file of fixed-stride pattern records (the same
+// SaveSlotHeader + bit-packed payload used by the EEPROM slots), so any pattern
+// is one seek away and only the patterns actually cued are ever read into RAM.
+//
+// [ProjectHeader][record 0][record 1]...[song 0][song 1]...
+// record index = bank * patternsPerBank + pattern
+//
+// On the Teensy the backend is the built-in SD slot; on a host build (no ARDUINO)
+// it is a plain POSIX FILE*, so load/save throughput can be measured on Linux.
+
+static const uint32_t PROJECT_MAGIC = 0x4A505153UL; // "SQPJ"
+static const uint8_t PROJECT_VERSION = 2; // v2: song region after the records
+static const uint8_t PROJECT_BANKS = 16;
+static const uint8_t PROJECT_PATTERNS_PER_BANK = 16;
+static const uint16_t PROJECT_MAX_RECORD_BYTES = 512;
+static const uint8_t PROJECT_SONGS = 16;
+static const uint16_t PROJECT_SONG_BYTES = 256; // fixed stride per song blob
+// Bytes read per service() call; bounds the time one loop() pass spends on SD I/O
+static const uint16_t PROJECT_READ_CHUNK = 128;
+
+struct ProjectHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t banks;
+  uint8_t patternsPerBank;
+  uint8_t songs;      // 0 in v1 files (no songs yet)
+  uint16_t recordBytes;
+  uint16_t reserved2;
+};
+
+// Thin file handle over SD or POSIX
+class ProjectFile {
+  public:
+    bool open(const char* path);
+    void close();
+    bool isOpen() const;
+    bool seek(uint32_t pos);
+    int32_t read(uint8_t* dst, uint16_t len);
+    int32_t write(const uint8_t* src, uint16_t len);
+    uint32_t size();
+  private:
+#ifdef ARDUINO
+    File f;
+    bool opened = false;
+#else
+    FILE* f = nullptr;
+#endif
+};
+
+class ProjectStore {
+  public:
+    bool begin();
+    bool open(const char* path, uint16_t recordBytes);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+    uint16_t recordCount() const { return (uint16_t)PROJECT_BANKS * PROJECT_PATTERNS_PER_BANK; }
+
+    // Blocking write of one record (user-initiated save)
+    bool writeRecord(uint16_t index, const uint8_t* rec, uint16_t len);
+    // Blocking read of one record (host tools / boot)
+    bool readRecord(uint16_t index, uint8_t* dst);
+    // Song blobs (up to PROJECT_SONG_BYTES); unwritten songs read back as 0xFF
+    bool writeSong(uint8_t index, const void* data, uint16_t len);
+    bool readSong(uint8_t index, void* dst, uint16_t len);
+
+    // --- STREAMED, DOUBLE-BUFFERED READS ---
+    // requestRecord() starts filling the back buffer; service() (UI loop) reads at
+    // most PROJECT_READ_CHUNK bytes per call. Once the record is complete it is
+    // flagged ready and the engine swaps it to the front with takeRecord(), which
+    // does no I/O.
+    bool requestRecord(uint16_t index);
+    void service();
+    bool recordReady() const { return ready; }
+    bool busy() const { return pending; }
+    int16_t readyIndex() const { return ready ? (int16_t)backIndex : -1; }
+    const uint8_t* takeRecord();
+    uint16_t recordBytes() const { return recBytes; }
+
+  private:
+    ProjectFile file;
+    uint16_t recBytes = 0;
+    uint8_t buffers[2][PROJECT_MAX_RECORD_BYTES];
+    uint8_t front = 0;
+    volatile bool ready = false;
+    bool pending = false;
+    uint16_t backIndex = 0;
+    uint16_t backFilled = 0;
+
+    uint32_t recordAddress(uint16_t index) const { return sizeof(ProjectHeader) + (uint32_t)index * recBytes; }
+    uint32_t songAddress(uint8_t index) const { return recordAddress(recordCount()) + (uint32_t)index * PROJECT_SONG_BYTES; }
+};
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef SAVEFORMAT_H
+#define SAVEFORMAT_H
+
+#include <stdint.h>
+#include <string.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include "SeqConfig.h"
+#include "PLockStore.h"
+#include "Modulation.h"
+#include "Arpeggiator.h"
+#include "GrooveTables.h"
+#include "MidiRouter.h"
+#include "ClockManager.h"
+#include "Crc16.h"
+
+// --- EEPROM LAYOUT ---
+// [SaveDirectory][record][record]...[free]...[slot table]
+// Each record = SaveSlotHeader + bit-packed payload. The payload is written field by
+// field with BitWriter so bools cost 1 bit and 255 "use default" sentinels cost 1 bit.
+// Records are stored at their actual length; the slot table at the top of the
+// EEPROM holds each slot's address and length. A rewritten slot goes into free
+// space and the table then points at it; the gaps this leaves are compacted when
+// a write needs the room. How many slots fit depends on what is in them.
+// Earlier firmware (directory "SQ23") kept the slots at a fixed worst-case stride
+// after the directory; those are packed at boot (see convertFixedSlots()).
+
+// Teensy 4.1 emulated EEPROM size (E2END + 1)
+static const uint16_t SAVE_EEPROM_BYTES = 4284;
+
+// Directory signatures: "SQ24" for packed records, "SQ23" for the earlier fixed
+// stride; both distinct from the legacy v3 magic (13572469)
+static const uint32_t SAVE_DIR_MAGIC = 0x34325153UL;
+static const uint32_t SAVE_DIR_MAGIC_FIXED = 0x33325153UL;
+static const uint32_t SAVE_V3_MAGIC = 13572469UL;
+// Current payload schema version. Bump when fields are added and gate the new
+// reads in decodePattern() on `version >= N` so older slots still load.
+//   v4: initial bit-packed layout
+//   v5: per-channel Euclid mode (Bresenham / Bjorklund)
+//   v6: 3-bit scale mode, scale root, user scale mask, trigger quantiser flag
+//   v7: per-step probability + trig condition, pattern PRNG seed
+//   v8: sparse CC p-lock list
+//   v9: per-track LFO + envelope modulation settings
+//   v10: per-track delay (latency compensation)
+//   v11: per-track output port + MIDI channel, per-port clock output
+//   v12: clock source priority preset
+//   v13: per-track arpeggiator settings
+//   v14: per-track groove template + amount
+static const uint8_t SAVE_VERSION = 14;
+
+struct SaveDirectory {
+  uint32_t magic;
+  uint8_t version;   // directory layout version
+  uint8_t lastSlot;  // slot restored at boot
+  uint16_t layout;   // SQ24: slot table entries; SQ23: slot stride in bytes
+};
+
+struct SaveSlotEntry {
+  uint16_t addr;     // record address in EEPROM
+  uint16_t bytes;    // record length (0 = empty)
+};
+
+struct SaveSlotHeader {
+  uint8_t version;     // payload schema version (0 / 0xFF = empty)
+  uint8_t reserved;
+  uint16_t payloadBytes;
+  uint16_t crc;        // CRC-16/CCITT over payload
+};
+
+// Bits needed to store values 0..maxVal
+constexpr uint8_t saveBitsFor(uint32_t maxVal) {
+  return maxVal < 2 ? 1 : 1 + saveBitsFor(maxVal >> 1);
+}
+
+// Field widths
+static const uint8_t SAVE_BITS_BPM = 9;       // 20-300
+static const uint8_t SAVE_BITS_LEN_IDX = 3;   // index into noteLenTicks
+static const uint8_t SAVE_BITS_NOTE = 7;
+static const uint8_t SAVE_BITS_VEL = 7;
+static const uint8_t SAVE_BITS_PULSES = saveBitsFor(NUM_STEPS);
+static const uint8_t SAVE_BITS_OFFSET = saveBitsFor(NUM_STEPS - 1);
+static const uint8_t SAVE_BITS_SCALE = 3;
+static const uint8_t SAVE_BITS_SCALE_V5 = 2;
+static const uint8_t SAVE_BITS_ROOT = 4;
+static const uint8_t SAVE_BITS_SCALE_MASK = 12;
+static const uint8_t SAVE_BITS_PROB = 7;
+static const uint8_t SAVE_BITS_COND = 6;
+static const uint8_t SAVE_BITS_SEED = 32;
+static const uint8_t SAVE_BITS_PLOCK_COUNT = saveBitsFor(PLOCK_CAPACITY);
+static const uint8_t SAVE_BITS_TRACK = saveBitsFor(NUM_CHANNELS - 1);
+static const uint8_t SAVE_BITS_STEP = saveBitsFor(NUM_STEPS - 1);
+static const uint8_t SAVE_BITS_PLOCK_PARAM = 7;
+static const uint16_t SAVE_PLOCK_BITS = SAVE_BITS_TRACK + SAVE_BITS_STEP + SAVE_BITS_PLOCK_PARAM + 7;
+static const uint8_t SAVE_BITS_LFO_SHAPE = saveBitsFor(LFO_NUM_SHAPES - 1);
+static const uint8_t SAVE_BITS_LFO_RATE = saveBitsFor(MOD_NUM_LFO_RATES - 1);
+static const uint8_t SAVE_BITS_ENV_TIME = saveBitsFor(MOD_NUM_ENV_TIMES - 1);
+static const uint8_t SAVE_BITS_MOD_DEST = 8;   // CC, pitch bend or off
+static const uint16_t SAVE_MOD_BITS = SAVE_BITS_LFO_SHAPE + SAVE_BITS_LFO_RATE + 7 + SAVE_BITS_MOD_DEST
+                                    + 2 * SAVE_BITS_ENV_TIME + 7 + SAVE_BITS_MOD_DEST;
+static const int8_t TRACK_DELAY_MAX_MS = 50;
+static const uint8_t SAVE_BITS_TRACK_DELAY = 7; // -50..+50 ms, offset by 50
+static const uint8_t SAVE_BITS_PORT = saveBitsFor(MIDI_MAX_PORTS - 1);
+static const uint8_t SAVE_BITS_MIDI_CH = 4;
+static const uint8_t SAVE_BITS_CLOCK_PRIO = saveBitsFor(CLOCK_NUM_PRIORITIES - 1);
+static const uint8_t SAVE_BITS_ARP_MODE = saveBitsFor(ARP_NUM_MODES - 1);
+static const uint8_t SAVE_BITS_ARP_OCTAVES = saveBitsFor(ARP_MAX_OCTAVES - 1); // stored minus one
+static const uint8_t SAVE_BITS_ARP_RATE = saveBitsFor(ARP_NUM_RATES - 1);
+static const uint8_t SAVE_BITS_ARP_CHORD = saveBitsFor(ARP_NUM_CHORDS - 1);
+static const uint16_t SAVE_ARP_BITS = SAVE_BITS_ARP_MODE + 1 + SAVE_BITS_ARP_OCTAVES + SAVE_BITS_ARP_RATE + SAVE_BITS_ARP_CHORD;
+static const uint8_t SAVE_BITS_GROOVE = saveBitsFor(GROOVE_MAX_TEMPLATES - 1);
+static const uint8_t SAVE_BITS_GROOVE_AMOUNT = 7;  // 0-100 %
+static const uint8_t SAVE_BITS_FILL = 2;
+static const uint8_t SAVE_BITS_RATCHET = 3;
+
+// Worst-case payload: every optional field present
+static const uint16_t SAVE_GLOBAL_BITS = SAVE_BITS_BPM + SAVE_BITS_LEN_IDX
+                                       + SAVE_BITS_SEED; // v7
+static const uint16_t SAVE_CHANNEL_BITS = SAVE_BITS_NOTE + 1 + 1 + SAVE_BITS_PULSES + SAVE_BITS_OFFSET
+                                        + SAVE_BITS_SCALE + SAVE_BITS_VEL
+                                        + 1   // v5 euclid mode
+                                        + SAVE_BITS_ROOT + SAVE_BITS_SCALE_MASK + 1; // v6 scale
+static const uint16_t SAVE_STEP_MAX_BITS = 1 + (1 + SAVE_BITS_NOTE) + (1 + SAVE_BITS_LEN_IDX)
+                                         + SAVE_BITS_FILL + SAVE_BITS_RATCHET + (1 + SAVE_BITS_VEL) + 1
+                                         + (1 + SAVE_BITS_PROB) + (1 + SAVE_BITS_COND); // v7
+static const uint16_t SAVE_PAYLOAD_MAX_BITS = SAVE_GLOBAL_BITS + NUM_CHANNELS * SAVE_CHANNEL_BITS
+                                            + NUM_CHANNELS * NUM_STEPS * SAVE_STEP_MAX_BITS
+                                            + SAVE_BITS_PLOCK_COUNT + PLOCK_CAPACITY * SAVE_PLOCK_BITS // v8
+                                            + NUM_CHANNELS * SAVE_MOD_BITS // v9
+                                            + NUM_CHANNELS * SAVE_BITS_TRACK_DELAY // v10
+                                            + NUM_CHANNELS * (SAVE_BITS_PORT + SAVE_BITS_MIDI_CH) + MIDI_MAX_PORTS // v11
+                                            + SAVE_BITS_CLOCK_PRIO // v12
+                                            + NUM_CHANNELS * SAVE_ARP_BITS // v13
+                                            + NUM_CHANNELS * (SAVE_BITS_GROOVE + SAVE_BITS_GROOVE_AMOUNT); // v14
+static const uint16_t SAVE_PAYLOAD_MAX_BYTES = (SAVE_PAYLOAD_MAX_BITS + 7) / 8;
+// Largest record: header + worst-case payload
+static const uint16_t SAVE_SLOT_BYTES = sizeof(SaveSlotHeader) + SAVE_PAYLOAD_MAX_BYTES;
+
+// Upper bound on any record or legacy slot stride, past or future (project files
+// use it as their fixed record stride)
+static const uint16_t SAVE_SLOT_MAX_BYTES = 512;
+
+// Slot table entries. Changing this moves the table, so it needs a new directory magic.
+static const uint8_t SAVE_NUM_SLOTS = 32;
+static const uint16_t SAVE_TABLE_ADDR = SAVE_EEPROM_BYTES - SAVE_NUM_SLOTS * sizeof(SaveSlotEntry);
+static const uint16_t SAVE_DATA_ADDR = sizeof(SaveDirectory);
+static const uint16_t SAVE_DATA_BYTES = SAVE_TABLE_ADDR - SAVE_DATA_ADDR;
+// Slots that fit whatever is in them (worst-case records only)
+static const uint8_t SAVE_MIN_SLOTS = SAVE_DATA_BYTES / SAVE_SLOT_BYTES;
+
+static_assert(SAVE_MIN_SLOTS >= 1, "save slot does not fit in EEPROM");
+static_assert(SAVE_SLOT_BYTES <= SAVE_SLOT_MAX_BYTES, "save slot exceeds SAVE_SLOT_MAX_BYTES");
+
+static inline uint16_t saveTableAddress(uint8_t slot) {
+  return SAVE_TABLE_ADDR + (uint16_t)slot * sizeof(SaveSlotEntry);
+}
+
+static inline bool saveDirPacked(const SaveDirectory& dir) {
+  return dir.magic == SAVE_DIR_MAGIC && dir.layout == SAVE_NUM_SLOTS;
+}
+
+// A table entry that points at a record inside the data area
+static inline bool saveEntryValid(const SaveSlotEntry& e) {
+  return e.bytes >= sizeof(SaveSlotHeader) && e.bytes <= SAVE_SLOT_BYTES
+      && e.addr >= SAVE_DATA_ADDR && e.addr + e.bytes <= SAVE_TABLE_ADDR;
+}
+
+// Length of the SaveSlotHeader + payload record at `rec` if its header and CRC
+// check out within `avail` bytes, else 0 (empty or corrupt)
+static inline uint16_t saveRecordBytes(const uint8_t* rec, uint16_t avail) {
+  SaveSlotHeader h;
+  if (avail < sizeof(h)) return 0;
+  memcpy(&h, rec, sizeof(h));
+  if (h.version == 0 || h.version == 0xFF || h.payloadBytes == 0 || h.payloadBytes > SAVE_PAYLOAD_MAX_BYTES) return 0;
+  if (sizeof(h) + h.payloadBytes > avail) return 0;
+  if (crc16(rec + sizeof(h), h.payloadBytes) != h.crc) return 0;
+  return sizeof(h) + h.payloadBytes;
+}
+
+// MSB-first bit packer over a caller-owned buffer
+class BitWriter {
+  public:
+    BitWriter(uint8_t* buf, uint16_t capacity) : buf(buf), cap(capacity), bitPos(0), overflow(false) {
+      memset(buf, 0, capacity);
+    }
+    void put(uint32_t v, uint8_t bits) {
+      for (int8_t i = bits - 1; i >= 0; i--) {
+        if ((bitPos >> 3) >= cap) { overflow = true; return; }
+        if ((v >> i) & 1) buf[bitPos >> 3] |= (uint8_t)(0x80 >> (bitPos & 7));
+        bitPos++;
+      }
+    }
+    void putBool(bool b) { put(b ? 1 : 0, 1); }
+    // Sentinel-aware: 255 ("use default") is a single 0 bit, anything else is 1 + value
+    void putOpt(uint8_t v, uint8_t bits) {
+      if (v == 255) { put(0, 1); return; }
+      put(1, 1);
+      put(v, bits);
+    }
+    uint16_t bytes() const { return (uint16_t)((bitPos + 7) >> 3); }
+    bool ok() const { return !overflow; }
+  private:
+    uint8_t* buf;
+    uint16_t cap;
+    uint32_t bitPos;
+    bool overflow;
+};
+
+class BitReader {
+  public:
+    BitReader(const uint8_t* buf, uint16_t len) : buf(buf), len(len), bitPos(0), overflow(false) {}
+    uint32_t get(uint8_t bits) {
+      uint32_t v = 0;
+      for (uint8_t i = 0; i < bits; i++) {
+        if ((bitPos >> 3) >= len) { overflow = true; return 0; }
+        v = (v << 1) | ((buf[bitPos >> 3] >> (7 - (bitPos & 7))) & 1);
+        bitPos++;
+      }
+      return v;
+    }
+    // A field with a legal range: anything past `max` fails the record (ok() = false)
+    uint32_t get(uint8_t bits, uint32_t max) {
+      uint32_t v = get(bits);
+      if (v > max) invalid = true;
+      return v;
+    }
+    bool getBool() { return get(1) != 0; }
+    uint8_t getOpt(uint8_t bits) { return get(1) ? (uint8_t)get(bits) : 255; }
+    uint8_t getOpt(uint8_t bits, uint8_t max) { return get(1) ? (uint8_t)get(bits, max) : 255; }
+    void reject() { invalid = true; }
+    bool ok() const { return !overflow && !invalid; }
+  private:
+    const uint8_t* buf;
+    uint16_t len;
+    uint32_t bitPos;
+    bool overflow;
+    bool invalid = false;
+};
+
+#endif
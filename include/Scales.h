@@ -0,0 +1,97 @@
+#ifndef SCALES_H
+#define SCALES_H
+
+#include <stdint.h>
+
+// --- SCALE LIBRARY ---
+// One table set per scale, built at compile time from a 12-bit pitch-class mask
+// (bit i = i semitones above the root). Note <-> degree conversion is two small
+// table reads plus an octave divide, for any root, with no searching:
+//   degree = octave * len + nearest[pitchClass]
+//   note   = root + octave * 12 + semitone[degree % len]
+
+enum ScaleMode : uint8_t {
+  SCALE_OFF = 0,
+  SCALE_LOCRIAN,
+  SCALE_DIMINISHED,
+  SCALE_ATONAL,
+  SCALE_USER,      // per-channel mask, saved with the pattern
+  SCALE_NUM_MODES
+};
+
+struct ScaleInfo {
+  uint16_t mask;
+  uint8_t len;             // degrees per octave
+  uint8_t semitone[12];    // degree -> semitone above root
+  int8_t nearest[12];      // semitone -> nearest degree (may be -1 or len: adjacent octave)
+};
+
+constexpr uint8_t scaleMaskLen(uint16_t mask) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < 12; i++) if (mask & (1 << i)) n++;
+  return n;
+}
+
+constexpr int8_t scaleAbs(int8_t v) { return v < 0 ? (int8_t)-v : v; }
+
+// Nearest in-scale degree for each semitone. Candidates from the octaves below and
+// above are considered; ties go to the lower note (as the old search did).
+constexpr ScaleInfo makeScale(uint16_t mask) {
+  ScaleInfo s{};
+  mask &= 0x0FFF;
+  if (mask == 0) mask = 1; // an empty scale degenerates to the root only
+  s.mask = mask;
+  s.len = scaleMaskLen(mask);
+  uint8_t d = 0;
+  for (uint8_t i = 0; i < 12; i++) if (mask & (1 << i)) s.semitone[d++] = i;
+  for (int8_t pc = 0; pc < 12; pc++) {
+    int8_t best = 0, bestDist = 127;
+    for (int8_t oct = -1; oct <= 1; oct++) {
+      for (uint8_t i = 0; i < s.len; i++) {
+        int8_t cand = (int8_t)(oct * 12 + s.semitone[i]);
+        int8_t dist = scaleAbs((int8_t)(cand - pc));
+        if (dist < bestDist) { bestDist = dist; best = (int8_t)(oct * s.len + i); }
+      }
+    }
+    s.nearest[pc] = best;
+  }
+  return s;
+}
+
+static const uint16_t SCALE_MASK_LOCRIAN    = 0b010101101011; // 0 1 3 5 6 8 10
+static const uint16_t SCALE_MASK_DIMINISHED = 0b011011011011; // 0 1 3 4 6 7 9 10
+static const uint16_t SCALE_MASK_CHROMATIC  = 0b111111111111;
+
+// Built-in scales, indexed by ScaleMode (OFF and USER map to chromatic here)
+static constexpr ScaleInfo SCALE_TABLE[SCALE_NUM_MODES] = {
+  makeScale(SCALE_MASK_CHROMATIC),
+  makeScale(SCALE_MASK_LOCRIAN),
+  makeScale(SCALE_MASK_DIMINISHED),
+  makeScale(SCALE_MASK_CHROMATIC),
+  makeScale(SCALE_MASK_CHROMATIC),
+};
+
+static_assert(SCALE_TABLE[SCALE_LOCRIAN].len == 7, "locrian has 7 degrees");
+static_assert(SCALE_TABLE[SCALE_DIMINISHED].len == 8, "diminished has 8 degrees");
+static_assert(SCALE_TABLE[SCALE_LOCRIAN].nearest[11] == 6, "B ties to Bb, not C");
+
+static inline int scaleFloorDiv(int a, int b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+
+// Global degree index of the in-scale note nearest to `note`
+static inline int scaleNoteToDegree(const ScaleInfo& s, uint8_t root, int note) {
+  int rel = note - (int)root;
+  int oct = scaleFloorDiv(rel, 12);
+  return oct * s.len + s.nearest[rel - oct * 12];
+}
+
+static inline uint8_t scaleDegreeToNote(const ScaleInfo& s, uint8_t root, int degree) {
+  int oct = scaleFloorDiv(degree, s.len);
+  int n = (int)root + oct * 12 + s.semitone[degree - oct * s.len];
+  return (uint8_t)(n < 0 ? 0 : (n > 127 ? 127 : n));
+}
+
+static inline uint8_t scaleQuantize(const ScaleInfo& s, uint8_t root, uint8_t note) {
+  return scaleDegreeToNote(s, root, scaleNoteToDegree(s, root, note));
+}
+
+#endif
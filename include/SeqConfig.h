@@ -1,7 +1,10 @@
 #ifndef SEQCONFIG_H
 #define SEQCONFIG_H
 
+#include <stdint.h>
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 // Button pins (16 buttons). User mapping: 0-12, 24-26
 static const uint8_t BUTTON_PINS[16] = {0,1,2,3,4,5,6,7,8,9,10,11,12,24,25,26};
@@ -17,7 +20,7 @@ static const int8_t ENC_SW[4] = {36,39,13,20};
 
 // Sequencer parameters
 static const uint8_t NUM_CHANNELS = 4;
-static const uint8_t NUM_STEPS = 16;
+static const uint8_t NUM_STEPS = 16; // up to 64 (Euclid tables are built for 64)
 
 // MIDI TX pin (connect to DIN pin of MIDI OUT optocoupler circuit)
 static const uint8_t MIDI_TX_PIN = 35;
@@ -28,6 +31,9 @@ static const uint8_t START_STOP_PIN = 27;
 
 // Button 28 is used as fill but isnt listed here
 
+// SD project file (Teensy 4.1 built-in slot)
+static const char* const PROJECT_PATH = "/SEQ23.PRJ";
+
 // LED data pin for chained per-step LEDs (single DIN chain)
 static const uint8_t LED_DATA_PIN = 16;
 
@@ -0,0 +1,106 @@
+#ifndef SERIALLINK_H
+#define SERIALLINK_H
+
+#include <stdint.h>
+#include "Crc16.h"
+
+// --- USB SERIAL LINK ---
+// Binary frames share the USB serial port with the single-character console
+// commands. A frame starts with two sync bytes that no command uses, so the
+// parser hands every byte outside a frame back to the console unchanged.
+//
+//   A5 5A | type | seq | len lo | len hi | payload[len] | crc lo | crc hi
+//
+// The CRC (CRC-16/CCITT) covers type through payload. The host sends a request
+// and waits for the reply with the same seq: ACK, NAK (+ error code) or DATA.
+// Objects are moved as whole records, the same bytes the EEPROM slots and the
+// SD project file hold (SaveSlotHeader + bit-packed payload), so a pattern
+// downloaded from one place can be uploaded to any other.
+//
+// A header with an impossible length, or a frame that stalls, leaves the parser
+// discarding: the rest of that frame must not reach the console as commands (a
+// stray 'c' would clear the EEPROM). Bytes are dropped until the next A5 5A, or
+// until the line has been quiet for LINK_DISCARD_IDLE_MS.
+//
+// The parser is byte-at-a-time with no allocation and builds on the host too;
+// tools/seqlink.cpp is the host side.
+
+static const uint8_t LINK_SOF1 = 0xA5;
+static const uint8_t LINK_SOF2 = 0x5A;
+static const uint8_t LINK_PROTOCOL_VERSION = 1;
+static const uint16_t LINK_MAX_PAYLOAD = 1024;
+static const uint8_t LINK_FRAME_OVERHEAD = 8;
+static const uint16_t LINK_MAX_FRAME = LINK_MAX_PAYLOAD + LINK_FRAME_OVERHEAD;
+static const uint32_t LINK_BYTE_TIMEOUT_MS = 250;   // a stalled frame is dropped after this
+static const uint32_t LINK_DISCARD_IDLE_MS = 500;   // quiet line that ends discarding
+
+enum LinkType : uint8_t {
+  // host -> device
+  LINK_PING = 0x01,   // -> ACK { protocol, save version, slots, max payload (2), project records (2), SD ready }
+  LINK_GET  = 0x02,   // { object, index (2) } -> DATA { object, index (2), bytes }
+  LINK_PUT  = 0x03,   // { object, index (2), bytes } -> ACK
+  LINK_STREAM = 0x04, // { on } -> ACK: start / stop telemetry frames
+  // device -> host
+  LINK_ACK  = 0x80,
+  LINK_NAK  = 0x81,   // { LinkError }
+  LINK_DATA = 0x82,
+  LINK_TELEMETRY = 0x83 // unsolicited, own seq: n x 12-byte records (Telemetry.h)
+};
+
+enum LinkObject : uint8_t {
+  LINK_OBJ_PATTERN = 0,   // the pattern in RAM (index ignored)
+  LINK_OBJ_SLOT,          // EEPROM save slot
+  LINK_OBJ_PROJECT,       // SD project record, index = bank * 16 + pattern
+  LINK_OBJ_SETTINGS,      // rig settings: clock, transport, routing, track delay
+  LINK_OBJ_TRACE          // GET: chunk `index` of the event trace; PUT { frozen }
+};
+
+enum LinkError : uint8_t {
+  LINK_ERR_NONE = 0,
+  LINK_ERR_TYPE,          // unknown frame type / object
+  LINK_ERR_RANGE,         // index out of range
+  LINK_ERR_EMPTY,         // nothing stored there
+  LINK_ERR_RECORD,        // record header / CRC / version rejected
+  LINK_ERR_BUSY,          // SD is streaming a cued pattern, retry
+  LINK_ERR_IO,            // storage read / write failed
+  LINK_ERR_NO_SD,         // no SD project open
+  LINK_ERR_FULL           // no room left in EEPROM for the slot record
+};
+
+enum LinkRx : uint8_t {
+  LINK_RX_BUSY = 0,       // byte consumed, frame in progress
+  LINK_RX_PASS,           // not part of a frame: console command byte
+  LINK_RX_FRAME,          // complete frame with good CRC (type / seq / len / payload)
+  LINK_RX_BAD             // frame dropped (CRC or length)
+};
+
+class LinkParser {
+  public:
+    uint8_t type = 0;
+    uint8_t seq = 0;
+    uint16_t len = 0;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+
+    uint32_t frames = 0;
+    uint32_t crcErrors = 0;
+    uint32_t timeouts = 0;
+    uint32_t discarded = 0;   // bytes dropped while resyncing
+
+    LinkRx feed(uint8_t b, uint32_t nowMs);
+    bool inFrame() const { return state != ST_SOF1; }
+
+  private:
+    enum State : uint8_t { ST_SOF1, ST_SOF2, ST_HEADER, ST_PAYLOAD, ST_CRC, ST_DISCARD };
+    State state = ST_SOF1;
+    bool resync = false;      // the A5 in ST_SOF2 was seen while discarding
+    uint8_t header[4];
+    uint16_t pos = 0;
+    uint16_t crc = 0;
+    uint8_t crcBytes[2];
+    uint32_t lastByteMs = 0;
+};
+
+// Build a frame into `out` (at least len + LINK_FRAME_OVERHEAD bytes); returns its length
+uint16_t linkEncode(uint8_t type, uint8_t seq, const uint8_t* payload, uint16_t len, uint8_t* out);
+
+#endif
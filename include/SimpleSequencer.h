@@ -4,12 +4,34 @@
 #include <Adafruit_NeoPixel.h>
 #include <Arduino.h>
 #include "SeqConfig.h"
+#include "SaveFormat.h"
+#include "ProjectStore.h"
+#include "SongMode.h"
+#include "Pattern.h"
+#include "EuclidTables.h"
+#include "Scales.h"
+#include "TrigCondition.h"
+#include "PLockStore.h"
+#include "Modulation.h"
+#include "Arpeggiator.h"
+#include "GrooveTables.h"
+#include "EventQueue.h"
+#include "CycleStat.h"
+#include "Transport.h"
+#include "SerialLink.h"
+#include "Telemetry.h"
+#include "Trace.h"
+#include "BigFont.h"
+#include "LoopScheduler.h"
+#include "UndoLog.h"
 #include <EEPROM.h>
 // OLED
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SH110X.h>
 
+static_assert(NUM_STEPS <= EUCLID_MAX_STEPS, "NUM_STEPS exceeds Euclid table length");
+
 class SimpleSequencer {
   public:
     // step division relative to quarter note (musical denominations)
@@ -22,42 +44,66 @@ class SimpleSequencer {
     void printEncoderRaw();
     void runMidiPinMonitor(uint32_t ms);
     // MIDI input handlers (moved into `runEngine()` to avoid concurrent Serial reads)
-    // MIDI output
-    void midiSendByte(uint8_t b);
-    void midiSendNoteOn(uint8_t channel, uint8_t note, uint8_t vel);
-    void midiSendNoteOff(uint8_t channel, uint8_t note, uint8_t vel);
+    // MIDI output (through the port router: track -> port + channel)
+    void midiSendRealtime(uint8_t b);
+    void midiSendSongPosition(uint16_t beats);
+    void midiSendNoteOn(uint8_t track, uint8_t note, uint8_t vel);
+    void midiSendNoteOff(uint8_t track, uint8_t note, uint8_t vel);
+    void midiSendCC(uint8_t track, uint8_t cc, uint8_t value);
+    void midiSendPitchBend(uint8_t track, uint16_t value);
     // ISR access
     static SimpleSequencer* instancePtr;
     void handleButtonIRQ(uint8_t idx);
     // Engine moved to a 1ms hardware timer: runs MIDI processing and step advancement
     void runEngine();
     void internalClockTick();
+    void transportFire();
 
   private:
-    bool steps[NUM_CHANNELS][NUM_STEPS];
+    // offline renders on the host simulator (tools/enginesim.cpp)
+    friend class EngineSim;
+    // --- PATTERN (see Pattern.h) ---
+    // Steps, per-step parameters, per-track settings, p-locks, modulation and arp
+    // settings all live in the live pattern; a load is decoded into the spare one
+    // and swapped in.
+    Pattern patterns[2];
+    Pattern* pat = &patterns[0];
+    Pattern* sparePattern() { return pat == &patterns[0] ? &patterns[1] : &patterns[0]; }
     bool pendingToggle[NUM_STEPS]; // tracks pending toggle state for each step (p-lock override)
-    bool euclidPattern[NUM_CHANNELS][NUM_STEPS];
-    uint8_t pulses[NUM_CHANNELS];
-    uint8_t euclidOffset[NUM_CHANNELS];
     uint8_t retrig[NUM_CHANNELS];
-    // --- UPDATED: Per-Step Parameter Arrays ---
-    uint8_t pitch[NUM_CHANNELS][NUM_STEPS];  // per-step pitch (MIDI note)
-    uint8_t noteLen[NUM_CHANNELS][NUM_STEPS]; // per-step length index into noteLenTicks
-    uint8_t stepRatchet[NUM_CHANNELS][NUM_STEPS]; // per-step ratchet count (0 = off)
-    // --- ACCENT / SLIDE (TB-303 style) ---
-    uint8_t stepVelocity[NUM_CHANNELS][NUM_STEPS]; // 255 = use channel default
-    bool stepSlide[NUM_CHANNELS][NUM_STEPS];
+    // --- PROBABILITY / CONDITIONAL TRIGS ---
+    uint32_t loopCount = 0;                    // pattern loops since start (A:B, FIRST)
+    bool lastCondPassed[NUM_CHANNELS];         // PRE / !PRE
+    bool seekPending = false;                  // SPP received: Continue plays the seeked step
+    // --- SPARSE P-LOCKS (MIDI CC) ---
+    uint8_t ccLockParam[NUM_CHANNELS];         // CC number edited by Fn + Enc3 on a held step
+    // --- LFO / ENVELOPE MODULATION ---
+    ModEngine mod;
+    static bool modSend(uint8_t track, uint8_t dest, uint16_t value);
+    static bool modSendQueued(uint8_t track, uint8_t dest, uint16_t value);
+    void editModulation(uint8_t enc, int steps);
+    void clickModulation(uint8_t enc);
+    void printModReport();
+    // --- ARPEGGIATOR (see Arpeggiator.h) ---
+    Arpeggiator arp[NUM_CHANNELS];
+    ArpNotes arpChord[NUM_CHANNELS];           // chord of the trig that opened the arp
+    ArpNotes heldNotes;                        // notes held on MIDI input (engine ISR)
+    uint32_t arpGateEnd[NUM_CHANNELS];         // arp plays on ticks before this one
+    uint8_t arpVelocity[NUM_CHANNELS];         // trig velocity for chord hits
+    bool arpSlide[NUM_CHANNELS];               // trig slides: hits play legato
+    bool arpPage = false;                      // Fn + START page shows the arp instead of modulation
+    void handleMidiIn(uint8_t src, const uint8_t* msg, uint8_t len, uint32_t nowMicros);
+    void handleNoteIn(uint8_t status, uint8_t note, uint8_t vel);
+    void openArp(uint8_t ch, uint8_t step, uint8_t note, uint8_t vel, uint32_t tick);
+    void renderArp(uint8_t ch, uint32_t tick);
+    void editArp(uint8_t enc, int steps);
+    void clickArp(uint8_t enc);
+    void drawArpPage();
     int8_t heldStep = -1; // Tracks which button is currently held down (-1 means none)
-    bool euclidEnabled[NUM_CHANNELS];
-    
-    // --- MUTE & MODIFIER STATE ---
-    bool muted[NUM_CHANNELS]; 
+
+    // --- MODIFIER STATE ---
     bool startStopModifierFlag = false; 
-    uint8_t noteLenIdx; // global default length index when no step is held
-    // --- CHANNEL DEFAULT PITCHES ---
-    uint8_t channelPitch[NUM_CHANNELS]; // per-channel base pitch (used when per-step pitch == 255)
     uint8_t lastNotePlaying[NUM_CHANNELS]; // last note sent per channel (for proper NoteOff)
-    uint8_t channelVelocity[NUM_CHANNELS]; // default velocity per channel (0-127)
 
     // runtime
     uint32_t bpm;
@@ -67,57 +113,146 @@ class SimpleSequencer {
     // high-resolution MIDI clock reference moved to file-scope static variable
     Division stepDivision = DIV_SIXTEENTH; // default to 1/16 (16 steps per 4/4 bar)
     // --- TICK-BASED NOTE LENGTH ENGINE ---
-    uint32_t noteOffTick[NUM_CHANNELS];
-    uint32_t absoluteTickCounter = 0;
+    volatile uint32_t absoluteTickCounter = 0;
+    volatile uint32_t lastTickMicros = 0;
+    uint32_t tickPeriodUs() const { return (60000000UL / bpm) / 24; }
+    // --- LOOK-AHEAD RENDERING ---
+    // loop() renders upcoming steps into `events`; the ISRs only drain what is due.
+    EventQueue events;
+    uint16_t renderBase = 0;                // step rendered at tick 0
+    uint32_t renderIndex = 0;               // next step to render, counted from renderBase
+    uint8_t renderNote[NUM_CHANNELS];       // note left sounding by the rendered events
+    uint32_t renderOffTick[NUM_CHANNELS];   // nominal tick of that note's note-off
+    bool renderSlide[NUM_CHANNELS];         // slide flag of the last rendered step
+    // --- GROOVE (see GrooveTables.h) ---
+    int32_t grooveShiftUs[NUM_CHANNELS];    // shift of the step being rendered, added by makeEvent()
+    int32_t renderOffShiftUs[NUM_CHANNELS]; // shift the last rendered note-off was placed with
+    volatile uint32_t lateRenders = 0;      // steps the clock ISR had to render itself
+    CycleStat tickProfile, engineProfile, renderProfile, seekProfile;
+    // --- TRANSPORT (engine-owned, see Transport.h) ---
+    volatile uint8_t transportState = TS_STOPPED;
+    volatile uint8_t transportCmd = TC_NONE;      // posted by the UI, taken by runEngine()
+    volatile uint32_t transportCmdMicros = 0;
+    uint8_t transportQuant = TQ_OFF;
+    bool startOnExtTick = false;                  // armed start waits for an external beat / bar
+    uint32_t startRequestMicros = 0;
+    uint32_t stopIndex = 0;                       // armed stop: first render index not played
+    uint32_t extTickPos = 0;                      // external clock position (Start = 0, SPP)
+    CycleStat startLatencyUs;                     // local start request -> step 0 sent
+    void postTransport(uint8_t cmd);
+    void setTransportState(uint8_t state);
+    void handleTransportCmd(uint8_t cmd, uint32_t postedMicros, uint32_t nowMicros);
+    void transportStart(uint32_t nowMicros);
+    void transportContinue(uint32_t nowMicros);
+    void transportStop(bool rewind);
+    void armStop();
+    uint32_t transportQuantTicks() const;
     // --- FILL / PERFORMANCE MODES ---
     bool fillModeActive = false; // live hold modifier (CHANNEL_BTN_PIN)
-    // per-step Fill memory: 0 = normal, 1 = fill (plays only when Fill held), 2 = anti-fill (never plays)
-    uint8_t fillState[NUM_CHANNELS][NUM_STEPS];
-    uint8_t euclidScaleMode[NUM_CHANNELS];
+    const ScaleInfo& channelScale(uint8_t ch) const {
+      return (pat->euclidScaleMode[ch] == SCALE_USER) ? pat->userScale[ch] : SCALE_TABLE[pat->euclidScaleMode[ch] % SCALE_NUM_MODES];
+    }
     // UI focus helpers
     uint8_t focusEncoder = 0;        // 0 = none, 1-4 = encoder focused
     uint32_t lastEncoderMoveTime = 0;
     const uint32_t focusTimeout = 1500; // ms to keep focus visible
 
-    // --- RATCHET / RETRIG ENGINE ---
-    uint8_t ratchetIntervalTicks[NUM_CHANNELS];
-    uint32_t ratchetNextTick[NUM_CHANNELS];
-    uint32_t ratchetEndTick[NUM_CHANNELS];
-    uint8_t ratchetPitch[NUM_CHANNELS];
     // display (use concrete SH1106G implementation)
     Adafruit_SH1106G display{128, 64, &Wire};
     // --- HARDWARE LED GRID ---
     Adafruit_NeoPixel ledStrip;
     void updateLEDs();
-    uint32_t lastDisplayMillis;
-    const uint32_t displayRefreshMs = 16; // display refresh interval in ms (~60Hz)
+    const uint32_t displayRefreshMs = 40; // display task period in ms (25 Hz; a frame is ~25 ms of I2C)
     void drawDisplay();
+    int16_t drawBig(int16_t x, int16_t y, uint8_t size, const char* text);
     void drawDebugGrid();
+    void drawModPage();
     void bootAnimation();
+    // save/clear flash: drawDisplay() shows it for at least one frame and until
+    // displayHoldUntil, then goes back to the normal views
+    enum DisplayHold : uint8_t { HOLD_NONE, HOLD_SAVED, HOLD_SAVE_FAILED, HOLD_CLEARED };
+    uint8_t displayHold = HOLD_NONE;
+    bool displayHoldDrawn = false;
+    uint8_t displayHoldSlot = 0;
+    uint32_t displayHoldUntil = 0;
+    void holdDisplay(uint8_t what, uint32_t ms);
+    void drawDisplayHold();
 
     // button debounce parameters (Arduino example)
     const unsigned long debounceMs = 10;
     // --- MODIFIER PINS ---
     const uint8_t CHANNEL_BTN_PIN = 28; // channel modifier (hold + Steps 1-4 to select channel)
-    // run state + start/stop button debounce state
-    bool isRunning = false;
+    // run state (set by the transport only) + start/stop button debounce state
+    volatile bool isRunning = false;
     bool startLastReading = false;
     bool startState = false;
     unsigned long startLastDebounceTime = 0;
-    // debug LED for ISR activity
+    // debug LED for ISR activity; the console tests blink it until debugLedOffTime
     volatile bool debugLedFlag;
     uint32_t debugLedOffTime;
 
     void setupPins();
     void readButtons();
-    void updateEuclid(uint8_t ch);
+    void updateEuclid(Pattern& p, uint8_t ch);
+    void updateEuclid(uint8_t ch) { updateEuclid(*pat, ch); }
+    bool isStepActive(uint8_t ch, uint8_t s) const {
+      return pat->euclidEnabled[ch] ? ((pat->euclidPattern[ch] >> s) & 1) : pat->steps[ch][s];
+    }
     void randomizeEuclidMelody(uint8_t ch);
     void readEncoders();
     void shiftEuclidNotes(uint8_t ch, int steps);
-    void triggerChannel(uint8_t ch);
+    void learnUserScale(uint8_t ch);
+    void resetRender(uint16_t fromStep);
+    bool renderStep(uint32_t horizon);
+    void renderAhead();
+    void renderChannel(uint8_t ch, uint8_t step, uint32_t tick);
+    void renderNoteOn(uint8_t ch, uint8_t note, uint8_t vel, uint32_t tick);
+    void renderGate(uint8_t ch, uint8_t note, uint32_t offTick);
+    SeqEvent makeEvent(uint8_t type, uint8_t ch, uint8_t d1, uint8_t d2, uint32_t tick);
+    void pushEvent(uint8_t type, uint8_t ch, uint8_t d1, uint8_t d2, uint32_t tick);
+    void drainEvents(uint32_t nowMicros);
+    void printProfile();
+    void printMidiReport();
+    void handleClockByte(uint8_t src, uint8_t b, uint32_t nowMicros);
+    void handleSongPosition(uint8_t src, uint16_t beats, uint32_t nowMicros);
+    void printClockReport();
+    bool evalTrigCondition(uint8_t ch, uint8_t step);
+    bool trigPasses(uint8_t ch, uint8_t step, uint32_t loop, bool pre) const;
+    bool trigEvaluated(uint8_t ch, uint8_t step) const;
+    void seekTo(uint32_t position);
+    void resetTrigState();
     void clearTrack(uint8_t ch);
+    // --- UNDO / REDO (see UndoLog.h; the log itself is file-static, in DMAMEM) ---
+    uint8_t undoShadow[NUM_CHANNELS][undoTrackBytes(NUM_STEPS)]; // pattern as of the last commit
+    PLockStore undoShadowLocks;
+    volatile bool undoResyncPending = true;   // pattern replaced: the history no longer applies
+    bool undoGesture = false;                 // a step was held since the last commit
+    uint32_t undoSeenMove = 0;                // lastEncoderMoveTime at the last commit
+    uint8_t* undoFieldPtr(uint8_t field, uint8_t ch, uint8_t idx);
+    void undoResync();
+    void undoCommit();
+    void serviceUndo();
+    bool undoEdit(bool redo);
+    static void applyUndoDelta(void* ctx, const UndoDelta& d);
+    // --- PAD PLAY (see handleButtonIRQ()) ---
+    enum PadMode : uint8_t { PAD_OFF = 0, PAD_DRUM, PAD_CHROMATIC, PAD_NUM_MODES };
+    static const uint8_t PAD_DRUM_BASE = 36;  // pad 1 = C1, GM kick; 16 pads up from there
+    static const uint8_t PAD_IDLE = 255, PAD_BUSY = 254;
+    volatile uint8_t padMode = PAD_OFF;
+    volatile uint8_t padNote[NUM_STEPS];      // note sounding from each pad, PAD_IDLE / PAD_BUSY
+    uint8_t padTrack[NUM_STEPS];              // track it was played on
+    volatile uint32_t padEdgeMs[NUM_STEPS];   // last edge acted on, for the bounce lockout
+    CycleStat padLatency;                     // pad edge interrupt -> note-on handed to the port
+    volatile uint32_t padQueued = 0;          // note-ons that waited behind earlier output
+    volatile uint32_t padPolled = 0;          // presses picked up by readButtons() instead
+    volatile uint32_t padDropped = 0;
+    uint8_t padClaim(uint8_t pad, bool press);
+    void padPress(uint8_t pad, uint32_t startCycles);
+    void padRelease(uint8_t pad, uint8_t note);
+    void setPadMode(uint8_t mode);
     // --- EEPROM SAVE SYSTEM ---
-    struct SaveData {
+    // Legacy single-slot layout (magic 13572469). Only read, to migrate into slot 0.
+    struct SaveDataV3 {
       uint32_t magicNumber;
       uint32_t savedBpm;
       uint8_t savedNoteLenIdx;
@@ -137,8 +272,88 @@ class SimpleSequencer {
       uint8_t savedStepSlide[NUM_CHANNELS][NUM_STEPS];
       uint8_t savedChannelVelocity[NUM_CHANNELS];
     };
+    uint8_t saveSlot = 0; // active slot for Fn+Enc1 save and boot restore
     void saveState();
     void loadState();
+    bool saveSlotTo(uint8_t slot);
+    bool writeSlotRecord(uint8_t slot, const uint8_t* rec, uint16_t len);
+    uint16_t readSlotRecord(uint8_t slot, uint8_t* rec);
+    uint16_t readSlotTable(SaveSlotEntry* table);
+    uint16_t compactSlots(SaveSlotEntry* table, uint8_t skip);
+    bool loadSlot(uint8_t slot);
+    bool migrateV3();
+    void convertFixedSlots(uint16_t oldSlotBytes);
+    void clearSavedState();
+    void printSaveReport();
+    uint16_t buildSlotRecord(uint8_t* rec);
+    bool applySlotRecord(const uint8_t* rec);
+    void applyRig(const SaveRig& rig);
+    void setBpm(uint32_t newBpm);
+    void encodePattern(BitWriter& w);
+    bool decodePattern(BitReader& r, uint8_t version, Pattern& p, SaveRig& rig);
+    // --- SD PROJECT STORAGE ---
+    ProjectStore projectStore;
+    bool projectReady = false;
+    volatile uint16_t projectPattern = 0; // record index of the pattern being played
+    volatile int16_t cuedPattern = -1;    // record streaming in
+    volatile int16_t stagedPattern = -1;  // record decoded into the spare, live at the next bar
+    SaveRig stagedRig;                    // its rig settings, applied if it goes live stopped
+    int16_t failedPattern = -1;           // empty or corrupt record, not streamed again
+    void beginProject();
+    bool saveProjectPattern(uint16_t index);
+    bool cueProjectPattern(uint16_t index);
+    void stageCuedPattern();
+    void swapStagedPattern();
+    // --- SONG MODE ---
+    Song song;                  // editable chain (project song 0)
+    Arrangement arrangement;    // compiled bar table the engine walks
+    volatile bool songActive = false;
+    volatile uint16_t songBar = 0;
+    volatile uint32_t songLateBars = 0; // bars that started before their pattern was staged
+    uint8_t songMuteMask = 0;   // per-bar mute override from the arrangement
+    int8_t songTranspose = 0;   // per-bar transpose override
+    void startSong();
+    void stopSong();
+    void resetSongPosition();
+    void advanceSongBar();
+    void prefetchSongPattern();
+    bool appendSongEntry(uint16_t pattern, uint8_t repeats);
+    // --- USB SERIAL LINK (see SerialLink.h) ---
+    LinkParser link;
+    uint8_t linkTx[LINK_MAX_FRAME];
+    void serviceSerial();
+    void handleSerialCommand(char c);
+    void handleLinkFrame();
+    void linkReply(uint8_t type, const uint8_t* payload, uint16_t len);
+    void linkNak(uint8_t err);
+    uint16_t buildLinkSettings(uint8_t* out);
+    bool applyLinkSettings(const uint8_t* in, uint16_t len);
+    // --- TELEMETRY (see Telemetry.h) ---
+    TelemetryRing telemetry;
+    volatile bool telemetryOn = false;
+    uint8_t telemetryStatusTicks = 0;   // engine passes since the last tempo / queue sample
+    uint32_t telemetryFrameMillis = 0;
+    uint8_t telemetrySeq = 0;
+    void telemetryStep(uint32_t nowMicros);
+    void telemetryStatus(uint32_t nowMicros);
+    void serviceTelemetry();
+    // --- LOOP SCHEDULER (see LoopScheduler.h) ---
+    LoopScheduler sched;
+    void beginScheduler();
+    void serviceInput();
+    void serviceStorage();
+    void printSchedReport();
+    // console tests ('t', 'e', 'm') poll from the diag task instead of blocking loop()
+    enum DiagMode : uint8_t { DIAG_NONE = 0, DIAG_SWITCHES, DIAG_ENC_SWITCHES, DIAG_MIDI_PIN };
+    uint8_t diagMode = DIAG_NONE;
+    uint32_t diagStartMillis = 0;
+    uint32_t diagLengthMs = 0;
+    uint32_t diagPollMillis = 0;
+    uint32_t diagLast = 0;              // last polled state, bit per switch
+    uint32_t readDiagState() const;
+    void startDiag(uint8_t mode, uint32_t ms);
+    void serviceDiag();
+    void blinkDebugLed(uint32_t ms);
 };
 
 #endif
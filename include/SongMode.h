@@ -0,0 +1,46 @@
+#ifndef SONGMODE_H
+#define SONGMODE_H
+
+#include <stdint.h>
+
+// --- SONG / CHAIN MODE ---
+// A Song is the editable list of entries (pattern + repeats + overrides). Before
+// playback it is compiled into an Arrangement: one flat row per bar, so at every
+// bar boundary the engine only bumps an index and reads 4 bytes.
+
+static const uint8_t SONG_MAX_ENTRIES = 32;
+static const uint16_t SONG_MAX_BARS = 256;
+static const uint8_t SONG_MAGIC = 0x5B;
+
+struct SongEntry {
+  uint16_t pattern;   // project record index
+  uint8_t repeats;    // bars to play this entry (0 treated as 1)
+  uint8_t muteMask;   // bit per track, muted on top of the pattern's own mutes
+  int8_t transpose;   // semitones added to every note
+  uint8_t reserved;
+};
+
+struct Song {
+  uint8_t magic;      // SONG_MAGIC when valid (unwritten project space reads 0xFF)
+  uint8_t length;     // used entries
+  SongEntry entries[SONG_MAX_ENTRIES];
+};
+
+struct ArrangementBar {
+  uint16_t pattern;
+  uint8_t muteMask;
+  int8_t transpose;
+};
+
+class Arrangement {
+  public:
+    // Flatten a song into bars. Returns the bar count (truncated at SONG_MAX_BARS).
+    uint16_t compile(const Song& song);
+    uint16_t length() const { return count; }
+    const ArrangementBar& bar(uint16_t i) const { return bars[i]; }
+  private:
+    ArrangementBar bars[SONG_MAX_BARS];
+    uint16_t count = 0;
+};
+
+#endif
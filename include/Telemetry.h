@@ -0,0 +1,115 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+// --- ENGINE TELEMETRY ---
+// Fixed 12-byte records (playhead, notes, tempo, queue depths) written by the
+// engine into a ring and sent to the host in LINK_TELEMETRY frames by loop().
+//
+// The ring is single-producer / single-consumer without locks. The producer is
+// the engine: the clock, engine and transport IntervalTimers share the PIT
+// interrupt, so they never preempt each other (UI-side writers disable
+// interrupts around push()). The consumer is loop(). The producer never waits:
+// when the ring is full the oldest records are overwritten and the consumer skips
+// past them. Every record carries the low 16 bits of its ring index, so the host
+// sees exactly how many were lost.
+
+enum TelemetryKind : uint8_t {
+  TEL_STEP = 1,   // a = step, b = TransportState, d = pattern loop count
+  TEL_NOTE,       // a = track, b = note, c = velocity (0 = note-off)
+  TEL_TEMPO,      // a = active ClockSourceId, b = locked mask (bit per source), c = priority, d = BPM x 10
+  TEL_QUEUE,      // a = DIN port depth, b = USB port depth, c = router drops (saturating), d = event queue depth
+  TEL_EDIT,       // a = track, b = step, c = step on
+  TEL_NUM_KINDS
+};
+
+static const char* const TELEMETRY_KIND_NAMES[TEL_NUM_KINDS] = { "?", "step", "note", "tempo", "queue", "edit" };
+
+struct TelemetryRecord {
+  uint16_t seq;
+  uint8_t kind;
+  uint8_t a;
+  uint32_t timeUs;
+  uint8_t b;
+  uint8_t c;
+  uint16_t d;
+};
+
+static const uint8_t TELEMETRY_RECORD_BYTES = 12;     // on the wire, little-endian
+static const uint16_t TELEMETRY_RING = 128;           // power of two
+static const uint8_t TELEMETRY_FRAME_RECORDS = 32;    // records per LINK_TELEMETRY frame
+static const uint16_t TELEMETRY_STATUS_MS = 50;       // tempo / queue sample interval
+static const uint16_t TELEMETRY_FRAME_MS = 10;        // minimum gap between frames
+
+static_assert((TELEMETRY_RING & (TELEMETRY_RING - 1)) == 0, "TELEMETRY_RING must be a power of two");
+
+static inline void telemetryPack(const TelemetryRecord& r, uint8_t* out) {
+  out[0] = r.seq & 0xFF;
+  out[1] = r.seq >> 8;
+  out[2] = r.kind;
+  out[3] = r.a;
+  out[4] = r.timeUs & 0xFF;
+  out[5] = (r.timeUs >> 8) & 0xFF;
+  out[6] = (r.timeUs >> 16) & 0xFF;
+  out[7] = r.timeUs >> 24;
+  out[8] = r.b;
+  out[9] = r.c;
+  out[10] = r.d & 0xFF;
+  out[11] = r.d >> 8;
+}
+
+static inline void telemetryUnpack(const uint8_t* in, TelemetryRecord& r) {
+  r.seq = in[0] | (in[1] << 8);
+  r.kind = in[2];
+  r.a = in[3];
+  r.timeUs = in[4] | (in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+  r.b = in[8];
+  r.c = in[9];
+  r.d = in[10] | (in[11] << 8);
+}
+
+class TelemetryRing {
+  public:
+    // Producer (engine). Never blocks.
+    void push(uint8_t kind, uint32_t timeUs, uint8_t a, uint8_t b = 0, uint8_t c = 0, uint16_t d = 0) {
+      uint32_t h = head;
+      TelemetryRecord& r = ring[h & (TELEMETRY_RING - 1)];
+      r.seq = (uint16_t)h;
+      r.kind = kind;
+      r.a = a;
+      r.timeUs = timeUs;
+      r.b = b;
+      r.c = c;
+      r.d = d;
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+      head = h + 1;
+    }
+
+    // Consumer (loop). Skips whatever the producer overwrote.
+    bool pop(TelemetryRecord& out) {
+      for (;;) {
+        uint32_t h = head;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (h - tail > TELEMETRY_RING) { dropped += h - tail - TELEMETRY_RING; tail = h - TELEMETRY_RING; }
+        if (tail == h) return false;
+        out = ring[tail & (TELEMETRY_RING - 1)];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        // lapped while copying: the slot now holds a newer record
+        if (head - tail > TELEMETRY_RING) continue;
+        tail++;
+        return true;
+      }
+    }
+
+    void clear() { tail = head; }
+    uint32_t written() const { return head; }
+    uint32_t dropped = 0;
+
+  private:
+    TelemetryRecord ring[TELEMETRY_RING];
+    volatile uint32_t head = 0;
+    uint32_t tail = 0;
+};
+
+#endif
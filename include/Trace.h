@@ -0,0 +1,136 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "IrqLock.h"
+
+// --- EVENT TRACE ---
+// Flight recorder for the engine: a fixed ring of 8-byte records (cycle counter,
+// event id, two small arguments) that always runs and overwrites the oldest entry.
+// Nothing is formatted on the device; the ids index the format table below, which
+// only the host decoder uses (tools/seqlink.cpp: text dump and Chrome trace JSON).
+//
+// Recording is a handful of instructions: save PRIMASK + cpsid, four stores into
+// the slot, bump the index, restore PRIMASK. Masking keeps the loop and the
+// interrupts from claiming the same slot, and restores rather than re-enables, so
+// it is safe inside noInterrupts() sections. Build with -D SEQ_NO_TRACE to compile
+// every record call out.
+//
+// ISR entry / exit is stored as one record at exit carrying the duration, so a
+// handler costs one slot instead of two. The engine pass is only recorded when it
+// did work or ran long; TR_HEARTBEAT once a second keeps the cycle counter (which
+// wraps every ~7 s at 600 MHz) unambiguous for the host.
+
+// id, name, Chrome trace thread, host format (%1$u = a, %2$u = b, %3$u = b & 0xFF, %4$u = b >> 8)
+#define TRACE_EVENTS(X) \
+  X(TR_NONE,        "none",        0, "") \
+  X(TR_TICK,        "tick",        1, "tick %2$u") \
+  X(TR_CLOCK_ISR,   "clock isr",   1, "clock isr %2$u x16 cycles") \
+  X(TR_ENGINE_ISR,  "engine isr",  2, "engine isr %2$u x16 cycles, %1$u events") \
+  X(TR_STEP,        "step",        2, "step %1$u loop %2$u") \
+  X(TR_NOTE_ON,     "note on",    10, "track %1$u note on %3$u vel %4$u") \
+  X(TR_NOTE_OFF,    "note off",   10, "track %1$u note off %3$u") \
+  X(TR_RATCHET,     "ratchet",    10, "track %1$u ratchet %3$u vel %4$u") \
+  X(TR_CLOCK_IN,    "clock in",    4, "source %1$u byte 0x%2$02X") \
+  X(TR_SPP_IN,      "spp in",      4, "source %1$u song position %2$u") \
+  X(TR_CLOCK_OUT,   "clock out",   5, "realtime out 0x%2$02X") \
+  X(TR_TRANSPORT,   "transport",   6, "transport state %1$u") \
+  X(TR_FAILOVER,    "failover",    6, "clock lost source %1$u, now %2$u") \
+  X(TR_RENDER,      "render",      3, "render step %1$u %2$u x16 cycles") \
+  X(TR_LATE_RENDER, "late render", 1, "step %1$u rendered in the clock isr") \
+  X(TR_PLOCK_FULL,  "plock full",  3, "p-lock table full (track %1$u step %2$u)") \
+  X(TR_HEARTBEAT,   "heartbeat",   2, "heartbeat %2$u s")
+
+#define TRACE_ID(id, name, thread, fmt) id,
+enum TraceId : uint8_t { TRACE_EVENTS(TRACE_ID) TR_NUM_IDS };
+#undef TRACE_ID
+
+struct TraceInfo {
+  const char* name;
+  uint8_t thread;
+  const char* format;
+};
+
+#define TRACE_INFO(id, name, thread, fmt) { name, thread, fmt },
+static const TraceInfo TRACE_INFO_TABLE[TR_NUM_IDS] = { TRACE_EVENTS(TRACE_INFO) };
+#undef TRACE_INFO
+
+struct TraceRecord {
+  uint32_t cycles;
+  uint8_t id;
+  uint8_t a;
+  uint16_t b;
+};
+
+static const uint16_t TRACE_RING = 4096;              // records (32 KB), power of two
+static const uint8_t TRACE_RECORD_BYTES = 8;          // on the wire, little-endian
+static const uint8_t TRACE_CHUNK_HEADER = 8;          // total (2), cycles per us (2), first (2), reserved (2)
+static const uint8_t TRACE_CHUNK_RECORDS = 120;       // per LINK_DATA reply
+static const uint16_t TRACE_ENGINE_MIN_CYCLES = 3000; // idle engine passes shorter than this are not recorded
+
+static_assert((TRACE_RING & (TRACE_RING - 1)) == 0, "TRACE_RING must be a power of two");
+
+// Duration in 16-cycle units, saturating, for the ISR records
+static inline uint16_t traceDuration(uint32_t cycles) {
+  return cycles >= (65535UL << 4) ? 65535 : (uint16_t)(cycles >> 4);
+}
+
+static inline void tracePack(const TraceRecord& r, uint8_t* out) {
+  out[0] = r.cycles & 0xFF;
+  out[1] = (r.cycles >> 8) & 0xFF;
+  out[2] = (r.cycles >> 16) & 0xFF;
+  out[3] = r.cycles >> 24;
+  out[4] = r.id;
+  out[5] = r.a;
+  out[6] = r.b & 0xFF;
+  out[7] = r.b >> 8;
+}
+
+static inline void traceUnpack(const uint8_t* in, TraceRecord& r) {
+  r.cycles = in[0] | (in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+  r.id = in[4];
+  r.a = in[5];
+  r.b = in[6] | (in[7] << 8);
+}
+
+class TraceRing {
+  public:
+    inline void record(uint8_t id, uint8_t a = 0, uint16_t b = 0) {
+#ifndef SEQ_NO_TRACE
+#ifdef ARDUINO
+      uint32_t primask = irqSave();
+      uint32_t now = ARM_DWT_CYCCNT;
+#else
+      uint32_t now = head;
+#endif
+      if (!frozen){
+        TraceRecord& r = ring[head & (TRACE_RING - 1)];
+        r.cycles = now;
+        r.id = id;
+        r.a = a;
+        r.b = b;
+        head++;
+      }
+#ifdef ARDUINO
+      irqRestore(primask);
+#endif
+#endif
+    }
+
+    // Empty and running (the ring lives in DMAMEM, which isn't zeroed at boot)
+    void reset() { head = 0; frozen = false; }
+    // Frozen, the ring keeps its contents (for a dump after something went wrong)
+    void freeze(bool on) { frozen = on; }
+    bool isFrozen() const { return frozen; }
+    // Oldest-first view of what the ring holds; only stable while frozen
+    uint16_t count() const { return head < TRACE_RING ? (uint16_t)head : TRACE_RING; }
+    const TraceRecord& at(uint16_t i) const { return ring[(head - count() + i) & (TRACE_RING - 1)]; }
+    uint32_t recorded() const { return head; }
+
+  private:
+    TraceRecord ring[TRACE_RING];
+    volatile uint32_t head = 0;
+    volatile bool frozen = false;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+
+// --- TRANSPORT STATE MACHINE ---
+// Owned by the engine. The UI only posts a command (single slot, taken by
+// runEngine() on its next 1 ms pass); external Start / Continue / Stop / SPP are
+// applied by the engine directly. Local and external starts run the same code, so
+// they send the same bytes.
+//
+//   STOPPED --start--> START_ARMED --(lead time | quantised external tick)--> RUNNING
+//   RUNNING --stop---> STOP_ARMED  --(next beat / bar boundary)-------------> STOPPED
+//
+// A local start is fired from a one-shot timer a fixed lead time after the button
+// was seen, so the first note always leaves TRANSPORT_START_LEAD_US after the
+// request instead of wherever the UI loop or the 1 ms engine pass happened to be.
+// With quantise on, a start while an external clock is running waits for the next
+// beat / bar of that clock, and a stop waits for the next beat / bar of the pattern.
+
+enum TransportState : uint8_t { TS_STOPPED = 0, TS_START_ARMED, TS_RUNNING, TS_STOP_ARMED };
+enum TransportCmd : uint8_t { TC_NONE = 0, TC_TOGGLE };
+enum TransportQuant : uint8_t { TQ_OFF = 0, TQ_BEAT, TQ_BAR, TQ_NUM_MODES };
+
+static const char* const TRANSPORT_QUANT_NAMES[TQ_NUM_MODES] = { "off", "beat", "bar" };
+static const uint32_t TRANSPORT_START_LEAD_US = 2000; // > one engine pass
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef TRIGCONDITION_H
+#define TRIGCONDITION_H
+
+#include <stdint.h>
+
+// --- COUNTER-BASED TRIG RANDOMNESS ---
+// The dice roll for a probability trig is a hash of (pattern seed, track, loop,
+// step) rather than the next value of a running PRNG. A run still replays exactly
+// from its seed, and any song position can be evaluated directly, which makes
+// Song Position Pointer seeks O(1). Two murmur3 finalizer rounds, no divide.
+static inline uint32_t trigMix(uint32_t x) {
+  x ^= x >> 16; x *= 0x85EBCA6BUL;
+  x ^= x >> 13; x *= 0xC2B2AE35UL;
+  x ^= x >> 16;
+  return x;
+}
+
+// Uniform in [0, n) via multiply-shift instead of modulo
+static inline uint32_t trigRandom(uint32_t seed, uint8_t ch, uint32_t loop, uint8_t step, uint32_t n) {
+  uint32_t h = trigMix(trigMix(seed ^ (0x9E3779B9UL * (ch + 1)) ^ loop) ^ step);
+  return (uint32_t)(((uint64_t)h * n) >> 32);
+}
+
+// --- CONDITIONAL TRIGS (Elektron style) ---
+// 0 = always, then FIRST / !FIRST / PRE / !PRE, then every A:B pair for B = 2..8
+// (A:B plays on loop A of every B loops). Fill / !Fill stay on fillState.
+enum TrigCondition : uint8_t {
+  TRIG_ALWAYS = 0,
+  TRIG_FIRST,      // first loop since start
+  TRIG_NOT_FIRST,
+  TRIG_PRE,        // previous evaluated condition on this track passed
+  TRIG_NOT_PRE,
+  TRIG_AB_BASE     // TRIG_AB_BASE + index of (A,B)
+};
+
+static const uint8_t TRIG_AB_MAX_B = 8;
+static const uint8_t TRIG_AB_COUNT = 35; // sum of B for B = 2..8
+static const uint8_t TRIG_NUM_CONDITIONS = TRIG_AB_BASE + TRIG_AB_COUNT;
+
+struct TrigAB { uint8_t a, b; };
+
+struct TrigABTable { TrigAB ab[TRIG_AB_COUNT]; };
+
+constexpr TrigABTable makeTrigABTable() {
+  TrigABTable t{};
+  uint8_t i = 0;
+  for (uint8_t b = 2; b <= TRIG_AB_MAX_B; b++)
+    for (uint8_t a = 1; a <= b; a++) t.ab[i++] = TrigAB{a, b};
+  return t;
+}
+
+static constexpr TrigABTable TRIG_AB_TABLE = makeTrigABTable();
+
+static inline TrigAB trigConditionAB(uint8_t cond) {
+  return TRIG_AB_TABLE.ab[cond - TRIG_AB_BASE];
+}
+
+// Short label for the OLED, e.g. "1:4", "1ST", "!PRE"
+static inline void trigConditionName(uint8_t cond, char* out) {
+  static const char* const names[TRIG_AB_BASE] = {"ALL", "1ST", "!1ST", "PRE", "!PRE"};
+  if (cond < TRIG_AB_BASE) {
+    const char* n = names[cond];
+    while ((*out++ = *n++)) {}
+    return;
+  }
+  TrigAB ab = trigConditionAB(cond);
+  out[0] = '0' + ab.a; out[1] = ':'; out[2] = '0' + ab.b; out[3] = 0;
+}
+
+#endif
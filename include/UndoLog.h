@@ -0,0 +1,107 @@
+#ifndef UNDOLOG_H
+#define UNDOLOG_H
+
+#include <stdint.h>
+
+// --- UNDO / REDO DELTA LOG ---
+// Pattern edits are kept as a ring of 5-byte deltas: which byte changed (field,
+// track, index, param) and old XOR new. XOR makes a delta its own inverse, so undo
+// and redo apply the same record and nothing but the change is stored. Each edit
+// (one held-step gesture, one encoder turn, one Clear Track) is a run of deltas,
+// the first flagged; undo walks the newest run backwards, redo walks it forwards,
+// so either costs the size of that one edit whatever the history length. When the
+// ring is full the oldest edits are dropped whole.
+//
+// The sequencer finds the deltas by diffing the pattern against a shadow copy
+// when an edit gesture ends (see SimpleSequencer::undoCommit()), so edit paths
+// don't have to report their writes.
+
+static const uint16_t UNDO_LOG_RECORDS = 768;   // 3840 B
+
+// What a delta points at. Step fields are indexed by step, track fields by 0, the
+// multi-byte ones by byte.
+enum UndoField : uint8_t {
+  UF_STEP_ON = 0,
+  UF_PITCH,
+  UF_LEN,
+  UF_RATCHET,
+  UF_VELOCITY,
+  UF_SLIDE,
+  UF_PROB,
+  UF_COND,
+  UF_FILL,
+  UF_EUCLID_ON,
+  UF_PULSES,
+  UF_OFFSET,
+  UF_EUCLID_MODE,
+  UF_SCALE,
+  UF_SCALE_ROOT,
+  UF_USER_SCALE,     // userScaleMask, 2 bytes
+  UF_CH_PITCH,
+  UF_CH_VELOCITY,
+  UF_EUCLID_BITS,    // euclidPattern, 8 bytes
+  UF_NUM_BYTE_FIELDS,
+  UF_PLOCK = UF_NUM_BYTE_FIELDS,  // index = step, param = CC; 0xFF = no lock
+};
+
+static const uint8_t UNDO_STEP_FIELDS = UF_FILL + 1;
+// Bytes per track of each field after the step fields, UF_EUCLID_ON .. UF_EUCLID_BITS
+static constexpr uint8_t UNDO_TRACK_FIELD_BYTES[UF_NUM_BYTE_FIELDS - UNDO_STEP_FIELDS] = { 1, 1, 1, 1, 1, 1, 2, 1, 1, 8 };
+
+constexpr uint16_t undoFieldBytes(uint8_t field, uint8_t steps) {
+  return field < UNDO_STEP_FIELDS ? steps : UNDO_TRACK_FIELD_BYTES[field - UNDO_STEP_FIELDS];
+}
+// Where a field starts in a track's shadow copy
+constexpr uint16_t undoFieldOffset(uint8_t field, uint8_t steps) {
+  uint16_t n = 0;
+  for (uint8_t f = 0; f < field; f++) n += undoFieldBytes(f, steps);
+  return n;
+}
+constexpr uint16_t undoTrackBytes(uint8_t steps) { return undoFieldOffset(UF_NUM_BYTE_FIELDS, steps); }
+
+struct UndoDelta {
+  uint8_t field;   // UndoField, UNDO_EDIT_START on an edit's first delta
+  uint8_t track;
+  uint8_t index;
+  uint8_t param;
+  uint8_t x;       // old ^ new
+};
+
+static const uint8_t UNDO_EDIT_START = 0x80;
+
+class UndoLog {
+  public:
+    typedef void (*ApplyFn)(void* ctx, const UndoDelta& d);
+
+    void clear();
+    // clear() plus the stats, for storage that isn't zeroed at boot (DMAMEM)
+    void reset() { clear(); dropped = 0; }
+    // The next record() starts a new edit
+    void beginEdit() { open = false; }
+    // Add a delta to the current edit; drops any redo history
+    void record(uint8_t field, uint8_t track, uint8_t index, uint8_t param, uint8_t x);
+    // Revert the newest edit / re-apply the next undone one. False if there is none.
+    bool undo(ApplyFn fn, void* ctx);
+    bool redo(ApplyFn fn, void* ctx);
+
+    uint16_t undoLevels() const { return levels; }
+    uint16_t redoLevels() const { return redoable; }
+    uint16_t records() const { return total; }
+    uint32_t droppedEdits() const { return dropped; }
+
+  private:
+    UndoDelta ring[UNDO_LOG_RECORDS];
+    uint16_t tail = 0;      // ring index of the oldest delta
+    uint16_t applied = 0;   // deltas from tail that are in effect
+    uint16_t total = 0;     // deltas from tail, redo history included
+    uint16_t editStart = 0; // offset from tail of the open edit's first delta
+    uint16_t levels = 0, redoable = 0;
+    uint32_t dropped = 0;
+    bool open = false;
+    bool overflow = false; // current edit is larger than the ring: not kept
+
+    static uint16_t wrap(uint16_t i) { return i % UNDO_LOG_RECORDS; }
+    bool dropOldest();
+};
+
+#endif
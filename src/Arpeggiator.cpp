@@ -0,0 +1,74 @@
+#include "Arpeggiator.h"
+#include <string.h>
+
+bool ArpNotes::add(uint8_t note, uint8_t vel){
+  if (count >= ARP_MAX_NOTES) return false;
+  uint8_t i = 0;
+  while (i < count && sorted[i] < note) i++;
+  if (i < count && sorted[i] == note) return false;
+  memmove(&sorted[i + 1], &sorted[i], count - i);
+  memmove(&sortedVel[i + 1], &sortedVel[i], count - i);
+  sorted[i] = note;
+  sortedVel[i] = vel;
+  order[count] = note;
+  orderVel[count] = vel;
+  count++;
+  return true;
+}
+
+void ArpNotes::remove(uint8_t note){
+  uint8_t i = 0;
+  while (i < count && sorted[i] != note) i++;
+  if (i == count) return;
+  memmove(&sorted[i], &sorted[i + 1], count - i - 1);
+  memmove(&sortedVel[i], &sortedVel[i + 1], count - i - 1);
+  i = 0;
+  while (order[i] != note) i++;
+  memmove(&order[i], &order[i + 1], count - i - 1);
+  memmove(&orderVel[i], &orderVel[i + 1], count - i - 1);
+  count--;
+}
+
+void Arpeggiator::restart(){
+  countdown = 0;
+  pos = 0;
+  rnd = 0x9E3779B9UL;
+}
+
+bool Arpeggiator::tick(const ArpParams& params, const ArpNotes& set, ArpHit& hit){
+  if (countdown) { countdown--; return false; }
+  countdown = ARP_RATE_TICKS[params.rateIdx % ARP_NUM_RATES] - 1;
+  uint8_t n = set.count;
+  if (n == 0) return false;
+  uint8_t octaves = (params.octaves >= 1 && params.octaves <= ARP_MAX_OCTAVES) ? params.octaves : 1;
+  uint8_t len = n * octaves;
+  // the set may have shrunk since the last hit
+  if (pos >= len) pos = 0;
+
+  uint8_t idx;
+  switch (params.mode){
+    case ARP_DOWN:
+      idx = len - 1 - pos;
+      break;
+    case ARP_RANDOM:
+      rnd ^= rnd << 13;
+      rnd ^= rnd >> 17;
+      rnd ^= rnd << 5;
+      idx = rnd % len;
+      break;
+    default:
+      idx = pos;
+      break;
+  }
+  if (++pos >= len) pos = 0;
+
+  uint8_t i = idx % n;
+  uint8_t octave = idx / n;
+  bool arrival = params.mode == ARP_ORDER;
+  uint8_t note = arrival ? set.order[i] : set.sorted[i];
+  hit.vel = arrival ? set.orderVel[i] : set.sortedVel[i];
+  // fold octaves that run off the top of the MIDI range back down
+  while (octave && note + 12 * octave > 127) octave--;
+  hit.note = note + 12 * octave;
+  return true;
+}
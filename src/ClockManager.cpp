@@ -0,0 +1,139 @@
+#include "ClockManager.h"
+#include "MemPlacement.h"
+
+void ClockManager::begin(uint8_t priority){
+  for (uint8_t i = 0; i < CLOCK_SRC_INTERNAL; i++) srcs[i] = Source();
+  activeSrc = CLOCK_SRC_INTERNAL;
+  switchGuard = false;
+  startTick = false;
+  setPriority(priority);
+}
+
+void ClockManager::setPriority(uint8_t p){
+  prio = p < CLOCK_NUM_PRIORITIES ? p : 0;
+  // a source that is now switched off can't stay in charge
+  if (external() && rank(activeSrc) == CLOCK_RANK_OFF) activeSrc = CLOCK_SRC_INTERNAL;
+}
+
+FASTRUN void ClockManager::record(Source& s, uint32_t nowMicros){
+  if (s.valid && nowMicros - s.lastUs > CLOCK_MAX_PERIOD_US) { s.valid = 0; s.index = 0; }
+  s.stamps[s.index] = nowMicros;
+  s.index = (s.index + 1) % CLOCK_WINDOW;
+  if (s.valid < CLOCK_WINDOW) s.valid++;
+  s.lastUs = nowMicros;
+}
+
+uint32_t ClockManager::sourcePeriod(const Source& s) const {
+  if (s.valid < 2) return 0;
+  uint32_t newest = s.stamps[(s.index + CLOCK_WINDOW - 1) % CLOCK_WINDOW];
+  uint32_t oldest = s.stamps[(s.index + CLOCK_WINDOW - s.valid) % CLOCK_WINDOW];
+  return (newest - oldest) / (s.valid - 1);
+}
+
+uint32_t ClockManager::periodUs() const {
+  return external() ? sourcePeriod(srcs[activeSrc]) : 0;
+}
+
+bool ClockManager::settled() const {
+  return external() && srcs[activeSrc].valid >= CLOCK_WINDOW;
+}
+
+bool ClockManager::alive(uint8_t src, uint32_t nowMicros) const {
+  if (src >= CLOCK_SRC_INTERNAL) return true;
+  if (rank(src) == CLOCK_RANK_OFF || srcs[src].valid < CLOCK_LOCK_TICKS) return false;
+  uint32_t period = sourcePeriod(srcs[src]);
+  return nowMicros - srcs[src].lastUs <= period + grace(period);
+}
+
+void ClockManager::takeOver(uint8_t src, uint32_t nowMicros){
+  activeSrc = src;
+  activeSinceUs = nowMicros;
+  switchGuard = true;
+  startTick = false;
+}
+
+FASTRUN ClockManager::Event ClockManager::onRealtime(uint8_t src, uint8_t b, uint32_t nowMicros){
+  if (src >= CLOCK_SRC_INTERNAL) return CLK_NONE;
+  Source& s = srcs[src];
+  if (b == 0xF8){
+    record(s, nowMicros);
+    if (rank(src) == CLOCK_RANK_OFF) return CLK_NONE;
+    if (src != activeSrc){
+      // a higher-ranked source takes over once it has a steady tempo
+      if (s.valid < CLOCK_LOCK_TICKS || rank(src) >= rank(activeSrc)) return CLK_NONE;
+      takeOver(src, nowMicros);
+    }
+    if (startTick){
+      // tick 0, already played by Start
+      startTick = false;
+      lastEngineTickUs = nowMicros;
+      return CLK_NONE;
+    }
+    if (switchGuard){
+      // first tick after a switch: the previous source may already have played it
+      uint32_t period = sourcePeriod(s);
+      if (period && nowMicros - lastEngineTickUs < period / 2) { swallowed++; return CLK_NONE; }
+      switchGuard = false;
+    }
+    lastEngineTickUs = nowMicros;
+    return CLK_TICK;
+  }
+  if (b != 0xFA && b != 0xFB && b != 0xFC) return CLK_NONE;
+  if (!controlsTransport(src, nowMicros)) return CLK_NONE;
+  if (b == 0xFA){
+    lastEngineTickUs = nowMicros; // Start plays tick 0 now
+    switchGuard = false;
+    startTick = true;
+    return CLK_START;
+  }
+  startTick = false;
+  return b == 0xFB ? CLK_CONTINUE : CLK_STOP;
+}
+
+ClockManager::Event ClockManager::onSongPosition(uint8_t src, uint32_t nowMicros){
+  if (src >= CLOCK_SRC_INTERNAL || !controlsTransport(src, nowMicros)) return CLK_NONE;
+  return CLK_SEEK;
+}
+
+// Transport follows the active source; an equal or higher-ranked one takes control
+bool ClockManager::controlsTransport(uint8_t src, uint32_t nowMicros){
+  if (rank(src) == CLOCK_RANK_OFF || rank(src) > rank(activeSrc)) return false;
+  if (src != activeSrc) takeOver(src, nowMicros);
+  return true;
+}
+
+FASTRUN bool ClockManager::poll(uint32_t nowMicros){
+  if (!external()) return false;
+  Source& s = srcs[activeSrc];
+  uint32_t period = sourcePeriod(s);
+  uint32_t ref = s.valid ? s.lastUs : activeSinceUs;
+  uint32_t limit = period ? period + grace(period) : CLOCK_MAX_PERIOD_US;
+  if (nowMicros - ref <= limit) return false;
+
+  // Dropped: hand over to the best remaining source
+  lastLost = activeSrc;
+  failovers++;
+  uint8_t next = CLOCK_SRC_INTERNAL;
+  for (uint8_t i = 0; i < CLOCK_SRC_INTERNAL; i++){
+    if (i != activeSrc && alive(i, nowMicros) && rank(i) < rank(next)) next = i;
+  }
+  fillPeriodUs = period;
+  if (period){
+    // the missed tick belongs on the grid of the last estimate
+    gridUs = s.lastUs + period;
+    lastGapUs = nowMicros - s.lastUs;
+    lastPhaseErrUs = nowMicros - gridUs;
+    if (lastPhaseErrUs > maxPhaseErrUs) maxPhaseErrUs = lastPhaseErrUs;
+    lastEngineTickUs = nowMicros;
+  } else {
+    gridUs = nowMicros;
+  }
+  // the lost source has to lock again before it can take back over
+  s.valid = 0;
+  s.index = 0;
+  takeOver(next, nowMicros);
+  // a new external source that already ticked nearer the missed tick than the last
+  // one delivered it: the fill stands for that tick and its next one is new
+  if (period && next != CLOCK_SRC_INTERNAL && (int32_t)(srcs[next].lastUs - (gridUs - period / 2)) > 0) switchGuard = false;
+  return true;
+}
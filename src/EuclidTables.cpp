@@ -0,0 +1,8 @@
+#include "MemPlacement.h"
+#include "EuclidTables.h"
+
+// Built entirely by the compiler; PROGMEM keeps the ~34 KB out of DTCM.
+PROGMEM const EuclidTable euclidTables[EUCLID_NUM_MODES] = {
+  makeEuclidTable(EUCLID_BRESENHAM),
+  makeEuclidTable(EUCLID_BJORKLUND),
+};
@@ -0,0 +1,20 @@
+#include "GrooveTables.h"
+#include "MemPlacement.h"
+#include "GrooveImports.h"
+
+// Built by the compiler, read from flash (see MemPlacement.h)
+PROGMEM const GrooveTemplate grooveTables[] = {
+  makeGroove("OFF", 1),
+  makeSwing("SWING 54", 54),
+  makeSwing("SWING 58", 58),
+  makeSwing("SWING 62", 62),
+  makeSwing("SWING 66", 66),
+  makeSwing("SWING 70", 70),
+  GROOVE_IMPORTS
+};
+
+const uint8_t grooveCount = sizeof(grooveTables) / sizeof(grooveTables[0]);
+
+// Saved indices must keep meaning the same groove: imports only ever go after
+// the built-ins, and re-running groove2h with a file removed renumbers them
+static_assert(sizeof(grooveTables) / sizeof(grooveTables[0]) <= GROOVE_MAX_TEMPLATES, "too many grooves for the saved index");
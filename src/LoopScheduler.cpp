@@ -0,0 +1,78 @@
+#include "LoopScheduler.h"
+
+void LoopScheduler::begin(ClockFn clock, IdleFn idleFn){
+  now = clock;
+  idle = idleFn;
+  count = 0;
+  resetStats();
+}
+
+int8_t LoopScheduler::addTask(const char* name, TaskFn fn, void* ctx, uint32_t periodUs, uint32_t budgetUs, uint32_t deadlineUs){
+  if (count >= SCHED_MAX_TASKS || !fn || periodUs == 0) return -1;
+  Task& t = tasks[count];
+  t.name = name;
+  t.fn = fn;
+  t.ctx = ctx;
+  t.periodUs = periodUs;
+  t.budgetUs = budgetUs;
+  t.deadlineUs = deadlineUs;
+  t.nextDue = now() + periodUs;
+  t.heldNow = false;
+  t.stats = SchedTaskStats();
+  return (int8_t)count++;
+}
+
+void LoopScheduler::resetStats(){
+  for (uint8_t i = 0; i < count; i++) tasks[i].stats = SchedTaskStats();
+  idleTotalUs = 0;
+  windowStart = now();
+}
+
+// Starting task i at `t` keeps every higher-priority task within its deadline
+bool LoopScheduler::fits(uint8_t i, uint32_t t) const {
+  const Task& task = tasks[i];
+  if ((int32_t)(t - (task.nextDue + task.deadlineUs)) > 0) return true;
+  for (uint8_t j = 0; j < i; j++){
+    uint32_t latest = tasks[j].nextDue + tasks[j].deadlineUs;
+    if ((int32_t)(latest - (t + task.budgetUs)) < 0) return false;
+  }
+  return true;
+}
+
+void LoopScheduler::run(Task& task, uint32_t t){
+  uint32_t late = t - task.nextDue;
+  if (late > task.stats.maxLateUs) task.stats.maxLateUs = late;
+  if (late > task.deadlineUs) task.stats.missed++;
+  task.heldNow = false;
+  task.fn(task.ctx);
+  uint32_t used = now() - t;
+  task.stats.runs++;
+  task.stats.totalUs += used;
+  if (used > task.stats.maxUs) task.stats.maxUs = used;
+  if (used > task.budgetUs) task.stats.overBudget++;
+  // next release; a task that fell a whole period behind drops the missed ones
+  task.nextDue += task.periodUs;
+  if ((int32_t)(t - task.nextDue) >= 0) task.nextDue = t + task.periodUs;
+}
+
+void LoopScheduler::runOnce(){
+  if (count == 0) return;
+  uint32_t t = now();
+  // wake-up time if nothing runs: the next release, or a held task's deadline
+  uint32_t until = t + 0x7FFFFFFFUL;
+  for (uint8_t i = 0; i < count; i++){
+    Task& task = tasks[i];
+    uint32_t wake = task.nextDue;
+    if ((int32_t)(t - task.nextDue) >= 0){
+      if (fits(i, t)) { run(task, t); return; }
+      if (!task.heldNow) { task.heldNow = true; task.stats.held++; }
+      wake = task.nextDue + task.deadlineUs + 1;
+    }
+    if ((int32_t)(wake - until) < 0) until = wake;
+  }
+  uint32_t idleStart = now();
+  while ((int32_t)(now() - until) < 0){
+    if (idle) idle();
+  }
+  idleTotalUs += now() - idleStart;
+}
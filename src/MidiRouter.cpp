@@ -0,0 +1,248 @@
+#include "MidiRouter.h"
+#include "MemPlacement.h"
+#include "IrqLock.h"
+
+// Entry points run from the engine and clock ISRs and from loop(), sometimes
+// inside the caller's own critical section: irqSave() / irqRestore() hand back
+// the interrupt state the caller had.
+
+void MidiRouter::begin(ClockFn clock){
+  now = clock;
+  for (uint8_t t = 0; t < MIDI_MAX_TRACKS; t++) route[t] = TrackRoute{MIDI_PORT_DIN, (uint8_t)(t & 0x0F)};
+}
+
+bool MidiRouter::addPort(uint8_t id, MidiPortBackend* backend, bool clockOut){
+  if (id >= MIDI_MAX_PORTS || !backend) return false;
+  ports[id].backend = backend;
+  ports[id].clockOut = clockOut;
+  return true;
+}
+
+FASTRUN void MidiRouter::written(Port& p, const MidiMsg& m, bool waited){
+  p.stats.sent++;
+  if (!waited) return;
+  uint32_t lat = now() - m.queuedMicros;
+  p.stats.queued++;
+  p.stats.totalLatencyUs += lat;
+  if (lat > p.stats.maxLatencyUs) p.stats.maxLatencyUs = lat;
+}
+
+// Write as much as fits: realtime bytes first, then whole thru messages, then
+// whole sequencer messages
+FASTRUN void MidiRouter::pump(Port& p){
+  int room = p.backend->availableForWrite();
+  bool any = false;
+  while (p.rtHead != p.rtTail && room >= 1){
+    p.backend->write(&p.rt[p.rtHead & (MIDI_RT_QUEUE - 1)], 1);
+    p.rtHead++;
+    room--;
+    any = true;
+  }
+  while (p.thruHead != p.thruTail){
+    const MidiMsg& m = p.thruQ[p.thruHead & (MIDI_THRU_QUEUE - 1)];
+    if (room < m.len) break;
+    p.backend->write(m.b, m.len);
+    written(p, m, true);
+    room -= m.len;
+    p.thruHead++;
+    any = true;
+  }
+  // sequencer messages wait behind thru that didn't fit
+  while (p.head != p.tail && p.thruHead == p.thruTail){
+    const MidiMsg& m = p.queue[p.head & (MIDI_PORT_QUEUE - 1)];
+    if (room < m.len) break;
+    p.backend->write(m.b, m.len);
+    written(p, m, true);
+    room -= m.len;
+    p.head++;
+    any = true;
+  }
+  if (any) p.backend->flush();
+}
+
+FASTRUN bool MidiRouter::send(uint8_t track, uint8_t status, uint8_t d1, uint8_t d2){
+  if (track >= MIDI_MAX_TRACKS) return false;
+  const TrackRoute& r = route[track];
+  if (!hasPort(r.port)) return false;
+  Port& p = ports[r.port];
+  MidiMsg m;
+  m.len = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 2 : 3;
+  m.b[0] = (status & 0xF0) | (r.channel & 0x0F);
+  m.b[1] = d1 & 0x7F;
+  m.b[2] = d2 & 0x7F;
+  m.queuedMicros = now();
+
+  uint32_t primask = irqSave();
+  bool ok = put(p, m);
+  irqRestore(primask);
+  return ok;
+}
+
+// Caller holds interrupts off
+FASTRUN bool MidiRouter::put(Port& p, const MidiMsg& m){
+  // Straight through when nothing is waiting ahead of it
+  if (p.head == p.tail && p.rtHead == p.rtTail && p.thruHead == p.thruTail && p.backend->availableForWrite() >= m.len){
+    p.backend->write(m.b, m.len);
+    p.backend->flush();
+    written(p, m, false);
+    return true;
+  }
+  if ((uint8_t)(p.tail - p.head) >= MIDI_PORT_QUEUE){
+    p.stats.dropped++;
+    return false;
+  }
+  p.queue[p.tail & (MIDI_PORT_QUEUE - 1)] = m;
+  p.tail++;
+  uint8_t d = (uint8_t)(p.tail - p.head);
+  if (d > p.stats.maxDepth) p.stats.maxDepth = d;
+  pump(p);
+  return true;
+}
+
+// Thru lane: only realtime bytes and earlier thru go first. Caller holds interrupts off.
+FASTRUN uint8_t MidiRouter::putThru(Port& p, const MidiMsg& m){
+  if (p.rtHead == p.rtTail && p.thruHead == p.thruTail && p.backend->availableForWrite() >= m.len){
+    p.backend->write(m.b, m.len);
+    p.backend->flush();
+    written(p, m, false);
+    return MIDI_PLAY_WRITTEN;
+  }
+  if ((uint8_t)(p.thruTail - p.thruHead) >= MIDI_THRU_QUEUE){
+    p.stats.dropped++;
+    return MIDI_PLAY_DROPPED;
+  }
+  p.thruQ[p.thruTail & (MIDI_THRU_QUEUE - 1)] = m;
+  p.thruTail++;
+  pump(p);
+  return MIDI_PLAY_QUEUED;
+}
+
+FASTRUN uint8_t MidiRouter::play(uint8_t track, uint8_t status, uint8_t d1, uint8_t d2){
+  if (track >= MIDI_MAX_TRACKS) return MIDI_PLAY_DROPPED;
+  const TrackRoute& r = route[track];
+  if (!hasPort(r.port)) return MIDI_PLAY_DROPPED;
+  MidiMsg m;
+  m.len = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 2 : 3;
+  m.b[0] = (status & 0xF0) | (r.channel & 0x0F);
+  m.b[1] = d1 & 0x7F;
+  m.b[2] = d2 & 0x7F;
+  m.queuedMicros = now();
+  uint32_t primask = irqSave();
+  uint8_t res = putThru(ports[r.port], m);
+  irqRestore(primask);
+  return res;
+}
+
+FASTRUN bool MidiRouter::sendIfIdle(uint8_t track, uint8_t status, uint8_t d1, uint8_t d2, uint8_t minFree){
+  if (track >= MIDI_MAX_TRACKS) return false;
+  const TrackRoute& r = route[track];
+  if (!hasPort(r.port)) return false;
+  Port& p = ports[r.port];
+  bool ok = false;
+  uint32_t primask = irqSave();
+  if (p.head == p.tail && p.rtHead == p.rtTail && p.thruHead == p.thruTail && p.backend->availableForWrite() >= minFree + 3){
+    uint8_t b[3] = { (uint8_t)((status & 0xF0) | (r.channel & 0x0F)), (uint8_t)(d1 & 0x7F), (uint8_t)(d2 & 0x7F) };
+    p.backend->write(b, 3);
+    p.backend->flush();
+    p.stats.sent++;
+    ok = true;
+  }
+  irqRestore(primask);
+  return ok;
+}
+
+FASTRUN void MidiRouter::sendRealtime(uint8_t b){
+  uint32_t primask = irqSave();
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++){
+    Port& p = ports[i];
+    if (!p.backend || !p.clockOut) continue;
+    if (p.rtHead == p.rtTail && p.backend->availableForWrite() >= 1){
+      p.backend->write(&b, 1);
+      p.backend->flush();
+    } else if ((uint8_t)(p.rtTail - p.rtHead) < MIDI_RT_QUEUE){
+      p.rt[p.rtTail & (MIDI_RT_QUEUE - 1)] = b;
+      p.rtTail++;
+    }
+  }
+  irqRestore(primask);
+}
+
+FASTRUN void MidiRouter::sendSongPosition(uint16_t beats){
+  MidiMsg m;
+  m.len = 3;
+  m.b[0] = 0xF2;
+  m.b[1] = beats & 0x7F;
+  m.b[2] = (beats >> 7) & 0x7F;
+  m.queuedMicros = now();
+  uint32_t primask = irqSave();
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++){
+    if (ports[i].backend && ports[i].clockOut) put(ports[i], m);
+  }
+  irqRestore(primask);
+}
+
+uint8_t MidiInParser::feed(uint8_t b, uint8_t* msg){
+  if (b >= 0xF8) { msg[0] = b; return 1; }
+  if (b & 0x80){
+    count = 0;
+    if (b == 0xF6) { status = 0; msg[0] = b; return 1; }
+    // 0xF0 holds sysex data off; 0xF7 and undefined status bytes clear running status
+    status = (b == 0xF0 || midiDataBytes(b)) ? b : 0;
+    return 0;
+  }
+  if (status == 0 || status == 0xF0) return 0;
+  data[count++] = b;
+  uint8_t need = midiDataBytes(status);
+  if (count < need) return 0;
+  count = 0;
+  msg[0] = status;
+  msg[1] = data[0];
+  msg[2] = need > 1 ? data[1] : 0;
+  // system common messages don't set running status
+  if (status >= 0xF0) status = 0;
+  return need + 1;
+}
+
+FASTRUN bool MidiRouter::thru(uint8_t src, const uint8_t* msg, uint8_t len, uint8_t track){
+  const MidiThruConfig& c = thruConfig;
+  if (c.mode == MIDI_THRU_OFF || !((c.sources >> src) & 1)) return false;
+  if (msg[0] < 0x80 || msg[0] >= 0xF0 || len < 2) return false;
+  uint8_t inCh = msg[0] & 0x0F;
+  if (!((c.channels >> inCh) & 1)) { thruStat.filtered++; return false; }
+
+  MidiMsg m;
+  m.len = len;
+  m.b[1] = msg[1] & 0x7F;
+  m.b[2] = len > 2 ? (msg[2] & 0x7F) : 0;
+  m.queuedMicros = now();
+  uint8_t portMask;
+  if (c.mode == MIDI_THRU_TRACK){
+    if (track >= MIDI_MAX_TRACKS) return false;
+    m.b[0] = (msg[0] & 0xF0) | (route[track].channel & 0x0F);
+    portMask = 1 << route[track].port;
+  } else {
+    m.b[0] = (msg[0] & 0xF0) | (c.remap[inCh] < 16 ? c.remap[inCh] : inCh);
+    portMask = c.ports;
+  }
+  bool ok = true;
+  uint32_t primask = irqSave();
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++){
+    if (((portMask >> i) & 1) && ports[i].backend) ok &= putThru(ports[i], m) != MIDI_PLAY_DROPPED;
+  }
+  irqRestore(primask);
+  if (ok) thruStat.forwarded++; else thruStat.dropped++;
+  return ok;
+}
+
+FASTRUN void MidiRouter::service(){
+  uint32_t primask = irqSave();
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++){
+    if (ports[i].backend) pump(ports[i]);
+  }
+  irqRestore(primask);
+}
+
+void MidiRouter::resetStats(){
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) ports[i].stats = MidiPortStats();
+  thruStat = MidiThruStats();
+}
@@ -0,0 +1,145 @@
+#include "Modulation.h"
+#include "MemPlacement.h"
+
+static const uint32_t MOD_BYTE_UNITS = 1000000UL; // bucket counts bytes x 1e6 (byte-microseconds)
+static const uint32_t MOD_BYTES_PER_SEC = MIDI_WIRE_BYTES_PER_SEC * MOD_WIRE_SHARE_PCT / 100;
+
+void ModEngine::init(){
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++) rnd[t] = 0x9E3779B9UL * (t + 1);
+  reset();
+}
+
+void ModEngine::reset(){
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    phase[t] = 0;
+    rndHeld[t] = 0;
+    envTick[t] = 0xFFFF;
+    lastSent[t][0] = lastSent[t][1] = -1; // resend everything after a restart
+  }
+}
+
+// Phase is linear in ticks, so it is set directly (wraps like the running sum).
+// Envelopes start idle; S&H picks a new value at its next wrap.
+void ModEngine::seek(const LfoParams* lfo, uint32_t ticks){
+  reset();
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    uint32_t inc = 0xFFFFFFFFUL / MOD_LFO_TICKS[lfo[t].rateIdx % MOD_NUM_LFO_RATES];
+    phase[t] = inc * ticks;
+  }
+}
+
+void ModEngine::noteOn(uint8_t track){
+  if (track < NUM_CHANNELS) envTick[track] = 0;
+}
+
+void ModEngine::park(const LfoParams* lfo, const EnvParams* env, SendFn send){
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    for (uint8_t slot = 0; slot < 2; slot++){
+      uint8_t dest = slot == 0 ? lfo[t].dest : env[t].dest;
+      if (dest == MOD_DEST_PITCHBEND && lastSent[t][slot] >= 0 && lastSent[t][slot] != 8192){
+        send(t, dest, 8192);
+        lastSent[t][slot] = 8192;
+      }
+    }
+  }
+}
+
+int16_t ModEngine::lfoValue(const LfoParams& l, uint8_t t){
+  uint16_t p = (uint16_t)(phase[t] >> 16);
+  switch (l.shape){
+    case LFO_SINE: {
+      // Parabolic approximation 4x(1-|x|), x = angle/pi in Q15
+      int32_t x = (int16_t)p;
+      int32_t ax = x < 0 ? -x : x;
+      int32_t y = (x * (32768 - ax)) >> 13;
+      return (int16_t)(y > 32767 ? 32767 : (y < -32767 ? -32767 : y));
+    }
+    case LFO_TRIANGLE:
+      return (int16_t)(p < 32768 ? (int32_t)p * 2 - 32767 : 32767 - ((int32_t)p - 32768) * 2);
+    case LFO_SAW:
+      return (int16_t)((int32_t)p - 32768);
+    case LFO_SQUARE:
+      return p < 32768 ? 32767 : -32767;
+    default:
+      return rndHeld[t];
+  }
+}
+
+int16_t ModEngine::envValue(const EnvParams& e, uint8_t t){
+  uint16_t n = envTick[t];
+  if (n == 0xFFFF) return 0;
+  uint16_t a = MOD_ENV_TICKS[e.attackIdx % MOD_NUM_ENV_TIMES];
+  uint16_t d = MOD_ENV_TICKS[e.decayIdx % MOD_NUM_ENV_TIMES];
+  if (n < a) return (int16_t)(32767L * n / a);
+  if (n < a + d) return (int16_t)(32767L * (a + d - n) / d);
+  return 0;
+}
+
+bool ModEngine::spend(uint8_t bytes){
+  uint32_t cost = (uint32_t)bytes * MOD_BYTE_UNITS;
+  if (budgetMicros < cost) return false;
+  budgetMicros -= cost;
+  return true;
+}
+
+// Scale a Q15 modulator by depth into a CC (0-127) or pitch-bend (0-16383) offset
+static int32_t modScale(int32_t q15, uint8_t depth, bool bend){
+  int32_t v = (q15 * depth) >> 15;  // -127..127
+  return bend ? v * 64 : v;
+}
+
+FASTRUN void ModEngine::tick(const LfoParams* lfo, const EnvParams* env, uint32_t nowMicros, SendFn send){
+  // Refill the byte budget for the time since the last tick
+  uint32_t elapsed = nowMicros - lastMicros;
+  lastMicros = nowMicros;
+  if (elapsed > 1000000UL) elapsed = 1000000UL;
+  budgetMicros += elapsed * MOD_BYTES_PER_SEC;
+  if (budgetMicros > MOD_BURST_BYTES * MOD_BYTE_UNITS) budgetMicros = MOD_BURST_BYTES * MOD_BYTE_UNITS;
+
+  // Rotate which track gets first claim on the budget so none is starved
+  for (uint8_t i = 0; i < NUM_CHANNELS; i++){
+    uint8_t t = (uint8_t)((rrStart + i) % NUM_CHANNELS);
+    // Advance the LFO; sample & hold picks a new value on every wrap
+    uint32_t inc = 0xFFFFFFFFUL / MOD_LFO_TICKS[lfo[t].rateIdx % MOD_NUM_LFO_RATES];
+    uint32_t prev = phase[t];
+    phase[t] += inc;
+    if (phase[t] < prev || prev == 0){
+      uint32_t x = rnd[t];
+      x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+      rnd[t] = x;
+      rndHeld[t] = (int16_t)(x >> 16);
+    }
+
+    int16_t lv = lfoValue(lfo[t], t);
+    int16_t ev = envValue(env[t], t);
+    if (envTick[t] != 0xFFFF && envTick[t] < 0xFFFE) envTick[t]++;
+
+    uint8_t ld = lfo[t].depth ? lfo[t].dest : MOD_DEST_OFF;
+    uint8_t ed = env[t].depth ? env[t].dest : MOD_DEST_OFF;
+    for (uint8_t slot = 0; slot < 2; slot++){
+      uint8_t dest = slot == 0 ? ld : ed;
+      if (dest == MOD_DEST_OFF) { lastSent[t][slot] = -1; continue; }
+      if (slot == 1 && ed == ld) continue; // summed into slot 0
+
+      bool bend = (dest == MOD_DEST_PITCHBEND);
+      bool hasLfo = (ld == dest), hasEnv = (ed == dest);
+      // pitch bend rests at centre whatever drives it; a CC LFO swings around 64
+      // and a CC envelope rises from 0
+      int32_t v = bend ? 8192 : (hasLfo ? 64 : 0);
+      if (hasLfo) v += modScale(lv, lfo[t].depth, bend);
+      if (hasEnv) v += modScale(ev, env[t].depth, bend);
+      int32_t hi = bend ? 16383 : 127;
+      if (v < 0) v = 0;
+      if (v > hi) v = hi;
+
+      // Change-only; the latest value wins, so a deferred update is simply retried
+      if (v == lastSent[t][slot]) continue;
+      uint8_t bytes = 3;
+      if (!spend(bytes)) { deferred++; continue; }
+      if (!send(t, dest, (uint16_t)v)) { budgetMicros += bytes * MOD_BYTE_UNITS; deferred++; continue; }
+      bytesSent += bytes;
+      lastSent[t][slot] = v;
+    }
+  }
+  rrStart = (uint8_t)((rrStart + 1) % NUM_CHANNELS);
+}
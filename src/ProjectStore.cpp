@@ -0,0 +1,154 @@
+#include "ProjectStore.h"
+#include <string.h>
+
+// --- FILE BACKENDS ---
+#ifdef ARDUINO
+
+bool ProjectFile::open(const char* path){
+  // FILE_WRITE on Teensy is read/write + create, positioned at end
+  f = SD.open(path, FILE_WRITE);
+  opened = (bool)f;
+  return opened;
+}
+void ProjectFile::close(){ if (opened) { f.close(); opened = false; } }
+bool ProjectFile::isOpen() const { return opened; }
+bool ProjectFile::seek(uint32_t pos){ return f.seek(pos); }
+int32_t ProjectFile::read(uint8_t* dst, uint16_t len){ return f.read(dst, len); }
+int32_t ProjectFile::write(const uint8_t* src, uint16_t len){ return (int32_t)f.write(src, len); }
+uint32_t ProjectFile::size(){ return (uint32_t)f.size(); }
+
+#else
+
+bool ProjectFile::open(const char* path){
+  f = fopen(path, "r+b");
+  if (!f) f = fopen(path, "w+b");
+  return f != nullptr;
+}
+void ProjectFile::close(){ if (f) { fclose(f); f = nullptr; } }
+bool ProjectFile::isOpen() const { return f != nullptr; }
+bool ProjectFile::seek(uint32_t pos){ return fseek(f, (long)pos, SEEK_SET) == 0; }
+int32_t ProjectFile::read(uint8_t* dst, uint16_t len){ return (int32_t)fread(dst, 1, len, f); }
+int32_t ProjectFile::write(const uint8_t* src, uint16_t len){ return (int32_t)fwrite(src, 1, len, f); }
+uint32_t ProjectFile::size(){
+  long cur = ftell(f);
+  fseek(f, 0, SEEK_END);
+  long end = ftell(f);
+  fseek(f, cur, SEEK_SET);
+  return (uint32_t)end;
+}
+
+#endif
+
+// --- PROJECT STORE ---
+
+bool ProjectStore::begin(){
+#ifdef ARDUINO
+  return SD.begin(BUILTIN_SDCARD);
+#else
+  return true;
+#endif
+}
+
+bool ProjectStore::open(const char* path, uint16_t recordBytes){
+  close();
+  if (recordBytes == 0 || recordBytes > PROJECT_MAX_RECORD_BYTES) return false;
+  if (!file.open(path)) return false;
+  recBytes = recordBytes;
+
+  ProjectHeader h;
+  if (file.size() >= sizeof(ProjectHeader)){
+    file.seek(0);
+    if (file.read((uint8_t*)&h, sizeof(h)) != (int32_t)sizeof(h)) { close(); return false; }
+    // Reject files written with a different record stride rather than misreading them
+    if (h.magic != PROJECT_MAGIC || h.recordBytes != recordBytes ||
+        h.banks != PROJECT_BANKS || h.patternsPerBank != PROJECT_PATTERNS_PER_BANK){
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  // New project: header only, records are written on demand
+  memset(&h, 0, sizeof(h));
+  h.magic = PROJECT_MAGIC;
+  h.version = PROJECT_VERSION;
+  h.banks = PROJECT_BANKS;
+  h.patternsPerBank = PROJECT_PATTERNS_PER_BANK;
+  h.songs = PROJECT_SONGS;
+  h.recordBytes = recordBytes;
+  file.seek(0);
+  return file.write((const uint8_t*)&h, sizeof(h)) == (int32_t)sizeof(h);
+}
+
+void ProjectStore::close(){
+  file.close();
+  ready = false;
+  pending = false;
+}
+
+bool ProjectStore::writeRecord(uint16_t index, const uint8_t* rec, uint16_t len){
+  if (!isOpen() || index >= recordCount() || len > recBytes) return false;
+  // Unwritten gaps read back as empty records, so pad the tail with 0xFF
+  uint8_t pad[PROJECT_MAX_RECORD_BYTES];
+  memcpy(pad, rec, len);
+  memset(pad + len, 0xFF, recBytes - len);
+  if (!file.seek(recordAddress(index))) return false;
+  return file.write(pad, recBytes) == (int32_t)recBytes;
+}
+
+bool ProjectStore::readRecord(uint16_t index, uint8_t* dst){
+  if (!isOpen() || index >= recordCount()) return false;
+  memset(dst, 0xFF, recBytes);
+  if (!file.seek(recordAddress(index))) return false;
+  return file.read(dst, recBytes) >= 0;
+}
+
+bool ProjectStore::writeSong(uint8_t index, const void* data, uint16_t len){
+  if (!isOpen() || index >= PROJECT_SONGS || len > PROJECT_SONG_BYTES) return false;
+  if (!file.seek(songAddress(index))) return false;
+  return file.write((const uint8_t*)data, len) == (int32_t)len;
+}
+
+bool ProjectStore::readSong(uint8_t index, void* dst, uint16_t len){
+  if (!isOpen() || index >= PROJECT_SONGS || len > PROJECT_SONG_BYTES) return false;
+  memset(dst, 0xFF, len);
+  if (!file.seek(songAddress(index))) return false;
+  return file.read((uint8_t*)dst, len) >= 0;
+}
+
+bool ProjectStore::requestRecord(uint16_t index){
+  if (!isOpen() || index >= recordCount()) return false;
+  // A record still waiting to be taken is dropped in favour of the new request
+  ready = false;
+  backIndex = index;
+  backFilled = 0;
+  pending = true;
+  return true;
+}
+
+void ProjectStore::service(){
+  if (!pending) return;
+  uint8_t* back = buffers[front ^ 1];
+  uint16_t n = recBytes - backFilled;
+  if (n > PROJECT_READ_CHUNK) n = PROJECT_READ_CHUNK;
+  int32_t got = -1;
+  if (file.seek(recordAddress(backIndex) + backFilled)) got = file.read(back + backFilled, n);
+  if (got < (int32_t)n){
+    // Past EOF (never written): the rest of the record is empty
+    memset(back + backFilled + (got > 0 ? got : 0), 0xFF, recBytes - backFilled - (got > 0 ? got : 0));
+    backFilled = recBytes;
+  } else {
+    backFilled += n;
+  }
+  if (backFilled >= recBytes){
+    pending = false;
+    ready = true;
+  }
+}
+
+const uint8_t* ProjectStore::takeRecord(){
+  if (!ready) return nullptr;
+  front ^= 1;
+  ready = false;
+  return buffers[front];
+}
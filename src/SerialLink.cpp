@@ -0,0 +1,79 @@
+#include "SerialLink.h"
+#include <string.h>
+
+LinkRx LinkParser::feed(uint8_t b, uint32_t nowMs){
+  uint32_t idleMs = nowMs - lastByteMs;
+  lastByteMs = nowMs;
+  // the sender stalled mid-frame: whatever is left of it is not console input
+  if (state != ST_SOF1 && state != ST_DISCARD && !resync && idleMs > LINK_BYTE_TIMEOUT_MS){
+    state = ST_DISCARD;
+    timeouts++;
+  }
+  // the line went quiet: the next byte is fresh, frame or command
+  if ((state == ST_DISCARD || resync) && idleMs > LINK_DISCARD_IDLE_MS){
+    state = ST_SOF1;
+    resync = false;
+  }
+
+  switch (state){
+    case ST_SOF1:
+      if (b != LINK_SOF1) return LINK_RX_PASS;
+      state = ST_SOF2;
+      return LINK_RX_BUSY;
+    case ST_SOF2:
+      if (b == LINK_SOF1) return LINK_RX_BUSY; // repeated sync byte
+      if (b != LINK_SOF2){
+        if (resync) { state = ST_DISCARD; discarded += 2; return LINK_RX_BUSY; }
+        state = ST_SOF1;
+        return LINK_RX_PASS;
+      }
+      resync = false;
+      state = ST_HEADER;
+      pos = 0;
+      crc = 0xFFFF;
+      return LINK_RX_BUSY;
+    case ST_HEADER:
+      header[pos++] = b;
+      crc = crc16Update(crc, b);
+      if (pos < sizeof(header)) return LINK_RX_BUSY;
+      type = header[0];
+      seq = header[1];
+      len = header[2] | (header[3] << 8);
+      // no such frame: its payload is still coming and must not reach the console
+      if (len > LINK_MAX_PAYLOAD) { state = ST_DISCARD; crcErrors++; return LINK_RX_BAD; }
+      pos = 0;
+      state = len ? ST_PAYLOAD : ST_CRC;
+      return LINK_RX_BUSY;
+    case ST_PAYLOAD:
+      payload[pos++] = b;
+      crc = crc16Update(crc, b);
+      if (pos == len) { state = ST_CRC; pos = 0; }
+      return LINK_RX_BUSY;
+    case ST_CRC:
+      crcBytes[pos++] = b;
+      if (pos < 2) return LINK_RX_BUSY;
+      state = ST_SOF1;
+      if ((uint16_t)(crcBytes[0] | (crcBytes[1] << 8)) != crc) { crcErrors++; return LINK_RX_BAD; }
+      frames++;
+      return LINK_RX_FRAME;
+    case ST_DISCARD:
+      if (b == LINK_SOF1) { state = ST_SOF2; resync = true; return LINK_RX_BUSY; }
+      discarded++;
+      return LINK_RX_BUSY;
+  }
+  return LINK_RX_PASS;
+}
+
+uint16_t linkEncode(uint8_t type, uint8_t seq, const uint8_t* payload, uint16_t len, uint8_t* out){
+  out[0] = LINK_SOF1;
+  out[1] = LINK_SOF2;
+  out[2] = type;
+  out[3] = seq;
+  out[4] = len & 0xFF;
+  out[5] = len >> 8;
+  if (len) memcpy(out + 6, payload, len);
+  uint16_t crc = crc16(out + 2, len + 4);
+  out[6 + len] = crc & 0xFF;
+  out[7 + len] = crc >> 8;
+  return len + LINK_FRAME_OVERHEAD;
+}
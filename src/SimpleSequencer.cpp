@@ -1,5 +1,9 @@
 #include "SimpleSequencer.h"
 #include <IntervalTimer.h>
+#include "MidiRouter.h"
+#include "ClockManager.h"
+#include "MemPlacement.h"
+#include <stdio.h>
 
 // Background Hardware Timer for flawless MIDI clock
 static IntervalTimer midiClockTimer;
@@ -7,31 +11,55 @@ static volatile bool midiTimerRunning = false;
 
 // Engine timer (1ms) to decouple MIDI processing from UI drawing
 static IntervalTimer engineTimer;
+// One-shot that fires a local start a fixed lead time after it was requested
+static IntervalTimer transportTimer;
 static volatile bool stepAdvanceRequested = false; // set by internalClockTick
 
+// MIDI output ports: DIN on Serial8 and USB device MIDI, each with its own queue
+static MidiRouter midiRouter;
+static UartMidiPort dinPort(Serial8);
+static UsbMidiPort usbPort;
+static const char* const midiPortNames[MIDI_MAX_PORTS] = { "DIN", "USB", "P3", "P4" };
+static uint32_t routerClock() { return micros(); }
+
 // forward wrapper so ISR stays tiny
 static void internalClockTickWrapper();
 
-void sendClockISR() {
+// Clock input: DIN, USB and internal, ranked by a priority preset
+static ClockManager clockIn;
+// Engine flight recorder (see Trace.h), dumped with `seqlink trace`. 32 KB that is
+// written from the ISRs but only read for a dump: RAM2, cleared in begin().
+DMAMEM static TraceRing traceRing;
+// Pattern edit history (see UndoLog.h): 3.8 KB, touched once per edit
+DMAMEM static UndoLog undoLog;
+static uint16_t traceEnginePasses = 0;
+static uint16_t traceSeconds = 0;
+static const char* const clockSourceNames[CLOCK_NUM_SOURCES] = { "DIN", "USB", "INT" };
+// DIN input: whole messages for the clock manager, SPP, the arpeggiator and thru
+static MidiInParser dinIn;
+
+FASTRUN void sendClockISR() {
   // ISR must be as tiny as possible: emit MIDI Clock and advance internal tick counter
-  Serial8.write(0xF8);
+  midiRouter.sendRealtime(0xF8);
+  clockIn.onInternalTick(micros());
   internalClockTickWrapper();
 }
 // MIDI clock timing (24 PPQN)
 static uint32_t lastMidiClockMicros = 0;
 
-// external MIDI clock state
-static bool externalMidiClockActive = false;
-static uint32_t lastExternalClockMillis = 0;
 static uint8_t midiStepTickCounter = 0; // counts MIDI clock ticks toward a 16th (6 ticks)
+static const uint8_t TICKS_PER_STEP = 6;
+
+// Look-ahead rendering: loop() keeps this many ticks of events queued (plus the
+// largest negative track delay). Two steps covers a full display refresh.
+static const uint8_t RENDER_LOOKAHEAD_TICKS = 2 * TICKS_PER_STEP;
+// Worst case per step: per channel legato off/on, env trig, 6 ratchet on/off pairs (or
+// three arp hits of legato off/on, env trig, note-off); plus CC locks
+static const uint16_t RENDER_STEP_MAX_EVENTS = NUM_CHANNELS * 16 + PLOCK_CAPACITY;
 
 // No special auto-channel mapping: send notes on per-track channels by default
 
-// Absolute Timestamp Window for Bulletproof BPM
-#define BPM_TICK_WINDOW 49 // 49 timestamps = exactly 48 gaps (2 full beats)
-static uint32_t tickTimestamps[BPM_TICK_WINDOW];
-static uint8_t tickIndex = 0;
-static uint8_t validTicks = 0;
+// BPM display for external clock: smoothed over the active source's 2-beat window
 static float smoothedBpm = 120.0f;
 
 
@@ -58,39 +86,32 @@ SimpleSequencer::SimpleSequencer()
   : bpm(200), lastStepMillis(0), currentStep(0), selectedChannel(0),
     ledStrip(NUM_STEPS, 17, NEO_GRB + NEO_KHZ800)
 {
-  // Default base pitch per channel
-
+  patterns[0].init();
+  patterns[1].init();
   for (uint8_t c=0;c<NUM_CHANNELS;c++){
-    pulses[c]=4;
-    euclidOffset[c] = 0;
     retrig[c]=1;
-    euclidEnabled[c]=false;
-    euclidScaleMode[c] = 0;
-    muted[c]=false; // <-- All channels start unmuted
-    noteOffTick[c]=0;
-    for (uint8_t s=0; s<NUM_STEPS; s++) fillState[c][s] = 0;
+    grooveShiftUs[c] = 0;
+    renderOffShiftUs[c] = 0;
     for(uint8_t s=0;s<NUM_STEPS;s++){
-      steps[c][s]=false;
-      euclidPattern[c][s]=false;
-      // --- THE FIX: 255 means "Use Global Pitch" ---
-      pitch[c][s] = 255;
-      // --- THE FIX: 255 means "Use Global Length" ---
-      noteLen[c][s] = 255;
-      // ratchet default: off
-      stepRatchet[c][s] = 0;
-      // default Accent (Velocity) and Slide
-      stepVelocity[c][s] = 255; // use channel default
-      stepSlide[c][s] = false;
       pendingToggle[s] = false;
+      padNote[s] = PAD_IDLE;
+      padEdgeMs[s] = 0;
     }
-    channelPitch[c] = 36; // Default each channel's base pitch to C2
-    channelVelocity[c] = 96; // default channel velocity (initialized to 96)
-    // ratchet engine defaults
-    ratchetIntervalTicks[c] = 0;
+    ccLockParam[c] = 74; // brightness / filter cutoff on most synths
     lastNotePlaying[c] = 255;
+    renderNote[c] = 255;
+    renderOffTick[c] = 0;
+    renderSlide[c] = false;
+    arpGateEnd[c] = 0;
+    arpVelocity[c] = 0;
+    arpSlide[c] = false;
   }
+  heldNotes.clear();
   lastMidiClockMicros = 0;
-  noteLenIdx = 4; // default to 1/16 (use shorter gate to avoid envelope collisions)
+  mod.init();
+  resetTrigState();
+  memset(&song, 0, sizeof(song));
+  song.magic = SONG_MAGIC;
   absoluteTickCounter = 0;
 }
 
@@ -119,9 +140,12 @@ static void (* const isr_table[NUM_STEPS])() = {
   isr_btn_12, isr_btn_13, isr_btn_14, isr_btn_15
 };
 
-void SimpleSequencer::begin(){
+FLASHMEM void SimpleSequencer::begin(){
   // set instance pointer for ISRs
   SimpleSequencer::instancePtr = this;
+  // DMAMEM holds whatever was there before the reset
+  traceRing.reset();
+  undoLog.reset();
   setupPins();
   // euclidean functionality removed for simplified MIDI test
   lastStepMillis = millis();
@@ -154,6 +178,12 @@ void SimpleSequencer::begin(){
 
   // Initialize hardware Serial8 for MIDI at 31250 baud
   Serial8.begin(31250);
+  // Output router: DIN + USB, both sending clock. Tracks default to DIN channels 1-4.
+  midiRouter.begin(routerClock);
+  midiRouter.addPort(MIDI_PORT_DIN, &dinPort, true);
+  midiRouter.addPort(MIDI_PORT_USB, &usbPort, true);
+  // Clock input: DIN first, then USB, internal as fallback (saved with the pattern)
+  clockIn.begin(0);
   // initialize high-resolution clock reference for internal MIDI output
   lastMidiClockMicros = micros();
 
@@ -164,33 +194,84 @@ void SimpleSequencer::begin(){
 
   // attempt to auto-load saved state from EEPROM
   loadState();
-
+  // SD project storage (optional; EEPROM slots still work without a card)
+  beginProject();
+  // loop() tasks
+  beginScheduler();
 }
 
 // Removed helper setStepLED and refreshStepLEDs; using updateLEDs() below.
 
-void SimpleSequencer::midiSendByte(uint8_t b){
-  // Use hardware Serial8 for MIDI output (31250 baud)
-  Serial8.write(b);
+// Clock / start / stop to every port with clock output enabled
+FASTRUN void SimpleSequencer::midiSendRealtime(uint8_t b){
+  traceRing.record(TR_CLOCK_OUT, 0, b);
+  midiRouter.sendRealtime(b);
 }
 
-void SimpleSequencer::midiSendNoteOn(uint8_t channel, uint8_t note, uint8_t vel){
-  uint8_t status = 0x90 | (channel & 0x0F);
-  midiSendByte(status);
-  midiSendByte(note & 0x7F);
-  midiSendByte(vel & 0x7F);
+// Song Position Pointer (16th-note steps since song start) to the same ports
+FASTRUN void SimpleSequencer::midiSendSongPosition(uint16_t beats){
+  midiRouter.sendSongPosition(beats);
 }
 
-void SimpleSequencer::midiSendNoteOff(uint8_t channel, uint8_t note, uint8_t vel){
+// Channel messages take a track; the router picks the port and MIDI channel
+FASTRUN void SimpleSequencer::midiSendNoteOn(uint8_t track, uint8_t note, uint8_t vel){
+  midiRouter.send(track, 0x90, note, vel);
+}
+
+FASTRUN void SimpleSequencer::midiSendNoteOff(uint8_t track, uint8_t note, uint8_t vel){
   // Some Elektron devices expect Note-Offs as Note-On with velocity 0.
   // Send a Note-On (0x90) with velocity 0 to be compatible.
-  uint8_t status = 0x90 | (channel & 0x0F);
-  midiSendByte(status);
-  midiSendByte(note & 0x7F);
-  midiSendByte(0);
+  midiRouter.send(track, 0x90, note, 0);
+}
+
+FASTRUN void SimpleSequencer::midiSendCC(uint8_t track, uint8_t cc, uint8_t value){
+  midiRouter.send(track, 0xB0, cc, value);
+}
+
+FASTRUN void SimpleSequencer::midiSendPitchBend(uint8_t track, uint16_t value){
+  midiRouter.send(track, 0xE0, value & 0x7F, (value >> 7) & 0x7F);
+}
+
+// Modulation output sink (called from ModEngine::tick in clock ISR context). Only
+// writes when the track's port is idle, so modulation never queues ahead of notes.
+FASTRUN bool SimpleSequencer::modSend(uint8_t track, uint8_t dest, uint16_t value){
+  if (dest == MOD_DEST_PITCHBEND) return midiRouter.sendIfIdle(track, 0xE0, value & 0x7F, (value >> 7) & 0x7F, MOD_TX_MIN_FREE);
+  return midiRouter.sendIfIdle(track, 0xB0, dest, (uint8_t)value, MOD_TX_MIN_FREE);
+}
+
+// Queued variant for the pitch-bend re-centre on stop, which must not be skipped
+FASTRUN bool SimpleSequencer::modSendQueued(uint8_t track, uint8_t dest, uint16_t value){
+  if (dest == MOD_DEST_PITCHBEND) return midiRouter.send(track, 0xE0, value & 0x7F, (value >> 7) & 0x7F);
+  return midiRouter.send(track, 0xB0, dest, (uint8_t)value);
+}
+
+FLASHMEM void SimpleSequencer::printMidiReport(){
+  Serial.println("--- MIDI output ports ---");
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++){
+    if (!midiRouter.hasPort(i)) continue;
+    const MidiPortStats& st = midiRouter.stats(i);
+    Serial.print(midiPortNames[i]); Serial.print(midiRouter.clockOut(i) ? " clk on " : " clk off");
+    Serial.print("  sent "); Serial.print(st.sent);
+    Serial.print("  queued "); Serial.print(st.queued);
+    Serial.print("  dropped "); Serial.print(st.dropped);
+    Serial.print("  depth max "); Serial.print(st.maxDepth);
+    Serial.print("  wait avg/max us "); Serial.print(st.queued ? st.totalLatencyUs / st.queued : 0);
+    Serial.print("/"); Serial.println(st.maxLatencyUs);
+  }
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    Serial.print("track "); Serial.print(t + 1); Serial.print(" -> ");
+    Serial.print(midiPortNames[midiRouter.route[t].port % MIDI_MAX_PORTS]);
+    Serial.print(" ch "); Serial.println(midiRouter.route[t].channel + 1);
+  }
+  const MidiThruStats& th = midiRouter.thruStats();
+  Serial.print("thru mode "); Serial.print(midiRouter.thruConfig.mode);
+  Serial.print("  forwarded "); Serial.print(th.forwarded);
+  Serial.print("  filtered "); Serial.print(th.filtered);
+  Serial.print("  dropped "); Serial.println(th.dropped);
+  midiRouter.resetStats();
 }
 
-void SimpleSequencer::setupPins(){
+FLASHMEM void SimpleSequencer::setupPins(){
   // 1. Setup encoder pins FIRST
   for (uint8_t e=0; e<4; e++){
     pinMode(ENC_A[e], INPUT_PULLUP);
@@ -200,6 +281,8 @@ void SimpleSequencer::setupPins(){
   // 2. Setup button pins
   for (uint8_t i=0; i<NUM_STEPS; i++){
     pinMode(BUTTON_PINS[i], INPUT_PULLUP);
+    // edges only matter in pad mode; readButtons() polls everything else
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PINS[i]), isr_table[i], CHANGE);
   }
   pinMode(CHANNEL_BTN_PIN, INPUT_PULLUP);
   pinMode(START_STOP_PIN, INPUT_PULLUP);
@@ -224,17 +307,107 @@ void SimpleSequencer::setupPins(){
 // static instance pointer for ISR forwarding
 SimpleSequencer* SimpleSequencer::instancePtr = nullptr;
 
-void SimpleSequencer::handleButtonIRQ(uint8_t idx){
-  // (no-op when using Bounce2 polling). Kept for backward compatibility.
+// --- PAD PLAY ---
+// Step button edge. In pad mode a press plays its note right here instead of
+// waiting up to a millisecond for readButtons(), so press-to-MIDI is the pin
+// interrupt plus the port write. An edge within debounceMs of the last one acted
+// on is contact bounce. readButtons() catches what this misses (a release inside
+// the lockout, a press while a modifier was held) on its next pass.
+FASTRUN void SimpleSequencer::handleButtonIRQ(uint8_t idx){
+  uint32_t startCycles = ARM_DWT_CYCCNT;
+  if (padMode == PAD_OFF || idx >= NUM_STEPS) return;
+  uint32_t nowMs = millis();
+  if (nowMs - padEdgeMs[idx] <= debounceMs) return;
+  if (digitalRead(BUTTON_PINS[idx]) == LOW){
+    // Fn / START chords are track select, mutes and pages: left to readButtons()
+    if (digitalRead(CHANNEL_BTN_PIN) == LOW || digitalRead(START_STOP_PIN) == LOW) return;
+    if (padClaim(idx, true) != PAD_IDLE) return;
+    padPress(idx, startCycles);
+  } else {
+    uint8_t note = padClaim(idx, false);
+    if (note >= 128) return;
+    padRelease(idx, note);
+  }
+  padEdgeMs[idx] = nowMs;
+}
+
+// A pad changes state from the edge interrupt or from readButtons(), whichever
+// gets there first; the other finds it busy or already changed. Returns the pad's
+// old note (PAD_IDLE for a press), or PAD_BUSY if the change isn't this caller's.
+FASTRUN uint8_t SimpleSequencer::padClaim(uint8_t pad, bool press){
+  noInterrupts();
+  uint8_t n = padNote[pad];
+  bool take = press ? n == PAD_IDLE : n < 128;
+  if (take) padNote[pad] = PAD_BUSY;
+  interrupts();
+  return take ? n : PAD_BUSY;
+}
+
+// Drum: 16 fixed notes from PAD_DRUM_BASE. Chromatic: semitones up from the
+// track's base pitch. Either way on the selected track's port and channel.
+FASTRUN void SimpleSequencer::padPress(uint8_t pad, uint32_t startCycles){
+  uint8_t track = selectedChannel;
+  uint16_t note = (padMode == PAD_DRUM ? PAD_DRUM_BASE : pat->channelPitch[track]) + pad;
+  if (note > 127) note = 127;
+  uint8_t res = midiRouter.play(track, 0x90, note, pat->channelVelocity[track]);
+  if (startCycles) padLatency.add(ARM_DWT_CYCCNT - startCycles);
+  if (res == MIDI_PLAY_QUEUED) padQueued++;
+  if (res == MIDI_PLAY_DROPPED) { padDropped++; padNote[pad] = PAD_IDLE; return; }
+  padTrack[pad] = track;
+  padNote[pad] = note;
+}
+
+FASTRUN void SimpleSequencer::padRelease(uint8_t pad, uint8_t note){
+  // note-on with velocity 0, the note-off midiSendNoteOff() sends
+  midiRouter.play(padTrack[pad], 0x90, note, 0);
+  padNote[pad] = PAD_IDLE;
+}
+
+// Off / drum / chromatic. Pads still sounding get their note-offs first.
+FLASHMEM void SimpleSequencer::setPadMode(uint8_t mode){
+  static const char* const padNames[PAD_NUM_MODES] = { "off", "drum", "chromatic" };
+  padMode = mode % PAD_NUM_MODES;
+  for (uint8_t i = 0; i < NUM_STEPS; i++){
+    uint8_t note = padClaim(i, false);
+    if (note < 128) padRelease(i, note);
+  }
+  Serial.print("Pad play: "); Serial.println(padNames[padMode]);
 }
 
 void SimpleSequencer::loop(){
+  // UI-side work runs as scheduler tasks; time-critical MIDI work runs in the engine timer
+  sched.runOnce();
+}
+
+// --- LOOP SCHEDULER ---
+// Tasks in priority order. Deadlines are how late a task may start: the renderer
+// keeps two steps queued and the ISR renders a late step itself, so 40 ms is safe
+// up to 300 BPM and leaves room for a display frame (~25 ms of I2C at 400 kHz).
+FLASHMEM void SimpleSequencer::beginScheduler(){
+  sched.begin(routerClock, [](){ yield(); });
+  // keep the next steps rendered so the ISRs only send
+  sched.addTask("render", [](void* s){ static_cast<SimpleSequencer*>(s)->renderAhead(); }, this, 1000, 500, 40000);
+  sched.addTask("input", [](void* s){ static_cast<SimpleSequencer*>(s)->serviceInput(); }, this, 1000, 300, 40000);
+  // console commands and binary link frames from USB serial, then telemetry out
+  sched.addTask("serial", [](void* s){
+    static_cast<SimpleSequencer*>(s)->serviceSerial();
+    static_cast<SimpleSequencer*>(s)->serviceTelemetry();
+  }, this, 1000, 2000, 50000);
+  sched.addTask("storage", [](void* s){ static_cast<SimpleSequencer*>(s)->serviceStorage(); }, this, 2000, 3000, 100000);
+  sched.addTask("diag", [](void* s){ static_cast<SimpleSequencer*>(s)->serviceDiag(); }, this, 1000, 100, 20000);
+  sched.addTask("display", [](void* s){
+    static_cast<SimpleSequencer*>(s)->updateLEDs();
+    static_cast<SimpleSequencer*>(s)->drawDisplay();
+  }, this, displayRefreshMs * 1000, 30000, displayRefreshMs * 1000);
+}
+
+void SimpleSequencer::serviceInput(){
   // --- TRACK THE FILL PERFORMANCE BUTTON (Now on Pin 28) ---
   fillModeActive = (digitalRead(CHANNEL_BTN_PIN) == LOW);
 
-  // UI-only loop: read controls and update display. Time-critical MIDI work runs in engine timer.
   readButtons();
   readEncoders();
+  serviceUndo();
   // handle start/stop button debounce (Arduino-style)
   // NOTE: Start/Stop now requires BOTH the FN and FILL buttons held together (pins 27 + 28)
   unsigned long now = millis();
@@ -253,84 +426,372 @@ void SimpleSequencer::loop(){
       } else {
         // RELEASED: Only toggle transport if we DID NOT use it to mute a track
         if (!startStopModifierFlag) {
-          // toggle running state
-          isRunning = !isRunning;
-          if (isRunning){
-            midiStepTickCounter = 0;
-            stepAdvanceRequested = false;
-            // reset absolute tick counter so internal timing/ratchets start aligned
-            absoluteTickCounter = 0;
-            midiSendByte(0xFA); // MIDI Start
-            midiSendByte(0xF8); // MIDI Clock
-            currentStep = 0;
-            for (uint8_t ch=0; ch<NUM_CHANNELS; ch++){
-              bool isActive = euclidEnabled[ch] ? euclidPattern[ch][currentStep] : steps[ch][currentStep];
-              if (isActive) triggerChannel(ch);
-            }
-            if (!externalMidiClockActive && !midiTimerRunning) {
-              uint32_t interval = (60000000UL / bpm) / 24;
-              midiClockTimer.begin(sendClockISR, interval);
-              midiTimerRunning = true;
-            }
-          } else {
-            for (uint8_t ch=0; ch<NUM_CHANNELS; ch++){
-              if (noteOffTick[ch]){
-                if (lastNotePlaying[ch] < 128) midiSendNoteOff(ch, lastNotePlaying[ch], 0);
-                noteOffTick[ch] = 0;
-              }
-            }
-            midiSendByte(0xFC); // MIDI Stop
-            if (midiTimerRunning) { midiClockTimer.end(); midiTimerRunning = false; }
-            currentStep = 0;
-            midiStepTickCounter = 0;
-            stepAdvanceRequested = false;
-          }
+          // the engine owns the transport: start / stop (quantised if set) on its next pass
+          postTransport(TC_TOGGLE);
         }
       }
     }
   }
   startLastReading = startReading;
-  // serial command: 't' to run a 10s switch test
-  if (Serial.available()){
-    char c = Serial.read();
-    if (c == 't' || c == 'T') runSwitchTest(10000);
-    if (c == 'd' || c == 'D'){
-      // cycle division
-      stepDivision = (Division)((stepDivision + 1) % 5);
-      Serial.print("Division: "); Serial.println(divisionNames[(int)stepDivision]);
-    }
-    if (c == 'c' || c == 'C'){
-      // Clear saved EEPROM state (one-time clear)
-      SaveData z = {};
-      z.magicNumber = 0;
-      EEPROM.put(0, z);
-      Serial.println("Saved state cleared (EEPROM).");
-    }
-    if (c == 'p' || c == 'P'){
-      // play test note C3 on channel 0 immediately
-      Serial.println("Play C3 (ch1)");
-      triggerChannel(0);
-    }
-    if (c == 'r' || c == 'R'){
-      printEncoderRaw();
-    }
-    if (c == 'm' || c == 'M'){
-      runMidiPinMonitor(2000);
-    }
-    if (c == 'e' || c == 'E'){
-      // run encoder switch test for 10s
-      runEncoderSwitchTest(10000);
-    }
-  }
-  // MIDI clock generation and external MIDI handling moved to `runEngine()` only to avoid race conditions.
-
-  // Time-critical MIDI processing (advancing steps/note-offs/MIDI RX) now runs in the engine timer.
-  // update display at configured refresh interval
-  if (millis() - lastDisplayMillis > displayRefreshMs){
-    updateLEDs();
-    drawDisplay();
-    lastDisplayMillis = millis();
+}
+
+void SimpleSequencer::serviceStorage(){
+  // stream any cued project pattern a chunk at a time, then decode it into the spare
+  prefetchSongPattern();
+  projectStore.service();
+  stageCuedPattern();
+  // stopped: no bar boundary to wait for
+  noInterrupts();
+  if (!isRunning && stagedPattern >= 0 && (!songActive || stagedPattern == (int16_t)arrangement.bar(songBar).pattern)){
+    swapStagedPattern();
+    applyRig(stagedRig);
+  }
+  interrupts();
+}
+
+// Per-task share of the time since the last report, then reset
+FLASHMEM void SimpleSequencer::printSchedReport(){
+  uint32_t window = sched.windowUs();
+  if (window == 0) window = 1;
+  Serial.print("--- Loop scheduler over "); Serial.print(window / 1000); Serial.println(" ms (us) ---");
+  uint32_t busy = 0;
+  for (uint8_t i = 0; i < sched.taskCount(); i++){
+    const SchedTaskStats& st = sched.stats(i);
+    uint32_t permille = (uint64_t)st.totalUs * 1000 / window;
+    busy += st.totalUs;
+    Serial.print(sched.taskName(i)); Serial.print("  load "); Serial.print(permille / 10); Serial.print("."); Serial.print(permille % 10); Serial.print("%");
+    Serial.print("  avg/max "); Serial.print(st.runs ? st.totalUs / st.runs : 0); Serial.print("/"); Serial.print(st.maxUs);
+    Serial.print("  budget "); Serial.print(sched.taskBudget(i)); Serial.print(" over "); Serial.print(st.overBudget);
+    Serial.print("  late max "); Serial.print(st.maxLateUs); Serial.print(" missed "); Serial.print(st.missed);
+    Serial.print(" held "); Serial.print(st.held);
+    Serial.print("  runs "); Serial.println(st.runs);
+  }
+  uint32_t idle = sched.idleUs();
+  uint32_t idlePermille = (uint64_t)idle * 1000 / window;
+  uint32_t other = window > busy + idle ? window - busy - idle : 0;
+  Serial.print("idle "); Serial.print(idlePermille / 10); Serial.print("."); Serial.print(idlePermille % 10); Serial.print("%");
+  Serial.print("  scheduler "); Serial.print(other); Serial.println(" us");
+  sched.resetStats();
+}
+
+// Single-character console commands ('t' runs a 10s switch test, ...)
+FLASHMEM void SimpleSequencer::handleSerialCommand(char c){
+  if (c == 't' || c == 'T') runSwitchTest(10000);
+  if (c == 'd' || c == 'D'){
+    // cycle division
+    stepDivision = (Division)((stepDivision + 1) % 5);
+    Serial.print("Division: "); Serial.println(divisionNames[(int)stepDivision]);
+  }
+  if (c == 'c' || c == 'C'){
+    // Clear saved EEPROM state (one-time clear)
+    clearSavedState();
+    Serial.println("Saved state cleared (EEPROM).");
+  }
+  if (c == '+' || c == '-'){
+    // select save slot
+    saveSlot = (c == '+') ? (saveSlot + 1) % SAVE_NUM_SLOTS : (saveSlot + SAVE_NUM_SLOTS - 1) % SAVE_NUM_SLOTS;
+    Serial.print("Save slot: "); Serial.println(saveSlot + 1);
+  }
+  if (c == 'l' || c == 'L'){
+    // load the selected save slot
+    if (loadSlot(saveSlot)) { Serial.print("Loaded slot "); Serial.println(saveSlot + 1); }
+    else { Serial.print("Slot empty: "); Serial.println(saveSlot + 1); }
+  }
+  if (c == 'i' || c == 'I'){
+    printSaveReport();
+  }
+  if (c == 'o' || c == 'O'){
+    printModReport();
+  }
+  if (c == 'f' || c == 'F'){
+    printProfile();
+  }
+  if (c == 'j' || c == 'J'){
+    setPadMode(padMode + 1);
+  }
+  if (c == 'h' || c == 'H'){
+    // cycle the soft thru: off, on (channels kept or remapped), to the selected track
+    static const char* const thruNames[MIDI_THRU_NUM_MODES] = { "off", "on", "track" };
+    MidiThruConfig& t = midiRouter.thruConfig;
+    t.mode = (t.mode + 1) % MIDI_THRU_NUM_MODES;
+    Serial.print("MIDI thru: "); Serial.println(thruNames[t.mode]);
+  }
+  if (c == 'v' || c == 'V'){
+    printSchedReport();
+  }
+  if (c == 'z' || c == 'Z'){
+    // z undoes the last pattern edit, Z redoes it
+    undoEdit(c == 'Z');
+  }
+  if (c == 'u' || c == 'U'){
+    printMidiReport();
+  }
+  if (c == 'k' || c == 'K'){
+    printClockReport();
+  }
+  if (c == 'y' || c == 'Y'){
+    // freeze the event trace right after a glitch so it survives until dumped
+    traceRing.freeze(!traceRing.isFrozen());
+    Serial.print(traceRing.isFrozen() ? "Trace frozen, records: " : "Trace running, records: "); Serial.println(traceRing.count());
+  }
+  if (c == 'q' || c == 'Q'){
+    // cycle start / stop quantise
+    transportQuant = (transportQuant + 1) % TQ_NUM_MODES;
+    Serial.print("Transport quantise: "); Serial.println(TRANSPORT_QUANT_NAMES[transportQuant]);
+  }
+  if (c == 's' || c == 'S'){
+    // cycle the clock source priority
+    noInterrupts();
+    clockIn.setPriority((clockIn.priority() + 1) % CLOCK_NUM_PRIORITIES);
+    interrupts();
+    Serial.print("Clock priority: "); Serial.println(CLOCK_PRIORITIES[clockIn.priority()].name);
   }
+  if (c == 'w' || c == 'W'){
+    // write current pattern into the SD project
+    bool ok = saveProjectPattern(projectPattern);
+    Serial.print(ok ? "Project pattern saved: " : "Project save failed: "); Serial.println(projectPattern + 1);
+  }
+  if (c == 'x' || c == 'X'){
+    // re-roll the pattern seed used by probability trigs
+    pat->patternSeed = micros() ^ (pat->patternSeed * 0x9E3779B9UL);
+    resetTrigState();
+    Serial.print("Pattern seed: "); Serial.println(pat->patternSeed, HEX);
+  }
+  if (c == 'a' || c == 'A'){
+    // append the current project pattern to the song
+    if (appendSongEntry(projectPattern, 1)) { Serial.print("Song entries: "); Serial.println(song.length); }
+  }
+  if (c == 'g' || c == 'G'){
+    // toggle song mode
+    if (songActive) stopSong(); else startSong();
+    Serial.print("Song mode bars: "); Serial.println(songActive ? arrangement.length() : 0);
+    Serial.print("Song bars late (pattern not streamed in time): "); Serial.println(songLateBars);
+  }
+  if (c == 'n' || c == 'N' || c == 'b' || c == 'B'){
+    // cue next/previous project pattern (switches at the next bar)
+    uint16_t count = projectStore.recordCount();
+    uint16_t next = (c == 'n' || c == 'N') ? (projectPattern + 1) % count : (projectPattern + count - 1) % count;
+    if (cueProjectPattern(next)) { Serial.print("Cued pattern "); Serial.println(next + 1); }
+  }
+  if (c == 'p' || c == 'P'){
+    // play test note C3 on channel 0 immediately
+    Serial.println("Play C3 (ch1)");
+    // the event queue is shared with the engine ISR; the router keeps interrupts
+    // off while it sends (irqSave / irqRestore)
+    noInterrupts();
+    renderChannel(0, currentStep, absoluteTickCounter);
+    drainEvents(micros());
+    interrupts();
+  }
+  if (c == 'r' || c == 'R'){
+    printEncoderRaw();
+  }
+  if (c == 'm' || c == 'M'){
+    runMidiPinMonitor(2000);
+  }
+  if (c == 'e' || c == 'E'){
+    // run encoder switch test for 10s
+    runEncoderSwitchTest(10000);
+  }
+}
+
+// --- USB SERIAL LINK ---
+// Bytes read from USB serial per loop() pass: a 512 byte pattern record plus
+// framing arrives in one pass, a flood of data still can't hold up the display.
+static const uint16_t SERIAL_RX_BUDGET = 2048;
+static const uint8_t SERIAL_RX_CHUNK = 64;
+
+// Rig settings object: format, clock priority, transport quantise, clock-out port
+// mask, then port / MIDI channel / delay (ms, signed) per track. Format 2 adds the
+// soft thru: mode, source mask, port mask, channel mask (LSB first), 16 remaps.
+static const uint8_t LINK_SETTINGS_FORMAT = 2;
+static const uint16_t LINK_SETTINGS_V1_BYTES = 4 + 3 * NUM_CHANNELS;
+static const uint16_t LINK_SETTINGS_BYTES = LINK_SETTINGS_V1_BYTES + 5 + 16;
+static_assert(3 + TRACE_CHUNK_HEADER + TRACE_CHUNK_RECORDS * TRACE_RECORD_BYTES <= LINK_MAX_PAYLOAD, "trace chunk does not fit a link frame");
+
+void SimpleSequencer::serviceSerial(){
+  uint8_t buf[SERIAL_RX_CHUNK];
+  uint16_t budget = SERIAL_RX_BUDGET;
+  while (budget){
+    int avail = Serial.available();
+    if (avail <= 0) break;
+    uint16_t n = avail < SERIAL_RX_CHUNK ? avail : SERIAL_RX_CHUNK;
+    if (n > budget) n = budget;
+    n = Serial.readBytes((char*)buf, n);
+    if (n == 0) break;
+    budget -= n;
+    uint32_t nowMs = millis();
+    for (uint16_t i = 0; i < n; i++){
+      LinkRx rx = link.feed(buf[i], nowMs);
+      if (rx == LINK_RX_PASS) handleSerialCommand((char)buf[i]);
+      else if (rx == LINK_RX_FRAME) handleLinkFrame();
+    }
+  }
+}
+
+void SimpleSequencer::linkReply(uint8_t type, const uint8_t* payload, uint16_t len){
+  uint16_t n = linkEncode(type, link.seq, payload, len, linkTx);
+  Serial.write(linkTx, n);
+  Serial.send_now(); // the host waits for this reply before its next request
+}
+
+void SimpleSequencer::linkNak(uint8_t err){
+  linkReply(LINK_NAK, &err, 1);
+}
+
+FLASHMEM uint16_t SimpleSequencer::buildLinkSettings(uint8_t* out){
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) if (midiRouter.clockOut(i)) mask |= 1 << i;
+  out[0] = LINK_SETTINGS_FORMAT;
+  out[1] = clockIn.priority();
+  out[2] = transportQuant;
+  out[3] = mask;
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    out[4 + c * 3] = midiRouter.route[c].port;
+    out[5 + c * 3] = midiRouter.route[c].channel;
+    out[6 + c * 3] = (uint8_t)pat->trackDelayMs[c];
+  }
+  const MidiThruConfig& t = midiRouter.thruConfig;
+  uint8_t* th = out + LINK_SETTINGS_V1_BYTES;
+  th[0] = t.mode;
+  th[1] = t.sources;
+  th[2] = t.ports;
+  th[3] = t.channels & 0xFF;
+  th[4] = t.channels >> 8;
+  memcpy(th + 5, t.remap, 16);
+  return LINK_SETTINGS_BYTES;
+}
+
+// All fields are checked before any is applied
+FLASHMEM bool SimpleSequencer::applyLinkSettings(const uint8_t* in, uint16_t len){
+  // format 1 files (no thru) still load and leave the thru as it is
+  bool v1 = in[0] == 1 && len == LINK_SETTINGS_V1_BYTES;
+  if (!v1 && (len != LINK_SETTINGS_BYTES || in[0] != LINK_SETTINGS_FORMAT)) return false;
+  const uint8_t* th = in + LINK_SETTINGS_V1_BYTES;
+  if (!v1){
+    if (th[0] >= MIDI_THRU_NUM_MODES) return false;
+    for (uint8_t c = 0; c < 16; c++) if (th[5 + c] > 15 && th[5 + c] != 0xFF) return false;
+  }
+  if (in[1] >= CLOCK_NUM_PRIORITIES || in[2] >= TQ_NUM_MODES) return false;
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    int8_t d = (int8_t)in[6 + c * 3];
+    if (!midiRouter.hasPort(in[4 + c * 3]) || in[5 + c * 3] > 15) return false;
+    if (d < -TRACK_DELAY_MAX_MS || d > TRACK_DELAY_MAX_MS) return false;
+  }
+  noInterrupts();
+  clockIn.setPriority(in[1]);
+  transportQuant = in[2];
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) midiRouter.setClockOut(i, ((in[3] >> i) & 1) && midiRouter.hasPort(i));
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    midiRouter.route[c].port = in[4 + c * 3];
+    midiRouter.route[c].channel = in[5 + c * 3];
+    pat->trackDelayMs[c] = (int8_t)in[6 + c * 3];
+  }
+  if (!v1){
+    MidiThruConfig& t = midiRouter.thruConfig;
+    t.mode = th[0];
+    t.sources = th[1];
+    t.ports = th[2];
+    t.channels = th[3] | (th[4] << 8);
+    memcpy(t.remap, th + 5, 16);
+  }
+  interrupts();
+  return true;
+}
+
+// One request per frame: PING, or GET / PUT { object, index (LE16), record }.
+// Records are validated (header + CRC) before anything is stored or applied.
+FLASHMEM void SimpleSequencer::handleLinkFrame(){
+  if (link.type == LINK_PING){
+    uint16_t records = projectStore.recordCount();
+    uint8_t info[8] = { LINK_PROTOCOL_VERSION, SAVE_VERSION, SAVE_NUM_SLOTS,
+                        (uint8_t)(LINK_MAX_PAYLOAD & 0xFF), (uint8_t)(LINK_MAX_PAYLOAD >> 8),
+                        (uint8_t)(records & 0xFF), (uint8_t)(records >> 8), projectReady };
+    linkReply(LINK_ACK, info, sizeof(info));
+    return;
+  }
+  if (link.type == LINK_STREAM && link.len == 1){
+    telemetryOn = false;
+    telemetry.clear();
+    telemetryStatusTicks = TELEMETRY_STATUS_MS; // first tempo / queue sample right away
+    telemetryOn = link.payload[0] != 0;
+    linkReply(LINK_ACK, nullptr, 0);
+    return;
+  }
+  if ((link.type != LINK_GET && link.type != LINK_PUT) || link.len < 3) { linkNak(LINK_ERR_TYPE); return; }
+  uint8_t obj = link.payload[0];
+  uint16_t index = link.payload[1] | (link.payload[2] << 8);
+  if (obj > LINK_OBJ_TRACE) { linkNak(LINK_ERR_TYPE); return; }
+  if (obj == LINK_OBJ_SLOT && index >= SAVE_NUM_SLOTS) { linkNak(LINK_ERR_RANGE); return; }
+  if (obj == LINK_OBJ_PROJECT){
+    if (!projectReady) { linkNak(LINK_ERR_NO_SD); return; }
+    if (index >= projectStore.recordCount()) { linkNak(LINK_ERR_RANGE); return; }
+  }
+
+  if (link.type == LINK_GET){
+    // DATA echoes object + index in front of the bytes
+    uint8_t out[LINK_MAX_PAYLOAD];
+    memcpy(out, link.payload, 3);
+    uint8_t* rec = out + 3;
+    uint16_t len = 0;
+    if (obj == LINK_OBJ_PATTERN){
+      len = buildSlotRecord(rec);
+    } else if (obj == LINK_OBJ_SLOT){
+      len = readSlotRecord(index, rec);
+    } else if (obj == LINK_OBJ_PROJECT){
+      if (!projectStore.readRecord(index, rec)) { linkNak(LINK_ERR_IO); return; }
+      len = saveRecordBytes(rec, projectStore.recordBytes());
+    } else if (obj == LINK_OBJ_SETTINGS){
+      len = buildLinkSettings(rec);
+    } else {
+      // trace chunk: header, then up to TRACE_CHUNK_RECORDS records oldest first
+      uint16_t total = traceRing.count();
+      uint32_t first = (uint32_t)index * TRACE_CHUNK_RECORDS;
+      if (first > total) { linkNak(LINK_ERR_RANGE); return; }
+      uint16_t n = total - first < TRACE_CHUNK_RECORDS ? total - first : TRACE_CHUNK_RECORDS;
+      uint16_t mhz = F_CPU_ACTUAL / 1000000;
+      uint8_t header[TRACE_CHUNK_HEADER] = { (uint8_t)(total & 0xFF), (uint8_t)(total >> 8), (uint8_t)(mhz & 0xFF), (uint8_t)(mhz >> 8),
+                                             (uint8_t)(first & 0xFF), (uint8_t)(first >> 8), 0, 0 };
+      memcpy(rec, header, sizeof(header));
+      for (uint16_t i = 0; i < n; i++) tracePack(traceRing.at(first + i), rec + TRACE_CHUNK_HEADER + i * TRACE_RECORD_BYTES);
+      len = TRACE_CHUNK_HEADER + n * TRACE_RECORD_BYTES;
+    }
+    if (len == 0) { linkNak(LINK_ERR_EMPTY); return; }
+    linkReply(LINK_DATA, out, 3 + len);
+    return;
+  }
+
+  // PUT
+  const uint8_t* data = link.payload + 3;
+  uint16_t dataLen = link.len - 3;
+  if (obj == LINK_OBJ_SETTINGS){
+    if (!applyLinkSettings(data, dataLen)) { linkNak(LINK_ERR_RECORD); return; }
+    linkReply(LINK_ACK, nullptr, 0);
+    return;
+  }
+  if (obj == LINK_OBJ_TRACE){
+    if (dataLen != 1) { linkNak(LINK_ERR_RECORD); return; }
+    traceRing.freeze(data[0] != 0);
+    linkReply(LINK_ACK, nullptr, 0);
+    return;
+  }
+  uint16_t len = saveRecordBytes(data, dataLen);
+  if (len == 0 || len != dataLen) { linkNak(LINK_ERR_RECORD); return; }
+  bool ok;
+  if (obj == LINK_OBJ_PATTERN){
+    ok = applySlotRecord(data);
+    if (!ok) { linkNak(LINK_ERR_RECORD); return; }
+  } else if (obj == LINK_OBJ_SLOT){
+    SaveSlotEntry table[SAVE_NUM_SLOTS];
+    if (readSlotTable(table) - table[index].bytes + len > SAVE_DATA_BYTES) { linkNak(LINK_ERR_FULL); return; }
+    ok = writeSlotRecord(index, data, len);
+  } else {
+    // a cued pattern is streaming from the same file
+    if (projectStore.busy()) { linkNak(LINK_ERR_BUSY); return; }
+    ok = projectStore.writeRecord(index, data, len);
+  }
+  if (ok) linkReply(LINK_ACK, nullptr, 0);
+  else linkNak(LINK_ERR_IO);
 }
 
 void SimpleSequencer::readButtons(){
@@ -356,11 +817,35 @@ void SimpleSequencer::readButtons(){
           if (chanModHeld && i < NUM_CHANNELS) {
             selectedChannel = i;
           }
+          // 1b. PAGE SWITCH: Fn + START + Button 16 flips the modulation / arp page
+          else if (chanModHeld && digitalRead(START_STOP_PIN) == LOW && i == NUM_STEPS - 1) {
+            arpPage = !arpPage;
+            startStopModifierFlag = true;
+            focusEncoder = 1; // show the page straight away
+            lastEncoderMoveTime = millis();
+          }
+          // 1c. UNDO / REDO: Fn + START + Button 14 / 15
+          else if (chanModHeld && digitalRead(START_STOP_PIN) == LOW && (i == NUM_STEPS - 3 || i == NUM_STEPS - 2)) {
+            undoEdit(i == NUM_STEPS - 2);
+            startStopModifierFlag = true;
+          }
+          // 1d. PAD PLAY: Fn + START + Button 13 cycles off / drum / chromatic
+          else if (chanModHeld && digitalRead(START_STOP_PIN) == LOW && i == NUM_STEPS - 4) {
+            setPadMode(padMode + 1);
+            startStopModifierFlag = true;
+          }
           // 2. MUTE INTERCEPT: START (pin 27) + Buttons 1-4 => mute/unmute channel
           else if ((digitalRead(START_STOP_PIN) == LOW) && i < NUM_CHANNELS) {
-            muted[i] = !muted[i];
+            pat->muted[i] = !pat->muted[i];
             startStopModifierFlag = true;
           }
+          // 2b. PAD PLAY: normally the edge interrupt has played it already
+          else if (padMode != PAD_OFF) {
+            if (!chanModHeld && digitalRead(START_STOP_PIN) != LOW && padClaim(i, true) == PAD_IDLE){
+              padPolled++;
+              padPress(i, 0);
+            }
+          }
           // 3. NORMAL STEP TOGGLE / P-LOCK HOLD
           else {
             pendingToggle[i] = true;
@@ -374,38 +859,43 @@ void SimpleSequencer::readButtons(){
           if (pendingToggle[i]){
             bool startHeld = (digitalRead(START_STOP_PIN) == LOW);
             if (startHeld) {
-              // If START is held, treat the button as a momentary trigger — do not toggle state
+              // START held: a chord that matched no gesture, so no toggle (pads play in pad mode)
               pendingToggle[i] = false;
             } else {
-              if (euclidEnabled[selectedChannel]) {
-                // Toggle the generated euclidPattern and keep steps[] in sync
-                bool newState = !euclidPattern[selectedChannel][i];
-                euclidPattern[selectedChannel][i] = newState;
-                steps[selectedChannel][i] = newState;
+              if (pat->euclidEnabled[selectedChannel]) {
+                // Toggle the generated euclidPattern and keep pat->steps[] in sync
+                pat->euclidPattern[selectedChannel] ^= (1ULL << i);
+                bool newState = (pat->euclidPattern[selectedChannel] >> i) & 1;
+                pat->steps[selectedChannel][i] = newState;
                 if (newState) {
                   // Turning ON: initialize per-step params if unset so they are remembered
-                  if (pitch[selectedChannel][i] == 255) pitch[selectedChannel][i] = channelPitch[selectedChannel];
-                  if (noteLen[selectedChannel][i] == 255) noteLen[selectedChannel][i] = noteLenIdx;
-                  if (stepVelocity[selectedChannel][i] == 255) stepVelocity[selectedChannel][i] = channelVelocity[selectedChannel];
+                  if (pat->pitch[selectedChannel][i] == 255) pat->pitch[selectedChannel][i] = pat->channelPitch[selectedChannel];
+                  if (pat->noteLen[selectedChannel][i] == 255) pat->noteLen[selectedChannel][i] = pat->noteLenIdx;
+                  if (pat->stepVelocity[selectedChannel][i] == 255) pat->stepVelocity[selectedChannel][i] = pat->channelVelocity[selectedChannel];
                   // leave fillState/ratchet/slide as-is (user can set)
                 } else {
                   // Turning OFF: preserve per-step params so re-enabling restores them
                 }
               } else {
-                steps[selectedChannel][i] = !steps[selectedChannel][i];
+                pat->steps[selectedChannel][i] = !pat->steps[selectedChannel][i];
                 // THE ERASER: If step turned OFF, reset it to Global defaults (255) and clear Fill & Ratchet
-                if (!steps[selectedChannel][i]) {
-                  noteLen[selectedChannel][i] = 255;
-                  pitch[selectedChannel][i] = 255;
-                  fillState[selectedChannel][i] = 0;
-                  stepRatchet[selectedChannel][i] = 0;
-                  stepVelocity[selectedChannel][i] = 255;
-                  stepSlide[selectedChannel][i] = false;
+                if (!pat->steps[selectedChannel][i]) {
+                  pat->noteLen[selectedChannel][i] = 255;
+                  pat->pitch[selectedChannel][i] = 255;
+                  pat->fillState[selectedChannel][i] = 0;
+                  pat->stepRatchet[selectedChannel][i] = 0;
+                  pat->stepVelocity[selectedChannel][i] = 255;
+                  pat->stepSlide[selectedChannel][i] = false;
+                  pat->stepProb[selectedChannel][i] = 100;
+                  pat->stepCond[selectedChannel][i] = TRIG_ALWAYS;
+                  pat->plocks.clearStep(selectedChannel, i);
                 }
               }
-              Serial.print("Ch"); Serial.print(selectedChannel+1);
-              Serial.print(" Step "); Serial.print(i);
-              Serial.print(" = "); Serial.println(steps[selectedChannel][i]);
+              if (telemetryOn){
+                noInterrupts();
+                telemetry.push(TEL_EDIT, micros(), selectedChannel, i, pat->steps[selectedChannel][i]);
+                interrupts();
+              }
               pendingToggle[i] = false;
             }
           }
@@ -413,6 +903,11 @@ void SimpleSequencer::readButtons(){
         }
       }
     }
+    // pad released for a full debounce but still sounding: its edge fell in the lockout
+    if (padNote[i] < 128 && !reading && (now - lastDebounceTime[i]) > debounceMs){
+      uint8_t note = padClaim(i, false);
+      if (note < 128) padRelease(i, note);
+    }
     lastReading[i] = reading;
   }
 }
@@ -481,8 +976,26 @@ void SimpleSequencer::readEncoders(){
         // show encoder focus when the encoder is actively being used
         focusEncoder = e + 1;
         lastEncoderMoveTime = millis();
-        if (e == 0){ // Encoder 1: BPM or Ratchet when a step is held
-          if (heldStep >= 0){
+        // Fn + START held with no step: modulation page for the selected channel
+        bool modEdit = heldStep < 0 && digitalRead(START_STOP_PIN) == LOW && digitalRead(CHANNEL_BTN_PIN) == LOW;
+        if (modEdit){
+          if (arpPage) editArp(e, encSteps); else editModulation(e, encSteps);
+        } else if (e == 0){ // Encoder 1: BPM or Ratchet when a step is held
+          bool startHeldE1 = (digitalRead(START_STOP_PIN) == LOW);
+          bool chanModHeldE1 = (digitalRead(CHANNEL_BTN_PIN) == LOW);
+          if (heldStep >= 0 && startHeldE1){
+            // START + Enc1: per-step trig probability (1 % per detent)
+            pendingToggle[heldStep] = false;
+            pat->steps[selectedChannel][heldStep] = true;
+            int pr = (int)pat->stepProb[selectedChannel][heldStep] + encSteps;
+            pat->stepProb[selectedChannel][heldStep] = (uint8_t)constrain(pr, 0, 100);
+          } else if (heldStep >= 0 && chanModHeldE1){
+            // Fn + Enc1: per-step trig condition (ALL, 1ST, !1ST, PRE, !PRE, 1:2 ... 8:8)
+            pendingToggle[heldStep] = false;
+            pat->steps[selectedChannel][heldStep] = true;
+            int cd = (int)pat->stepCond[selectedChannel][heldStep] + encSteps;
+            pat->stepCond[selectedChannel][heldStep] = (uint8_t)constrain(cd, 0, TRIG_NUM_CONDITIONS - 1);
+          } else if (heldStep >= 0){
             // RATCHET GEARBOX
             static int ratchetAcc = 0;
             ratchetAcc += encSteps;
@@ -492,19 +1005,15 @@ void SimpleSequencer::readEncoders(){
               ratchetAcc %= 2;
               
               pendingToggle[heldStep] = false;
-              steps[selectedChannel][heldStep] = true;
-              int val = (int)stepRatchet[selectedChannel][heldStep] + rSteps;
-              stepRatchet[selectedChannel][heldStep] = (uint8_t)constrain(val, 0, 5);
+              pat->steps[selectedChannel][heldStep] = true;
+              int val = (int)pat->stepRatchet[selectedChannel][heldStep] + rSteps;
+              pat->stepRatchet[selectedChannel][heldStep] = (uint8_t)constrain(val, 0, 5);
             }
           } else {
             int newBpm = (int)bpm + encSteps;
             if (newBpm < 20) newBpm = 20;
             if (newBpm > 300) newBpm = 300;
-            bpm = newBpm;
-            if (isRunning && !externalMidiClockActive && midiTimerRunning){
-              uint32_t interval = (60000000UL / bpm) / 24;
-              midiClockTimer.update(interval);
-            }
+            setBpm(newBpm);
           }
         } else if (e == 1){ // encoder 2: PITCH or scale-shift when Euclid active
           // New behavior: If START/STOP (Pin 27) is held, adjust Accent (Velocity).
@@ -514,32 +1023,36 @@ void SimpleSequencer::readEncoders(){
             // otherwise adjust the channel default velocity.
             if (heldStep >= 0) {
               pendingToggle[heldStep] = false;
-              steps[selectedChannel][heldStep] = true;
-              if (stepVelocity[selectedChannel][heldStep] == 255) stepVelocity[selectedChannel][heldStep] = channelVelocity[selectedChannel];
-              int v = (int)stepVelocity[selectedChannel][heldStep] + encSteps;
-              stepVelocity[selectedChannel][heldStep] = (uint8_t)constrain(v, 0, 127);
+              pat->steps[selectedChannel][heldStep] = true;
+              if (pat->stepVelocity[selectedChannel][heldStep] == 255) pat->stepVelocity[selectedChannel][heldStep] = pat->channelVelocity[selectedChannel];
+              int v = (int)pat->stepVelocity[selectedChannel][heldStep] + encSteps;
+              pat->stepVelocity[selectedChannel][heldStep] = (uint8_t)constrain(v, 0, 127);
             } else {
-              int v = (int)channelVelocity[selectedChannel] + encSteps;
-              channelVelocity[selectedChannel] = (uint8_t)constrain(v, 0, 127);
+              int v = (int)pat->channelVelocity[selectedChannel] + encSteps;
+              pat->channelVelocity[selectedChannel] = (uint8_t)constrain(v, 0, 127);
             }
+          } else if (heldStep >= 0 && digitalRead(CHANNEL_BTN_PIN) == LOW) {
+            // Fn + Enc2 on a held step: choose which CC Fn + Enc3 locks
+            int cc = (int)ccLockParam[selectedChannel] + encSteps;
+            ccLockParam[selectedChannel] = (uint8_t)constrain(cc, 0, PLOCK_CC_MAX);
           } else {
             if (heldStep >= 0){
               // Per-step fine adjustment (P-Lock)
               pendingToggle[heldStep] = false;
-              steps[selectedChannel][heldStep] = true;
-              if (pitch[selectedChannel][heldStep] == 255) {
-                pitch[selectedChannel][heldStep] = channelPitch[selectedChannel];
+              pat->steps[selectedChannel][heldStep] = true;
+              if (pat->pitch[selectedChannel][heldStep] == 255) {
+                pat->pitch[selectedChannel][heldStep] = pat->channelPitch[selectedChannel];
               }
-              int note = (int)pitch[selectedChannel][heldStep] + encSteps;
-              pitch[selectedChannel][heldStep] = (uint8_t)constrain(note, 0, 127);
+              int note = (int)pat->pitch[selectedChannel][heldStep] + encSteps;
+              pat->pitch[selectedChannel][heldStep] = (uint8_t)constrain(note, 0, 127);
             } else {
               // If Euclidean engine is active, rotate should shift the whole scale
-              if (euclidEnabled[selectedChannel]){
+              if (pat->euclidEnabled[selectedChannel]){
                 shiftEuclidNotes(selectedChannel, encSteps);
               } else {
                 if (encSteps != 0){
-                  int note = (int)channelPitch[selectedChannel] + encSteps;
-                  channelPitch[selectedChannel] = (uint8_t)constrain(note, 0, 127);
+                  int note = (int)pat->channelPitch[selectedChannel] + encSteps;
+                  pat->channelPitch[selectedChannel] = (uint8_t)constrain(note, 0, 127);
                 }
               }
             }
@@ -547,42 +1060,60 @@ void SimpleSequencer::readEncoders(){
         } else if (e == 2){ // encoder 3: NOTE LENGTH
           // Encoder 3: primary function is gate/length, but when START is held allow Slide toggling
           bool startHeldE3 = (digitalRead(START_STOP_PIN) == LOW);
+          bool chanModHeldE3 = (digitalRead(CHANNEL_BTN_PIN) == LOW);
           if (startHeldE3 && heldStep >= 0) {
             // Use turns to set/clear slide for the held step. Positive = ON, Negative = OFF
-            if (encSteps > 0) stepSlide[selectedChannel][heldStep] = true;
-            else if (encSteps < 0) stepSlide[selectedChannel][heldStep] = false;
+            if (encSteps > 0) pat->stepSlide[selectedChannel][heldStep] = true;
+            else if (encSteps < 0) pat->stepSlide[selectedChannel][heldStep] = false;
+          } else if (chanModHeldE3 && heldStep >= 0) {
+            // Fn + Enc3: CC p-lock value for the held step. Turning below 0 removes the lock.
+            uint8_t cc = ccLockParam[selectedChannel];
+            int cur = pat->plocks.get(selectedChannel, heldStep, cc);
+            int v = (cur < 0 ? 63 : cur) + encSteps;
+            pendingToggle[heldStep] = false;
+            pat->steps[selectedChannel][heldStep] = true;
+            if (cur >= 0 && v < 0) pat->plocks.remove(selectedChannel, heldStep, cc);
+            else if (!pat->plocks.set(selectedChannel, heldStep, cc, (uint8_t)constrain(v, 0, 127))) traceRing.record(TR_PLOCK_FULL, selectedChannel, heldStep);
+          } else if (startHeldE3 && heldStep < 0) {
+            // START + Enc3: MIDI channel the track plays on
+            int mc = (int)midiRouter.route[selectedChannel].channel + encSteps;
+            midiRouter.route[selectedChannel].channel = (uint8_t)constrain(mc, 0, 15);
           } else {
             if (heldStep >= 0){
               pendingToggle[heldStep] = false;
-              steps[selectedChannel][heldStep] = true;
-              if (noteLen[selectedChannel][heldStep] == 255) {
-                noteLen[selectedChannel][heldStep] = noteLenIdx;
+              pat->steps[selectedChannel][heldStep] = true;
+              if (pat->noteLen[selectedChannel][heldStep] == 255) {
+                pat->noteLen[selectedChannel][heldStep] = pat->noteLenIdx;
               }
-              int idxn = (int)noteLen[selectedChannel][heldStep] + encSteps;
+              int idxn = (int)pat->noteLen[selectedChannel][heldStep] + encSteps;
               int maxIdx = (int)(sizeof(noteLenTicks)/sizeof(noteLenTicks[0])) - 1;
-              noteLen[selectedChannel][heldStep] = (uint8_t)constrain(idxn, 0, maxIdx);
+              pat->noteLen[selectedChannel][heldStep] = (uint8_t)constrain(idxn, 0, maxIdx);
             } else {
-              int idxn = (int)noteLenIdx + encSteps;
+              int idxn = (int)pat->noteLenIdx + encSteps;
               int maxIdx = (int)(sizeof(noteLenTicks)/sizeof(noteLenTicks[0])) - 1;
-              noteLenIdx = (uint8_t)constrain(idxn, 0, maxIdx);
+              pat->noteLenIdx = (uint8_t)constrain(idxn, 0, maxIdx);
             }
           }
         } else if (e == 3){ // encoder 4: EUCLID PULSES or OFFSET
-          if (heldStep < 0) { 
-            if (euclidEnabled[selectedChannel]){
+          if (heldStep < 0 && digitalRead(START_STOP_PIN) == LOW) {
+            // START + Enc4: track delay in ms (negative = earlier) for slow downstream synths
+            int d = (int)pat->trackDelayMs[selectedChannel] + encSteps;
+            pat->trackDelayMs[selectedChannel] = (int8_t)constrain(d, -TRACK_DELAY_MAX_MS, TRACK_DELAY_MAX_MS);
+          } else if (heldStep < 0) { 
+            if (pat->euclidEnabled[selectedChannel]){
               bool chanModHeld = (digitalRead(CHANNEL_BTN_PIN) == LOW);
               
               if (chanModHeld) {
                 // Adjust the Shift Offset
-                int o = (int)euclidOffset[selectedChannel] + encSteps;
+                int o = (int)pat->euclidOffset[selectedChannel] + encSteps;
                 while (o < 0) o += NUM_STEPS; // Safe negative wrapping
-                euclidOffset[selectedChannel] = (uint8_t)(o % NUM_STEPS);
+                pat->euclidOffset[selectedChannel] = (uint8_t)(o % NUM_STEPS);
               } else {
                 // Adjust the Hit Pulses
-                int p = (int)pulses[selectedChannel] + encSteps;
+                int p = (int)pat->pulses[selectedChannel] + encSteps;
                 if (p < 0) p = 0;
                 if (p > NUM_STEPS) p = NUM_STEPS;
-                pulses[selectedChannel] = p;
+                pat->pulses[selectedChannel] = p;
               }
               updateEuclid(selectedChannel);
             }
@@ -609,29 +1140,41 @@ void SimpleSequencer::readEncoders(){
           focusEncoder = e + 1;
           lastEncoderMoveTime = millis();
           // PRESSED
-          if (e == 0) {
+          bool modEdit = heldStep < 0 && digitalRead(START_STOP_PIN) == LOW && digitalRead(CHANNEL_BTN_PIN) == LOW;
+          if (modEdit) {
+            if (arpPage) clickArp(e); else clickModulation(e);
+          }
+          else if (e == 0) {
             // Encoder 1 Click: Fn+Click = Save, Click = enable retrig/ratchet gearbox when p-locking
             bool chanModHeld = (digitalRead(CHANNEL_BTN_PIN) == LOW);
             if (chanModHeld) {
               saveState();
             } else {
               if (heldStep >= 0) {
-                uint8_t &r = stepRatchet[selectedChannel][heldStep];
+                uint8_t &r = pat->stepRatchet[selectedChannel][heldStep];
                 r = (r == 0) ? 1 : 0; // toggle simple ratchet enable
                 pendingToggle[heldStep] = false;
-                steps[selectedChannel][heldStep] = true;
+                pat->steps[selectedChannel][heldStep] = true;
               }
             }
           }
           else if (e == 1) {
             // Encoder 2 Click: Cycle scale modes only when Euclid is enabled
-            if (euclidEnabled[selectedChannel]){
-              euclidScaleMode[selectedChannel] = (euclidScaleMode[selectedChannel] + 1) % 4;
+            // START+Click toggles the trigger-time quantiser, Fn+Click learns a user scale
+            bool startHeld = (digitalRead(START_STOP_PIN) == LOW);
+            bool chanModHeld = (digitalRead(CHANNEL_BTN_PIN) == LOW);
+            if (startHeld){
+              pat->quantizeEnabled[selectedChannel] = !pat->quantizeEnabled[selectedChannel];
+              startStopModifierFlag = true;
+            } else if (chanModHeld){
+              learnUserScale(selectedChannel);
+            } else if (pat->euclidEnabled[selectedChannel]){
+              pat->euclidScaleMode[selectedChannel] = (pat->euclidScaleMode[selectedChannel] + 1) % SCALE_NUM_MODES;
               randomizeEuclidMelody(selectedChannel);
             } else {
               // Ensure scale mode is off and fall back to channel note
-              euclidScaleMode[selectedChannel] = 0;
-              for (uint8_t s=0; s<NUM_STEPS; s++) pitch[selectedChannel][s] = 255;
+              pat->euclidScaleMode[selectedChannel] = 0;
+              for (uint8_t s=0; s<NUM_STEPS; s++) pat->pitch[selectedChannel][s] = 255;
             }
           }
           else if (e == 2) {
@@ -641,26 +1184,43 @@ void SimpleSequencer::readEncoders(){
               clearTrack(selectedChannel);
               focusEncoder = 3;
               lastEncoderMoveTime = millis();
+            } else if (heldStep < 0 && digitalRead(START_STOP_PIN) == LOW) {
+              // START + Click: next output port for the track
+              TrackRoute& r = midiRouter.route[selectedChannel];
+              for (uint8_t k = 1; k <= MIDI_MAX_PORTS; k++){
+                uint8_t id = (r.port + k) % MIDI_MAX_PORTS;
+                if (midiRouter.hasPort(id)) { r.port = id; break; }
+              }
             } else if (heldStep >= 0) {
               // Normal Enc 3 Click: Toggle Fill on held step
-              uint8_t &fs = fillState[selectedChannel][heldStep];
+              uint8_t &fs = pat->fillState[selectedChannel][heldStep];
               fs = (fs + 1) % 3;
-              steps[selectedChannel][heldStep] = true;
+              pat->steps[selectedChannel][heldStep] = true;
               pendingToggle[heldStep] = false;
             }
           }
           else if (e == 3){
-            // Encoder 4 Click: toggle euclid engine on/off
-            euclidEnabled[selectedChannel] = !euclidEnabled[selectedChannel];
-            if (euclidEnabled[selectedChannel]){
-              // If enabling and a scale is selected, regenerate melody
-              if (euclidScaleMode[selectedChannel] != 0) randomizeEuclidMelody(selectedChannel);
+            // Encoder 4 Click: toggle euclid engine on/off (Fn+Click: toggle Bresenham/Bjorklund)
+            bool chanModHeld = (digitalRead(CHANNEL_BTN_PIN) == LOW);
+            if (heldStep < 0 && digitalRead(START_STOP_PIN) == LOW) {
+              // START + Click: clock output on/off for the track's port
+              uint8_t port = midiRouter.route[selectedChannel].port;
+              midiRouter.setClockOut(port, !midiRouter.clockOut(port));
+            } else if (chanModHeld && pat->euclidEnabled[selectedChannel]) {
+              pat->euclidMode[selectedChannel] = (pat->euclidMode[selectedChannel] + 1) % EUCLID_NUM_MODES;
               updateEuclid(selectedChannel);
             } else {
-              // Disabling Euclid: clear scale mode and revert per-step pitches to channel note
-              euclidScaleMode[selectedChannel] = 0;
-              for (uint8_t s=0; s<NUM_STEPS; s++) pitch[selectedChannel][s] = 255;
-              updateEuclid(selectedChannel);
+              pat->euclidEnabled[selectedChannel] = !pat->euclidEnabled[selectedChannel];
+              if (pat->euclidEnabled[selectedChannel]){
+                // If enabling and a scale is selected, regenerate melody
+                if (pat->euclidScaleMode[selectedChannel] != 0) randomizeEuclidMelody(selectedChannel);
+                updateEuclid(selectedChannel);
+              } else {
+                // Disabling Euclid: clear scale mode and revert per-step pitches to channel note
+                pat->euclidScaleMode[selectedChannel] = 0;
+                for (uint8_t s=0; s<NUM_STEPS; s++) pat->pitch[selectedChannel][s] = 255;
+                updateEuclid(selectedChannel);
+              }
             }
           }
         }
@@ -672,439 +1232,1651 @@ void SimpleSequencer::readEncoders(){
 }
 
 
-void SimpleSequencer::saveState() {
-  SaveData data;
-  data.magicNumber = 13572469; // Unique signature (v3)
-  data.savedBpm = bpm;
-  data.savedNoteLenIdx = noteLenIdx;
-  
+// --- EEPROM SAVE SYSTEM ---
+// Bit-packed, versioned slots. See SaveFormat.h for the layout.
+
+void SimpleSequencer::encodePattern(BitWriter& w) {
+  w.put(bpm, SAVE_BITS_BPM);
+  w.put(pat->noteLenIdx, SAVE_BITS_LEN_IDX);
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    w.put(pat->channelPitch[c], SAVE_BITS_NOTE);
+    w.putBool(pat->muted[c]);
+    w.putBool(pat->euclidEnabled[c]);
+    w.put(pat->pulses[c], SAVE_BITS_PULSES);
+    w.put(pat->euclidOffset[c], SAVE_BITS_OFFSET);
+    w.put(pat->euclidScaleMode[c], SAVE_BITS_SCALE);
+    w.put(pat->channelVelocity[c], SAVE_BITS_VEL);
+    w.put(pat->euclidMode[c], 1);
+    w.put(pat->scaleRoot[c], SAVE_BITS_ROOT);
+    w.put(pat->userScaleMask[c], SAVE_BITS_SCALE_MASK);
+    w.putBool(pat->quantizeEnabled[c]);
+  }
   for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
-    data.savedChannelPitch[c] = channelPitch[c];
-    data.savedMuted[c] = muted[c];
-    data.savedEuclidEnabled[c] = euclidEnabled[c];
-    data.savedPulses[c] = pulses[c];
-    data.savedEuclidOffset[c] = euclidOffset[c];
-    data.savedEuclidScaleMode[c] = euclidScaleMode[c];
-    
     for (uint8_t s = 0; s < NUM_STEPS; s++) {
-      data.savedSteps[c][s] = steps[c][s];
-      data.savedPitch[c][s] = pitch[c][s];
-      data.savedNoteLen[c][s] = noteLen[c][s];
-      data.savedFillStep[c][s] = fillState[c][s];
-      data.savedStepRatchet[c][s] = stepRatchet[c][s];
-      data.savedStepVelocity[c][s] = stepVelocity[c][s];
-      data.savedStepSlide[c][s] = stepSlide[c][s] ? 1 : 0;
+      w.putBool(pat->steps[c][s]);
+      w.putOpt(pat->pitch[c][s], SAVE_BITS_NOTE);
+      w.putOpt(pat->noteLen[c][s], SAVE_BITS_LEN_IDX);
+      w.put(pat->fillState[c][s], SAVE_BITS_FILL);
+      w.put(pat->stepRatchet[c][s], SAVE_BITS_RATCHET);
+      w.putOpt(pat->stepVelocity[c][s], SAVE_BITS_VEL);
+      w.putBool(pat->stepSlide[c][s]);
     }
-    data.savedChannelVelocity[c] = channelVelocity[c];
   }
-  // Write to EEPROM
-  EEPROM.put(0, data);
-
-  // Flash the OLED
-  display.clearDisplay();
-  display.setTextSize(2);
-  display.setTextColor(SH110X_WHITE);
-  display.setCursor(24, 24);
-  display.print("SAVED!");
-  display.display();
-  delay(600);
+  // v7: seed + probability / conditions (default 100 % and ALWAYS cost 1 bit each)
+  w.put(pat->patternSeed, SAVE_BITS_SEED);
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    for (uint8_t s = 0; s < NUM_STEPS; s++) {
+      w.putBool(pat->stepProb[c][s] != 100);
+      if (pat->stepProb[c][s] != 100) w.put(pat->stepProb[c][s], SAVE_BITS_PROB);
+      w.putBool(pat->stepCond[c][s] != TRIG_ALWAYS);
+      if (pat->stepCond[c][s] != TRIG_ALWAYS) w.put(pat->stepCond[c][s], SAVE_BITS_COND);
+    }
+  }
+  // v8: sparse p-locks, in store order
+  w.put(pat->plocks.size(), SAVE_BITS_PLOCK_COUNT);
+  for (uint8_t i = 0; i < pat->plocks.size(); i++) {
+    const PLock& l = pat->plocks.at(i);
+    w.put(l.track, SAVE_BITS_TRACK);
+    w.put(l.step, SAVE_BITS_STEP);
+    w.put(l.param, SAVE_BITS_PLOCK_PARAM);
+    w.put(l.value, 7);
+  }
+  // v9: modulation settings
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    w.put(pat->lfo[c].shape, SAVE_BITS_LFO_SHAPE);
+    w.put(pat->lfo[c].rateIdx, SAVE_BITS_LFO_RATE);
+    w.put(pat->lfo[c].depth, 7);
+    w.put(pat->lfo[c].dest, SAVE_BITS_MOD_DEST);
+    w.put(pat->env[c].attackIdx, SAVE_BITS_ENV_TIME);
+    w.put(pat->env[c].decayIdx, SAVE_BITS_ENV_TIME);
+    w.put(pat->env[c].depth, 7);
+    w.put(pat->env[c].dest, SAVE_BITS_MOD_DEST);
+  }
+  // v10: track delay, stored offset by TRACK_DELAY_MAX_MS
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) w.put(pat->trackDelayMs[c] + TRACK_DELAY_MAX_MS, SAVE_BITS_TRACK_DELAY);
+  // v11: output routing and per-port clock enables
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    w.put(midiRouter.route[c].port, SAVE_BITS_PORT);
+    w.put(midiRouter.route[c].channel, SAVE_BITS_MIDI_CH);
+  }
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) w.putBool(midiRouter.clockOut(i));
+  // v12: clock source priority
+  w.put(clockIn.priority(), SAVE_BITS_CLOCK_PRIO);
+  // v13: arpeggiator
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    const ArpParams& a = pat->arp[c];
+    w.put(a.mode, SAVE_BITS_ARP_MODE);
+    w.put(a.source, 1);
+    w.put(a.octaves - 1, SAVE_BITS_ARP_OCTAVES);
+    w.put(a.rateIdx, SAVE_BITS_ARP_RATE);
+    w.put(a.chord, SAVE_BITS_ARP_CHORD);
+  }
+  // v14: groove
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    w.put(pat->trackGroove[c], SAVE_BITS_GROOVE);
+    w.put(pat->grooveAmount[c], SAVE_BITS_GROOVE_AMOUNT);
+  }
 }
 
-void SimpleSequencer::loadState() {
-  SaveData data;
-  EEPROM.get(0, data);
-
-  if (data.magicNumber == 13572469) {
-    bpm = data.savedBpm;
-    noteLenIdx = data.savedNoteLenIdx;
-
+// Decode a payload into `p` and `rig`. Every field is range-checked against what
+// the editor can produce; a value past that fails the whole record (r.ok() false)
+// rather than being patched, so a corrupt or foreign record never half-loads.
+// Only two fallbacks remain, both for settings that depend on this build rather
+// than on the record: a groove index past this build's table plays straight, and
+// a port that isn't registered routes to DIN.
+bool SimpleSequencer::decodePattern(BitReader& r, uint8_t version, Pattern& p, SaveRig& rig) {
+  if (version < 4 || version > SAVE_VERSION) return false;
+  const uint8_t maxLenIdx = (uint8_t)(sizeof(noteLenTicks) / sizeof(noteLenTicks[0])) - 1;
+  p.init();
+  rig.bpm = r.get(SAVE_BITS_BPM, 300);
+  if (rig.bpm < 20) r.reject();
+  p.noteLenIdx = r.get(SAVE_BITS_LEN_IDX, maxLenIdx);
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    p.channelPitch[c] = r.get(SAVE_BITS_NOTE, 127);
+    p.muted[c] = r.getBool();
+    p.euclidEnabled[c] = r.getBool();
+    p.pulses[c] = r.get(SAVE_BITS_PULSES, NUM_STEPS);
+    p.euclidOffset[c] = r.get(SAVE_BITS_OFFSET, NUM_STEPS - 1);
+    p.euclidScaleMode[c] = r.get(version >= 6 ? SAVE_BITS_SCALE : SAVE_BITS_SCALE_V5, SCALE_NUM_MODES - 1);
+    p.channelVelocity[c] = r.get(SAVE_BITS_VEL, 127);
+    p.euclidMode[c] = (version >= 5) ? (uint8_t)r.get(1, EUCLID_BJORKLUND) : (uint8_t)EUCLID_BRESENHAM;
+    if (version >= 6) {
+      p.scaleRoot[c] = r.get(SAVE_BITS_ROOT, 11);
+      p.userScaleMask[c] = r.get(SAVE_BITS_SCALE_MASK, SCALE_MASK_CHROMATIC);
+      p.quantizeEnabled[c] = r.getBool();
+    } else {
+      // Older melodies were generated from the channel note
+      p.scaleRoot[c] = p.channelPitch[c] % 12;
+    }
+    p.userScale[c] = makeScale(p.userScaleMask[c]);
+  }
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    for (uint8_t s = 0; s < NUM_STEPS; s++) {
+      p.steps[c][s] = r.getBool();
+      p.pitch[c][s] = r.getOpt(SAVE_BITS_NOTE, 127);
+      p.noteLen[c][s] = r.getOpt(SAVE_BITS_LEN_IDX, maxLenIdx);
+      p.fillState[c][s] = r.get(SAVE_BITS_FILL, 2);
+      p.stepRatchet[c][s] = r.get(SAVE_BITS_RATCHET, 5);
+      p.stepVelocity[c][s] = r.getOpt(SAVE_BITS_VEL, 127);
+      p.stepSlide[c][s] = r.getBool();
+    }
+  }
+  if (version >= 7) {
+    p.patternSeed = r.get(SAVE_BITS_SEED);
     for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
-      channelPitch[c] = data.savedChannelPitch[c];
-      muted[c] = data.savedMuted[c];
-      euclidEnabled[c] = data.savedEuclidEnabled[c];
-      pulses[c] = data.savedPulses[c];
-      euclidOffset[c] = data.savedEuclidOffset[c];
-      euclidScaleMode[c] = data.savedEuclidScaleMode[c];
-      
       for (uint8_t s = 0; s < NUM_STEPS; s++) {
-        steps[c][s] = data.savedSteps[c][s];
-        pitch[c][s] = data.savedPitch[c][s];
-        noteLen[c][s] = data.savedNoteLen[c][s];
-        fillState[c][s] = data.savedFillStep[c][s];
-        stepRatchet[c][s] = data.savedStepRatchet[c][s];
-        stepVelocity[c][s] = data.savedStepVelocity[c][s];
-        // Normalize suspicious saved per-step velocities (preserve 255 sentinel)
-        if (stepVelocity[c][s] != 255 && stepVelocity[c][s] > 120) stepVelocity[c][s] = 96;
-        stepSlide[c][s] = (data.savedStepSlide[c][s] != 0);
+        if (r.getBool()) p.stepProb[c][s] = r.get(SAVE_BITS_PROB, 100);
+        if (r.getBool()) p.stepCond[c][s] = r.get(SAVE_BITS_COND, TRIG_NUM_CONDITIONS - 1);
       }
-      channelVelocity[c] = data.savedChannelVelocity[c];
-      // If saved velocity is unexpectedly high (old TD-3 defaults), normalize to requested default
-      if (channelVelocity[c] > 120) channelVelocity[c] = 96;
-      // Regenerate Euclidean patterns if enabled
-      if (euclidEnabled[c]) updateEuclid(c);
     }
-    Serial.println("State loaded from EEPROM.");
+  }
+  if (version >= 8) {
+    uint8_t n = r.get(SAVE_BITS_PLOCK_COUNT, PLOCK_CAPACITY);
+    for (uint8_t i = 0; i < n && r.ok(); i++) {
+      uint8_t t = r.get(SAVE_BITS_TRACK, NUM_CHANNELS - 1);
+      uint8_t st = r.get(SAVE_BITS_STEP, NUM_STEPS - 1);
+      uint8_t prm = r.get(SAVE_BITS_PLOCK_PARAM, PLOCK_CC_MAX);
+      uint8_t v = r.get(7);
+      if (r.ok() && !p.plocks.set(t, st, prm, v)) r.reject();
+    }
+  }
+  if (version >= 9) {
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      p.lfo[c].shape = r.get(SAVE_BITS_LFO_SHAPE, LFO_NUM_SHAPES - 1);
+      p.lfo[c].rateIdx = r.get(SAVE_BITS_LFO_RATE, MOD_NUM_LFO_RATES - 1);
+      p.lfo[c].depth = r.get(7);
+      p.lfo[c].dest = r.get(SAVE_BITS_MOD_DEST);
+      if (!modDestValid(p.lfo[c].dest)) r.reject();
+      p.env[c].attackIdx = r.get(SAVE_BITS_ENV_TIME, MOD_NUM_ENV_TIMES - 1);
+      p.env[c].decayIdx = r.get(SAVE_BITS_ENV_TIME, MOD_NUM_ENV_TIMES - 1);
+      p.env[c].depth = r.get(7);
+      p.env[c].dest = r.get(SAVE_BITS_MOD_DEST);
+      if (!modDestValid(p.env[c].dest)) r.reject();
+    }
+  }
+  if (version >= 10) {
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      p.trackDelayMs[c] = (int8_t)((int)r.get(SAVE_BITS_TRACK_DELAY, 2 * TRACK_DELAY_MAX_MS) - TRACK_DELAY_MAX_MS);
+    }
+  }
+  if (version >= 11) {
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      uint8_t port = r.get(SAVE_BITS_PORT);
+      rig.route[c].port = midiRouter.hasPort(port) ? port : (uint8_t)MIDI_PORT_DIN;
+      rig.route[c].channel = r.get(SAVE_BITS_MIDI_CH);
+    }
+    for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) rig.clockOut[i] = r.getBool() && midiRouter.hasPort(i);
   } else {
-    Serial.println("No saved state found. Booting blank.");
+    // Before routing: track n on DIN channel n, clock on every port
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++) rig.route[c] = TrackRoute{MIDI_PORT_DIN, c};
+    for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) rig.clockOut[i] = midiRouter.hasPort(i);
   }
-}
-
-void SimpleSequencer::randomizeEuclidMelody(uint8_t ch) {
-  uint8_t mode = euclidScaleMode[ch];
-  
-  if (mode == 0) {
-    // MODE 0: OFF (Clear all 16 pitches back to the base drum sound)
-    for (uint8_t s = 0; s < NUM_STEPS; s++) {
-      pitch[ch][s] = 255; 
+  rig.clockPriority = (version >= 12) ? r.get(SAVE_BITS_CLOCK_PRIO, CLOCK_NUM_PRIORITIES - 1) : 0;
+  if (version >= 13) {
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      ArpParams& a = p.arp[c];
+      a.mode = r.get(SAVE_BITS_ARP_MODE, ARP_NUM_MODES - 1);
+      a.source = r.get(1, ARP_NUM_SOURCES - 1);
+      a.octaves = r.get(SAVE_BITS_ARP_OCTAVES, ARP_MAX_OCTAVES - 1) + 1;
+      a.rateIdx = r.get(SAVE_BITS_ARP_RATE, ARP_NUM_RATES - 1);
+      a.chord = r.get(SAVE_BITS_ARP_CHORD, ARP_NUM_CHORDS - 1);
+    }
+  }
+  if (version >= 14) {
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      // a groove this firmware doesn't have (imports changed) plays straight
+      uint8_t g = r.get(SAVE_BITS_GROOVE);
+      p.trackGroove[c] = (g < grooveCount) ? g : 0;
+      p.grooveAmount[c] = r.get(SAVE_BITS_GROOVE_AMOUNT, 100);
     }
-    return;
   }
-  // MODES 1-3: Generate Scale for ALL 16 STEPS (1=Locrian, 2=Diminished, 3=Atonal)
-  uint8_t root = channelPitch[ch];
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    if (p.euclidEnabled[c]) updateEuclid(p, c);
+  }
+  return r.ok();
+}
 
-  const uint8_t locrian[] = {0, 1, 3, 5, 6, 8, 10, 12};
-  const uint8_t diminished[] = {0, 1, 3, 4, 6, 7, 9, 10, 12};
-  const uint8_t atonal[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+// Serialise the current pattern as SaveSlotHeader + payload. Returns bytes used.
+uint16_t SimpleSequencer::buildSlotRecord(uint8_t* rec) {
+  uint8_t* payload = rec + sizeof(SaveSlotHeader);
+  BitWriter w(payload, SAVE_PAYLOAD_MAX_BYTES);
+  encodePattern(w);
+  if (!w.ok()) return 0;
+
+  SaveSlotHeader h;
+  h.version = SAVE_VERSION;
+  h.reserved = 0;
+  h.payloadBytes = w.bytes();
+  h.crc = crc16(payload, h.payloadBytes);
+  memcpy(rec, &h, sizeof(h));
+  return sizeof(SaveSlotHeader) + h.payloadBytes;
+}
 
-  for (uint8_t s = 0; s < NUM_STEPS; s++) {
-    uint8_t interval = 0;
-    if (mode == 1) interval = locrian[random(0, 8)];
-    else if (mode == 2) interval = diminished[random(0, 9)];
-    else if (mode == 3) interval = atonal[random(0, 13)];
+// Validate and decode a slot record (EEPROM or SD) into the spare pattern, then
+// swap it in. Leaves state untouched if the header, CRC or any field is bad.
+bool SimpleSequencer::applySlotRecord(const uint8_t* rec) {
+  if (saveRecordBytes(rec, SAVE_SLOT_BYTES) == 0) return false;
+  SaveSlotHeader h;
+  memcpy(&h, rec, sizeof(h));
+
+  BitReader r(rec + sizeof(SaveSlotHeader), h.payloadBytes);
+  // a staged cue lives in the spare: drop it before decoding over it
+  noInterrupts();
+  stagedPattern = -1;
+  Pattern* next = sparePattern();
+  interrupts();
+  SaveRig rig;
+  if (!decodePattern(r, h.version, *next, rig)) return false;
+  // Callers run in loop context (console, link PUT, boot): swap and apply the
+  // rig with interrupts off, as serviceStorage() does, so no engine pass sees the
+  // new pattern with the old routing and clock source.
+  noInterrupts();
+  pat = next;
+  // While playing, the running tempo, routing and clock source stay: a cued
+  // pattern must not jump the tempo or strand notes on a port it reroutes.
+  if (!isRunning) applyRig(rig);
+  interrupts();
+  // a different pattern: edits made to the old one can't be undone on it
+  undoResyncPending = true;
+  return true;
+}
 
-    // Randomly drop some notes down an octave for bass movement
-    int note = root + interval - (random(0, 2) * 12); 
-    pitch[ch][s] = (uint8_t)constrain(note, 0, 127);
+void SimpleSequencer::applyRig(const SaveRig& rig) {
+  setBpm(rig.bpm);
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) midiRouter.route[c] = rig.route[c];
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) midiRouter.setClockOut(i, rig.clockOut[i]);
+  clockIn.setPriority(rig.clockPriority);
+}
+
+// Tempo changes go through here so the internal clock timer follows at once
+void SimpleSequencer::setBpm(uint32_t newBpm) {
+  bpm = newBpm;
+  if (isRunning && !clockIn.external() && midiTimerRunning) midiClockTimer.update(tickPeriodUs());
+}
+
+bool SimpleSequencer::saveSlotTo(uint8_t slot) {
+  if (slot >= SAVE_NUM_SLOTS) return false;
+  uint8_t rec[SAVE_SLOT_BYTES];
+  uint16_t len = buildSlotRecord(rec);
+  return len != 0 && writeSlotRecord(slot, rec, len);
+}
+
+// Load the slot table into `table` (all empty if the EEPROM holds no packed
+// directory) and return the bytes its records take up
+uint16_t SimpleSequencer::readSlotTable(SaveSlotEntry* table) {
+  SaveDirectory dir;
+  EEPROM.get(0, dir);
+  uint16_t used = 0;
+  for (uint8_t i = 0; i < SAVE_NUM_SLOTS; i++) {
+    EEPROM.get(saveTableAddress(i), table[i]);
+    if (!saveDirPacked(dir) || !saveEntryValid(table[i])) table[i] = SaveSlotEntry{0, 0};
+    used += table[i].bytes;
   }
+  return used;
 }
 
-// Shift all euclid-generated notes up/down by "steps" scale degrees for channel ch.
-void SimpleSequencer::shiftEuclidNotes(uint8_t ch, int steps){
-  uint8_t mode = euclidScaleMode[ch];
-  const uint8_t *scale = nullptr;
-  uint8_t len = 12; // default chromatic
-  static const uint8_t locrian[] = {0,1,3,5,6,8,10};
-  static const uint8_t diminished[] = {0,1,3,4,6,7,9,10};
-  static const uint8_t atonal[] = {0,1,2,3,4,5,6,7,8,9,10,11};
-
-  if (mode == 1){ scale = locrian; len = sizeof(locrian)/sizeof(locrian[0]); }
-  else if (mode == 2){ scale = diminished; len = sizeof(diminished)/sizeof(diminished[0]); }
-  else { scale = atonal; len = sizeof(atonal)/sizeof(atonal[0]); }
-
-  // Helper to convert a note to a global index (scale-step count)
-  auto noteToGlobalIndex = [&](int note)->int{
-    int bestGlobal = (note/12) * len; // fallback
-    int bestDist = 1000;
-    int baseOct = note / 12;
-    for (int oct = baseOct-2; oct <= baseOct+2; oct++){
-      for (int i=0;i<(int)len;i++){
-        int cand = oct*12 + scale[i];
-        if (cand < 0 || cand > 127) continue;
-        int d = abs(cand - note);
-        if (d < bestDist){ bestDist = d; bestGlobal = oct * len + i; }
-      }
+// Close the gaps left by rewritten slots: move every record but `skip`'s down,
+// lowest first, pointing its table entry at it as it lands. `skip` is being
+// replaced, so it is emptied first. Returns the first free address.
+uint16_t SimpleSequencer::compactSlots(SaveSlotEntry* table, uint8_t skip) {
+  table[skip] = SaveSlotEntry{0, 0};
+  EEPROM.put(saveTableAddress(skip), table[skip]);
+  uint16_t to = SAVE_DATA_ADDR;
+  for (;;) {
+    int8_t next = -1;
+    for (uint8_t i = 0; i < SAVE_NUM_SLOTS; i++) {
+      if (table[i].bytes && table[i].addr >= to && (next < 0 || table[i].addr < table[next].addr)) next = i;
     }
-    return bestGlobal;
-  };
-
-  // Helper to convert global index back to MIDI note
-  auto globalIndexToNote = [&](int gidx)->int{
-    int oct = gidx / len;
-    int idx = gidx % len;
-    if (idx < 0) { idx += len; oct -= 1; }
-    int cand = oct*12 + scale[idx];
-    if (cand < 0) cand = 0;
-    if (cand > 127) cand = 127;
-    return cand;
-  };
+    if (next < 0) return to;
+    SaveSlotEntry& e = table[next];
+    if (e.addr != to) {
+      for (uint16_t i = 0; i < e.bytes; i++) EEPROM.update(to + i, EEPROM.read(e.addr + i));
+      e.addr = to;
+      EEPROM.put(saveTableAddress(next), e);
+    }
+    to += e.bytes;
+  }
+}
 
-  // Shift per-step pitches if present
-  for (uint8_t s=0; s<NUM_STEPS; s++){
-    if (pitch[ch][s] == 255) continue;
-    int g = noteToGlobalIndex((int)pitch[ch][s]);
-    int ng = g + steps;
-    int nn = globalIndexToNote(ng);
-    pitch[ch][s] = (uint8_t)nn;
+// Store a ready-made record (the current pattern or one uploaded over USB). A
+// record of the same length is rewritten in place; otherwise it goes into free
+// space and the old one stays valid until the table points at the new one.
+// Fails if the other slots leave no room for it.
+bool SimpleSequencer::writeSlotRecord(uint8_t slot, const uint8_t* rec, uint16_t len) {
+  if (slot >= SAVE_NUM_SLOTS || len < sizeof(SaveSlotHeader) || len > SAVE_SLOT_BYTES) return false;
+  SaveSlotEntry table[SAVE_NUM_SLOTS];
+  uint16_t used = readSlotTable(table);
+  if (used - table[slot].bytes + len > SAVE_DATA_BYTES) return false;
+
+  uint16_t addr = table[slot].addr;
+  if (table[slot].bytes != len) {
+    addr = SAVE_DATA_ADDR;
+    for (uint8_t i = 0; i < SAVE_NUM_SLOTS; i++) {
+      if (table[i].bytes && table[i].addr + table[i].bytes > addr) addr = table[i].addr + table[i].bytes;
+    }
+    if (addr + len > SAVE_TABLE_ADDR) addr = compactSlots(table, slot);
   }
+  for (uint16_t i = 0; i < len; i++) EEPROM.update(addr + i, rec[i]);
+  table[slot] = SaveSlotEntry{addr, len};
+  EEPROM.put(SAVE_TABLE_ADDR, table);
+
+  // Directory last: a fresh directory also retires a legacy v3 image at address 0
+  SaveDirectory dir;
+  dir.magic = SAVE_DIR_MAGIC;
+  dir.version = SAVE_VERSION;
+  dir.lastSlot = slot;
+  dir.layout = SAVE_NUM_SLOTS;
+  EEPROM.put(0, dir);
+  return true;
+}
 
-  // Shift channelPitch as well
-  int groot = noteToGlobalIndex((int)channelPitch[ch]);
-  int ngroot = groot + steps;
-  int nroot = globalIndexToNote(ngroot);
-  channelPitch[ch] = (uint8_t)nroot;
+// Copy a slot's record into `rec` (SAVE_SLOT_BYTES); returns its length, 0 if the
+// slot is empty or its record fails the header / CRC check
+uint16_t SimpleSequencer::readSlotRecord(uint8_t slot, uint8_t* rec) {
+  if (slot >= SAVE_NUM_SLOTS) return 0;
+  SaveDirectory dir;
+  EEPROM.get(0, dir);
+  SaveSlotEntry e;
+  EEPROM.get(saveTableAddress(slot), e);
+  if (!saveDirPacked(dir) || !saveEntryValid(e)) return 0;
+  for (uint16_t i = 0; i < e.bytes; i++) rec[i] = EEPROM.read(e.addr + i);
+  return saveRecordBytes(rec, e.bytes) == e.bytes ? e.bytes : 0;
 }
 
+bool SimpleSequencer::loadSlot(uint8_t slot) {
+  uint8_t rec[SAVE_SLOT_BYTES];
+  return readSlotRecord(slot, rec) != 0 && applySlotRecord(rec);
+}
 
+// --- SD PROJECT PATTERNS ---
 
-void SimpleSequencer::updateEuclid(uint8_t ch){
-  uint8_t k = pulses[ch];
-  uint8_t n = NUM_STEPS;
-  uint8_t offset = euclidOffset[ch];
-  if (k == 0){
-    for (uint8_t i=0;i<n;i++) euclidPattern[ch][i]=false;
-    return;
-  }
-  if (k >= n){
-    for (uint8_t i=0;i<n;i++) euclidPattern[ch][i]=true;
-    return;
-  }
+// Project records use the fixed maximum stride so growing the save schema never
+// invalidates existing project files.
+static_assert(SAVE_SLOT_MAX_BYTES <= PROJECT_MAX_RECORD_BYTES, "save slot does not fit a project record");
 
-  bool tempPattern[NUM_STEPS];
-  for (uint8_t j=0;j<n;j++){
-    int x = (j * k) / n;
-    int y = ((j+1) * k) / n;
-    tempPattern[j] = (y > x);
+FLASHMEM void SimpleSequencer::beginProject() {
+  projectReady = projectStore.begin() && projectStore.open(PROJECT_PATH, PROJECT_MAX_RECORD_BYTES);
+  Serial.println(projectReady ? "SD project opened." : "No SD project (EEPROM only).");
+  if (projectReady) {
+    Song s;
+    if (projectStore.readSong(0, &s, sizeof(s)) && s.magic == SONG_MAGIC && s.length <= SONG_MAX_ENTRIES) song = s;
   }
+}
 
-  // Apply the rotation offset wrapping around NUM_STEPS
-  for (uint8_t j=0;j<n;j++){
-    euclidPattern[ch][(j + offset) % n] = tempPattern[j];
-  }
-  // Melody generation is decoupled from rhythm changes: do not regenerate here.
+bool SimpleSequencer::saveProjectPattern(uint16_t index) {
+  if (!projectReady) return false;
+  uint8_t rec[SAVE_SLOT_BYTES];
+  uint16_t len = buildSlotRecord(rec);
+  if (len == 0 || !projectStore.writeRecord(index, rec, len)) return false;
+  if (failedPattern == (int16_t)index) failedPattern = -1;
+  return true;
 }
 
-// Advance the internal MIDI tick counter (called from MIDI clock ISR)
-void SimpleSequencer::internalClockTick(){
-  // increment absolute tick counter
-  absoluteTickCounter++;
+// Queue a pattern for streaming; the engine switches to it at the next bar (step 0).
+// A pattern already staged for an earlier cue is dropped.
+bool SimpleSequencer::cueProjectPattern(uint16_t index) {
+  if (!projectReady || !projectStore.requestRecord(index)) return false;
+  noInterrupts();
+  stagedPattern = -1;
+  interrupts();
+  cuedPattern = (int16_t)index;
+  failedPattern = -1;
+  return true;
+}
 
-  // 1) Process tick-based note-offs FIRST so they clear before a new step triggers
-  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
-    if (noteOffTick[ch] > 0 && absoluteTickCounter >= noteOffTick[ch]){
-      if (lastNotePlaying[ch] < 128){
-        midiSendNoteOff(ch, lastNotePlaying[ch], 0);
-      }
-      noteOffTick[ch] = 0;
-      lastNotePlaying[ch] = 255;
-    }
-
-    // 1b) Process pure-tick Ratchet Note-Ons
-    if (ratchetIntervalTicks[ch] > 0 && absoluteTickCounter >= ratchetNextTick[ch]) {
-      if (absoluteTickCounter < ratchetEndTick[ch]) {
-        // Fire next ratchet
-        midiSendNoteOn(ch, ratchetPitch[ch], 100);
-        lastNotePlaying[ch] = ratchetPitch[ch];
-        // Schedule its crisp note-off
-        uint32_t offOffset = ratchetIntervalTicks[ch] / 2;
-        if (offOffset == 0) offOffset = 1;
-        noteOffTick[ch] = absoluteTickCounter + offOffset;
-        // Schedule next hit
-        ratchetNextTick[ch] += ratchetIntervalTicks[ch];
-      } else {
-        ratchetIntervalTicks[ch] = 0; // Burst finished
-      }
+// Storage task: decode a fully streamed cue into the spare pattern. CRC, decode
+// and range checks all run here, with interrupts on; the engine only swaps the
+// pointer. Waits while an earlier staged pattern still holds the spare.
+void SimpleSequencer::stageCuedPattern() {
+  if (cuedPattern < 0 || stagedPattern >= 0 || projectStore.readyIndex() != cuedPattern) return;
+  int16_t index = cuedPattern;
+  const uint8_t* rec = projectStore.takeRecord();
+  cuedPattern = -1;
+  SaveSlotHeader h;
+  if (rec && saveRecordBytes(rec, SAVE_SLOT_BYTES) != 0) {
+    memcpy(&h, rec, sizeof(h));
+    BitReader r(rec + sizeof(SaveSlotHeader), h.payloadBytes);
+    if (decodePattern(r, h.version, *sparePattern(), stagedRig)) {
+      stagedPattern = index;
+      return;
     }
   }
+  failedPattern = index; // empty or corrupt: don't stream it again every pass
+}
 
-  // 2) Advance the sequencer step using PPQN counting
-  midiStepTickCounter++;
-  if (midiStepTickCounter >= 6){
-    midiStepTickCounter = 0;
-    stepAdvanceRequested = true;
+// Engine context at step 0 (or interrupts off): make the staged pattern live.
+// A pointer store; nothing is decoded or copied. In song mode only the pattern
+// the arrangement names for this bar goes live. If it isn't staged yet (SD late)
+// the old pattern carries on and the bar is counted, rather than the late one
+// playing over a bar it doesn't belong to.
+void SimpleSequencer::swapStagedPattern() {
+  int16_t staged = stagedPattern;
+  if (songActive) {
+    uint16_t want = arrangement.bar(songBar).pattern;
+    if (want == projectPattern) return;
+    if (staged != (int16_t)want) { songLateBars++; return; }
+  } else if (staged < 0) {
+    return;
   }
+  pat = sparePattern();
+  projectPattern = (uint16_t)staged;
+  stagedPattern = -1;
+  // a different pattern: edits made to the old one can't be undone on it
+  undoResyncPending = true;
 }
 
-// Small static wrapper to keep ISR tiny
-static void internalClockTickWrapper(){ if (SimpleSequencer::instancePtr) SimpleSequencer::instancePtr->internalClockTick(); }
+// --- SONG MODE ---
+static_assert(sizeof(Song) <= PROJECT_SONG_BYTES, "Song does not fit its project slot");
+
+bool SimpleSequencer::appendSongEntry(uint16_t pattern, uint8_t repeats) {
+  if (song.length >= SONG_MAX_ENTRIES) return false;
+  SongEntry& e = song.entries[song.length++];
+  e.pattern = pattern;
+  e.repeats = repeats;
+  e.muteMask = 0;
+  e.transpose = 0;
+  e.reserved = 0;
+  if (projectReady) projectStore.writeSong(0, &song, sizeof(song));
+  return true;
+}
 
-// Engine runs at 1ms from hardware timer. It processes incoming MIDI bytes,
-// handles external/internal clock state, advances steps when requested, and
-// services scheduled note-offs. This function is intentionally minimal and
-// avoids USB Serial printing to keep timing deterministic.
-void SimpleSequencer::runEngine(){
-  // Use micros() for timing inside the engine to avoid reliance on millis()
-  uint32_t nowMicros = micros();
-  uint32_t nowMs = nowMicros / 1000;
+// Compile the chain and queue bar 0. Compilation happens here, in UI context, so
+// the engine never walks the entry list.
+void SimpleSequencer::startSong() {
+  songActive = false;
+  songLateBars = 0;
+  failedPattern = -1;
+  if (arrangement.compile(song) == 0) return;
+  resetSongPosition();
+  songActive = true;
+}
 
-  // 1) Process any MIDI bytes from hardware Serial8
-  while (Serial8.available() > 0){
-    uint8_t b = Serial8.read();
-    if (b == 0xF8){
-      externalMidiClockActive = true;
-      lastExternalClockMillis = nowMs;
-      if (midiTimerRunning){ midiClockTimer.end(); midiTimerRunning = false; }
-      // update timestamp window for BPM calculation
-      uint32_t currentMicros = nowMicros;
-      tickTimestamps[tickIndex] = currentMicros;
-      if (validTicks < BPM_TICK_WINDOW) {
-        validTicks++;
-      } else {
-        uint8_t oldestIndex = (tickIndex + 1) % BPM_TICK_WINDOW;
-        uint32_t elapsedMicros = currentMicros - tickTimestamps[oldestIndex];
-        if (elapsedMicros > 0){
-          float calculatedBpm = 120000000.0f / (float)elapsedMicros;
-          smoothedBpm = (smoothedBpm * 0.40f) + (calculatedBpm * 0.60f);
-          bpm = (uint32_t)(smoothedBpm + 0.5f);
-        }
-      }
-      tickIndex = (tickIndex + 1) % BPM_TICK_WINDOW;
-      // advance internal tick counter for this incoming clock
-      internalClockTick();
-    }
-    else if (b == 0xFA){
-      // MIDI Start
-      externalMidiClockActive = true;
-      lastExternalClockMillis = nowMs;
-      midiStepTickCounter = 0; validTicks = 0; tickIndex = 0;
-      absoluteTickCounter = 0;
-      if (midiTimerRunning){ midiClockTimer.end(); midiTimerRunning = false; }
-      // start playback
-      isRunning = true;
-      currentStep = 0;
-      // immediately trigger steps at position 0
-      for (uint8_t ch=0; ch<NUM_CHANNELS; ch++){
-        bool isActive = euclidEnabled[ch] ? euclidPattern[ch][currentStep] : steps[ch][currentStep];
-        if (isActive) triggerChannel(ch);
-      }
+void SimpleSequencer::stopSong() {
+  songActive = false;
+  songMuteMask = 0;
+  songTranspose = 0;
+}
+
+// Back to bar 0 (transport start). Safe from the engine: the pattern itself is
+// streamed in by prefetchSongPattern().
+void SimpleSequencer::resetSongPosition() {
+  songBar = 0;
+  const ArrangementBar& b = arrangement.bar(0);
+  songMuteMask = b.muteMask;
+  songTranspose = b.transpose;
+}
+
+// Engine context, at the bar boundary: index bump + copy of the bar's overrides.
+void SimpleSequencer::advanceSongBar() {
+  if (++songBar >= arrangement.length()) songBar = 0;
+  const ArrangementBar& b = arrangement.bar(songBar);
+  songMuteMask = b.muteMask;
+  songTranspose = b.transpose;
+}
+
+// Storage task: keep the pattern of the next bar to start streamed and staged.
+// Playing, that is the bar after this one (the current bar started already, with
+// its pattern or late); stopped, it is the current bar, which plays first.
+void SimpleSequencer::prefetchSongPattern() {
+  if (!songActive || !projectReady) return;
+  uint16_t bar = songBar;
+  if (isRunning) bar = (bar + 1 < arrangement.length()) ? bar + 1 : 0;
+  int16_t want = (int16_t)arrangement.bar(bar).pattern;
+  if (want == failedPattern) return;
+  if (stagedPattern >= 0 && stagedPattern != want) {
+    // staged for a bar that has gone by
+    noInterrupts();
+    if (stagedPattern != want) stagedPattern = -1;
+    interrupts();
+  }
+  if (want == (int16_t)projectPattern || stagedPattern == want || cuedPattern == want) return;
+  if (projectStore.requestRecord((uint16_t)want)) cuedPattern = want;
+}
+
+// Earlier firmware kept the slots at a fixed stride sized for the worst-case
+// record. Pack them down to their actual lengths, lowest slot first: each lands
+// at or below where it was, so none is overwritten before it has been read, and
+// the slot table (which may overlap the last old slot) is written once all have
+// moved. A record that no longer fits below the table is dropped.
+FLASHMEM void SimpleSequencer::convertFixedSlots(uint16_t oldSlotBytes) {
+  uint8_t oldCount = (SAVE_EEPROM_BYTES - sizeof(SaveDirectory)) / oldSlotBytes;
+  uint8_t n = (oldCount < SAVE_NUM_SLOTS) ? oldCount : SAVE_NUM_SLOTS;
+  SaveSlotEntry table[SAVE_NUM_SLOTS];
+  memset(table, 0, sizeof(table));
+  uint16_t to = SAVE_DATA_ADDR;
+  uint8_t packed = 0, dropped = 0;
+
+  for (uint8_t slot = 0; slot < n; slot++) {
+    uint16_t from = sizeof(SaveDirectory) + (uint16_t)slot * oldSlotBytes;
+    SaveSlotHeader h;
+    EEPROM.get(from, h);
+    uint16_t len = sizeof(SaveSlotHeader) + h.payloadBytes;
+    bool valid = h.version != 0 && h.version != 0xFF && h.payloadBytes <= SAVE_PAYLOAD_MAX_BYTES
+              && len <= oldSlotBytes;
+    if (!valid) continue;
+    if (to + len > SAVE_TABLE_ADDR) { dropped++; continue; }
+    for (uint16_t i = 0; i < len; i++) EEPROM.update(to + i, EEPROM.read(from + i));
+    table[slot] = SaveSlotEntry{to, len};
+    to += len;
+    packed++;
+  }
+  EEPROM.put(SAVE_TABLE_ADDR, table);
+
+  SaveDirectory dir;
+  EEPROM.get(0, dir);
+  dir.magic = SAVE_DIR_MAGIC;
+  dir.layout = SAVE_NUM_SLOTS;
+  if (dir.lastSlot >= SAVE_NUM_SLOTS) dir.lastSlot = 0;
+  EEPROM.put(0, dir);
+  Serial.print("Save slots packed: "); Serial.println(packed);
+  if (dropped) { Serial.print("Save slots dropped (no room): "); Serial.println(dropped); }
+}
+
+// Import the legacy v3 struct at address 0 and rewrite it as slot 0.
+bool SimpleSequencer::migrateV3() {
+  SaveDataV3 data;
+  EEPROM.get(0, data);
+  if (data.magicNumber != SAVE_V3_MAGIC) return false;
+
+  bpm = data.savedBpm;
+  pat->noteLenIdx = data.savedNoteLenIdx;
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) {
+    pat->channelPitch[c] = data.savedChannelPitch[c];
+    pat->muted[c] = data.savedMuted[c];
+    pat->euclidEnabled[c] = data.savedEuclidEnabled[c];
+    pat->pulses[c] = data.savedPulses[c];
+    pat->euclidOffset[c] = data.savedEuclidOffset[c];
+    pat->euclidScaleMode[c] = data.savedEuclidScaleMode[c];
+    pat->scaleRoot[c] = pat->channelPitch[c] % 12;
+    for (uint8_t s = 0; s < NUM_STEPS; s++) {
+      pat->steps[c][s] = data.savedSteps[c][s];
+      pat->pitch[c][s] = data.savedPitch[c][s];
+      pat->noteLen[c][s] = data.savedNoteLen[c][s];
+      pat->fillState[c][s] = data.savedFillStep[c][s];
+      pat->stepRatchet[c][s] = data.savedStepRatchet[c][s];
+      pat->stepVelocity[c][s] = data.savedStepVelocity[c][s];
+      // v3 images may carry old TD-3 velocity defaults (preserve 255 sentinel)
+      if (pat->stepVelocity[c][s] != 255 && pat->stepVelocity[c][s] > 120) pat->stepVelocity[c][s] = 96;
+      pat->stepSlide[c][s] = (data.savedStepSlide[c][s] != 0);
     }
-    else if (b == 0xFB){
-      // MIDI Continue
-      externalMidiClockActive = true;
-      lastExternalClockMillis = nowMs;
-      if (midiTimerRunning){ midiClockTimer.end(); midiTimerRunning = false; }
-      // resume without resetting position
-      isRunning = true;
-    }
-    else if (b == 0xFC){
-      // MIDI Stop
-      externalMidiClockActive = true;
-      if (midiTimerRunning){ midiClockTimer.end(); midiTimerRunning = false; }
-      isRunning = false;
-      // silence any playing notes immediately
-      for (uint8_t ch=0; ch<NUM_CHANNELS; ch++){
-        if (lastNotePlaying[ch] < 128){ midiSendNoteOff(ch, lastNotePlaying[ch], 0); lastNotePlaying[ch] = 255; }
-        noteOffTick[ch] = 0;
-      }
-      // reset metronome counters on external Stop
-      midiStepTickCounter = 0;
-      stepAdvanceRequested = false;
-      absoluteTickCounter = 0;
-    }
-    else {
-      // other MIDI bytes ignored by engine to keep it tight
-    }
-  }
-
-  // 2) Detect loss of external clock and fall back to internal timer if needed
-  if (externalMidiClockActive){
-    if ((nowMs - lastExternalClockMillis) > 2000){
-      externalMidiClockActive = false;
-      midiStepTickCounter = 0;
-      validTicks = 0; tickIndex = 0;
-      // restart internal hardware timer if needed
-      if (isRunning && !midiTimerRunning){
-        uint32_t interval = (60000000UL / bpm) / 24;
-        midiClockTimer.begin(sendClockISR, interval);
-        midiTimerRunning = true;
-      }
+    pat->channelVelocity[c] = data.savedChannelVelocity[c];
+    if (pat->channelVelocity[c] > 120) pat->channelVelocity[c] = 96;
+  }
+
+  // Round-trip through the encoder so the decoder's range checks apply, then
+  // persist as slot 0. A legacy image that fails them isn't kept half-imported.
+  saveSlot = 0;
+  uint8_t rec[SAVE_SLOT_BYTES];
+  uint16_t len = (bpm >= 20 && bpm <= 300) ? buildSlotRecord(rec) : 0;
+  if (len == 0 || !applySlotRecord(rec)) {
+    pat->init();
+    bpm = 120;
+    Serial.println("Legacy v3 save out of range. Booting blank.");
+    return true;
+  }
+  if (!writeSlotRecord(0, rec, len)) {
+    Serial.println("Migrated v3 save, but slot 1 write failed.");
+    return true;
+  }
+  Serial.println("Migrated v3 save into slot 1.");
+  return true;
+}
+
+void SimpleSequencer::saveState() {
+  bool ok = saveSlotTo(saveSlot);
+  // Flash the OLED
+  holdDisplay(ok ? HOLD_SAVED : HOLD_SAVE_FAILED, 600);
+}
+
+FLASHMEM void SimpleSequencer::loadState() {
+  SaveDirectory dir;
+  EEPROM.get(0, dir);
+
+  if (dir.magic == SAVE_DIR_MAGIC_FIXED && dir.layout >= sizeof(SaveSlotHeader) && dir.layout <= SAVE_SLOT_MAX_BYTES) {
+    convertFixedSlots(dir.layout);
+    EEPROM.get(0, dir);
+  }
+  if (saveDirPacked(dir)) {
+    saveSlot = (dir.lastSlot < SAVE_NUM_SLOTS) ? dir.lastSlot : 0;
+    if (loadSlot(saveSlot)) {
+      Serial.print("State loaded from EEPROM slot "); Serial.println(saveSlot + 1);
+    } else {
+      Serial.println("Saved slot invalid. Booting blank.");
+    }
+  } else if (migrateV3()) {
+    // migrated in place
+  } else {
+    Serial.println("No saved state found. Booting blank.");
+  }
+}
+
+FLASHMEM void SimpleSequencer::clearSavedState() {
+  // Invalidate the directory (and any legacy v3 image sharing address 0)
+  SaveDirectory dir = {};
+  EEPROM.put(0, dir);
+}
+
+FLASHMEM void SimpleSequencer::printSaveReport() {
+  uint8_t payload[SAVE_PAYLOAD_MAX_BYTES];
+  BitWriter w(payload, sizeof(payload));
+  encodePattern(w);
+  uint16_t recBytes = sizeof(SaveSlotHeader) + w.bytes();
+  SaveSlotEntry table[SAVE_NUM_SLOTS];
+  uint16_t used = readSlotTable(table);
+  uint8_t inUse = 0;
+  for (uint8_t i = 0; i < SAVE_NUM_SLOTS; i++) if (table[i].bytes) inUse++;
+  // further slots if each held a record the size of the current pattern
+  uint16_t more = (SAVE_DATA_BYTES - used) / recBytes;
+  if (more > SAVE_NUM_SLOTS - inUse) more = SAVE_NUM_SLOTS - inUse;
+  Serial.println("--- Save format report ---");
+  Serial.print("v3 struct bytes:      "); Serial.println(sizeof(SaveDataV3));
+  Serial.print("v3 patterns in EEPROM: "); Serial.println(SAVE_EEPROM_BYTES / sizeof(SaveDataV3));
+  Serial.print("v"); Serial.print(SAVE_VERSION);
+  Serial.print(" record bytes (max): "); Serial.println(SAVE_SLOT_BYTES);
+  Serial.print("current record bytes:  "); Serial.println(recBytes);
+  Serial.print("EEPROM record bytes:   "); Serial.print(used);
+  Serial.print(" used, "); Serial.print(SAVE_DATA_BYTES - used); Serial.println(" free");
+  Serial.print("slots in use:          "); Serial.print(inUse);
+  Serial.print("/"); Serial.println(SAVE_NUM_SLOTS);
+  Serial.print("slots that fit:        "); Serial.print(inUse + more);
+  Serial.print(" at the current size, "); Serial.print(SAVE_MIN_SLOTS); Serial.println(" if all are worst case");
+  Serial.print("active slot:           "); Serial.println(saveSlot + 1);
+  Serial.print("p-locks in use:        "); Serial.print(pat->plocks.size());
+  Serial.print("/"); Serial.println(PLOCK_CAPACITY);
+  // Per lockable parameter: dense [tracks][steps] array vs the shared sparse table
+  Serial.print("dense bytes/param 4x16: "); Serial.print(plockDenseBytes(4, 16, 1));
+  Serial.print("  16x64: "); Serial.println(plockDenseBytes(16, 64, 1));
+  Serial.print("sparse bytes (32 locks) 4x16: "); Serial.print(plockSparseBytes(4, 32));
+  Serial.print("  16x64: "); Serial.println(plockSparseBytes(16, 32));
+}
+
+void SimpleSequencer::randomizeEuclidMelody(uint8_t ch) {
+  uint8_t mode = pat->euclidScaleMode[ch];
+  
+  if (mode == SCALE_OFF) {
+    // MODE 0: OFF (Clear all 16 pitches back to the base drum sound)
+    for (uint8_t s = 0; s < NUM_STEPS; s++) {
+      pat->pitch[ch][s] = 255; 
+    }
+    return;
+  }
+  // MODES 1-4: Generate Scale for ALL STEPS (Locrian, Diminished, Atonal, User)
+  // The scale is rooted on the channel note so later degree shifts stay in key.
+  pat->scaleRoot[ch] = pat->channelPitch[ch] % 12;
+  const ScaleInfo& sc = channelScale(ch);
+  int base = scaleNoteToDegree(sc, pat->scaleRoot[ch], pat->channelPitch[ch]);
+
+  for (uint8_t s = 0; s < NUM_STEPS; s++) {
+    // Any degree up to and including the octave
+    int degree = base + random(0, sc.len + 1);
+    // Randomly drop some notes down an octave for bass movement
+    degree -= random(0, 2) * sc.len;
+    pat->pitch[ch][s] = scaleDegreeToNote(sc, pat->scaleRoot[ch], degree);
+  }
+}
+
+// Shift all euclid-generated notes up/down by "steps" scale degrees for channel ch.
+// O(steps): each note is two table reads, no nearest-note search.
+void SimpleSequencer::shiftEuclidNotes(uint8_t ch, int steps){
+  const ScaleInfo& sc = channelScale(ch);
+  uint8_t root = pat->scaleRoot[ch];
+
+  // Shift per-step pitches if present
+  for (uint8_t s=0; s<NUM_STEPS; s++){
+    if (pat->pitch[ch][s] == 255) continue;
+    pat->pitch[ch][s] = scaleDegreeToNote(sc, root, scaleNoteToDegree(sc, root, pat->pitch[ch][s]) + steps);
+  }
+
+  // Shift channelPitch as well
+  pat->channelPitch[ch] = scaleDegreeToNote(sc, root, scaleNoteToDegree(sc, root, pat->channelPitch[ch]) + steps);
+}
+
+// Build the user scale from the pitch classes the track currently plays.
+void SimpleSequencer::learnUserScale(uint8_t ch) {
+  pat->scaleRoot[ch] = pat->channelPitch[ch] % 12;
+  uint16_t mask = 1; // root is always in the scale
+  for (uint8_t s = 0; s < NUM_STEPS; s++) {
+    if (pat->pitch[ch][s] == 255) continue;
+    mask |= 1 << ((pat->pitch[ch][s] + 12 - pat->scaleRoot[ch]) % 12);
+  }
+  pat->userScaleMask[ch] = mask;
+  pat->userScale[ch] = makeScale(mask);
+  pat->euclidScaleMode[ch] = SCALE_USER;
+}
+
+// --- MODULATION PAGE (Fn + START held, no step) ---
+// Enc1 LFO rate, Enc2 LFO depth, Enc3 env decay, Enc4 env depth.
+// Clicks: Enc1 LFO shape, Enc2 LFO dest, Enc3 env dest, Enc4 env attack.
+static uint8_t nextModDest(uint8_t dest) {
+  for (uint8_t i = 0; i < MOD_NUM_DESTS; i++) {
+    if (MOD_DESTS[i] == dest) return MOD_DESTS[(i + 1) % MOD_NUM_DESTS];
+  }
+  return MOD_DESTS[0];
+}
+
+void SimpleSequencer::editModulation(uint8_t enc, int steps) {
+  LfoParams& l = pat->lfo[selectedChannel];
+  EnvParams& en = pat->env[selectedChannel];
+  startStopModifierFlag = true; // releasing Fn + START must not toggle transport
+  if (enc == 0) l.rateIdx = (uint8_t)constrain((int)l.rateIdx + steps, 0, MOD_NUM_LFO_RATES - 1);
+  else if (enc == 1) l.depth = (uint8_t)constrain((int)l.depth + steps, 0, 127);
+  else if (enc == 2) en.decayIdx = (uint8_t)constrain((int)en.decayIdx + steps, 0, MOD_NUM_ENV_TIMES - 1);
+  else en.depth = (uint8_t)constrain((int)en.depth + steps, 0, 127);
+}
+
+void SimpleSequencer::clickModulation(uint8_t enc) {
+  LfoParams& l = pat->lfo[selectedChannel];
+  EnvParams& en = pat->env[selectedChannel];
+  startStopModifierFlag = true;
+  if (enc == 0) l.shape = (l.shape + 1) % LFO_NUM_SHAPES;
+  else if (enc == 1) l.dest = nextModDest(l.dest);
+  else if (enc == 2) en.dest = nextModDest(en.dest);
+  else en.attackIdx = (en.attackIdx + 1) % MOD_NUM_ENV_TIMES;
+}
+
+// --- ARP PAGE (Fn + START held, Button 16 flips to it) ---
+// Enc1 rate, Enc2 octave range, Enc3 chord, Enc4 groove. Clicks: Enc1 mode,
+// Enc2 source, Enc4 groove amount.
+void SimpleSequencer::editArp(uint8_t enc, int steps) {
+  ArpParams& a = pat->arp[selectedChannel];
+  startStopModifierFlag = true;
+  if (enc == 0) a.rateIdx = (uint8_t)constrain((int)a.rateIdx + steps, 0, ARP_NUM_RATES - 1);
+  else if (enc == 1) a.octaves = (uint8_t)constrain((int)a.octaves + steps, 1, ARP_MAX_OCTAVES);
+  else if (enc == 2) a.chord = (uint8_t)constrain((int)a.chord + steps, 0, ARP_NUM_CHORDS - 1);
+  else pat->trackGroove[selectedChannel] = (uint8_t)constrain((int)pat->trackGroove[selectedChannel] + steps, 0, grooveCount - 1);
+}
+
+void SimpleSequencer::clickArp(uint8_t enc) {
+  ArpParams& a = pat->arp[selectedChannel];
+  startStopModifierFlag = true;
+  if (enc == 0) a.mode = (a.mode + 1) % ARP_NUM_MODES;
+  else if (enc == 1) a.source = (a.source + 1) % ARP_NUM_SOURCES;
+  else if (enc == 3) {
+    // 100 -> 75 -> 50 -> 25 -> 100
+    uint8_t& amt = pat->grooveAmount[selectedChannel];
+    amt = (amt > 25) ? (uint8_t)((amt - 1) / 25 * 25) : 100;
+  }
+}
+
+FLASHMEM void SimpleSequencer::printModReport() {
+  static uint32_t lastMs = 0, lastBytes = 0;
+  uint32_t now = millis();
+  uint32_t sent = mod.bytesSent;
+  uint32_t dt = now - lastMs;
+  Serial.println("--- Modulation wire report ---");
+  Serial.print("budget bytes/s:   "); Serial.print(MIDI_WIRE_BYTES_PER_SEC * MOD_WIRE_SHARE_PCT / 100);
+  Serial.print(" ("); Serial.print(MOD_WIRE_SHARE_PCT); Serial.println("% of 31250 baud)");
+  Serial.print("sent bytes/s:     "); Serial.println(dt ? (uint32_t)((uint64_t)(sent - lastBytes) * 1000 / dt) : 0);
+  Serial.print("total bytes sent: "); Serial.println(sent);
+  Serial.print("deferred updates: "); Serial.println(mod.deferred);
+  lastMs = now;
+  lastBytes = sent;
+}
+
+void SimpleSequencer::updateEuclid(Pattern& p, uint8_t ch){
+  // Table lookup + rotate; cheap enough to run on every encoder detent while playing
+  uint64_t bits = euclidLookup(p.euclidMode[ch], p.pulses[ch], NUM_STEPS);
+  p.euclidPattern[ch] = euclidRotate(bits, p.euclidOffset[ch], NUM_STEPS);
+  // Melody generation is decoupled from rhythm changes: do not regenerate here.
+}
+
+// Advance the internal MIDI tick counter (called from MIDI clock ISR)
+FASTRUN void SimpleSequencer::internalClockTick(){
+  uint32_t cycStart = ARM_DWT_CYCCNT;
+  // increment absolute tick counter
+  absoluteTickCounter++;
+  lastTickMicros = micros();
+  traceRing.record(TR_TICK, 0, (uint16_t)absoluteTickCounter);
+  // quantised stop: this tick is the boundary, nothing past it was rendered
+  if (transportState == TS_STOP_ARMED && absoluteTickCounter >= stopIndex * TICKS_PER_STEP){
+    transportStop(true);
+    uint32_t cycles = ARM_DWT_CYCCNT - cycStart;
+    tickProfile.add(cycles);
+    traceRing.record(TR_CLOCK_ISR, 0, traceDuration(cycles));
+    return;
+  }
+
+  // 1) Send the pre-rendered events for this tick (note-offs, ratchets, step notes).
+  // If loop() fell behind, render the due step here so nothing is dropped.
+  if (isRunning){
+    while (renderStep(absoluteTickCounter)){
+      lateRenders++;
+      traceRing.record(TR_LATE_RENDER, (renderBase + renderIndex - 1) % NUM_STEPS);
     }
   }
+  drainEvents(lastTickMicros);
 
-  // 3) Advance step when requested (set by internalClockTick)
+  // 1c) LFO / envelope modulation, after this tick's note traffic. Only sends while
+  // the TX buffer has headroom so the next step's note-ons never wait behind it.
+  if (isRunning) mod.tick(pat->lfo, pat->env, lastTickMicros, modSend);
+
+  // 2) Advance the sequencer step using PPQN counting
+  midiStepTickCounter++;
+  if (midiStepTickCounter >= TICKS_PER_STEP){
+    midiStepTickCounter = 0;
+    stepAdvanceRequested = true;
+  }
+  uint32_t cycles = ARM_DWT_CYCCNT - cycStart;
+  tickProfile.add(cycles);
+  traceRing.record(TR_CLOCK_ISR, 0, traceDuration(cycles));
+}
+
+// Small static wrapper to keep ISR tiny
+static void internalClockTickWrapper(){ if (SimpleSequencer::instancePtr) SimpleSequencer::instancePtr->internalClockTick(); }
+
+// Engine runs at 1ms from hardware timer. It processes incoming MIDI bytes,
+// handles external/internal clock state, advances steps when requested, and
+// services scheduled note-offs. This function is intentionally minimal and
+// avoids USB Serial printing to keep timing deterministic.
+// One whole message from DIN or USB (engine ISR): realtime to the clock manager,
+// SPP, notes to the arpeggiator, channel messages to the soft thru
+FASTRUN void SimpleSequencer::handleMidiIn(uint8_t src, const uint8_t* msg, uint8_t len, uint32_t nowMicros){
+  uint8_t clockSrc = src == MIDI_PORT_DIN ? CLOCK_SRC_DIN : CLOCK_SRC_USB;
+  if (msg[0] >= 0xF8) { handleClockByte(clockSrc, msg[0], nowMicros); return; }
+  if (msg[0] == 0xF2) { handleSongPosition(clockSrc, msg[1] | (msg[2] << 7), nowMicros); return; }
+  if (msg[0] >= 0xF0) return;
+  uint8_t kind = msg[0] & 0xF0;
+  if (kind == 0x90 || kind == 0x80) handleNoteIn(kind, msg[1], msg[2]);
+  midiRouter.thru(src, msg, len, selectedChannel);
+}
+
+FASTRUN void SimpleSequencer::runEngine(){
+  uint32_t cycStart = ARM_DWT_CYCCNT;
+  uint32_t tracedBefore = traceRing.recorded();
+  // Use micros() for timing inside the engine to avoid reliance on millis()
+  uint32_t nowMicros = micros();
+
+  // 1) Realtime bytes from DIN (Serial8) and USB MIDI; the clock manager decides
+  // which source drives the engine
+  while (Serial8.available() > 0){
+    uint8_t msg[3];
+    uint8_t len = dinIn.feed(Serial8.read(), msg);
+    if (len) handleMidiIn(MIDI_PORT_DIN, msg, len, nowMicros);
+  }
+  while (usbMIDI.read()){
+    uint8_t type = usbMIDI.getType();
+    uint8_t msg[3] = { type, usbMIDI.getData1(), usbMIDI.getData2() };
+    if (type < 0xF0) msg[0] |= (usbMIDI.getChannel() - 1) & 0x0F;
+    handleMidiIn(MIDI_PORT_USB, msg, type >= 0xF8 ? 1 : midiDataBytes(type) + 1, nowMicros);
+  }
+
+  // 1b) Transport command posted by the UI
+  uint8_t cmd = transportCmd;
+  if (cmd != TC_NONE){
+    transportCmd = TC_NONE;
+    handleTransportCmd(cmd, transportCmdMicros, nowMicros);
+  }
+
+  // 2) Active source dropped a tick: play the missed tick now and carry on from the
+  // next source, on the grid of the last tempo estimate
+  if (clockIn.poll(nowMicros)){
+    traceRing.record(TR_FAILOVER, clockIn.lastLost, clockIn.active());
+    bool internal = !clockIn.external();
+    uint32_t period = clockIn.fillPeriod();
+    if (isRunning && period){
+      if (internal) sendClockISR(); else internalClockTick();
+    }
+    if (isRunning && internal && !midiTimerRunning){
+      uint32_t first = period ? clockIn.nextTickDueUs() - nowMicros : (60000000UL / bpm) / 24;
+      if ((int32_t)first < 100) first = 100;
+      midiClockTimer.begin(sendClockISR, first);
+      // reload value applies from the second interrupt on
+      if (period) midiClockTimer.update(period);
+      midiTimerRunning = true;
+    }
+  }
+
+  // 3) Advance the playhead when requested (set by internalClockTick). The step's
+  // events were rendered ahead by loop(); the engine only sends what is due.
   if (stepAdvanceRequested){
     stepAdvanceRequested = false;
     if (isRunning){
       currentStep = (currentStep + 1) % NUM_STEPS;
-      // trigger channels that have the step enabled
-        for (uint8_t ch=0; ch<NUM_CHANNELS; ch++){
-          bool isActive = euclidEnabled[ch] ? euclidPattern[ch][currentStep] : steps[ch][currentStep];
-          if (isActive) triggerChannel(ch);
-        }
+      traceRing.record(TR_STEP, currentStep, (uint16_t)loopCount);
+      if (telemetryOn) telemetryStep(nowMicros);
     }
   }
+  if (telemetryOn && ++telemetryStatusTicks >= TELEMETRY_STATUS_MS){
+    telemetryStatusTicks = 0;
+    telemetryStatus(nowMicros);
+  }
 
-  // Note-offs are now handled in `internalClockTick()` on MIDI ticks.
+  // 4) Send latency-compensated events whose delay has elapsed since the last tick
+  drainEvents(nowMicros);
+  // 5) Move queued messages on to any port that has room again
+  midiRouter.service();
+  if (++traceEnginePasses >= 1000){
+    traceEnginePasses = 0;
+    traceRing.record(TR_HEARTBEAT, 0, ++traceSeconds);
+  }
+  uint32_t cycles = ARM_DWT_CYCCNT - cycStart;
+  engineProfile.add(cycles);
+  // idle passes would flood the ring: only record one that did something or ran long
+  uint32_t traced = traceRing.recorded() - tracedBefore;
+  if (traced || cycles > TRACE_ENGINE_MIN_CYCLES) traceRing.record(TR_ENGINE_ISR, traced > 255 ? 255 : traced, traceDuration(cycles));
+}
 
-  // Note-offs are now handled in `internalClockTick()` on MIDI ticks.
+// Realtime byte from an external clock source (engine ISR)
+FASTRUN void SimpleSequencer::handleClockByte(uint8_t src, uint8_t b, uint32_t nowMicros){
+  traceRing.record(TR_CLOCK_IN, src, b);
+  ClockManager::Event ev = clockIn.onRealtime(src, b, nowMicros);
+  // an external source in charge always silences the internal timer
+  if (clockIn.external() && midiTimerRunning){ midiClockTimer.end(); midiTimerRunning = false; }
+  if (ev == ClockManager::CLK_TICK){
+    if (clockIn.settled()){
+      float calculatedBpm = 2500000.0f / (float)clockIn.periodUs();
+      smoothedBpm = (smoothedBpm * 0.40f) + (calculatedBpm * 0.60f);
+      bpm = (uint32_t)(smoothedBpm + 0.5f);
+    }
+    // a start armed for the next beat / bar of this clock fires on it, in place of the tick
+    extTickPos++;
+    if (transportState == TS_START_ARMED && startOnExtTick && extTickPos % transportQuantTicks() == 0){
+      transportStart(nowMicros);
+      return;
+    }
+    // advance internal tick counter for this incoming clock
+    internalClockTick();
+  }
+  else if (ev == ClockManager::CLK_START){
+    extTickPos = 0;
+    transportStart(nowMicros);
+  }
+  else if (ev == ClockManager::CLK_CONTINUE){
+    transportContinue(nowMicros);
+  }
+  else if (ev == ClockManager::CLK_STOP){
+    // external Stop keeps the position for a later Continue
+    transportStop(false);
+  }
 }
 
-void SimpleSequencer::triggerChannel(uint8_t ch){
-  // 1. THE NORMAL MUTE & FILL BLOCK
-  if (muted[ch]) return;
-  uint8_t fstate = fillState[ch][currentStep];
-  if (fstate == 1 && !fillModeActive) return;
-  if (fstate == 2 && fillModeActive) return;
-  uint8_t p = pitch[ch][currentStep];
-  if (p == 255) p = channelPitch[ch];
-  uint8_t note = constrain(p, 0, 127);
+// Song Position Pointer from an external source (engine ISR)
+void SimpleSequencer::handleSongPosition(uint8_t src, uint16_t beats, uint32_t nowMicros){
+  traceRing.record(TR_SPP_IN, src, beats);
+  if (clockIn.onSongPosition(src, nowMicros) != ClockManager::CLK_SEEK) return;
+  extTickPos = (uint32_t)beats * TICKS_PER_STEP;
+  uint32_t cycStart = ARM_DWT_CYCCNT;
+  seekTo(beats);
+  seekProfile.add(ARM_DWT_CYCCNT - cycStart);
+}
 
-  uint8_t vel = stepVelocity[ch][currentStep];
-  if (vel == 255) vel = channelVelocity[ch];
+FLASHMEM void SimpleSequencer::printClockReport(){
+  Serial.println("--- Clock sources ---");
+  Serial.print("priority: "); Serial.println(CLOCK_PRIORITIES[clockIn.priority()].name);
+  Serial.print("active:   "); Serial.println(clockSourceNames[clockIn.active()]);
+  for (uint8_t i = 0; i < CLOCK_SRC_INTERNAL; i++){
+    Serial.print(clockSourceNames[i]); Serial.println(clockIn.locked(i) ? " locked" : " no clock");
+  }
+  noInterrupts();
+  uint32_t failovers = clockIn.failovers, swallowed = clockIn.swallowed;
+  uint32_t gap = clockIn.lastGapUs, err = clockIn.lastPhaseErrUs, maxErr = clockIn.maxPhaseErrUs;
+  uint8_t lost = clockIn.lastLost;
+  interrupts();
+  Serial.print("failovers: "); Serial.print(failovers);
+  if (failovers){ Serial.print(" (last lost "); Serial.print(clockSourceNames[lost]); Serial.print(")"); }
+  Serial.println();
+  Serial.print("last gap us: "); Serial.println(gap);
+  Serial.print("fill tick phase error us last/max: "); Serial.print(err); Serial.print("/"); Serial.println(maxErr);
+  Serial.print("duplicate ticks swallowed: "); Serial.println(swallowed);
+}
 
-  // 2. THE MONOSYNTH LEGATO MAGIC
-  static bool prevSlide[NUM_CHANNELS] = {false};
-  bool isSlidingIntoThis = prevSlide[ch];
+// --- TRANSPORT ---
+// Every state change goes through here so it lands in the trace
+void SimpleSequencer::setTransportState(uint8_t state){
+  transportState = state;
+  traceRing.record(TR_TRANSPORT, state);
+}
 
-  if (lastNotePlaying[ch] < 128) {
-    if (isSlidingIntoThis) {
-      // LEGATO: Fire the new note BEFORE killing the old one to trigger portamento
-      midiSendNoteOn(ch, note, vel);
-      midiSendNoteOff(ch, lastNotePlaying[ch], 0);
-    } else {
-      // NORMAL: Kill the old note BEFORE firing the new one (Crisp re-trigger)
-      midiSendNoteOff(ch, lastNotePlaying[ch], 0);
-      midiSendNoteOn(ch, note, vel);
+// UI side: post a command for the engine. A second press before the engine has
+// taken the first simply replaces it.
+void SimpleSequencer::postTransport(uint8_t cmd){
+  noInterrupts();
+  transportCmdMicros = micros();
+  transportCmd = cmd;
+  interrupts();
+}
+
+uint32_t SimpleSequencer::transportQuantTicks() const {
+  return transportQuant == TQ_BAR ? (uint32_t)NUM_STEPS * TICKS_PER_STEP : 4 * TICKS_PER_STEP;
+}
+
+static void transportFireISR(){
+  transportTimer.end();
+  if (SimpleSequencer::instancePtr) SimpleSequencer::instancePtr->transportFire();
+}
+
+// Engine side: apply a posted command
+void SimpleSequencer::handleTransportCmd(uint8_t cmd, uint32_t postedMicros, uint32_t nowMicros){
+  if (cmd != TC_TOGGLE) return;
+  switch (transportState){
+    case TS_STOPPED:
+      setTransportState(TS_START_ARMED);
+      startRequestMicros = postedMicros;
+      // joining a running external clock: wait for its next beat / bar
+      startOnExtTick = (transportQuant != TQ_OFF && clockIn.running(nowMicros));
+      if (!startOnExtTick){
+        uint32_t wait = postedMicros + TRANSPORT_START_LEAD_US - nowMicros;
+        if ((int32_t)wait < 10) wait = 10;
+        transportTimer.begin(transportFireISR, wait);
+      }
+      break;
+    case TS_START_ARMED:
+      // pressed again before it fired: cancel
+      transportTimer.end();
+      setTransportState(TS_STOPPED);
+      break;
+    case TS_RUNNING:
+      if (transportQuant == TQ_OFF) transportStop(true);
+      else armStop();
+      break;
+    case TS_STOP_ARMED:
+      // pressed again while waiting for the boundary: stop now
+      transportStop(true);
+      break;
+  }
+}
+
+// Lead-time one-shot (timer ISR): the armed local start
+FASTRUN void SimpleSequencer::transportFire(){
+  if (transportState != TS_START_ARMED) return;
+  uint32_t nowMicros = micros();
+  transportStart(nowMicros);
+  startLatencyUs.add(nowMicros - startRequestMicros);
+}
+
+// Both local and external starts: rewind, and play step 0 now. As master also send
+// Start plus the tick-0 clock and run the clock timer from here.
+void SimpleSequencer::transportStart(uint32_t nowMicros){
+  transportTimer.end();
+  setTransportState(TS_RUNNING);
+  isRunning = true;
+  seekPending = false;
+  midiStepTickCounter = 0;
+  stepAdvanceRequested = false;
+  absoluteTickCounter = 0;
+  currentStep = 0;
+  resetTrigState();
+  mod.reset();
+  if (songActive) resetSongPosition();
+  if (!clockIn.external()){
+    midiSendRealtime(0xFA); // MIDI Start
+    midiSendRealtime(0xF8); // MIDI Clock
+    clockIn.onInternalTick(nowMicros);
+    if (!midiTimerRunning){
+      midiClockTimer.begin(sendClockISR, tickPeriodUs());
+      midiTimerRunning = true;
     }
+  }
+  traceRing.record(TR_STEP, 0, (uint16_t)loopCount);
+  if (telemetryOn) telemetryStep(nowMicros);
+  // render and send step 0 now; loop() keeps rendering ahead from here
+  resetRender(0);
+  while (renderStep(absoluteTickCounter)) {}
+  drainEvents(nowMicros);
+}
+
+void SimpleSequencer::transportContinue(uint32_t nowMicros){
+  transportTimer.end();
+  setTransportState(TS_RUNNING);
+  isRunning = true;
+  resetRender(currentStep);
+  if (seekPending){
+    // after a Song Position Pointer the target step has not played yet: play it now
+    seekPending = false;
+    while (renderStep(absoluteTickCounter)) {}
+    drainEvents(nowMicros);
   } else {
-    // No overlapping note, just fire
-    midiSendNoteOn(ch, note, vel);
+    // resume without resetting position: the next step lands on tick 6
+    renderIndex = 1;
   }
+}
+
+// Stop at the next beat / bar of the pattern. Steps already rendered still play, so
+// the boundary is the first one not rendered yet.
+void SimpleSequencer::armStop(){
+  uint32_t q = transportQuantTicks() / TICKS_PER_STEP;
+  uint32_t idx = renderIndex;
+  uint32_t playing = absoluteTickCounter / TICKS_PER_STEP + 1;
+  if (idx < playing) idx = playing;
+  idx += (q - (renderBase + idx) % q) % q;
+  stopIndex = idx;
+  setTransportState(TS_STOP_ARMED);
+}
+
+// Local stop rewinds to the top (and tells followers with SPP 0 when we are master);
+// external Stop keeps the position for Continue.
+void SimpleSequencer::transportStop(bool rewind){
+  transportTimer.end();
+  setTransportState(TS_STOPPED);
+  isRunning = false;
+  // drop everything rendered ahead and silence sounding notes
+  resetRender(rewind ? 0 : currentStep);
+  mod.park(pat->lfo, pat->env, modSendQueued);
+  if (!clockIn.external()){
+    midiSendRealtime(0xFC); // MIDI Stop
+    if (rewind) midiSendSongPosition(0);
+  }
+  if (midiTimerRunning){ midiClockTimer.end(); midiTimerRunning = false; }
+  if (rewind) currentStep = 0;
+  midiStepTickCounter = 0;
+  stepAdvanceRequested = false;
+  absoluteTickCounter = 0;
+  if (telemetryOn) telemetryStep(micros());
+}
+
+// --- TELEMETRY ---
+// Engine side only writes into the ring; loop() frames and sends what USB can take.
+
+void SimpleSequencer::telemetryStep(uint32_t nowMicros){
+  telemetry.push(TEL_STEP, nowMicros, currentStep, transportState, 0, (uint16_t)loopCount);
+}
 
-  // Save the new state for the NEXT step
-  lastNotePlaying[ch] = note;
-  prevSlide[ch] = stepSlide[ch][currentStep];
+void SimpleSequencer::telemetryStatus(uint32_t nowMicros){
+  uint8_t locked = 0;
+  for (uint8_t i = 0; i < CLOCK_SRC_INTERNAL; i++) if (clockIn.locked(i)) locked |= 1 << i;
+  float shownBpm = clockIn.external() ? smoothedBpm : (float)bpm;
+  telemetry.push(TEL_TEMPO, nowMicros, clockIn.active(), locked, clockIn.priority(), (uint16_t)(shownBpm * 10.0f + 0.5f));
+  uint32_t drops = midiRouter.stats(MIDI_PORT_DIN).dropped + midiRouter.stats(MIDI_PORT_USB).dropped;
+  telemetry.push(TEL_QUEUE, nowMicros, midiRouter.depth(MIDI_PORT_DIN), midiRouter.depth(MIDI_PORT_USB),
+                 drops > 255 ? 255 : (uint8_t)drops, events.size());
+}
+
+// Rate-limited and never blocking: a frame goes out only when the USB transmit
+// buffer has room for a full one. If the host stops reading, the ring drops the
+// oldest records instead of stalling the UI.
+void SimpleSequencer::serviceTelemetry(){
+  if (!telemetryOn) return;
+  uint32_t now = millis();
+  if (now - telemetryFrameMillis < TELEMETRY_FRAME_MS) return;
+  if (Serial.availableForWrite() < LINK_FRAME_OVERHEAD + TELEMETRY_FRAME_RECORDS * TELEMETRY_RECORD_BYTES) return;
+  uint8_t payload[TELEMETRY_FRAME_RECORDS * TELEMETRY_RECORD_BYTES];
+  uint8_t n = 0;
+  TelemetryRecord r;
+  while (n < TELEMETRY_FRAME_RECORDS && telemetry.pop(r)) telemetryPack(r, payload + TELEMETRY_RECORD_BYTES * n++);
+  if (n == 0) return;
+  telemetryFrameMillis = now;
+  Serial.write(linkTx, linkEncode(LINK_TELEMETRY, telemetrySeq++, payload, n * TELEMETRY_RECORD_BYTES, linkTx));
+}
+
+// --- LOOK-AHEAD RENDERING ---
+// Forget everything rendered ahead, silence sounding notes and restart rendering at
+// `fromStep` on tick 0. Caller holds interrupts off (or is the engine ISR).
+void SimpleSequencer::resetRender(uint16_t fromStep){
+  events.clear();
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    if (lastNotePlaying[ch] < 128) midiSendNoteOff(ch, lastNotePlaying[ch], 0);
+    lastNotePlaying[ch] = 255;
+    renderNote[ch] = 255;
+    renderOffTick[ch] = 0;
+    renderOffShiftUs[ch] = 0;
+    renderSlide[ch] = false;
+    arpGateEnd[ch] = 0;
+  }
+  renderBase = fromStep;
+  renderIndex = 0;
+  lastTickMicros = micros();
+}
+
+// Render the next step if it falls within `horizon` ticks and the queue has room.
+bool SimpleSequencer::renderStep(uint32_t horizon){
+  uint32_t tick = renderIndex * TICKS_PER_STEP;
+  if (!isRunning || tick > horizon) return false;
+  if (transportState == TS_STOP_ARMED && renderIndex >= stopIndex) return false;
+  if (events.space() < RENDER_STEP_MAX_EVENTS) return false;
+  uint32_t cycStart = ARM_DWT_CYCCNT;
+  uint8_t step = (renderBase + renderIndex) % NUM_STEPS;
+  // bar boundary: advance the song, then switch to the staged pattern (pointer swap)
+  if (step == 0){
+    if (renderIndex > 0){
+      loopCount++;
+      if (songActive) advanceSongBar();
+    }
+    swapStagedPattern();
+  }
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    if (isStepActive(ch, step)) renderChannel(ch, step, tick);
+    if (pat->arp[ch].mode != ARP_OFF) renderArp(ch, tick);
+  }
+  renderIndex++;
+  uint32_t cycles = ARM_DWT_CYCCNT - cycStart;
+  renderProfile.add(cycles);
+  traceRing.record(TR_RENDER, step, traceDuration(cycles));
+  return true;
+}
+
+// Keep RENDER_LOOKAHEAD_TICKS of events queued (UI loop, one step per critical section)
+void SimpleSequencer::renderAhead(){
+  int8_t earliest = 0;
+  bool grooved = false;
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    if (pat->trackDelayMs[ch] < earliest) earliest = pat->trackDelayMs[ch];
+    if (pat->trackGroove[ch]) grooved = true;
+  }
+  uint32_t period = tickPeriodUs();
+  uint32_t ahead = RENDER_LOOKAHEAD_TICKS + ((uint32_t)(-earliest) * 1000 + period - 1) / period;
+  // a groove can pull a step up to 2/3 of a step early
+  if (grooved) ahead += TICKS_PER_STEP;
+  for (;;){
+    noInterrupts();
+    bool more = renderStep(absoluteTickCounter + ahead);
+    interrupts();
+    if (!more) break;
+  }
+}
+
+// Place an event at `tick` shifted by the channel's delay and the groove of the step
+// being rendered. Negative shifts move it to an earlier tick plus a positive
+// remainder, which is why rendering runs ahead.
+SeqEvent SimpleSequencer::makeEvent(uint8_t type, uint8_t ch, uint8_t d1, uint8_t d2, uint32_t tick){
+  SeqEvent e{tick, 0, type, ch, d1, d2};
+  int32_t off = (int32_t)pat->trackDelayMs[ch] * 1000 + grooveShiftUs[ch];
+  uint32_t period = tickPeriodUs();
+  if (off >= 0){
+    e.tick += off / period;
+    e.delayUs = off % period;
+  } else {
+    uint32_t k = ((uint32_t)(-off) + period - 1) / period;
+    if (tick >= k){ e.tick = tick - k; e.delayUs = k * period + off; }
+    else e.tick = 0; // before transport start: send as early as possible
+  }
+  return e;
+}
+
+FASTRUN void SimpleSequencer::pushEvent(uint8_t type, uint8_t ch, uint8_t d1, uint8_t d2, uint32_t tick){
+  events.push(makeEvent(type, ch, d1, d2, tick));
+}
+
+// Send every queued event that is due (engine and clock ISRs)
+FASTRUN void SimpleSequencer::drainEvents(uint32_t nowMicros){
+  uint32_t tick = absoluteTickCounter;
+  while (!events.empty()){
+    const SeqEvent& e = events.front();
+    if (e.tick > tick) break;
+    if (e.tick == tick && e.delayUs > 0 && (nowMicros - lastTickMicros) < e.delayUs) break;
+    switch (e.type){
+      case EV_NOTE_ON:
+      case EV_RATCHET_ON:
+        midiSendNoteOn(e.ch, e.d1, e.d2);
+        lastNotePlaying[e.ch] = e.d1;
+        traceRing.record(e.type == EV_NOTE_ON ? TR_NOTE_ON : TR_RATCHET, e.ch, e.d1 | (e.d2 << 8));
+        if (telemetryOn) telemetry.push(TEL_NOTE, nowMicros, e.ch, e.d1, e.d2);
+        break;
+      case EV_NOTE_OFF:
+        midiSendNoteOff(e.ch, e.d1, 0);
+        if (lastNotePlaying[e.ch] == e.d1) lastNotePlaying[e.ch] = 255;
+        traceRing.record(TR_NOTE_OFF, e.ch, e.d1);
+        if (telemetryOn) telemetry.push(TEL_NOTE, nowMicros, e.ch, e.d1, 0);
+        break;
+      case EV_CC:
+        midiSendCC(e.ch, e.d1, e.d2);
+        break;
+      case EV_ENV_TRIG:
+        mod.noteOn(e.ch);
+        break;
+    }
+    events.pop();
+  }
+}
+
+// Render one channel's step at `tick`: everything the old trigger-time path did, but
+// as queued events instead of immediate MIDI writes.
+FASTRUN void SimpleSequencer::renderChannel(uint8_t ch, uint8_t step, uint32_t tick){
+  // 1. THE NORMAL MUTE & FILL BLOCK
+  if (pat->muted[ch] || (songMuteMask & (1 << ch))) return;
+  uint8_t fstate = pat->fillState[ch][step];
+  if (fstate == 1 && !fillModeActive) return;
+  if (fstate == 2 && fillModeActive) return;
+  if (!evalTrigCondition(ch, step)) return;
+  uint8_t p = pat->pitch[ch][step];
+  if (p == 255) p = pat->channelPitch[ch];
+  uint8_t note = constrain((int)p + songTranspose, 0, 127);
+  // Optional trigger-time quantiser: snap to the channel scale (after song transpose)
+  if (pat->quantizeEnabled[ch] && pat->euclidScaleMode[ch] != SCALE_OFF) note = scaleQuantize(channelScale(ch), pat->scaleRoot[ch], note);
+
+  uint8_t vel = pat->stepVelocity[ch][step];
+  if (vel == 255) vel = pat->channelVelocity[ch];
+
+  // Groove: every event of the step moves with it, the note takes its accent
+  if (pat->trackGroove[ch]) {
+    const GrooveTemplate& g = grooveTables[pat->trackGroove[ch]];
+    uint8_t pos = step % g.length;
+    int32_t amt = pat->grooveAmount[ch];
+    int32_t unitUs = (int32_t)(tickPeriodUs() * TICKS_PER_STEP / GROOVE_UNITS_PER_STEP);
+    grooveShiftUs[ch] = g.offset[pos] * amt * unitUs / 100;
+    vel = constrain((int32_t)vel * (10000 + ((int32_t)g.velocity[pos] - 100) * amt) / 10000, 1, 127);
+  }
+
+  // CC p-locks go out just ahead of the note so the synth is set when it fires
+  if (pat->plocks.hasLocks(ch, step)) {
+    uint8_t n;
+    uint8_t first = pat->plocks.findStep(ch, step, n);
+    for (uint8_t i = first; i < first + n; i++) {
+      const PLock& l = pat->plocks.at(i);
+      if (l.param <= PLOCK_CC_MAX) pushEvent(EV_CC, ch, l.param, l.value, tick);
+    }
+  }
+
+  // Arp track: the trig opens the arpeggiator instead of playing its note
+  if (pat->arp[ch].mode != ARP_OFF) {
+    grooveShiftUs[ch] = 0;
+    openArp(ch, step, note, vel, tick);
+    return;
+  }
+
+  renderNoteOn(ch, note, vel, tick);
+  // Save the slide for the NEXT step
+  renderSlide[ch] = pat->stepSlide[ch][step];
 
   // 3. RATCHET & GATE LENGTH
-  uint8_t lenIdx = noteLen[ch][currentStep];
-  if (lenIdx == 255) lenIdx = noteLenIdx;
+  uint8_t lenIdx = pat->noteLen[ch][step];
+  if (lenIdx == 255) lenIdx = pat->noteLenIdx;
 
-  uint8_t rIdx = stepRatchet[ch][currentStep];
+  uint8_t rIdx = pat->stepRatchet[ch][step];
   if (rIdx > 0) {
     const uint8_t rTicks[] = {0, 6, 4, 3, 2, 1};
     uint8_t ticksPerHit = rTicks[rIdx];
-
-    ratchetIntervalTicks[ch] = ticksPerHit;
-    ratchetNextTick[ch] = absoluteTickCounter + ticksPerHit;
-    ratchetEndTick[ch] = absoluteTickCounter + 6; 
-    ratchetPitch[ch] = note;
     uint32_t offOffset = ticksPerHit / 2;
     if (offOffset == 0) offOffset = 1;
-    noteOffTick[ch] = absoluteTickCounter + offOffset;
-
-
+    // Every hit inside the step, each with its own crisp note-off
+    for (uint32_t t = tick; t < tick + TICKS_PER_STEP; t += ticksPerHit) {
+      if (t != tick) pushEvent(EV_RATCHET_ON, ch, note, 100, t);
+      renderGate(ch, note, t + offOffset);
+    }
   } else {
     // Normal single-hit logic
-    ratchetIntervalTicks[ch] = 0;
     uint32_t ticks = noteLenTicks[lenIdx];
     uint32_t gateLength;
 
-    if (stepSlide[ch][currentStep]) {
+    if (pat->stepSlide[ch][step]) {
       // FORCE OVERLAP: If this step is sliding, ensure it bleeds past the 6-tick boundary
       gateLength = (ticks < 7) ? 7 : (ticks + 1);
     } else {
       // NORMAL: Cut it short to leave a gap for envelopes to reset
       gateLength = (ticks > 1) ? (ticks - 1) : 1;
     }
-    noteOffTick[ch] = absoluteTickCounter + gateLength;
+    renderGate(ch, note, tick + gateLength);
+  }
+  grooveShiftUs[ch] = 0;
+}
 
+// 2. THE MONOSYNTH LEGATO MAGIC: note-on at `tick`, ordered against a note still
+// sounding from the previous step (or arp hit) by the slide flag it left behind.
+// Overlap is judged after both notes' groove shifts, so a rushed step still cuts
+// the note before it.
+FASTRUN void SimpleSequencer::renderNoteOn(uint8_t ch, uint8_t note, uint8_t vel, uint32_t tick){
+  bool isSlidingIntoThis = renderSlide[ch];
+  int32_t dt = (int32_t)(renderOffTick[ch] - tick);
+  bool overlaps = renderNote[ch] < 128 && dt > -2 * TICKS_PER_STEP
+               && dt * (int32_t)tickPeriodUs() + renderOffShiftUs[ch] - grooveShiftUs[ch] > 0;
+
+  if (overlaps) {
+    // Previous note still sounding here: its queued note-off is replaced by an explicit one
+    uint8_t prev = renderNote[ch];
+    events.cancelAfter(ch, EV_NOTE_OFF, makeEvent(EV_NOTE_ON, ch, note, vel, tick));
+    if (isSlidingIntoThis) {
+      // LEGATO: Fire the new note BEFORE killing the old one to trigger portamento
+      pushEvent(EV_NOTE_ON, ch, note, vel, tick);
+      pushEvent(EV_NOTE_OFF, ch, prev, 0, tick);
+    } else {
+      // NORMAL: Kill the old note BEFORE firing the new one (Crisp re-trigger)
+      pushEvent(EV_NOTE_OFF, ch, prev, 0, tick);
+      pushEvent(EV_NOTE_ON, ch, note, vel, tick);
+    }
+  } else {
+    // No overlapping note, just fire
+    pushEvent(EV_NOTE_ON, ch, note, vel, tick);
+  }
 
+  // Retrigger the track's envelope (slides keep it running, like a legato synth)
+  if (!isSlidingIntoThis) pushEvent(EV_ENV_TRIG, ch, 0, 0, tick);
+  renderNote[ch] = note;
+}
+
+FASTRUN void SimpleSequencer::renderGate(uint8_t ch, uint8_t note, uint32_t offTick){
+  pushEvent(EV_NOTE_OFF, ch, note, 0, offTick);
+  renderOffTick[ch] = offTick;
+  renderOffShiftUs[ch] = grooveShiftUs[ch];
+}
+
+// --- ARPEGGIATOR ---
+// Note on / off from DIN or USB input (engine ISR). Velocity 0 is a note-off.
+void SimpleSequencer::handleNoteIn(uint8_t status, uint8_t note, uint8_t vel){
+  if (note > 127) return;
+  if (status == 0x90 && vel > 0) heldNotes.add(note, vel);
+  else heldNotes.remove(note);
+}
+
+// A trig on an arp track: the arp plays for the step's note length. A trig that is
+// slid into keeps the walk going; any other restarts it from the first note.
+void SimpleSequencer::openArp(uint8_t ch, uint8_t step, uint8_t note, uint8_t vel, uint32_t tick){
+  uint8_t lenIdx = pat->noteLen[ch][step];
+  if (lenIdx == 255) lenIdx = pat->noteLenIdx;
+  arpGateEnd[ch] = tick + noteLenTicks[lenIdx];
+  arpVelocity[ch] = vel;
+  arpSlide[ch] = pat->stepSlide[ch][step];
+  if (!renderSlide[ch]) arp[ch].restart();
+  if (pat->arp[ch].source != ARP_SRC_CHORD) return;
+  ArpNotes& chord = arpChord[ch];
+  chord.clear();
+  const uint8_t* iv = ARP_CHORD_INTERVALS[pat->arp[ch].chord % ARP_NUM_CHORDS];
+  for (uint8_t i = 0; i < ARP_CHORD_NOTES && iv[i] != 0xFF; i++) {
+    int n = (int)note + iv[i];
+    if (n > 127) break;
+    // chord tones follow the trigger-time quantiser like the step's note does
+    if (pat->quantizeEnabled[ch] && pat->euclidScaleMode[ch] != SCALE_OFF) n = scaleQuantize(channelScale(ch), pat->scaleRoot[ch], n);
+    chord.add((uint8_t)n, vel);
+  }
+}
+
+// Clock the track's arp through one step's ticks (render path, interrupts off).
+// Each hit is a note through renderNoteOn() / renderGate(), so slide and
+// envelope retriggering behave as they do for step notes.
+void SimpleSequencer::renderArp(uint8_t ch, uint32_t tick){
+  if (arpGateEnd[ch] <= tick) return;
+  bool silent = pat->muted[ch] || (songMuteMask & (1 << ch));
+  const ArpNotes& set = (pat->arp[ch].source == ARP_SRC_HELD) ? heldNotes : arpChord[ch];
+  uint8_t rate = ARP_RATE_TICKS[pat->arp[ch].rateIdx % ARP_NUM_RATES];
+  // FORCE OVERLAP on a slide so the next hit glides; otherwise leave a gap
+  uint32_t gate = arpSlide[ch] ? rate + 1 : rate - 1;
+  for (uint32_t t = tick; t < tick + TICKS_PER_STEP && t < arpGateEnd[ch]; t++) {
+    ArpHit hit;
+    if (!arp[ch].tick(pat->arp[ch], set, hit) || silent) continue;
+    uint8_t vel = (pat->arp[ch].source == ARP_SRC_HELD) ? hit.vel : arpVelocity[ch];
+    renderNoteOn(ch, hit.note, vel, t);
+    renderSlide[ch] = arpSlide[ch];
+    uint32_t off = t + gate;
+    // the last hit ends with the trig's gate unless it slides on
+    if (!arpSlide[ch] && off > arpGateEnd[ch]) off = arpGateEnd[ch];
+    renderGate(ch, hit.note, off);
+  }
+}
+
+FLASHMEM void SimpleSequencer::printProfile(){
+  uint32_t mhz = F_CPU_ACTUAL / 1000000;
+  Serial.println("--- Engine profile (cycles, us) ---");
+  Serial.print("tick ISR   avg "); Serial.print(tickProfile.avg()); Serial.print(" / "); Serial.print(tickProfile.avg() / mhz);
+  Serial.print("  max "); Serial.print(tickProfile.max); Serial.print(" / "); Serial.println(tickProfile.max / mhz);
+  Serial.print("engine ISR avg "); Serial.print(engineProfile.avg()); Serial.print(" / "); Serial.print(engineProfile.avg() / mhz);
+  Serial.print("  max "); Serial.print(engineProfile.max); Serial.print(" / "); Serial.println(engineProfile.max / mhz);
+  Serial.print("step render avg "); Serial.print(renderProfile.avg()); Serial.print(" / "); Serial.print(renderProfile.avg() / mhz);
+  Serial.print("  max "); Serial.print(renderProfile.max); Serial.print(" / "); Serial.println(renderProfile.max / mhz);
+  Serial.print("SPP seek   avg "); Serial.print(seekProfile.avg()); Serial.print(" / "); Serial.print(seekProfile.avg() / mhz);
+  Serial.print("  max "); Serial.print(seekProfile.max); Serial.print(" / "); Serial.println(seekProfile.max / mhz);
+  Serial.print("start request -> step 0 us  avg "); Serial.print(startLatencyUs.avg());
+  Serial.print("  max "); Serial.print(startLatencyUs.max); Serial.print("  ("); Serial.print(startLatencyUs.count); Serial.println(" starts)");
+  Serial.print("pad edge -> note-on at port us  avg "); Serial.print(padLatency.avg() / mhz);
+  Serial.print("  max "); Serial.print(padLatency.max / mhz); Serial.print("  ("); Serial.print(padLatency.count);
+  Serial.print(" presses, "); Serial.print(padQueued); Serial.print(" queued, "); Serial.print(padPolled);
+  Serial.print(" polled, "); Serial.print(padDropped); Serial.println(" dropped)");
+  Serial.print("queued events: "); Serial.print(events.size());
+  Serial.print("  late renders (in ISR): "); Serial.println(lateRenders);
+  tickProfile.reset();
+  engineProfile.reset();
+  renderProfile.reset();
+  seekProfile.reset();
+  startLatencyUs.reset();
+  padLatency.reset();
+  padQueued = padPolled = padDropped = 0;
+}
+
+// Trig condition + probability for a step on a given loop. Pure: the dice roll is
+// a hash of the position, so seeks can evaluate any loop without replaying.
+bool SimpleSequencer::trigPasses(uint8_t ch, uint8_t step, uint32_t loop, bool pre) const {
+  uint8_t cond = pat->stepCond[ch][step];
+  uint8_t prob = pat->stepProb[ch][step];
+  bool pass = true;
+  switch (cond){
+    case TRIG_ALWAYS:    break;
+    case TRIG_FIRST:     pass = (loop == 0); break;
+    case TRIG_NOT_FIRST: pass = (loop != 0); break;
+    case TRIG_PRE:       pass = pre; break;
+    case TRIG_NOT_PRE:   pass = !pre; break;
+    default: {
+      TrigAB ab = trigConditionAB(cond);
+      pass = (loop % ab.b) == (uint32_t)(ab.a - 1);
+    }
+  }
+  if (pass && prob < 100) pass = trigRandom(pat->patternSeed, ch, loop, step, 100) < prob;
+  return pass;
+}
+
+// Would renderChannel() evaluate this step's condition and update PRE from it?
+bool SimpleSequencer::trigEvaluated(uint8_t ch, uint8_t step) const {
+  if (!isStepActive(ch, step) || pat->muted[ch] || (songMuteMask & (1 << ch))) return false;
+  uint8_t fstate = pat->fillState[ch][step];
+  if ((fstate == 1 && !fillModeActive) || (fstate == 2 && fillModeActive)) return false;
+  uint8_t cond = pat->stepCond[ch][step];
+  if (cond == TRIG_ALWAYS && pat->stepProb[ch][step] >= 100) return false;
+  return cond != TRIG_PRE && cond != TRIG_NOT_PRE;
+}
+
+// Trig condition + probability for a step, evaluated at trigger time (ISR safe:
+// no divides except the A:B modulo).
+FASTRUN bool SimpleSequencer::evalTrigCondition(uint8_t ch, uint8_t step){
+  uint8_t cond = pat->stepCond[ch][step];
+  if (cond == TRIG_ALWAYS && pat->stepProb[ch][step] >= 100) return true;
+  bool pass = trigPasses(ch, step, loopCount, lastCondPassed[ch]);
+  // PRE refers to the last non-PRE condition on the track
+  if (cond != TRIG_PRE && cond != TRIG_NOT_PRE) lastCondPassed[ch] = pass;
+  return pass;
+}
+
+// Transport start: rewind loop counters, so a run replays exactly
+void SimpleSequencer::resetTrigState(){
+  loopCount = 0;
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) lastCondPassed[ch] = false;
+}
+
+// --- SONG POSITION POINTER ---
+// Jump the engine to `position` (MIDI beats = 16th-note steps since song start).
+// Everything is derived from the position instead of replaying ticks: bar and
+// step by division, A:B / FIRST from the loop count, probability from the
+// position hash, and PRE from at most one pattern length of steps before the
+// target. Ratchets, slides and note-offs are rendered per step, so dropping the
+// rendered queue leaves nothing behind. Engine context (or interrupts off).
+void SimpleSequencer::seekTo(uint32_t position){
+  uint32_t bar = position / NUM_STEPS;
+  uint8_t step = position % NUM_STEPS;
+  currentStep = step;
+  midiStepTickCounter = 0;
+  stepAdvanceRequested = false;
+  absoluteTickCounter = 0;
+
+  loopCount = bar;
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    bool pre = false;
+    // walk back to the last step that updated PRE (this loop, then the previous one)
+    for (uint8_t k = 1; k <= NUM_STEPS; k++){
+      uint8_t s = (step + NUM_STEPS - k) % NUM_STEPS;
+      if (s >= step && bar == 0) break;
+      uint32_t loop = (s >= step) ? bar - 1 : bar;
+      if (!trigEvaluated(ch, s)) continue;
+      pre = trigPasses(ch, s, loop, false);
+      break;
+    }
+    lastCondPassed[ch] = pre;
+  }
+
+  // Song: bar lookup is an index into the compiled arrangement; the bar's pattern is
+  // staged by prefetchSongPattern() and swapped in while stopped or at the next bar
+  if (songActive && arrangement.length()){
+    songBar = bar % arrangement.length();
+    const ArrangementBar& b = arrangement.bar(songBar);
+    songMuteMask = b.muteMask;
+    songTranspose = b.transpose;
+  }
+  mod.seek(pat->lfo, position * TICKS_PER_STEP);
+
+  resetRender(step);
+  seekPending = true;
+  if (isRunning){
+    // seek while playing: the target step sounds now, the next lands 6 ticks later
+    if (transportState == TS_STOP_ARMED) armStop();
+    while (renderStep(absoluteTickCounter)) {}
+    drainEvents(micros());
+    seekPending = false;
   }
 }
 
 // CV/Gate functions removed; using MIDI out only
 
-void SimpleSequencer::drawDisplay(){
+// Hold a flash screen on the OLED for `ms`; the display task draws it and ends it
+void SimpleSequencer::holdDisplay(uint8_t what, uint32_t ms){
+  displayHold = what;
+  displayHoldDrawn = false;
+  displayHoldSlot = saveSlot;
+  displayHoldUntil = millis() + ms;
+}
+
+FLASHMEM void SimpleSequencer::drawDisplayHold(){
   display.clearDisplay();
+  if (displayHold == HOLD_CLEARED){
+    display.fillRect(0, 0, 128, 64, SH110X_WHITE);
+    return;
+  }
+  display.setTextSize(2);
+  display.setTextColor(SH110X_WHITE);
+  display.setCursor(24, 16);
+  display.print(displayHold == HOLD_SAVED ? "SAVED!" : "FAILED");
+  display.setCursor(24, 40);
+  display.print("SLOT "); display.print(displayHoldSlot + 1);
+}
 
+FLASHMEM void SimpleSequencer::drawDisplay(){
   uint32_t now = millis();
+
+  // ── SAVE / CLEAR FLASH: drawn once, kept until it times out ───
+  if (displayHold != HOLD_NONE){
+    if (!displayHoldDrawn){
+      drawDisplayHold();
+      display.display();
+      displayHoldDrawn = true;
+      updateLEDs();
+      return;
+    }
+    if ((int32_t)(now - displayHoldUntil) < 0){
+      updateLEDs();
+      return;
+    }
+    displayHold = HOLD_NONE;
+  }
+
+  display.clearDisplay();
+
   bool focused = (focusEncoder != 0) && ((now - lastEncoderMoveTime) < focusTimeout);
 
   const char* noteNames[] = {"C","C#","D","D#","E","F","F#","G","G#","A","A#","B"};
-  const char* scaleNames[] = {"OFF", "LOC", "DIM", "ATO"};
+  const char* scaleNames[] = {"OFF", "LOC", "DIM", "ATO", "USR"};
   const char* ratchetNames[] = {"OFF", "1/16", "1/24", "1/32", "1/48", "1/96"};
 
   // ── DEBUG MODE: Hold both FN + START to show full grid ─────────
   bool debugHold = (digitalRead(CHANNEL_BTN_PIN) == LOW) && (digitalRead(START_STOP_PIN) == LOW);
+  if (debugHold && focused){
+    if (arpPage) drawArpPage(); else drawModPage();
+    display.display();
+    updateLEDs();
+    return;
+  }
   if (debugHold){
     drawDebugGrid();
     // Thin status line at top
@@ -1132,61 +2904,90 @@ void SimpleSequencer::drawDisplay(){
 
     // ── ENCODER 1 ────────────────────────────────────────────────
     if (fe == 0){
-      if (heldStep >= 0){
+      bool startHeld = (digitalRead(START_STOP_PIN) == LOW);
+      bool chanModHeld = (digitalRead(CHANNEL_BTN_PIN) == LOW);
+      if (heldStep >= 0 && (startHeld || chanModHeld)){
+        // P-LOCK: probability or trig condition
+        display.setTextColor(SH110X_WHITE);
+        drawBig(4, 2, 2, startHeld ? "PROB" : "COND");
+        display.setTextSize(1);
+        display.setCursor(90, 6);
+        display.print("STP "); display.print(heldStep + 1);
+        char label[8];
+        if (startHeld) snprintf(label, sizeof(label), "%u%%", pat->stepProb[selectedChannel][heldStep]);
+        else trigConditionName(pat->stepCond[selectedChannel][heldStep], label);
+        drawBig(4, 26, 4, label);
+      } else if (heldStep >= 0){
         // P-LOCK: Full-screen retrig rate
-        uint8_t r = stepRatchet[selectedChannel][heldStep];
-        display.setTextSize(2);
+        uint8_t r = pat->stepRatchet[selectedChannel][heldStep];
         display.setTextColor(SH110X_WHITE);
-        display.setCursor(4, 2);
-        display.print("RETRIG");
+        drawBig(4, 2, 2, "RETRIG");
         display.setTextSize(1);
         display.setCursor(90, 6);
         display.print("STP "); display.print(heldStep + 1);
-        display.setTextSize(4);
-        display.setCursor(4, 26);
-        display.print(ratchetNames[r]);
+        drawBig(4, 26, 4, ratchetNames[r]);
       } else {
         // BPM — big
-        display.setTextSize(2);
         display.setTextColor(SH110X_WHITE);
-        display.setCursor(4, 2);
-        display.print("BPM");
-        display.setTextSize(4);
-        display.setCursor(4, 26);
-        display.print(bpm);
+        drawBig(4, 2, 2, "BPM");
+        // clock source in charge
+        display.setTextSize(1);
+        display.setCursor(100, 6);
+        display.print(clockSourceNames[clockIn.active()]);
+        char value[12];
+        snprintf(value, sizeof(value), "%lu", (unsigned long)bpm);
+        drawBig(4, 26, 4, value);
       }
       display.display();
       updateLEDs();
       return;
     }
 
+    // ── CC P-LOCK (Fn + Enc2/Enc3 on a held step) ────────────────
+    if ((fe == 1 || fe == 2) && heldStep >= 0 && digitalRead(CHANNEL_BTN_PIN) == LOW){
+      uint8_t cc = ccLockParam[selectedChannel];
+      int v = pat->plocks.get(selectedChannel, heldStep, cc);
+      char label[12];
+      display.setTextColor(SH110X_WHITE);
+      snprintf(label, sizeof(label), "CC%u", cc);
+      drawBig(4, 2, 2, label);
+      display.setTextSize(1); display.setCursor(90, 6);
+      display.print("STP "); display.print(heldStep + 1);
+      if (v < 0) drawBig(4, 26, 4, "--");
+      else { snprintf(label, sizeof(label), "%d", v); drawBig(4, 26, 4, label); }
+      display.display();
+      updateLEDs();
+      return;
+    }
+
     // ── ENCODER 2 ────────────────────────────────────────────────
     if (fe == 1){
       if (heldStep >= 0){
         bool startHeld = (digitalRead(START_STOP_PIN) == LOW);
         if (startHeld) {
           // ACCENT UI
-          uint8_t v = stepVelocity[selectedChannel][heldStep];
-          if (v == 255) v = channelVelocity[selectedChannel];
-          display.setTextSize(2); display.setTextColor(SH110X_WHITE);
-          display.setCursor(4, 2); display.print("ACCENT");
+          uint8_t v = pat->stepVelocity[selectedChannel][heldStep];
+          if (v == 255) v = pat->channelVelocity[selectedChannel];
+          char value[4];
+          display.setTextColor(SH110X_WHITE);
+          drawBig(4, 2, 2, "ACCENT");
           display.setTextSize(1); display.setCursor(90, 6);
           display.print("STP "); display.print(heldStep + 1);
-          display.setTextSize(4); display.setCursor(4, 26);
-          display.print(v);
+          snprintf(value, sizeof(value), "%u", v);
+          drawBig(4, 26, 4, value);
         } else {
           // PITCH UI
-          uint8_t p = pitch[selectedChannel][heldStep];
-          if (p == 255) p = channelPitch[selectedChannel];
-          display.setTextSize(2); display.setTextColor(SH110X_WHITE);
-          display.setCursor(4, 2); display.print("NOTE");
+          uint8_t p = pat->pitch[selectedChannel][heldStep];
+          if (p == 255) p = pat->channelPitch[selectedChannel];
+          char name[6];
+          display.setTextColor(SH110X_WHITE);
+          drawBig(4, 2, 2, "NOTE");
           display.setTextSize(1); display.setCursor(90, 6);
           display.print("STP "); display.print(heldStep + 1);
-          display.setTextSize(4); display.setCursor(4, 26);
-          display.print(noteNames[p % 12]);
-          display.print((p / 12) - 1);
+          snprintf(name, sizeof(name), "%s%d", noteNames[p % 12], (p / 12) - 1);
+          drawBig(4, 26, 4, name);
         }
-      } else if (euclidEnabled[selectedChannel]){
+      } else if (pat->euclidEnabled[selectedChannel]){
         // Euclid scale shift — show grid + shift info
         drawDebugGrid();
         display.fillRect(0, 0, 128, 12, SH110X_BLACK);
@@ -1194,22 +2995,19 @@ void SimpleSequencer::drawDisplay(){
         display.setTextColor(SH110X_WHITE);
         display.setCursor(2, 2);
         display.print("SHIFT ");
-        display.print(noteNames[channelPitch[selectedChannel] % 12]);
-        display.print((channelPitch[selectedChannel] / 12) - 1);
+        display.print(noteNames[pat->channelPitch[selectedChannel] % 12]);
+        display.print((pat->channelPitch[selectedChannel] / 12) - 1);
         display.setCursor(80, 2);
         display.print("SCL:");
-        display.print(scaleNames[euclidScaleMode[selectedChannel] % 4]);
+        display.print(scaleNames[pat->euclidScaleMode[selectedChannel] % SCALE_NUM_MODES]);
       } else {
         // Channel note — big
-        uint8_t cp = channelPitch[selectedChannel];
-        display.setTextSize(2);
+        uint8_t cp = pat->channelPitch[selectedChannel];
+        char name[6];
         display.setTextColor(SH110X_WHITE);
-        display.setCursor(4, 2);
-        display.print("NOTE");
-        display.setTextSize(4);
-        display.setCursor(4, 26);
-        display.print(noteNames[cp % 12]);
-        display.print((cp / 12) - 1);
+        drawBig(4, 2, 2, "NOTE");
+        snprintf(name, sizeof(name), "%s%d", noteNames[cp % 12], (cp / 12) - 1);
+        drawBig(4, 26, 4, name);
       }
       display.display();
       updateLEDs();
@@ -1222,32 +3020,34 @@ void SimpleSequencer::drawDisplay(){
         bool startHeld = (digitalRead(START_STOP_PIN) == LOW);
         if (startHeld) {
           // SLIDE UI
-          display.setTextSize(2); display.setTextColor(SH110X_WHITE);
-          display.setCursor(4, 2); display.print("SLIDE");
+          display.setTextColor(SH110X_WHITE);
+          drawBig(4, 2, 2, "SLIDE");
           display.setTextSize(1); display.setCursor(90, 6);
           display.print("STP "); display.print(heldStep + 1);
-          display.setTextSize(4); display.setCursor(4, 26);
-          display.print(stepSlide[selectedChannel][heldStep] ? "ON" : "OFF");
+          drawBig(4, 26, 4, pat->stepSlide[selectedChannel][heldStep] ? "ON" : "OFF");
         } else {
           // GATE UI
-          uint8_t lenIdx = noteLen[selectedChannel][heldStep];
-          if (lenIdx == 255) lenIdx = noteLenIdx;
-          display.setTextSize(2); display.setTextColor(SH110X_WHITE);
-          display.setCursor(4, 2); display.print("GATE");
+          uint8_t lenIdx = pat->noteLen[selectedChannel][heldStep];
+          if (lenIdx == 255) lenIdx = pat->noteLenIdx;
+          display.setTextColor(SH110X_WHITE);
+          drawBig(4, 2, 2, "GATE");
           display.setTextSize(1); display.setCursor(90, 6);
           display.print("STP "); display.print(heldStep + 1);
-          display.setTextSize(4); display.setCursor(4, 26);
-          display.print(noteLenNames[lenIdx]);
+          drawBig(4, 26, 4, noteLenNames[lenIdx]);
         }
+      } else if (digitalRead(START_STOP_PIN) == LOW) {
+        // Output routing for the selected track
+        const TrackRoute& r = midiRouter.route[selectedChannel];
+        char label[8];
+        display.setTextColor(SH110X_WHITE);
+        drawBig(4, 2, 2, "ROUTE");
+        snprintf(label, sizeof(label), "%s %u", midiPortNames[r.port % MIDI_MAX_PORTS], r.channel + 1);
+        drawBig(4, 28, 3, label);
       } else {
         // Global gate length — big
-        display.setTextSize(2);
         display.setTextColor(SH110X_WHITE);
-        display.setCursor(4, 2);
-        display.print("GATE");
-        display.setTextSize(4);
-        display.setCursor(4, 26);
-        display.print(noteLenNames[noteLenIdx]);
+        drawBig(4, 2, 2, "GATE");
+        drawBig(4, 26, 4, noteLenNames[pat->noteLenIdx]);
       }
       display.display();
       updateLEDs();
@@ -1256,27 +3056,38 @@ void SimpleSequencer::drawDisplay(){
 
     // ── ENCODER 4 ────────────────────────────────────────────────
     if (fe == 3){
-      if (euclidEnabled[selectedChannel]){
+      if (heldStep < 0 && digitalRead(START_STOP_PIN) == LOW){
+        // Track delay (latency compensation)
+        char value[6];
+        display.setTextColor(SH110X_WHITE);
+        drawBig(4, 2, 2, "DELAY");
+        snprintf(value, sizeof(value), pat->trackDelayMs[selectedChannel] > 0 ? "+%d" : "%d", pat->trackDelayMs[selectedChannel]);
+        int16_t end = drawBig(4, 28, 3, value);
+        display.setTextSize(1);
+        display.setCursor(end, 28);
+        display.print("ms");
+        // Clock output of the track's port (START + Enc4 click)
+        uint8_t port = midiRouter.route[selectedChannel].port;
+        display.setCursor(80, 6);
+        display.print(midiPortNames[port % MIDI_MAX_PORTS]);
+        display.print(midiRouter.clockOut(port) ? " CLK" : " ---");
+      } else if (pat->euclidEnabled[selectedChannel]){
         // Euclid active — show grid + params
         drawDebugGrid();
         display.fillRect(0, 0, 128, 12, SH110X_BLACK);
         display.setTextSize(1);
         display.setTextColor(SH110X_WHITE);
         display.setCursor(2, 2);
-        display.print("EUCLID");
+        display.print(pat->euclidMode[selectedChannel] == EUCLID_BJORKLUND ? "BJORK" : "EUCLID");
         display.setCursor(48, 2);
-        display.print("H:"); display.print(pulses[selectedChannel]);
+        display.print("H:"); display.print(pat->pulses[selectedChannel]);
         display.setCursor(80, 2);
-        display.print("O:"); display.print(euclidOffset[selectedChannel]);
+        display.print("O:"); display.print(pat->euclidOffset[selectedChannel]);
       } else {
         // Euclid off
-        display.setTextSize(2);
         display.setTextColor(SH110X_WHITE);
-        display.setCursor(4, 2);
-        display.print("EUCLID");
-        display.setTextSize(3);
-        display.setCursor(4, 28);
-        display.print("OFF");
+        drawBig(4, 2, 2, "EUCLID");
+        drawBig(4, 28, 3, "OFF");
       }
       display.display();
       updateLEDs();
@@ -1294,7 +3105,7 @@ void SimpleSequencer::drawDisplay(){
       display.fillRect(bx, 0, 30, 11, SH110X_WHITE);
       display.setTextColor(SH110X_BLACK, SH110X_WHITE);
     } else {
-      if (muted[c]){
+      if (pat->muted[c]){
         display.drawRect(bx, 0, 30, 11, SH110X_WHITE);
         display.drawLine(bx, 5, bx + 29, 5, SH110X_WHITE);
       } else {
@@ -1309,14 +3120,12 @@ void SimpleSequencer::drawDisplay(){
   display.setTextColor(SH110X_WHITE, SH110X_BLACK);
 
   // Row 2: Channel note + note length (note length slightly smaller)
-  uint8_t cp = channelPitch[selectedChannel];
-  display.setTextSize(3);
-  display.setCursor(4, 16);
-  display.print(noteNames[cp % 12]); display.print((cp / 12) - 1);
+  uint8_t cp = pat->channelPitch[selectedChannel];
+  char name[6];
+  snprintf(name, sizeof(name), "%s%d", noteNames[cp % 12], (cp / 12) - 1);
+  drawBig(4, 16, 3, name);
   // Note length: reduce font to avoid awkward overflow
-  display.setTextSize(2);
-  display.setCursor(76, 18);
-  display.print(noteLenNames[noteLenIdx]);
+  drawBig(76, 18, 2, noteLenNames[pat->noteLenIdx]);
 
   // Row 3: Euclid status (BPM tucked bottom-right)
   display.setTextSize(1);
@@ -1324,42 +3133,116 @@ void SimpleSequencer::drawDisplay(){
   display.setCursor(84, 44);
   display.print("BPM "); display.print(bpm);
 
-  if (euclidEnabled[selectedChannel]){
+  if (pat->euclidEnabled[selectedChannel]){
     display.setCursor(52, 44);
-    display.print("EUC H:"); display.print(pulses[selectedChannel]);
-    display.print(" O:"); display.print(euclidOffset[selectedChannel]);
+    display.print("EUC H:"); display.print(pat->pulses[selectedChannel]);
+    display.print(" O:"); display.print(pat->euclidOffset[selectedChannel]);
   }
 
   // Row 4: Scale + P-lock indicator (always show scale)
   display.setCursor(4, 55);
-  display.print("SCL:"); display.print(scaleNames[euclidScaleMode[selectedChannel] % 4]);
+  display.print("SCL:"); display.print(scaleNames[pat->euclidScaleMode[selectedChannel] % SCALE_NUM_MODES]);
+  if (pat->quantizeEnabled[selectedChannel]) display.print("Q");
   if (heldStep >= 0){
     display.setCursor(100, 55);
     display.print("P:"); display.print(heldStep + 1);
     // Show per-step P-Lock VEL and SLD
-    uint8_t v = stepVelocity[selectedChannel][heldStep];
-    if (v == 255) v = channelVelocity[selectedChannel];
+    uint8_t v = pat->stepVelocity[selectedChannel][heldStep];
+    if (v == 255) v = pat->channelVelocity[selectedChannel];
     display.setCursor(4, 55);
     display.print("VEL:"); display.print(v);
     display.setCursor(52, 55);
-    display.print("SLD:"); display.print(stepSlide[selectedChannel][heldStep] ? "ON" : "OFF");
+    display.print("SLD:"); display.print(pat->stepSlide[selectedChannel][heldStep] ? "ON" : "OFF");
   }
 
   display.display();
   updateLEDs();
 }
 
-void SimpleSequencer::drawDebugGrid(){
+// Text at size 2-4 from the compile-time glyph cache (BigFont.h), written straight
+// into the display buffer; any character the cache lacks goes through GFX.
+// Returns the x after the last character, like the GFX cursor.
+int16_t SimpleSequencer::drawBig(int16_t x, int16_t y, uint8_t size, const char* text){
+  uint8_t* buf = display.getBuffer();
+  for (const char* c = text; *c; c++){
+    if (!bigFontBlit(buf, display.width(), display.height(), x, y, *c, size)) {
+      display.drawChar(x, y, *c, SH110X_WHITE, SH110X_WHITE, size);
+    }
+    x += 6 * size;
+  }
+  return x;
+}
+
+FLASHMEM void SimpleSequencer::drawModPage(){
+  const char* shapeNames[] = {"SIN", "TRI", "SAW", "SQR", "RND"};
+  const char* rateNames[] = {"1/16", "1/8", "1/4", "1/2", "1BAR", "2BAR", "4BAR", "8BAR"};
+  const LfoParams& l = pat->lfo[selectedChannel];
+  const EnvParams& en = pat->env[selectedChannel];
+  display.setTextSize(1);
+  display.setTextColor(SH110X_WHITE);
+  display.setCursor(2, 1);
+  display.print("MOD  CH"); display.print(selectedChannel + 1);
+
+  // LFO: shape, rate, depth, destination
+  display.setCursor(2, 18);
+  display.print("LFO "); display.print(shapeNames[l.shape % LFO_NUM_SHAPES]);
+  display.print(" "); display.print(rateNames[l.rateIdx % MOD_NUM_LFO_RATES]);
+  display.setCursor(2, 28);
+  display.print("  D"); display.print(l.depth);
+  display.print(" > ");
+  if (l.dest == MOD_DEST_OFF) display.print("OFF");
+  else if (l.dest == MOD_DEST_PITCHBEND) display.print("PB");
+  else { display.print("CC"); display.print(l.dest); }
+
+  // Envelope: attack / decay in ticks, depth, destination
+  display.setCursor(2, 42);
+  display.print("ENV A"); display.print(MOD_ENV_TICKS[en.attackIdx % MOD_NUM_ENV_TIMES]);
+  display.print(" D"); display.print(MOD_ENV_TICKS[en.decayIdx % MOD_NUM_ENV_TIMES]);
+  display.setCursor(2, 52);
+  display.print("  D"); display.print(en.depth);
+  display.print(" > ");
+  if (en.dest == MOD_DEST_OFF) display.print("OFF");
+  else if (en.dest == MOD_DEST_PITCHBEND) display.print("PB");
+  else { display.print("CC"); display.print(en.dest); }
+}
+
+FLASHMEM void SimpleSequencer::drawArpPage(){
+  const char* modeNames[] = {"OFF", "UP", "DOWN", "RND", "ORDER"};
+  const char* rateNames[] = {"1/48", "1/32", "1/16T", "1/16", "1/8T", "1/8", "1/4T", "1/4"};
+  const char* chordNames[] = {"MAJ", "MIN", "SUS4", "MAJ7", "MIN7", "DOM7", "DIM", "OCT"};
+  const ArpParams& a = pat->arp[selectedChannel];
+  display.setTextSize(1);
+  display.setTextColor(SH110X_WHITE);
+  display.setCursor(2, 1);
+  display.print("ARP  CH"); display.print(selectedChannel + 1);
+
+  display.setCursor(2, 18);
+  display.print(modeNames[a.mode % ARP_NUM_MODES]);
+  display.print(" "); display.print(rateNames[a.rateIdx % ARP_NUM_RATES]);
+  display.print(" x"); display.print(a.octaves); display.print("OCT");
+  display.setCursor(2, 32);
+  if (a.source == ARP_SRC_HELD) {
+    display.print("HELD ");
+    display.print(heldNotes.count); display.print(" notes");
+  } else {
+    display.print("CHORD "); display.print(chordNames[a.chord % ARP_NUM_CHORDS]);
+  }
+  display.setCursor(2, 46);
+  display.print("GROOVE "); display.print(grooveTables[pat->trackGroove[selectedChannel]].name);
+  if (pat->trackGroove[selectedChannel]) { display.print(" "); display.print(pat->grooveAmount[selectedChannel]); display.print("%"); }
+}
+
+FLASHMEM void SimpleSequencer::drawDebugGrid(){
   // replicate previous grid drawing for debugging
   const int stepW = 12, stepH = 12, startX = 6, startY = 16, spacingX = 3, spacingY = 4;
   for (uint8_t i = 0; i < NUM_STEPS; i++){
     int col = i % 8; int row = i / 8;
     int x = startX + col * (stepW + spacingX);
     int y = startY + row * (stepH + spacingY);
-    bool stepActive = euclidEnabled[selectedChannel] ? euclidPattern[selectedChannel][i] : steps[selectedChannel][i];
+    bool stepActive = isStepActive(selectedChannel, i);
     if (stepActive){ 
       display.fillRect(x, y, stepW, stepH, SH110X_WHITE);
-      uint8_t fs = fillState[selectedChannel][i];
+      uint8_t fs = pat->fillState[selectedChannel][i];
       if (fs == 1) display.fillRect(x+3, y+3, stepW-6, stepH-6, SH110X_BLACK);
       else if (fs == 2){ display.drawRect(x+2, y+2, stepW-4, stepH-4, SH110X_WHITE); display.fillRect(x+4, y+4, 4, 4, SH110X_WHITE); }
     }
@@ -1368,64 +3251,19 @@ void SimpleSequencer::drawDebugGrid(){
   }
 }
 
-void SimpleSequencer::runSwitchTest(uint32_t ms){
+FLASHMEM void SimpleSequencer::runSwitchTest(uint32_t ms){
   Serial.print("Starting switch test for "); Serial.print(ms); Serial.println(" ms");
   Serial.println("Press buttons to see state changes.");
-  bool lastState[NUM_STEPS];
-  for (uint8_t i=0;i<NUM_STEPS;i++) lastState[i] = (digitalRead(BUTTON_PINS[i])==LOW);
-  bool lastStart = (digitalRead(START_STOP_PIN) == LOW);
-  uint32_t start = millis();
-  while (millis() - start < ms){
-    // buttons
-    for (uint8_t i=0;i<NUM_STEPS;i++){
-      bool s = (digitalRead(BUTTON_PINS[i])==LOW);
-      if (s != lastState[i]){
-        Serial.print("Button "); Serial.print(i); Serial.print(s?" pressed":" released"); Serial.println();
-        // blink built-in LED briefly
-        digitalWrite(LED_BUILTIN, HIGH);
-        delay(30);
-        digitalWrite(LED_BUILTIN, LOW);
-        lastState[i] = s;
-      }
-    }
-    // start/stop button
-    bool sr = (digitalRead(START_STOP_PIN) == LOW);
-    if (sr != lastStart){
-      Serial.print("Start button "); Serial.print(sr?"pressed":"released"); Serial.println();
-      digitalWrite(LED_BUILTIN, HIGH);
-      delay(40);
-      digitalWrite(LED_BUILTIN, LOW);
-      lastStart = sr;
-    }
-    delay(8); // poll interval ~8ms
-  }
-  Serial.println("Switch test finished");
+  startDiag(DIAG_SWITCHES, ms);
 }
 
-void SimpleSequencer::runEncoderSwitchTest(uint32_t ms){
+FLASHMEM void SimpleSequencer::runEncoderSwitchTest(uint32_t ms){
   Serial.print("Starting encoder-switch test for "); Serial.print(ms); Serial.println(" ms");
   Serial.println("Press encoder buttons to see state changes.");
-  bool lastState[4];
-  for (uint8_t i=0;i<4;i++) lastState[i] = (digitalRead(ENC_SW[i])==LOW);
-  uint32_t start = millis();
-  while (millis() - start < ms){
-    for (uint8_t i=0;i<4;i++){
-      bool s = (digitalRead(ENC_SW[i])==LOW);
-      if (s != lastState[i]){
-        Serial.print("Enc button "); Serial.print(i+1); Serial.print(s?" pressed":" released"); Serial.println();
-        // blink built-in LED briefly
-        digitalWrite(LED_BUILTIN, HIGH);
-        delay(30);
-        digitalWrite(LED_BUILTIN, LOW);
-        lastState[i] = s;
-      }
-    }
-    delay(8);
-  }
-  Serial.println("Encoder switch test finished");
+  startDiag(DIAG_ENC_SWITCHES, ms);
 }
 
-void SimpleSequencer::printEncoderRaw(){
+FLASHMEM void SimpleSequencer::printEncoderRaw(){
   Serial.println("Encoder raw states (A B SW):");
   for (uint8_t e=0;e<4;e++){
     int a = digitalRead(ENC_A[e]);
@@ -1436,27 +3274,89 @@ void SimpleSequencer::printEncoderRaw(){
   }
 }
 
-void SimpleSequencer::runMidiPinMonitor(uint32_t ms){
+FLASHMEM void SimpleSequencer::runMidiPinMonitor(uint32_t ms){
   Serial.print("Monitoring MIDI RX pin for "); Serial.print(ms); Serial.println(" ms");
-  unsigned long start = millis();
-  int last = digitalRead(MIDI_RX_PIN);
-  while (millis() - start < ms){
-    int v = digitalRead(MIDI_RX_PIN);
-    if (v != last){
-      Serial.print("MIDI_RX changed: "); Serial.println(v);
-      digitalWrite(LED_BUILTIN, HIGH);
-      delay(20);
-      digitalWrite(LED_BUILTIN, LOW);
-      last = v;
+  startDiag(DIAG_MIDI_PIN, ms);
+}
+
+// --- CONSOLE TESTS ---
+// The tests used to spin in loop() for their whole length; now the diag task polls
+// them (every 8 ms for switches, 1 ms for the MIDI pin) while the sequencer keeps
+// running. Starting a test replaces the one in progress.
+uint32_t SimpleSequencer::readDiagState() const {
+  uint32_t state = 0;
+  switch (diagMode){
+    case DIAG_SWITCHES:
+      for (uint8_t i=0;i<NUM_STEPS;i++) if (digitalRead(BUTTON_PINS[i])==LOW) state |= 1UL << i;
+      if (digitalRead(START_STOP_PIN) == LOW) state |= 1UL << NUM_STEPS;
+      break;
+    case DIAG_ENC_SWITCHES:
+      for (uint8_t i=0;i<4;i++) if (digitalRead(ENC_SW[i])==LOW) state |= 1UL << i;
+      break;
+    case DIAG_MIDI_PIN:
+      state = digitalRead(MIDI_RX_PIN) ? 1 : 0;
+      break;
+  }
+  return state;
+}
+
+FLASHMEM void SimpleSequencer::startDiag(uint8_t mode, uint32_t ms){
+  diagMode = mode;
+  diagStartMillis = millis();
+  diagPollMillis = diagStartMillis;
+  diagLengthMs = ms;
+  diagLast = readDiagState();
+}
+
+// Built-in LED on for `ms`; serviceDiag() turns it off
+void SimpleSequencer::blinkDebugLed(uint32_t ms){
+  digitalWrite(LED_BUILTIN, HIGH);
+  debugLedOffTime = millis() + ms;
+  if (debugLedOffTime == 0) debugLedOffTime = 1;
+}
+
+void SimpleSequencer::serviceDiag(){
+  uint32_t now = millis();
+  if (debugLedOffTime && (int32_t)(now - debugLedOffTime) >= 0){
+    digitalWrite(LED_BUILTIN, LOW);
+    debugLedOffTime = 0;
+  }
+  if (diagMode == DIAG_NONE) return;
+  if (now - diagStartMillis >= diagLengthMs){
+    if (diagMode == DIAG_SWITCHES) Serial.println("Switch test finished");
+    else if (diagMode == DIAG_ENC_SWITCHES) Serial.println("Encoder switch test finished");
+    else Serial.println("Monitor finished");
+    diagMode = DIAG_NONE;
+    return;
+  }
+  uint32_t pollMs = (diagMode == DIAG_MIDI_PIN) ? 1 : 8;
+  if (now - diagPollMillis < pollMs) return;
+  diagPollMillis = now;
+  uint32_t state = readDiagState();
+  uint32_t changed = state ^ diagLast;
+  diagLast = state;
+  for (uint8_t i = 0; changed; i++, changed >>= 1){
+    if (!(changed & 1)) continue;
+    bool s = (state >> i) & 1;
+    if (diagMode == DIAG_MIDI_PIN){
+      Serial.print("MIDI_RX changed: "); Serial.println(s ? 1 : 0);
+      blinkDebugLed(20);
+    } else if (diagMode == DIAG_ENC_SWITCHES){
+      Serial.print("Enc button "); Serial.print(i+1); Serial.print(s?" pressed":" released"); Serial.println();
+      blinkDebugLed(30);
+    } else if (i == NUM_STEPS){
+      Serial.print("Start button "); Serial.print(s?"pressed":"released"); Serial.println();
+      blinkDebugLed(40);
+    } else {
+      Serial.print("Button "); Serial.print(i); Serial.print(s?" pressed":" released"); Serial.println();
+      blinkDebugLed(30);
     }
-    delay(1);
   }
-  Serial.println("Monitor finished");
 }
 
 // MIDI input handlers removed — processing consolidated in runEngine() to avoid concurrent Serial reads.
 
-void SimpleSequencer::bootAnimation() {
+FLASHMEM void SimpleSequencer::bootAnimation() {
   display.clearDisplay();
   ledStrip.clear();
   randomSeed(analogRead(0));
@@ -1558,7 +3458,7 @@ void SimpleSequencer::bootAnimation() {
 }
 
 // LED update: new color mapping (playhead purple, fills blue, triggers red)
-void SimpleSequencer::updateLEDs() {
+FLASHMEM void SimpleSequencer::updateLEDs() {
   // 1. LIVE PERFORMANCE MODE: Crackling Red Glitch Strobe
   if (fillModeActive) {
     for (uint8_t i = 0; i < NUM_STEPS; i++) {
@@ -1575,6 +3475,16 @@ void SimpleSequencer::updateLEDs() {
     ledStrip.show();
     return; // Exit early to skip normal drawing
   }
+  // PAD PLAY: sounding pads white, the rest dim (C pads brighter in chromatic mode)
+  if (padMode != PAD_OFF) {
+    for (uint8_t i = 0; i < NUM_STEPS; i++) {
+      if (padNote[i] < 128) ledStrip.setPixelColor(i, ledStrip.Color(255, 255, 255));
+      else if (padMode == PAD_CHROMATIC && (pat->channelPitch[selectedChannel] + i) % 12 == 0) ledStrip.setPixelColor(i, ledStrip.Color(0, 40, 120));
+      else ledStrip.setPixelColor(i, ledStrip.Color(30, 12, 0));
+    }
+    ledStrip.show();
+    return;
+  }
   // PAUSE LIGHTSHOW: Polyrhythmic Phase-Shifting Ring
   if (!isRunning) {
     uint32_t now = millis();
@@ -1635,7 +3545,7 @@ void SimpleSequencer::updateLEDs() {
   }
   // 2. NORMAL MODE: Playhead and Triggers
   for (uint8_t i = 0; i < NUM_STEPS; i++) {
-    bool stepActive = euclidEnabled[selectedChannel] ? euclidPattern[selectedChannel][i] : steps[selectedChannel][i];
+    bool stepActive = isStepActive(selectedChannel, i);
     uint8_t r = 0, g = 0, b = 0;
 
     if (i == currentStep) {
@@ -1643,7 +3553,7 @@ void SimpleSequencer::updateLEDs() {
       r = 180; g = 0; b = 255; 
     } else if (stepActive) {
       // ACTIVE STEPS
-      uint8_t fs = fillState[selectedChannel][i];
+      uint8_t fs = pat->fillState[selectedChannel][i];
       if (fs == 1) {
         // FILL STEP: Blue
         r = 0; g = 50; b = 255;   
@@ -1663,20 +3573,143 @@ void SimpleSequencer::updateLEDs() {
 
 void SimpleSequencer::clearTrack(uint8_t ch) {
   for (uint8_t s = 0; s < NUM_STEPS; s++) {
-    steps[ch][s] = false;
-    pitch[ch][s] = 255;
-    noteLen[ch][s] = 255;
-    fillState[ch][s] = 0;
-    stepRatchet[ch][s] = 0;
-    stepVelocity[ch][s] = 255;
-    stepSlide[ch][s] = false;
-  }
-  euclidEnabled[ch] = false;
-  pulses[ch] = 4;
-  euclidOffset[ch] = 0;
-  
-  display.clearDisplay();
-  display.fillRect(0, 0, 128, 64, SH110X_WHITE);
-  display.display();
-  delay(30);
+    pat->steps[ch][s] = false;
+    pat->pitch[ch][s] = 255;
+    pat->noteLen[ch][s] = 255;
+    pat->fillState[ch][s] = 0;
+    pat->stepRatchet[ch][s] = 0;
+    pat->stepVelocity[ch][s] = 255;
+    pat->stepSlide[ch][s] = false;
+    pat->stepProb[ch][s] = 100;
+    pat->stepCond[ch][s] = TRIG_ALWAYS;
+  }
+  pat->plocks.clearTrack(ch);
+  pat->euclidEnabled[ch] = false;
+  pat->pulses[ch] = 4;
+  pat->euclidOffset[ch] = 0;
+  holdDisplay(HOLD_CLEARED, 30);
+}
+
+// --- UNDO / REDO ---
+// An edit is committed when its gesture ends: a held step is released, or the
+// encoders have been still for UNDO_SETTLE_MS (so one turn is one undo level).
+// Pattern loads and cued pattern swaps start a fresh history.
+static const uint32_t UNDO_SETTLE_MS = 600;
+
+uint8_t* SimpleSequencer::undoFieldPtr(uint8_t field, uint8_t ch, uint8_t idx){
+  switch (field){
+    case UF_STEP_ON:     return (uint8_t*)&pat->steps[ch][idx];
+    case UF_PITCH:       return &pat->pitch[ch][idx];
+    case UF_LEN:         return &pat->noteLen[ch][idx];
+    case UF_RATCHET:     return &pat->stepRatchet[ch][idx];
+    case UF_VELOCITY:    return &pat->stepVelocity[ch][idx];
+    case UF_SLIDE:       return (uint8_t*)&pat->stepSlide[ch][idx];
+    case UF_PROB:        return &pat->stepProb[ch][idx];
+    case UF_COND:        return &pat->stepCond[ch][idx];
+    case UF_FILL:        return &pat->fillState[ch][idx];
+    case UF_EUCLID_ON:   return (uint8_t*)&pat->euclidEnabled[ch];
+    case UF_PULSES:      return &pat->pulses[ch];
+    case UF_OFFSET:      return &pat->euclidOffset[ch];
+    case UF_EUCLID_MODE: return &pat->euclidMode[ch];
+    case UF_SCALE:       return &pat->euclidScaleMode[ch];
+    case UF_SCALE_ROOT:  return &pat->scaleRoot[ch];
+    case UF_USER_SCALE:  return (uint8_t*)&pat->userScaleMask[ch] + idx;
+    case UF_CH_PITCH:    return &pat->channelPitch[ch];
+    case UF_CH_VELOCITY: return &pat->channelVelocity[ch];
+    default:             return (uint8_t*)&pat->euclidPattern[ch] + idx;
+  }
+}
+
+void SimpleSequencer::undoResync(){
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    uint16_t slot = 0;
+    for (uint8_t f = 0; f < UF_NUM_BYTE_FIELDS; f++){
+      for (uint8_t i = 0; i < undoFieldBytes(f, NUM_STEPS); i++) undoShadow[ch][slot++] = *undoFieldPtr(f, ch, i);
+    }
+  }
+  undoShadowLocks = pat->plocks;
+}
+
+// Log what changed since the last commit as one edit
+void SimpleSequencer::undoCommit(){
+  undoLog.beginEdit();
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    uint16_t slot = 0;
+    for (uint8_t f = 0; f < UF_NUM_BYTE_FIELDS; f++){
+      for (uint8_t i = 0; i < undoFieldBytes(f, NUM_STEPS); i++){
+        uint8_t live = *undoFieldPtr(f, ch, i);
+        uint8_t& shadow = undoShadow[ch][slot++];
+        if (live == shadow) continue;
+        undoLog.record(f, ch, i, 0, live ^ shadow);
+        shadow = live;
+      }
+    }
+  }
+  // Removed locks first: undo runs the edit backwards, so it frees table slots
+  // before it refills them, as the edit itself did
+  for (uint8_t i = 0; i < undoShadowLocks.size(); i++){
+    const PLock& l = undoShadowLocks.at(i);
+    if (pat->plocks.get(l.track, l.step, l.param) < 0) undoLog.record(UF_PLOCK, l.track, l.step, l.param, l.value ^ 0xFF);
+  }
+  for (uint8_t i = 0; i < pat->plocks.size(); i++){
+    const PLock& l = pat->plocks.at(i);
+    int old = undoShadowLocks.get(l.track, l.step, l.param);
+    uint8_t was = old < 0 ? 0xFF : (uint8_t)old;
+    if (was != l.value) undoLog.record(UF_PLOCK, l.track, l.step, l.param, was ^ l.value);
+  }
+  undoShadowLocks = pat->plocks;
+  undoLog.beginEdit();
+}
+
+// Input task: resync after a pattern swap, commit when a gesture ends
+void SimpleSequencer::serviceUndo(){
+  if (undoResyncPending){
+    undoResyncPending = false;
+    undoLog.clear();
+    undoResync();
+    undoSeenMove = lastEncoderMoveTime;
+    return;
+  }
+  if (heldStep >= 0) { undoGesture = true; return; }
+  bool settled = lastEncoderMoveTime != undoSeenMove && millis() - lastEncoderMoveTime >= UNDO_SETTLE_MS;
+  if (undoGesture || settled){
+    undoGesture = false;
+    undoSeenMove = lastEncoderMoveTime;
+    undoCommit();
+  }
+}
+
+// A lock the delta toggles between value and absent (0xFF)
+static bool togglePlock(PLockStore& store, const UndoDelta& d){
+  int cur = store.get(d.track, d.index, d.param);
+  uint8_t v = (uint8_t)((cur < 0 ? 0xFF : cur) ^ d.x);
+  if (v == 0xFF) { store.remove(d.track, d.index, d.param); return true; }
+  return store.set(d.track, d.index, d.param, v);
+}
+
+// Same XOR on the pattern and its shadow, so the next commit sees no change.
+// Plain byte writes: steps already rendered keep the old values, as with any edit.
+void SimpleSequencer::applyUndoDelta(void* ctx, const UndoDelta& d){
+  SimpleSequencer* s = static_cast<SimpleSequencer*>(ctx);
+  if (d.field == UF_PLOCK){
+    if (!togglePlock(s->pat->plocks, d)) traceRing.record(TR_PLOCK_FULL, d.track, d.index);
+    togglePlock(s->undoShadowLocks, d);
+    return;
+  }
+  *s->undoFieldPtr(d.field, d.track, d.index) ^= d.x;
+  s->undoShadow[d.track][undoFieldOffset(d.field, NUM_STEPS) + d.index] ^= d.x;
+  if (d.field == UF_USER_SCALE) s->pat->userScale[d.track] = makeScale(s->pat->userScaleMask[d.track]);
+}
+
+FLASHMEM bool SimpleSequencer::undoEdit(bool redo){
+  if (undoResyncPending) serviceUndo();
+  // an edit that hasn't settled yet is the newest one
+  undoCommit();
+  bool ok = redo ? undoLog.redo(applyUndoDelta, this) : undoLog.undo(applyUndoDelta, this);
+  undoSeenMove = lastEncoderMoveTime;
+  Serial.print(redo ? (ok ? "Redo" : "Nothing to redo") : (ok ? "Undo" : "Nothing to undo"));
+  Serial.print("  levels "); Serial.print(undoLog.undoLevels());
+  Serial.print(" / redo "); Serial.print(undoLog.redoLevels());
+  Serial.print("  deltas "); Serial.print(undoLog.records()); Serial.print("/"); Serial.println(UNDO_LOG_RECORDS);
+  return ok;
 }
@@ -0,0 +1,17 @@
+#include "SongMode.h"
+
+uint16_t Arrangement::compile(const Song& song){
+  count = 0;
+  if (song.magic != SONG_MAGIC) return 0;
+  uint8_t n = song.length <= SONG_MAX_ENTRIES ? song.length : SONG_MAX_ENTRIES;
+  for (uint8_t e = 0; e < n; e++){
+    const SongEntry& en = song.entries[e];
+    ArrangementBar b;
+    b.pattern = en.pattern;
+    b.muteMask = en.muteMask;
+    b.transpose = en.transpose;
+    uint8_t reps = en.repeats ? en.repeats : 1;
+    for (uint8_t r = 0; r < reps && count < SONG_MAX_BARS; r++) bars[count++] = b;
+  }
+  return count;
+}
@@ -0,0 +1,72 @@
+#include "UndoLog.h"
+
+void UndoLog::clear(){
+  tail = 0;
+  applied = 0;
+  total = 0;
+  levels = 0;
+  redoable = 0;
+  open = false;
+  overflow = false;
+}
+
+// Make room by forgetting the oldest edit. False if that edit is the one being recorded.
+bool UndoLog::dropOldest(){
+  if (levels == 0 || (open && editStart == 0)) return false;
+  uint16_t n = 1;
+  while (n < total && !(ring[wrap(tail + n)].field & UNDO_EDIT_START)) n++;
+  tail = wrap(tail + n);
+  total -= n;
+  applied -= n;
+  if (open) editStart -= n;
+  levels--;
+  dropped++;
+  return true;
+}
+
+void UndoLog::record(uint8_t field, uint8_t track, uint8_t index, uint8_t param, uint8_t x){
+  if (overflow && open) return;
+  overflow = false;
+  if (total > applied) { total = applied; redoable = 0; }
+  if (total == UNDO_LOG_RECORDS && !dropOldest()){
+    // one edit bigger than the whole log: it can't be undone, and neither can anything before it
+    clear();
+    overflow = true;
+    open = true;
+    dropped++;
+    return;
+  }
+  bool start = !open;
+  ring[wrap(tail + total)] = UndoDelta{ (uint8_t)(field | (start ? UNDO_EDIT_START : 0)), track, index, param, x };
+  if (start) { open = true; editStart = total; levels++; }
+  total++;
+  applied++;
+}
+
+bool UndoLog::undo(ApplyFn fn, void* ctx){
+  if (applied == 0) return false;
+  open = false;
+  for (;;){
+    UndoDelta d = ring[wrap(tail + --applied)];
+    bool first = d.field & UNDO_EDIT_START;
+    d.field &= ~UNDO_EDIT_START;
+    fn(ctx, d);
+    if (first || applied == 0) break;
+  }
+  levels--;
+  redoable++;
+  return true;
+}
+
+bool UndoLog::redo(ApplyFn fn, void* ctx){
+  if (applied == total) return false;
+  open = false;
+  do {
+    UndoDelta d = ring[wrap(tail + applied++)];
+    d.field &= ~UNDO_EDIT_START;
+    fn(ctx, d);
+  } while (applied < total && !(ring[wrap(tail + applied)].field & UNDO_EDIT_START));
+  levels++;
+  redoable--;
+  return true;
+}
@@ -9,7 +9,6 @@ void setup(){
 }
 
 void loop(){
+  // one scheduler pass: runs a due task or idles until the next one (see LoopScheduler.h)
   seq.loop();
-  // small delay to keep CPU usage low
-  delay(1);
 }
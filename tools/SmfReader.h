@@ -0,0 +1,142 @@
+#ifndef SMFREADER_H
+#define SMFREADER_H
+
+// Standard MIDI File reader shared by the host tools (groove2h, smf2pat). Reads
+// format 0 and 1 files with a ticks-per-quarter division into one list of notes,
+// every track merged and sorted by start tick. Only notes and the first tempo are
+// kept; other events are skipped without being decoded.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+struct SmfNote {
+  uint32_t tick;     // note-on, absolute
+  uint32_t length;   // ticks to its note-off (to the end of its track if none)
+  uint16_t track;    // MTrk chunk, 0-based
+  uint8_t ch, note, vel;
+};
+
+struct SmfFile {
+  uint16_t division = 0;       // ticks per quarter
+  uint32_t tempoUs = 500000;   // first Set Tempo, us per quarter (120 BPM if none)
+  bool tempoSet = false;
+  uint16_t tracks = 0;
+  uint32_t endTick = 0;        // latest End of Track
+  std::vector<SmfNote> notes;
+};
+
+static inline uint32_t smfBe(const uint8_t* p, uint8_t n){
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < n; i++) v = (v << 8) | p[i];
+  return v;
+}
+
+static inline bool smfVarLen(const uint8_t*& p, const uint8_t* end, uint32_t& v){
+  v = 0;
+  for (uint8_t i = 0; i < 4; i++){
+    if (p >= end) return false;
+    uint8_t b = *p++;
+    v = (v << 7) | (b & 0x7F);
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+// One MTrk chunk. Note-offs (or note-ons with velocity 0) close the oldest open
+// note on their key, so overlapping repeats of one key pair up in order.
+static inline bool smfReadTrack(const uint8_t* q, const uint8_t* qend, uint16_t track, SmfFile& f, std::string& err){
+  std::vector<uint32_t> open[16][128];   // indices into f.notes, oldest first
+  uint32_t tick = 0;
+  uint8_t status = 0;
+  while (q < qend){
+    uint32_t delta;
+    if (!smfVarLen(q, qend, delta)) { err = "bad delta time"; return false; }
+    tick += delta;
+    if (q >= qend) break;
+    uint8_t b = *q;
+    if (b == 0xFF){
+      // meta: type, length, data
+      uint32_t len;
+      if (qend - q < 2) { err = "bad meta event"; return false; }
+      uint8_t type = q[1];
+      q += 2;
+      if (!smfVarLen(q, qend, len) || (uint32_t)(qend - q) < len) { err = "bad meta event"; return false; }
+      if (type == 0x51 && len == 3 && !f.tempoSet) { f.tempoUs = smfBe(q, 3); f.tempoSet = true; }
+      q += len;
+      if (type == 0x2F) break;
+      continue;
+    }
+    if (b == 0xF0 || b == 0xF7){
+      uint32_t len;
+      q++;
+      if (!smfVarLen(q, qend, len) || (uint32_t)(qend - q) < len) { err = "bad sysex"; return false; }
+      q += len;
+      status = 0;
+      continue;
+    }
+    if (b & 0x80) { status = b; q++; }
+    else if (!status) { err = "data byte without status"; return false; }
+    uint8_t kind = status & 0xF0;
+    uint8_t need = (kind == 0xC0 || kind == 0xD0) ? 1 : 2;
+    if ((uint32_t)(qend - q) < need) { err = "truncated event"; return false; }
+    uint8_t ch = status & 0x0F;
+    if (kind == 0x90 && q[1] > 0){
+      open[ch][q[0] & 0x7F].push_back((uint32_t)f.notes.size());
+      f.notes.push_back(SmfNote{ tick, 0, track, ch, (uint8_t)(q[0] & 0x7F), q[1] });
+    } else if (kind == 0x80 || kind == 0x90){
+      std::vector<uint32_t>& o = open[ch][q[0] & 0x7F];
+      if (!o.empty()){
+        f.notes[o.front()].length = tick - f.notes[o.front()].tick;
+        o.erase(o.begin());
+      }
+    }
+    q += need;
+  }
+  for (uint8_t c = 0; c < 16; c++)
+    for (uint8_t n = 0; n < 128; n++)
+      for (uint32_t i : open[c][n]) f.notes[i].length = tick - f.notes[i].tick;
+  if (tick > f.endTick) f.endTick = tick;
+  return true;
+}
+
+// False on a file that isn't a standard MIDI file or uses SMPTE time
+static inline bool smfRead(const char* path, SmfFile& f, std::string& err){
+  FILE* fp = fopen(path, "rb");
+  if (!fp) { err = "can't open"; return false; }
+  std::vector<uint8_t> data;
+  if (fseek(fp, 0, SEEK_END) == 0){
+    long size = ftell(fp);
+    if (size > 0) data.resize((size_t)size);
+    rewind(fp);
+  }
+  size_t got = data.empty() ? 0 : fread(data.data(), 1, data.size(), fp);
+  fclose(fp);
+  data.resize(got);
+
+  const uint8_t* p = data.data();
+  const uint8_t* end = p + data.size();
+  if (data.size() < 14 || memcmp(p, "MThd", 4) || smfBe(p + 4, 4) < 6) { err = "not a MIDI file"; return false; }
+  f.division = (uint16_t)smfBe(p + 12, 2);
+  if (f.division & 0x8000) { err = "SMPTE time division not supported"; return false; }
+  if (f.division == 0) { err = "zero time division"; return false; }
+  p += 8 + smfBe(p + 4, 4);
+
+  while (end - p >= 8){
+    uint32_t len = smfBe(p + 4, 4);
+    const uint8_t* chunk = p + 8;
+    if ((uint32_t)(end - chunk) < len) { err = "truncated chunk"; return false; }
+    bool track = !memcmp(p, "MTrk", 4);
+    p = chunk + len;
+    if (!track) continue;
+    if (!smfReadTrack(chunk, chunk + len, f.tracks, f, err)) return false;
+    f.tracks++;
+  }
+  std::stable_sort(f.notes.begin(), f.notes.end(), [](const SmfNote& a, const SmfNote& b){ return a.tick < b.tick; });
+  return true;
+}
+
+#endif
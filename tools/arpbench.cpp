@@ -0,0 +1,121 @@
+// Host benchmark for the arpeggiator (see include/Arpeggiator.h).
+//
+//   g++ -O2 -Iinclude tools/arpbench.cpp src/Arpeggiator.cpp -o arpbench
+//
+//   arpbench [ticks]
+//
+// Clocks 4 and 16 arps side by side, as the render path does, through every mode
+// and set sizes of 1, 4 and 16 notes over four octaves, with the held set changing
+// underneath them. Prints the median and 99th percentile cost per arp tick over
+// 1024-tick blocks (the host scheduler makes the single worst block noise); the
+// cost should not grow with the set size or the mode. Also checks the walk order
+// of each mode on a small chord.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include "Arpeggiator.h"
+
+static const uint8_t MAX_ARPS = 16;
+static const uint32_t BLOCK_TICKS = 1024;   // ticks timed together
+
+static const char* const MODE_NAMES[ARP_NUM_MODES] = { "off", "up", "down", "random", "order" };
+
+static double nowNs(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static bool checkWalk(uint8_t mode, const uint8_t* expect, uint8_t n){
+  ArpNotes set;
+  set.add(67, 100);
+  set.add(60, 100);
+  set.add(64, 100);
+  Arpeggiator a;
+  a.restart();
+  ArpParams params = ARP_DEFAULT_PARAMS;
+  params.mode = mode;
+  params.octaves = 2;
+  params.rateIdx = 0;
+  uint8_t got = 0;
+  bool ok = true;
+  for (uint32_t t = 0; got < n; t++){
+    ArpHit hit;
+    if (!a.tick(params, set, hit)) continue;
+    if (hit.note != expect[got]) ok = false;
+    got++;
+  }
+  printf("walk %-6s %s\n", MODE_NAMES[mode], ok ? "ok" : "WRONG");
+  return ok;
+}
+
+// Median ns per arp tick over the blocks; the 99th percentile goes to *p99
+static double run(uint8_t arps, uint8_t mode, uint8_t notes, uint32_t ticks, double* p99, uint32_t* sink){
+  Arpeggiator arp[MAX_ARPS];
+  ArpParams params[MAX_ARPS];
+  ArpNotes held;
+  for (uint8_t i = 0; i < notes; i++) held.add(40 + i * 3, 64 + i);
+  for (uint8_t i = 0; i < arps; i++){
+    arp[i].restart();
+    params[i] = ARP_DEFAULT_PARAMS;
+    params[i].mode = mode;
+    params[i].octaves = ARP_MAX_OCTAVES;
+    params[i].rateIdx = i % ARP_NUM_RATES;
+  }
+  uint32_t blocks = ticks / BLOCK_TICKS;
+  double* ns = (double*)malloc(blocks * sizeof(double));
+  uint32_t churn = 0;
+  for (uint32_t b = 0; b < blocks; b++){
+    // a key is released and pressed again between blocks, as MIDI input would
+    uint8_t k = 40 + (churn++ % notes) * 3;
+    held.remove(k);
+    held.add(k, 90);
+    double t0 = nowNs();
+    for (uint32_t t = 0; t < BLOCK_TICKS; t++){
+      for (uint8_t i = 0; i < arps; i++){
+        ArpHit hit;
+        if (arp[i].tick(params[i], held, hit)) *sink += hit.note + hit.vel;
+      }
+    }
+    ns[b] = (nowNs() - t0) / ((double)BLOCK_TICKS * arps);
+  }
+  std::sort(ns, ns + blocks);
+  double median = ns[blocks / 2];
+  *p99 = ns[blocks - 1 - blocks / 100];
+  free(ns);
+  return median;
+}
+
+int main(int argc, char** argv){
+  uint32_t ticks = argc > 1 ? (uint32_t)atol(argv[1]) : 1000000;
+  if (ticks < BLOCK_TICKS) ticks = BLOCK_TICKS;
+
+  // C E G over two octaves
+  const uint8_t up[] = { 60, 64, 67, 72, 76, 79, 60 };
+  const uint8_t down[] = { 79, 76, 72, 67, 64, 60, 79 };
+  const uint8_t order[] = { 67, 60, 64, 79, 72, 76, 67 };
+  bool ok = checkWalk(ARP_UP, up, sizeof(up));
+  ok &= checkWalk(ARP_DOWN, down, sizeof(down));
+  ok &= checkWalk(ARP_ORDER, order, sizeof(order));
+
+  uint32_t sink = 0;
+  const uint8_t arpCounts[] = { 4, MAX_ARPS };
+  const uint8_t setSizes[] = { 1, 4, ARP_MAX_NOTES };
+  printf("\n%u ticks per case, ns per arp tick (median / p99 of %u-tick blocks)\n", (unsigned)ticks, (unsigned)BLOCK_TICKS);
+  printf("arps  mode     notes=1          notes=4          notes=16\n");
+  for (uint8_t arps : arpCounts){
+    for (uint8_t mode = ARP_UP; mode < ARP_NUM_MODES; mode++){
+      printf("%4u  %-7s", arps, MODE_NAMES[mode]);
+      for (uint8_t notes : setSizes){
+        double p99;
+        double median = run(arps, mode, notes, ticks, &p99, &sink);
+        printf("  %6.2f / %6.2f", median, p99);
+      }
+      printf("\n");
+    }
+  }
+  printf("(checksum %u)\n", (unsigned)sink);
+  return ok ? 0 : 1;
+}
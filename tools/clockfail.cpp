@@ -0,0 +1,173 @@
+// Host simulation of clock failover (see ClockManager.h).
+//
+//   g++ -O2 -Iinclude tools/clockfail.cpp src/ClockManager.cpp -o clockfail && ./clockfail
+//
+// A master sends 24 PPQN clock on DIN and, in some cases, the same clock on USB
+// shifted by an offset (USB packets early or late against the DIN bytes). Both
+// inputs are read by the 1 ms engine pass, as on the Teensy, so each tick is
+// stamped with the pass that saw it. The pass then calls poll(); a dropped source
+// plays the fill tick there, and the internal timer takes over on the grid of the
+// last estimate exactly as runEngine() starts it.
+//
+// DIN is locked for 3 s, then unplugged; the run goes on for 3 s more. From 1 s
+// on, every tick the engine plays is matched to the master's tick it stands for:
+// DIN's grid up to the fill tick, then the grid of whoever carries on (USB's, or
+// DIN's continued for the internal timer). The run fails if a tick is lost or
+// played twice. Printed per case: the gap from the last DIN tick to the fill tick
+// (here and as `k` reports it), the fill tick's phase error against the master
+// (and as `k` reports it, against the last estimate), the worst phase error before
+// the drop (poll jitter) and after it, and ticks swallowed as duplicates of the fill.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ClockManager.h"
+
+static const uint32_t ENGINE_US = 1000;
+static const uint32_t SETTLE_US = 1000000;
+static const uint32_t DROP_US = 3000000;
+static const uint32_t END_US = 6000000;
+
+struct Case {
+  const char* name;
+  uint8_t priority;
+  uint32_t bpm;
+  bool usb;
+  int32_t usbOffsetUs; // USB tick time minus DIN tick time
+};
+
+struct Result {
+  uint32_t gapUs, phaseErrUs;     // measured here
+  uint32_t kGapUs, kPhaseErrUs;   // as ClockManager reports them
+  uint32_t maxErrBefore, maxErrAfter;
+  uint32_t lost, doubled, swallowed;
+  uint8_t takenBy;
+};
+
+// Master tick n is at base + n * period; returns the tick a time stands for
+static int32_t tickIndex(uint32_t t, int64_t base, uint32_t period, uint32_t& err){
+  int64_t rel = (int64_t)t - base;
+  int32_t n = (int32_t)((rel + period / 2) / period);
+  int64_t e = rel - (int64_t)n * period;
+  err = (uint32_t)(e < 0 ? -e : e);
+  return n;
+}
+
+static Result run(const Case& c){
+  Result r = {};
+  ClockManager clk;
+  clk.begin(c.priority);
+  const uint32_t period = 2500000UL / c.bpm;   // 60e6 / bpm / 24
+  const int64_t dinBase = 1000;                // first DIN tick; USB's is dinBase + offset
+  const int64_t usbBase = dinBase + c.usbOffsetUs;
+
+  int64_t nextDin = dinBase, nextUsb = usbBase;
+  bool dinPending = false, usbPending = false;
+  bool timerRunning = false;
+  int64_t nextTimer = 0;
+  uint32_t timerPeriod = 0;
+
+  bool dropped = false;
+  int64_t base = dinBase;    // grid the engine is following
+  int32_t lastIndex = -1;
+  uint32_t lastDinUs = 0;
+
+  auto engineTick = [&](uint32_t t, bool fill){
+    uint32_t err;
+    int32_t n = tickIndex(t, base, period, err);
+    if (t >= SETTLE_US && lastIndex >= 0){
+      if (n == lastIndex) r.doubled++;
+      else if (n > lastIndex + 1) r.lost += n - lastIndex - 1;
+    }
+    lastIndex = n;
+    if (t < SETTLE_US) return;
+    if (fill) { r.gapUs = t - lastDinUs; r.phaseErrUs = err; }
+    else if (!dropped) { if (err > r.maxErrBefore) r.maxErrBefore = err; }
+    else if (err > r.maxErrAfter) r.maxErrAfter = err;
+  };
+
+  uint32_t swallowedAtSettle = 0;
+  for (uint32_t now = 0; now < END_US; now++){
+    if (now == SETTLE_US) swallowedAtSettle = clk.swallowed;
+    // the master's bytes reach the input buffers
+    if (now >= nextDin){
+      if (now < DROP_US) dinPending = true;
+      nextDin += period;
+    }
+    if (c.usb && (int64_t)now >= nextUsb){
+      usbPending = true;
+      nextUsb += period;
+    }
+    // internal timer ISR
+    if (timerRunning && (int64_t)now >= nextTimer){
+      clk.onInternalTick(now);
+      engineTick(now, false);
+      nextTimer += timerPeriod;
+    }
+    if (now % ENGINE_US) continue;
+
+    // engine pass: DIN, then USB, then the failover check
+    if (dinPending){
+      dinPending = false;
+      if (clk.onRealtime(CLOCK_SRC_DIN, 0xF8, now) == ClockManager::CLK_TICK) engineTick(now, false);
+      lastDinUs = now;
+    }
+    if (usbPending){
+      usbPending = false;
+      if (clk.onRealtime(CLOCK_SRC_USB, 0xF8, now) == ClockManager::CLK_TICK) engineTick(now, false);
+    }
+    if (clk.poll(now)){
+      uint32_t fillPeriod = clk.fillPeriod();
+      if (fillPeriod && !dropped){
+        dropped = true;
+        r.takenBy = clk.active();
+        engineTick(now, true);
+        // from here on the engine follows the source that took over
+        if (clk.active() == CLOCK_SRC_USB) base = usbBase;
+      }
+      if (!clk.external() && !timerRunning){
+        uint32_t first = fillPeriod ? clk.nextTickDueUs() - now : period;
+        if ((int32_t)first < 100) first = 100;
+        nextTimer = now + first;
+        timerPeriod = fillPeriod ? fillPeriod : period;
+        timerRunning = true;
+      }
+    }
+  }
+  // every master tick that a pass could still see before the end must have played
+  int32_t due = (int32_t)(((int64_t)END_US - ENGINE_US - base) / period);
+  if (lastIndex < due) r.lost += due - lastIndex;
+  r.kGapUs = clk.lastGapUs;
+  r.kPhaseErrUs = clk.lastPhaseErrUs;
+  r.swallowed = clk.swallowed - swallowedAtSettle;
+  return r;
+}
+
+int main(){
+  static const char* srcNames[] = {"DIN", "USB", "INT"};
+  const Case cases[] = {
+    {"DIN>INT",           2,  60, false, 0},
+    {"DIN>INT",           2, 120, false, 0},
+    {"DIN>INT",           2, 180, false, 0},
+    {"DIN>INT",           2, 300, false, 0},
+    {"DIN>USB, USB -4ms", 0, 120, true, -4000},
+    {"DIN>USB, USB -1ms", 0, 120, true, -1000},
+    {"DIN>USB, in step",  0, 120, true, 0},
+    {"DIN>USB, USB +1ms", 0, 120, true, 1000},
+    {"DIN>USB, USB +4ms", 0, 120, true, 4000},
+    {"DIN>USB, USB +8ms", 0, 120, true, 8000},
+    {"DIN>USB, USB +1ms", 0, 300, true, 1000},
+    {"DIN>INT, USB off",  2, 120, true, 1000},
+  };
+  printf("DIN unplugged at %u s, engine pass every %u us; times in us\n", (unsigned)(DROP_US / 1000000), (unsigned)ENGINE_US);
+  printf("case               BPM  to    gap  (k)    phase (k)   jitter before  after  swallowed  lost  doubled\n");
+  bool ok = true;
+  for (const Case& c : cases){
+    Result r = run(c);
+    printf("%-18s %3u  %s  %5u %5u  %5u %5u  %13u %6u  %9u  %4u  %7u\n", c.name, (unsigned)c.bpm, srcNames[r.takenBy],
+           (unsigned)r.gapUs, (unsigned)r.kGapUs, (unsigned)r.phaseErrUs, (unsigned)r.kPhaseErrUs,
+           (unsigned)r.maxErrBefore, (unsigned)r.maxErrAfter, (unsigned)r.swallowed, (unsigned)r.lost, (unsigned)r.doubled);
+    ok &= r.lost == 0 && r.doubled == 0 && r.gapUs == r.kGapUs;
+  }
+  printf(ok ? "no tick lost or doubled at any failover\n" : "FAILED: a failover lost or doubled a tick\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,559 @@
+// Offline renders of the real engine on the host simulator (tools/hostsim/).
+// Everything in src/ but main.cpp is built for a simulated Teensy, run for a
+// while on simulated time, and the MIDI it sends is checked byte by byte.
+//
+//   g++ -O2 -std=gnu++17 -DARDUINO -Itools/hostsim -Iinclude tools/enginesim.cpp tools/hostsim/HostSim.cpp $(ls src/*.cpp | grep -v main.cpp) -o enginesim
+//
+//   enginesim song [sdReadUs]
+//     Song mode across pattern changes. Four patterns go into an SD project on a
+//     scratch directory, each playing a different note on every step of track 1,
+//     and a six-bar song chains them (0 x2, 1, 2 x2, 3). Three passes of the song
+//     are rendered at the default tempo, with every SD read call stalling the storage task
+//     for sdReadUs (default 200). Checks, from the DIN bytes as they leave the wire:
+//       - every step-to-step interval is the step length, within a byte time,
+//         at bar boundaries (where the pattern changes) as everywhere else
+//       - every bar plays the pattern the song names for it, or, when the SD could
+//         not stream it in time, carries on with the previous one; such late bars
+//         must match the engine's own count (console 'g')
+//     A slow card (e.g. 600000: a record takes 2.4 s, more than a bar) shows the
+//     late path: timing still holds, the late bar plays its predecessor, and the
+//     next pattern is still applied on its own bar.
+//
+//   enginesim replay
+//     Replays a performance from its seed. One pattern mixes probability trigs
+//     (every step of track 1 at 50 %, track 2 at 20-80 %), A:B conditions on
+//     track 3 and FIRST / PRE / !PRE on track 4. Four takes of 16 bars each, from
+//     Start to Stop, with DIN byte times taken relative to the Start byte:
+//       A  the pattern as built
+//       B  the same again: must equal A byte for byte and microsecond for microsecond
+//       C  another pattern seed: must differ
+//       D  A's save record loaded back (seed included): must equal A
+//
+//   enginesim profile
+//     The engine's own cycle profile ('f' on the console) for a busy pattern:
+//     four tracks on every step with ratchets, CC locks, probability, and an LFO
+//     plus an envelope each. 16 bars with loop() rendering ahead, then 16 bars
+//     with loop() starved so the clock ISR renders every step itself, as before
+//     the look-ahead. ARM_DWT_CYCCNT reads host time here (600 counts per us),
+//     so these are PC times: the ratio holds, the Teensy's absolute numbers come
+//     from 'f' on the device.
+//
+//   enginesim start
+//     Local and external starts of one pattern (four tracks with ratchets, CC locks,
+//     probability, an LFO and an envelope). Eight local starts, pressed at different
+//     points of the 1 ms engine pass, time the press to step 0 and to the first
+//     note-on on the wire: both must be the same every time. Then a 4-bar take as
+//     master is recorded, and its Start, clock and Stop bytes are played back into
+//     DIN at the times they left the wire. The slave's note and CC bytes must equal
+//     the master's, and each must land on the same tick (within half a tick).
+//
+//   enginesim slots
+//     EEPROM save slots (see SaveFormat.h). First an image in the earlier fixed
+//     layout (SQ23: eight slots at the worst-case stride) is booted; every slot must
+//     come through the conversion to packed records byte for byte. Then 2000 saves
+//     of random patterns, from empty to every step set with all fields and all
+//     p-locks, go to random slots. After each, every slot must read back as last
+//     written, and a save must fail exactly when the other slots leave no room for
+//     it. Prints the record sizes and how many slots of each size fit.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "HostSim.h"
+#include "SimpleSequencer.h"
+
+SimpleSequencer seq;
+
+struct NoteOn {
+  uint8_t channel;   // 0-15
+  uint8_t note;
+  uint32_t atUs;
+};
+
+// Note-ons (velocity > 0) in a logged byte stream: running status, realtime bytes
+// between data bytes and system common messages are all handled
+static std::vector<NoteOn> noteOns(const std::vector<HostsimByte>& bytes){
+  std::vector<NoteOn> out;
+  uint8_t status = 0, data[2];
+  uint8_t n = 0;
+  for (const HostsimByte& b : bytes){
+    if (b.b >= 0xF8) continue;
+    if (b.b & 0x80) { status = b.b < 0xF0 ? b.b : 0; n = 0; continue; }
+    if (!status) continue;
+    data[n++] = b.b;
+    uint8_t need = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 1 : 2;
+    if (n < need) continue;
+    n = 0;
+    if ((status & 0xF0) == 0x90 && data[1]) out.push_back(NoteOn{(uint8_t)(status & 0x0F), data[0], b.atUs});
+  }
+  return out;
+}
+
+class EngineSim {
+  public:
+    // Loop passes (as main.cpp does) until `us` of simulated time have gone by
+    static void runFor(uint32_t us){
+      uint64_t end = hostsimNow() + us;
+      while (hostsimNow() < end) seq.loop();
+    }
+
+    static int song(uint32_t sdReadUs);
+    static std::vector<HostsimByte> take(uint32_t bars);
+    static int replay();
+    static void profileRun(bool lookAhead, struct ProfileCase& out);
+    static int profile();
+    static int start();
+    static void randomPattern(uint8_t density);
+    static int slots();
+};
+
+static const uint8_t SONG_PATTERNS = 4;
+static const uint8_t SONG_BASE_NOTE = 48;   // pattern k plays SONG_BASE_NOTE + k
+static const uint8_t SONG_PASSES = 3;
+
+int EngineSim::song(uint32_t sdReadUs){
+  char dir[] = "/tmp/enginesimXXXXXX";
+  if (!mkdtemp(dir)) { perror("enginesim: mkdtemp"); return 1; }
+  hostsimSdRoot = dir;
+  seq.begin();
+  if (!seq.projectReady) { fprintf(stderr, "enginesim: no SD project\n"); return 1; }
+
+  // Saved last to first, so pattern 0 is the one left live (projectPattern 0)
+  for (int k = SONG_PATTERNS - 1; k >= 0; k--){
+    seq.pat->init();
+    for (uint8_t s = 0; s < NUM_STEPS; s++) seq.pat->steps[0][s] = true;
+    seq.pat->channelPitch[0] = SONG_BASE_NOTE + k;
+    if (!seq.saveProjectPattern((uint16_t)k)) { fprintf(stderr, "enginesim: save %d failed\n", k); return 1; }
+  }
+  seq.projectPattern = 0;
+  seq.song.length = 0;
+  const uint8_t order[][2] = {{0, 2}, {1, 1}, {2, 2}, {3, 1}};
+  for (const auto& e : order) seq.appendSongEntry(e[0], e[1]);
+  seq.startSong();
+  const uint16_t songBars = seq.arrangement.length();
+
+  hostsimSdReadUs = sdReadUs;
+  runFor(50000);
+  hostsimDinOut.clear();
+  seq.postTransport(TC_TOGGLE);
+  const uint32_t stepUs = 60000000UL / seq.bpm / 4;
+  runFor((uint32_t)SONG_PASSES * songBars * NUM_STEPS * stepUs);
+  // The engine counts a late bar when it renders the bar's first step, ahead of
+  // the wire (and a long SD stall overshoots the run): take the count for the
+  // bars begun so far, then play on until they are all out
+  noInterrupts();
+  uint32_t engineLate = seq.songLateBars;
+  uint32_t bars = seq.loopCount + 1;
+  interrupts();
+  runFor(2 * NUM_STEPS * stepUs);
+
+  std::vector<NoteOn> all = noteOns(hostsimDinOut), notes;
+  for (const NoteOn& n : all) if (n.channel == 0) notes.push_back(n);
+  if (notes.size() < bars * NUM_STEPS) { fprintf(stderr, "enginesim: only %u steps played\n", (unsigned)notes.size()); return 1; }
+
+  // A DIN byte is 320 us; anything beyond one byte of jitter is a discontinuity
+  const uint32_t tolerance = 320;
+  uint32_t worstInBar = 0, worstAtBar = 0, discontinuities = 0, changes = 0;
+  for (size_t i = 1; i < bars * NUM_STEPS; i++){
+    int32_t err = (int32_t)(notes[i].atUs - notes[i - 1].atUs) - (int32_t)stepUs;
+    uint32_t e = err < 0 ? -err : err;
+    if (e > tolerance) discontinuities++;
+    if (i % NUM_STEPS) { if (e > worstInBar) worstInBar = e; continue; }
+    if (e > worstAtBar) worstAtBar = e;
+    if (notes[i].note != notes[i - 1].note) changes++;
+  }
+
+  uint32_t onTime = 0, late = 0, wrong = 0;
+  uint8_t played = SONG_BASE_NOTE;
+  for (uint32_t b = 0; b < bars; b++){
+    uint8_t want = SONG_BASE_NOTE + seq.arrangement.bar(b % songBars).pattern;
+    uint8_t got = notes[b * NUM_STEPS].note;
+    bool same = true;
+    for (uint8_t s = 1; s < NUM_STEPS; s++) same &= notes[b * NUM_STEPS + s].note == got;
+    if (!same) wrong++;
+    else if (got == want) onTime++;
+    else if (got == played) late++;
+    else wrong++;
+    played = got;
+  }
+
+  printf("song: %u-bar song, %u bars played, SD read call %u us, step %u us\n",
+         (unsigned)songBars, (unsigned)bars, (unsigned)sdReadUs, (unsigned)stepUs);
+  printf("timing: %u steps, interval error max %u us within bars, %u us at bar boundaries (%u pattern changes)\n",
+         (unsigned)(bars * NUM_STEPS), (unsigned)worstInBar, (unsigned)worstAtBar, (unsigned)changes);
+  printf("timing: %u discontinuities (> %u us)\n", (unsigned)discontinuities, (unsigned)tolerance);
+  printf("bars: %u on their pattern, %u late (engine counted %u), %u wrong\n",
+         (unsigned)onTime, (unsigned)late, (unsigned)engineLate, (unsigned)wrong);
+
+  char path[64];
+  snprintf(path, sizeof(path), "%s%s", dir, PROJECT_PATH);
+  remove(path);
+  rmdir(dir);
+  bool ok = bars >= (uint32_t)SONG_PASSES * songBars && discontinuities == 0 && wrong == 0 && late == engineLate;
+  return ok ? 0 : 1;
+}
+
+// Start, play `bars` bars, stop; the DIN bytes with times relative to the Start
+// byte. Takes are posted at the same phase of the 1 ms engine timer.
+std::vector<HostsimByte> EngineSim::take(uint32_t bars){
+  static uint64_t firstPost = 0;
+  if (!firstPost) firstPost = hostsimNow();
+  hostsimRun((uint32_t)((1000 - (hostsimNow() - firstPost) % 1000) % 1000));
+  hostsimDinOut.clear();
+  const uint32_t stepUs = 60000000UL / seq.bpm / 4;
+  seq.postTransport(TC_TOGGLE);
+  runFor(bars * NUM_STEPS * stepUs + stepUs / 2);
+  seq.postTransport(TC_TOGGLE);
+  runFor(20000);
+  std::vector<HostsimByte> out;
+  uint32_t t0 = 0;
+  for (const HostsimByte& b : hostsimDinOut){
+    if (out.empty() && b.b != 0xFA) continue;
+    if (out.empty()) t0 = b.atUs;
+    out.push_back(HostsimByte{b.b, b.atUs - t0});
+  }
+  return out;
+}
+
+static const uint32_t REPLAY_BARS = 16;
+
+// Index of the first byte that differs (value or time), -1 when identical
+static long firstDifference(const std::vector<HostsimByte>& a, const std::vector<HostsimByte>& b){
+  size_t n = a.size() < b.size() ? a.size() : b.size();
+  for (size_t i = 0; i < n; i++) if (a[i].b != b[i].b || a[i].atUs != b[i].atUs) return (long)i;
+  return a.size() == b.size() ? -1 : (long)n;
+}
+
+int EngineSim::replay(){
+  hostsimSdPresent = false;
+  seq.begin();
+  Pattern& p = *seq.pat;
+  p.init();
+  for (uint8_t s = 0; s < NUM_STEPS; s++){
+    p.steps[0][s] = true;
+    p.stepProb[0][s] = 50;
+    p.steps[1][s] = s % 2 == 0;
+    p.stepProb[1][s] = 20 + (s * 37) % 61;
+    p.steps[2][s] = s % 4 == 0;
+    p.stepCond[2][s] = TRIG_AB_BASE + (s * 7) % TRIG_AB_COUNT;
+    p.steps[3][s] = true;
+    p.stepProb[3][s] = s % 3 == 0 ? 60 : 100;
+    p.stepCond[3][s] = s == 0 ? TRIG_FIRST : (s % 3 == 0 ? TRIG_ALWAYS : (s % 3 == 1 ? TRIG_PRE : TRIG_NOT_PRE));
+  }
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) p.channelPitch[c] = 36 + 12 * c;
+  p.patternSeed = 0x5EED1234UL;
+  uint8_t rec[SAVE_SLOT_BYTES];
+  if (seq.buildSlotRecord(rec) == 0) { fprintf(stderr, "enginesim: can't build the save record\n"); return 1; }
+
+  std::vector<HostsimByte> a = take(REPLAY_BARS);
+  std::vector<HostsimByte> b = take(REPLAY_BARS);
+  seq.pat->patternSeed ^= 1;
+  std::vector<HostsimByte> c = take(REPLAY_BARS);
+  if (!seq.applySlotRecord(rec)) { fprintf(stderr, "enginesim: can't load the save record\n"); return 1; }
+  std::vector<HostsimByte> d = take(REPLAY_BARS);
+
+  uint32_t played = 0;
+  for (const NoteOn& n : noteOns(a)) if (n.channel == 0) played++;
+  long ab = firstDifference(a, b), ac = firstDifference(a, c), ad = firstDifference(a, d);
+  printf("replay: %u bars, take A %u bytes over %u us; track 1 at 50 %%: %u of %u trigs played\n",
+         (unsigned)REPLAY_BARS, (unsigned)a.size(), (unsigned)(a.empty() ? 0 : a.back().atUs),
+         (unsigned)played, (unsigned)(REPLAY_BARS * NUM_STEPS));
+  printf("B same seed:     %s\n", ab < 0 ? "identical" : "DIFFERS");
+  printf("C other seed:    %s", ac < 0 ? "IDENTICAL\n" : "differs");
+  if (ac >= 0) printf(" from byte %ld\n", ac);
+  printf("D saved, loaded: %s\n", ad < 0 ? "identical" : "DIFFERS");
+  if (ab >= 0) printf("B first differs at byte %ld\n", ab);
+  if (ad >= 0) printf("D first differs at byte %ld\n", ad);
+  return (ab < 0 && ac >= 0 && ad < 0 && played > 0 && played < REPLAY_BARS * NUM_STEPS) ? 0 : 1;
+}
+
+static const uint32_t PROFILE_BARS = 16;
+static const uint8_t PROFILE_RUNS = 15;
+
+// Lowest average and lowest maximum over the runs: a PC preempts the simulation
+// now and then, which only ever adds time
+struct RunBest {
+  uint32_t count = 0, avg = UINT32_MAX, max = UINT32_MAX;
+  void add(const CycleStat& c){
+    count = c.count;
+    if (c.avg() < avg) avg = c.avg();
+    if (c.max < max) max = c.max;
+  }
+};
+
+static void printStat(const char* name, const RunBest& b){
+  printf("  %-12s %6u calls  avg %6.2f us  max %6.2f us\n", name, (unsigned)b.count, b.avg / 600.0, b.max / 600.0);
+}
+
+struct ProfileCase {
+  RunBest tick, engine, render;
+  uint32_t late = 0;
+};
+
+// One run of PROFILE_BARS: with loop() passes (look-ahead) or interrupts only
+void EngineSim::profileRun(bool lookAhead, ProfileCase& out){
+  const uint32_t stepUs = 60000000UL / seq.bpm / 4;
+  seq.postTransport(TC_TOGGLE);
+  if (lookAhead) runFor(stepUs); else hostsimRun(stepUs);
+  noInterrupts();
+  seq.tickProfile.reset(); seq.engineProfile.reset(); seq.renderProfile.reset();
+  seq.lateRenders = 0;
+  interrupts();
+  if (lookAhead) runFor(PROFILE_BARS * NUM_STEPS * stepUs); else hostsimRun(PROFILE_BARS * NUM_STEPS * stepUs);
+  noInterrupts();
+  out.tick.add(seq.tickProfile);
+  out.engine.add(seq.engineProfile);
+  out.render.add(seq.renderProfile);
+  out.late = seq.lateRenders;
+  interrupts();
+  seq.postTransport(TC_TOGGLE);
+  runFor(20000);
+}
+
+int EngineSim::profile(){
+  hostsimSdPresent = false;
+  seq.begin();
+  Pattern& p = *seq.pat;
+  p.init();
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    for (uint8_t s = 0; s < NUM_STEPS; s++){
+      p.steps[c][s] = true;
+      p.stepRatchet[c][s] = s % 4 == 3 ? 3 : 0;
+      p.stepProb[c][s] = s % 5 == 0 ? 70 : 100;
+      if (s % 2 == 0) p.plocks.set(c, s, 74, (uint8_t)(s * 8));
+    }
+    p.channelPitch[c] = 36 + 7 * c;
+    p.lfo[c] = LfoParams{LFO_SINE, 2, 100, 71};
+    p.env[c] = EnvParams{1, 3, 100, MOD_DEST_PITCHBEND};
+  }
+  ProfileCase ahead, isr;
+  for (uint8_t i = 0; i < PROFILE_RUNS; i++){
+    profileRun(true, ahead);
+    profileRun(false, isr);
+  }
+
+  printf("profile: %u runs of %u bars, 4 tracks with ratchets, CC locks, LFO + envelope (host times)\n",
+         (unsigned)PROFILE_RUNS, (unsigned)PROFILE_BARS);
+  printf("look-ahead (loop renders, %u steps rendered late in the ISR):\n", (unsigned)ahead.late);
+  printStat("tick ISR", ahead.tick);
+  printStat("engine ISR", ahead.engine);
+  printStat("step render", ahead.render);
+  printf("ISR renders (loop starved, %u steps rendered in the ISR):\n", (unsigned)isr.late);
+  printStat("tick ISR", isr.tick);
+  printStat("engine ISR", isr.engine);
+  printStat("step render", isr.render);
+  return 0;
+}
+
+static const uint32_t START_BARS = 4;
+static const uint8_t START_PHASES = 8;
+
+// Channel messages only, with times: realtime bytes and system common messages
+// (the master's SPP after Stop) are dropped
+static std::vector<HostsimByte> channelBytes(const std::vector<HostsimByte>& bytes){
+  std::vector<HostsimByte> out;
+  bool channel = false;
+  for (const HostsimByte& b : bytes){
+    if (b.b >= 0xF8) continue;
+    if (b.b & 0x80) channel = b.b < 0xF0;
+    if (channel) out.push_back(b);
+  }
+  return out;
+}
+
+int EngineSim::start(){
+  hostsimSdPresent = false;
+  seq.begin();
+  Pattern& p = *seq.pat;
+  p.init();
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    for (uint8_t s = 0; s < NUM_STEPS; s++){
+      p.steps[c][s] = (s + c) % 3 != 0;
+      p.stepRatchet[c][s] = s % 8 == 5 ? 2 : 0;
+      p.stepProb[c][s] = s % 5 == 0 ? 60 : 100;
+      if (s % 4 == 0) p.plocks.set(c, s, 74, (uint8_t)(s * 8));
+    }
+    p.channelPitch[c] = 36 + 7 * c;
+  }
+  p.lfo[0] = LfoParams{LFO_SINE, 2, 100, 71};
+  p.env[1] = EnvParams{1, 3, 100, MOD_DEST_PITCHBEND};
+  const uint32_t stepUs = 60000000UL / seq.bpm / 4;
+  runFor(50000);
+
+  // Local start latency: press -> step 0's first note-on on the wire, with the press
+  // landing at different points of the 1 ms engine pass
+  noInterrupts();
+  seq.startLatencyUs.reset();
+  interrupts();
+  uint32_t firstMin = UINT32_MAX, firstMax = 0;
+  for (uint8_t i = 0; i < START_PHASES; i++){
+    hostsimRun(1000 - hostsimNow() % 1000 + i * 1000 / START_PHASES);
+    hostsimDinOut.clear();
+    uint32_t posted = (uint32_t)hostsimNow();
+    seq.postTransport(TC_TOGGLE);
+    runFor(NUM_STEPS * stepUs);
+    seq.postTransport(TC_TOGGLE);
+    runFor(20000);
+    std::vector<NoteOn> notes = noteOns(hostsimDinOut);
+    if (notes.empty()) { fprintf(stderr, "enginesim: start %u played nothing\n", (unsigned)i); return 1; }
+    uint32_t first = notes[0].atUs - posted;
+    if (first < firstMin) firstMin = first;
+    if (first > firstMax) firstMax = first;
+  }
+
+  // Master take: local start, START_BARS bars, local stop
+  hostsimDinOut.clear();
+  seq.postTransport(TC_TOGGLE);
+  runFor(START_BARS * NUM_STEPS * stepUs + stepUs / 2);
+  seq.postTransport(TC_TOGGLE);
+  runFor(20000);
+  std::vector<HostsimByte> master = hostsimDinOut;
+
+  // Slave take: the master's realtime bytes come back in on DIN, each at the time
+  // it left the master's wire, shifted to now
+  uint32_t masterStart = 0;
+  for (const HostsimByte& b : master) if (b.b == 0xFA) { masterStart = b.atUs; break; }
+  uint32_t shift = (uint32_t)hostsimNow() + 10000 - masterStart;
+  for (const HostsimByte& b : master) if (b.b >= 0xF8) hostsimDinIn(b.b, b.atUs + shift);
+  hostsimDinOut.clear();
+  runFor(master.back().atUs + shift + 20000 - (uint32_t)hostsimNow());
+  std::vector<HostsimByte> slave = hostsimDinOut;
+  for (HostsimByte& b : slave) b.atUs -= shift;
+
+  std::vector<HostsimByte> a = channelBytes(master), b = channelBytes(slave);
+  size_t n = a.size() < b.size() ? a.size() : b.size();
+  long differ = -1;
+  int32_t lagMin = INT32_MAX, lagMax = INT32_MIN;
+  for (size_t i = 0; i < n; i++){
+    if (a[i].b != b[i].b) { differ = (long)i; break; }
+    int32_t lag = (int32_t)(b[i].atUs - a[i].atUs);
+    if (lag < lagMin) lagMin = lag;
+    if (lag > lagMax) lagMax = lag;
+  }
+  if (differ < 0 && a.size() != b.size()) differ = (long)n;
+  std::vector<NoteOn> masterNotes = noteOns(master), slaveNotes = noteOns(slave);
+  uint32_t slaveFirst = slaveNotes.empty() ? 0 : slaveNotes[0].atUs - masterStart;
+
+  noInterrupts();
+  uint32_t latCount = seq.startLatencyUs.count, latAvg = seq.startLatencyUs.avg(), latMax = seq.startLatencyUs.max;
+  interrupts();
+  printf("start: %u local starts, press at %u phases of the 1 ms engine pass\n", (unsigned)latCount, (unsigned)START_PHASES);
+  printf("  press -> step 0 (engine)      avg %u us  max %u us\n", (unsigned)latAvg, (unsigned)latMax);
+  printf("  press -> first note-on wire   min %u us  max %u us\n", (unsigned)firstMin, (unsigned)firstMax);
+  printf("  Start byte in -> first note-on wire (slave)  %u us\n", (unsigned)slaveFirst);
+  printf("master vs slave over %u bars: %u / %u channel bytes, %u / %u note-ons\n", (unsigned)START_BARS,
+         (unsigned)a.size(), (unsigned)b.size(), (unsigned)masterNotes.size(), (unsigned)slaveNotes.size());
+  if (differ < 0) printf("  identical bytes; slave later than master by %d to %d us\n", (int)lagMin, (int)lagMax);
+  else printf("  DIFFER from channel byte %ld\n", differ);
+  // the slave follows the master's clock bytes, so it may lag by a poll and a UART
+  // window, but any byte half a tick or more away is on another tick
+  const int32_t halfTick = (int32_t)(stepUs / 6 / 2);   // 6 ticks a step at 24 PPQN
+  bool sameTicks = lagMin > -halfTick && lagMax < halfTick;
+  return differ < 0 && !a.empty() && sameTicks && latAvg == latMax && firstMin == firstMax ? 0 : 1;
+}
+
+// Steps set with probability `density` %, each set step with every optional
+// field at that probability too, and as many p-locks
+void EngineSim::randomPattern(uint8_t density){
+  Pattern& p = *seq.pat;
+  p.init();
+  p.patternSeed = (uint32_t)random(0x7FFFFFFFL);
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    for (uint8_t s = 0; s < NUM_STEPS; s++){
+      if (random(100) >= density) continue;
+      p.steps[c][s] = true;
+      if (random(100) < density) p.pitch[c][s] = (uint8_t)random(24, 96);
+      if (random(100) < density) p.noteLen[c][s] = (uint8_t)random(6);
+      if (random(100) < density) p.stepRatchet[c][s] = (uint8_t)random(1, 6);
+      if (random(100) < density) p.stepVelocity[c][s] = (uint8_t)random(1, 128);
+      if (random(100) < density) p.stepProb[c][s] = (uint8_t)random(1, 100);
+      if (random(100) < density) p.stepSlide[c][s] = true;
+    }
+  }
+  uint8_t locks = (uint8_t)(PLOCK_CAPACITY * density / 100);
+  for (uint8_t i = 0; i < locks; i++){
+    p.plocks.set((uint8_t)random(NUM_CHANNELS), (uint8_t)random(NUM_STEPS), (uint8_t)random(120), (uint8_t)random(128));
+  }
+}
+
+static const uint16_t SLOTS_SAVES = 2000;
+
+int EngineSim::slots(){
+  seq.begin();
+  bool ok = true;
+
+  // --- the earlier fixed layout, booted ---
+  const uint16_t stride = SAVE_SLOT_BYTES;
+  const uint8_t fixedSlots = (SAVE_EEPROM_BYTES - sizeof(SaveDirectory)) / stride;
+  static uint8_t model[SAVE_NUM_SLOTS][SAVE_SLOT_BYTES];
+  static uint16_t modelLen[SAVE_NUM_SLOTS];
+  memset(EEPROM.bytes, 0xFF, sizeof(EEPROM.bytes));
+  for (uint8_t k = 0; k < fixedSlots; k++){
+    randomPattern((uint8_t)(k * 100 / (fixedSlots - 1)));
+    modelLen[k] = seq.buildSlotRecord(model[k]);
+    memcpy(EEPROM.bytes + sizeof(SaveDirectory) + k * stride, model[k], modelLen[k]);
+  }
+  SaveDirectory dir = { SAVE_DIR_MAGIC_FIXED, SAVE_VERSION, 0, stride };
+  EEPROM.put(0, dir);
+  seq.loadState();
+  uint8_t rec[SAVE_SLOT_BYTES];
+  uint8_t converted = 0;
+  for (uint8_t k = 0; k < fixedSlots; k++){
+    uint16_t n = seq.readSlotRecord(k, rec);
+    if (n == modelLen[k] && !memcmp(rec, model[k], n)) converted++;
+  }
+  printf("fixed layout (%u slots of %u bytes): %u of %u slots converted intact\n",
+         (unsigned)fixedSlots, (unsigned)stride, (unsigned)converted, (unsigned)fixedSlots);
+  ok &= converted == fixedSlots;
+
+  // --- random saves ---
+  uint32_t saved = 0, full = 0, wrong = 0, writes0 = EEPROM.writes;
+  for (uint16_t i = 0; i < SLOTS_SAVES; i++){
+    uint8_t slot = (uint8_t)random(SAVE_NUM_SLOTS);
+    randomPattern((uint8_t)random(101));
+    uint8_t built[SAVE_SLOT_BYTES];
+    uint16_t len = seq.buildSlotRecord(built);
+    uint32_t others = 0;
+    for (uint8_t k = 0; k < SAVE_NUM_SLOTS; k++) if (k != slot) others += modelLen[k];
+    bool fits = others + len <= SAVE_DATA_BYTES;
+    bool done = seq.writeSlotRecord(slot, built, len);
+    if (done) { memcpy(model[slot], built, len); modelLen[slot] = len; saved++; }
+    else full++;
+    if (done != fits) wrong++;
+    for (uint8_t k = 0; k < SAVE_NUM_SLOTS; k++){
+      uint16_t n = seq.readSlotRecord(k, rec);
+      if (n != modelLen[k] || memcmp(rec, model[k], n)) wrong++;
+    }
+  }
+  printf("%u random saves: %u stored, %u refused for lack of room, %u slot reads or refusals wrong, "
+         "%.1f EEPROM byte writes per save\n", (unsigned)SLOTS_SAVES, (unsigned)saved, (unsigned)full,
+         (unsigned)wrong, (double)(EEPROM.writes - writes0) / SLOTS_SAVES);
+  ok &= wrong == 0 && saved > 0 && full > 0;
+
+  // --- how many fit ---
+  const uint8_t densities[] = { 0, 25, 50, 100 };
+  for (uint8_t d : densities){
+    randomPattern(d);
+    uint16_t len = seq.buildSlotRecord(rec);
+    uint16_t fit = SAVE_DATA_BYTES / len;
+    printf("density %3u %%: %3u-byte record, %2u slots fit\n", (unsigned)d, (unsigned)len,
+           (unsigned)(fit < SAVE_NUM_SLOTS ? fit : SAVE_NUM_SLOTS));
+  }
+  printf("worst case:    %3u-byte record, %2u slots fit (the v3 struct fit %u)\n", (unsigned)SAVE_SLOT_BYTES,
+         (unsigned)SAVE_MIN_SLOTS, (unsigned)(SAVE_EEPROM_BYTES / sizeof(SimpleSequencer::SaveDataV3)));
+  printf(ok ? "every slot read back as written\n" : "FAILED\n");
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+  const char* mode = argc > 1 ? argv[1] : "song";
+  if (!strcmp(mode, "song")) return EngineSim::song(argc > 2 ? (uint32_t)atoi(argv[2]) : 200);
+  if (!strcmp(mode, "replay")) return EngineSim::replay();
+  if (!strcmp(mode, "profile")) return EngineSim::profile();
+  if (!strcmp(mode, "start")) return EngineSim::start();
+  if (!strcmp(mode, "slots")) return EngineSim::slots();
+  fprintf(stderr, "usage: enginesim song [sdReadUs] | replay | profile | start | slots\n");
+  return 2;
+}
@@ -0,0 +1,127 @@
+// Host cross-check of the compile-time Euclid tables (see EuclidTables.h)
+// against independent reference implementations.
+//
+//   g++ -O2 -Iinclude tools/euclidcheck.cpp src/EuclidTables.cpp -o euclidcheck && ./euclidcheck
+//
+// For every (pulses, length) pair up to EUCLID_MAX_STEPS, in both modes:
+//   Bresenham  step j is a hit when ((j + 1) * k) mod n < k, the remainder form
+//              of the table's floor((j+1)k/n) > floor(jk/n)
+//   Bjorklund  Toussaint's sequence grouping done literally, one vector per group
+//              (the table tracks a single pattern per group kind instead); and
+//              Bjorklund's original recursive construction ("The Theory of
+//              Rep-Rate Pattern Generation in the SNS Timing System"), which
+//              yields the same rhythm at another rotation
+// Each table entry must equal the grouping (and Bresenham) reference bit for bit,
+// through euclidLookup(), have exactly k hits, and in Bjorklund mode be a rotation
+// of the recursive construction that starts on a hit. euclidRotate() is checked against a naive step-by-step
+// rotation for every offset of every entry. Exit status 0 when all agree.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "EuclidTables.h"
+
+static std::vector<uint8_t> refBresenham(uint8_t k, uint8_t n){
+  std::vector<uint8_t> p(n);
+  for (uint8_t j = 0; j < n; j++) p[j] = (k >= n) || (((j + 1) * k) % n < k);
+  return p;
+}
+
+// Toussaint: k groups [1] and n-k groups [0]; append the remainder groups to the
+// first ones until at most one remainder group is left
+static std::vector<uint8_t> refGrouping(uint8_t k, uint8_t n){
+  typedef std::vector<uint8_t> Seq;
+  std::vector<Seq> a(k, Seq(1, 1)), b(n - k, Seq(1, 0));
+  while (b.size() > 1 && !a.empty()){
+    size_t m = a.size() < b.size() ? a.size() : b.size();
+    std::vector<Seq> joined(a.begin(), a.begin() + m), rest;
+    for (size_t i = 0; i < m; i++) joined[i].insert(joined[i].end(), b[i].begin(), b[i].end());
+    if (a.size() > m) rest.assign(a.begin() + m, a.end());
+    else rest.assign(b.begin() + m, b.end());
+    a = joined;
+    b = rest;
+  }
+  Seq p;
+  for (const Seq& s : a) p.insert(p.end(), s.begin(), s.end());
+  for (const Seq& s : b) p.insert(p.end(), s.begin(), s.end());
+  return p;
+}
+
+struct SnsRef {
+  std::vector<int> counts, remainders;
+  std::vector<uint8_t> out;
+  void build(int level){
+    if (level == -1) { out.push_back(0); return; }
+    if (level == -2) { out.push_back(1); return; }
+    for (int i = 0; i < counts[level]; i++) build(level - 1);
+    if (remainders[level] != 0) build(level - 2);
+  }
+};
+
+static std::vector<uint8_t> refSns(uint8_t k, uint8_t n){
+  if (k == 0) return std::vector<uint8_t>(n, 0);
+  if (k >= n) return std::vector<uint8_t>(n, 1);
+  SnsRef r;
+  int divisor = n - k;
+  r.remainders.push_back(k);
+  int level = 0;
+  while (true){
+    r.counts.push_back(divisor / r.remainders[level]);
+    r.remainders.push_back(divisor % r.remainders[level]);
+    divisor = r.remainders[level];
+    level++;
+    if (r.remainders[level] <= 1) break;
+  }
+  r.counts.push_back(divisor);
+  r.build(level);
+  return r.out;
+}
+
+static uint64_t pack(const std::vector<uint8_t>& p){
+  uint64_t bits = 0;
+  for (size_t j = 0; j < p.size(); j++) if (p[j]) bits |= 1ULL << j;
+  return bits;
+}
+
+static uint64_t naiveRotate(uint64_t p, uint8_t offset, uint8_t n){
+  uint64_t r = 0;
+  for (uint8_t j = 0; j < n; j++) if ((p >> j) & 1) r |= 1ULL << ((j + offset) % n);
+  return r;
+}
+
+static bool isRotationOf(uint64_t p, uint64_t q, uint8_t n){
+  for (uint8_t off = 0; off < n; off++) if (naiveRotate(q, off, n) == p) return true;
+  return false;
+}
+
+int main(){
+  const char* names[EUCLID_NUM_MODES] = {"Bresenham", "Bjorklund"};
+  uint32_t bad[EUCLID_NUM_MODES] = {0, 0}, badSns = 0, badRotate = 0, entries = 0, rotations = 0;
+  for (uint8_t n = 1; n <= EUCLID_MAX_STEPS; n++){
+    for (uint8_t k = 0; k <= n; k++){
+      entries++;
+      for (uint8_t mode = 0; mode < EUCLID_NUM_MODES; mode++){
+        uint64_t want = pack(mode == EUCLID_BJORKLUND ? refGrouping(k, n) : refBresenham(k, n));
+        uint64_t got = euclidLookup(mode, k, n);
+        if (mode == EUCLID_BJORKLUND && (!isRotationOf(got, pack(refSns(k, n)), n) || (k && !(got & 1)))){
+          if (badSns++ < 5) printf("Bjorklund E(%u,%u): table %016llx is no rotation of the SNS construction\n",
+                                   (unsigned)k, (unsigned)n, (unsigned long long)got);
+        }
+        if (got != want || __builtin_popcountll(got) != k){
+          if (bad[mode]++ < 5) printf("%s E(%u,%u): table %016llx, reference %016llx\n", names[mode],
+                                      (unsigned)k, (unsigned)n, (unsigned long long)got, (unsigned long long)want);
+        }
+        for (uint8_t off = 0; off < n; off++){
+          rotations++;
+          if (euclidRotate(got, off, n) != naiveRotate(got, off, n)) badRotate++;
+        }
+      }
+    }
+  }
+  for (uint8_t mode = 0; mode < EUCLID_NUM_MODES; mode++)
+    printf("%-9s %u of %u entries differ from the reference\n", names[mode], (unsigned)bad[mode], (unsigned)entries);
+  printf("Bjorklund %u of %u entries are no rotation of the SNS construction or start on a rest\n",
+         (unsigned)badSns, (unsigned)entries);
+  printf("rotate    %u of %u rotations differ from a naive rotation\n", (unsigned)badRotate, (unsigned)rotations);
+  return (bad[0] || bad[1] || badSns || badRotate) ? 1 : 0;
+}
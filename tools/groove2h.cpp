@@ -0,0 +1,150 @@
+// Extracts groove templates from reference Standard MIDI Files (see
+// include/GrooveTables.h) and writes them as include/GrooveImports.h.
+//
+//   g++ -O2 -Iinclude tools/groove2h.cpp -o groove2h
+//
+//   groove2h [-o include/GrooveImports.h] [options] <file.mid> ...
+//     --steps N     template length in steps, 1..16 (default 16)
+//     --grid N      steps per quarter note (default 4: 16ths)
+//     --channel C   only notes on MIDI channel C (1-16)
+//     --note N      only note number N (e.g. 42 for a hi-hat)
+//     --name NAME   name of the next file's groove (default: file name, 9 chars)
+// Options apply to the files after them. With no files, writes an empty list.
+//
+// Every note-on is matched to the nearest grid step. Template position p averages
+// the timing error of all notes on steps p, p + N, p + 2N ... (in 1/192 step) and
+// their velocity as a percentage of the file's mean velocity. Positions with no
+// notes are left straight. Rebuild the firmware after regenerating the header.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "GrooveTables.h"
+#include "SmfReader.h"
+
+struct Options {
+  int steps = GROOVE_MAX_STEPS;
+  int grid = 4;
+  int channel = 0;     // 1-16, 0 = any
+  int note = -1;
+  std::string name;    // next file only
+};
+
+static std::string defaultName(const char* path){
+  const char* base = strrchr(path, '/');
+  base = base ? base + 1 : path;
+  std::string s;
+  for (const char* c = base; *c && *c != '.' && s.size() < GROOVE_NAME_LEN - 1u; c++){
+    s += (char)toupper((unsigned char)(*c == '_' || *c == '-' ? ' ' : *c));
+  }
+  return s;
+}
+
+// One template from a file's hits. False if no note passed the filters.
+static bool extract(const SmfFile& f, const Options& o, GrooveTemplate& g, uint32_t& used, uint32_t& clamped){
+  double stepTicks = (double)f.division / o.grid;
+  double devSum[GROOVE_MAX_STEPS] = {}, velSum[GROOVE_MAX_STEPS] = {};
+  uint32_t count[GROOVE_MAX_STEPS] = {};
+  double velAll = 0;
+  used = 0;
+  for (const SmfNote& h : f.notes){
+    if (o.channel && h.ch != o.channel - 1) continue;
+    if (o.note >= 0 && h.note != o.note) continue;
+    double pos = h.tick / stepTicks;
+    double step = floor(pos + 0.5);
+    uint8_t p = (uint8_t)((uint64_t)step % (uint64_t)o.steps);
+    devSum[p] += pos - step;
+    velSum[p] += h.vel;
+    count[p]++;
+    velAll += h.vel;
+    used++;
+  }
+  if (!used) return false;
+  velAll /= used;
+  g.length = (uint8_t)o.steps;
+  clamped = 0;
+  for (int p = 0; p < o.steps; p++){
+    if (!count[p]) { g.offset[p] = 0; g.velocity[p] = 100; continue; }
+    long off = lround(devSum[p] / count[p] * GROOVE_UNITS_PER_STEP);
+    if (off > 127 || off < -127) { clamped++; off = off > 0 ? 127 : -127; }
+    long vel = lround(velSum[p] / count[p] / velAll * 100);
+    g.offset[p] = (int8_t)off;
+    g.velocity[p] = (uint8_t)(vel < 1 ? 1 : vel > 255 ? 255 : vel);
+  }
+  return true;
+}
+
+int main(int argc, char** argv){
+  const char* outPath = nullptr;
+  Options o;
+  std::vector<GrooveTemplate> grooves;
+  std::vector<std::string> sources;
+  std::string cmd = "groove2h";
+
+  for (int i = 1; i < argc; i++){
+    std::string a = argv[i];
+    bool hasVal = i + 1 < argc;
+    if (a == "-o" && hasVal) { outPath = argv[++i]; cmd += " -o "; cmd += outPath; continue; }
+    if (a == "--steps" && hasVal) { o.steps = atoi(argv[++i]); cmd += " --steps "; cmd += argv[i]; continue; }
+    if (a == "--grid" && hasVal) { o.grid = atoi(argv[++i]); cmd += " --grid "; cmd += argv[i]; continue; }
+    if (a == "--channel" && hasVal) { o.channel = atoi(argv[++i]); cmd += " --channel "; cmd += argv[i]; continue; }
+    if (a == "--note" && hasVal) { o.note = atoi(argv[++i]); cmd += " --note "; cmd += argv[i]; continue; }
+    if (a == "--name" && hasVal) { o.name = argv[++i]; cmd += " --name \"" + o.name + "\""; continue; }
+    if (a[0] == '-'){
+      fprintf(stderr, "usage: groove2h [-o out.h] [--steps N] [--grid N] [--channel C] [--note N] [--name NAME] <file.mid> ...\n");
+      return 2;
+    }
+    if (o.steps < 1 || o.steps > GROOVE_MAX_STEPS || o.grid < 1 || o.channel < 0 || o.channel > 16){
+      fprintf(stderr, "groove2h: --steps 1..%d, --grid >= 1, --channel 1..16\n", GROOVE_MAX_STEPS);
+      return 2;
+    }
+    cmd += " " + a;
+
+    SmfFile f;
+    std::string err;
+    if (!smfRead(argv[i], f, err)) { fprintf(stderr, "groove2h: %s: %s\n", argv[i], err.c_str()); return 1; }
+    GrooveTemplate g = makeGroove(o.name.empty() ? defaultName(argv[i]).c_str() : o.name.c_str(), 1);
+    uint32_t used, clamped;
+    if (!extract(f, o, g, used, clamped)) { fprintf(stderr, "groove2h: %s: no notes match\n", argv[i]); return 1; }
+    o.name.clear();
+
+    fprintf(stderr, "%-9s %s: %u notes, %u ticks/quarter\n  offset:", g.name, argv[i], (unsigned)used, (unsigned)f.division);
+    for (int p = 0; p < g.length; p++) fprintf(stderr, " %4d", g.offset[p]);
+    fprintf(stderr, "\n  vel %%: ");
+    for (int p = 0; p < g.length; p++) fprintf(stderr, " %4d", g.velocity[p]);
+    fprintf(stderr, "\n");
+    if (clamped) fprintf(stderr, "  %u positions off by more than 2/3 step, clamped: wrong --grid?\n", (unsigned)clamped);
+
+    char src[256];
+    snprintf(src, sizeof(src), "%s (%u notes, %d steps)", argv[i], (unsigned)used, g.length);
+    sources.push_back(src);
+    grooves.push_back(g);
+  }
+  if (grooves.size() + GROOVE_BUILTINS > GROOVE_MAX_TEMPLATES){
+    fprintf(stderr, "groove2h: at most %d imported grooves\n", GROOVE_MAX_TEMPLATES - GROOVE_BUILTINS);
+    return 1;
+  }
+
+  FILE* out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) { fprintf(stderr, "groove2h: can't write %s\n", outPath); return 1; }
+  fprintf(out, "#ifndef GROOVEIMPORTS_H\n#define GROOVEIMPORTS_H\n\n");
+  fprintf(out, "// Generated by tools/groove2h.cpp, do not edit:\n//   %s\n", cmd.c_str());
+  for (const std::string& s : sources) fprintf(out, "// %s\n", s.c_str());
+  fprintf(out, "// Appended to grooveTables[] after the built-in swings (see GrooveTables.h).\n\n");
+  fprintf(out, "#define GROOVE_IMPORTS%s\n", grooves.empty() ? "" : " \\");
+  for (size_t i = 0; i < grooves.size(); i++){
+    const GrooveTemplate& g = grooves[i];
+    fprintf(out, "  GrooveTemplate{ \"%s\", %u, \\\n    {", g.name, g.length);
+    for (int p = 0; p < GROOVE_MAX_STEPS; p++) fprintf(out, "%s%d", p ? ", " : " ", g.offset[p]);
+    fprintf(out, " }, \\\n    {");
+    for (int p = 0; p < GROOVE_MAX_STEPS; p++) fprintf(out, "%s%u", p ? ", " : " ", g.velocity[p]);
+    fprintf(out, " } },%s\n", i + 1 < grooves.size() ? " \\" : "");
+  }
+  fprintf(out, "\n#endif\n");
+  if (outPath) fclose(out);
+  return 0;
+}
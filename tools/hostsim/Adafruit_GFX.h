@@ -0,0 +1,25 @@
+#ifndef HOSTSIM_ADAFRUIT_GFX_H
+#define HOSTSIM_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+// Drawing calls that draw nothing (tools/oledbench.cpp models the real ones)
+class Adafruit_GFX : public Print {
+  public:
+    size_t write(uint8_t) override { return 1; }
+    void setTextSize(uint8_t) {}
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setCursor(int16_t, int16_t) {}
+    void fillRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void drawRect(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void drawLine(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void drawPixel(int16_t, int16_t, uint16_t) {}
+    void drawChar(int16_t, int16_t, unsigned char, uint16_t, uint16_t, uint8_t) {}
+    void drawFastHLine(int16_t, int16_t, int16_t, uint16_t) {}
+    void drawFastVLine(int16_t, int16_t, int16_t, uint16_t) {}
+    int16_t width() { return 128; }
+    int16_t height() { return 64; }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOSTSIM_ADAFRUIT_NEOPIXEL_H
+#define HOSTSIM_ADAFRUIT_NEOPIXEL_H
+
+#include <stdint.h>
+
+#define NEO_GRB 0
+#define NEO_KHZ800 0
+
+// LED strip that draws nothing
+class Adafruit_NeoPixel {
+  public:
+    Adafruit_NeoPixel(uint16_t, int16_t, int) {}
+    void begin() {}
+    void setBrightness(uint8_t) {}
+    void show() {}
+    void clear() {}
+    void setPixelColor(uint16_t, uint32_t) {}
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOSTSIM_ADAFRUIT_SH110X_H
+#define HOSTSIM_ADAFRUIT_SH110X_H
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SH110X_WHITE 1
+#define SH110X_BLACK 0
+
+class Adafruit_SH1106G : public Adafruit_GFX {
+  public:
+    Adafruit_SH1106G(uint16_t, uint16_t, TwoWire*) {}
+    bool begin(uint8_t) { return true; }
+    void clearDisplay() { memset(buffer, 0, sizeof(buffer)); }
+    void display() {}
+    uint8_t* getBuffer() { return buffer; }
+  private:
+    uint8_t buffer[128 * 64 / 8] = {};
+};
+
+#endif
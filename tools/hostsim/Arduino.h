@@ -0,0 +1,199 @@
+#ifndef HOSTSIM_ARDUINO_H
+#define HOSTSIM_ARDUINO_H
+
+// Teensy 4.1 core stand-in for running the firmware sources on a PC (see
+// HostSim.h). Time is simulated: micros() only moves when the firmware waits
+// (yield(), delay(), a stalled SD read) or the harness advances it, and the
+// IntervalTimer and pin interrupts fire at those points, never inside a
+// noInterrupts() section. Build with -DARDUINO -Itools/hostsim.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 3
+#define FALLING 4
+#define CHANGE 5
+#define DEC 10
+#define HEX 16
+#define BIN 2
+#define LED_BUILTIN 13
+#define TWO_PI 6.283185307179586
+#define F_CPU_ACTUAL 600000000UL
+#define FASTRUN
+#define FLASHMEM
+#define PROGMEM
+#define DMAMEM
+
+typedef bool boolean;
+using std::abs;
+
+template <class T, class L, class H> T constrain(T x, L lo, H hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+// --- simulated core (HostSim.cpp) ---
+uint32_t hostsimMicros();
+uint32_t hostsimCycles();
+void hostsimWait(uint32_t us);
+void hostsimYield();
+void hostsimNoInterrupts();
+void hostsimInterrupts();
+uint32_t hostsimIrqSave();
+void hostsimIrqRestore(uint32_t mask);
+int hostsimDigitalRead(uint8_t pin);
+void hostsimAttachInterrupt(uint8_t pin, void (*fn)(), int mode);
+long hostsimRandom(long lo, long hi);
+void hostsimRandomSeed(unsigned long seed);
+
+inline uint32_t micros() { return hostsimMicros(); }
+inline uint32_t millis() { return hostsimMicros() / 1000; }
+inline void delay(uint32_t ms) { hostsimWait(ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { hostsimWait(us); }
+inline void yield() { hostsimYield(); }
+inline void noInterrupts() { hostsimNoInterrupts(); }
+inline void interrupts() { hostsimInterrupts(); }
+inline void __disable_irq() { hostsimNoInterrupts(); }
+inline void __enable_irq() { hostsimInterrupts(); }
+// Host time at 600 cycles per microsecond, so cycle profiles read as host time
+#define ARM_DWT_CYCCNT (hostsimCycles())
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t pin) { return hostsimDigitalRead(pin); }
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int analogRead(uint8_t) { return 0; }
+inline void analogWriteResolution(uint8_t) {}
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(uint8_t pin, void (*fn)(), int mode) { hostsimAttachInterrupt(pin, fn, mode); }
+inline long random(long hi) { return hostsimRandom(0, hi); }
+inline long random(long lo, long hi) { return hostsimRandom(lo, hi); }
+inline void randomSeed(unsigned long seed) { hostsimRandomSeed(seed); }
+
+// --- Print / Stream ---
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* b, size_t n) { for (size_t i = 0; i < n; i++) write(b[i]); return n; }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return printNumber(v, base, false); }
+    size_t print(int v, int base = DEC) { return printNumber(v, base, true); }
+    size_t print(unsigned int v, int base = DEC) { return printNumber(v, base, false); }
+    size_t print(long v, int base = DEC) { return printNumber(v, base, true); }
+    size_t print(unsigned long v, int base = DEC) { return printNumber(v, base, false); }
+    size_t print(long long v, int base = DEC) { return printNumber(v, base, true); }
+    size_t print(unsigned long long v, int base = DEC) { return printNumber(v, base, false); }
+    size_t print(double v, int digits = 2) {
+      char buf[48];
+      snprintf(buf, sizeof(buf), "%.*f", digits, v);
+      return write(buf);
+    }
+    template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <class T> size_t println(T v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+    size_t println() { return write("\r\n"); }
+    size_t printf(const char* fmt, ...) {
+      char buf[256];
+      va_list ap;
+      va_start(ap, fmt);
+      vsnprintf(buf, sizeof(buf), fmt, ap);
+      va_end(ap);
+      return write(buf);
+    }
+
+  private:
+    size_t printNumber(long long v, int base, bool isSigned) {
+      char buf[72];
+      if (base == DEC) snprintf(buf, sizeof(buf), isSigned ? "%lld" : "%llu", v);
+      else if (base == HEX) snprintf(buf, sizeof(buf), "%llX", (unsigned long long)v);
+      else {
+        unsigned long long u = (unsigned long long)v;
+        int i = 70;
+        buf[71] = 0;
+        do { buf[i--] = '0' + (u & 1); u >>= 1; } while (u && i >= 0);
+        return write(buf + i + 1);
+      }
+      return write(buf);
+    }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    size_t readBytes(char* dst, size_t n) {
+      size_t got = 0;
+      while (got < n && available() > 0) dst[got++] = (char)read();
+      return got;
+    }
+};
+
+// USB serial: console and link frames. TX is kept for the harness, RX is fed by it.
+class usb_serial_class : public Stream {
+  public:
+    void begin(uint32_t) {}
+    size_t write(uint8_t b) override;
+    using Print::write;
+    int availableForWrite() override { return 4096; }
+    int available() override;
+    int read() override;
+    int peek() override;
+    void send_now() {}
+    explicit operator bool() { return true; }
+};
+
+// 31250-baud UART with the Teensy's TX buffer; every byte is logged with the time
+// its last bit leaves the pin
+class HardwareSerial : public Stream {
+  public:
+    explicit HardwareSerial(uint8_t id) : id(id) {}
+    void begin(uint32_t baud) { byteUs = baud ? 10000000UL / baud : 320; }
+    size_t write(uint8_t b) override;
+    using Print::write;
+    int availableForWrite() override;
+    int available() override;
+    int read() override;
+    void addMemoryForWrite(void*, size_t) {}
+    void addMemoryForRead(void*, size_t) {}
+    uint8_t id;
+    uint32_t byteUs = 320;
+    uint64_t wireFreeAt = 0;   // when the last queued byte is out
+};
+
+extern usb_serial_class Serial;
+extern HardwareSerial Serial1, Serial2, Serial3, Serial4, Serial5, Serial6, Serial7, Serial8;
+
+// USB device MIDI: sends are logged as MIDI bytes, reads come from the harness
+class usb_midi_class {
+  public:
+    void sendRealTime(uint8_t b);
+    void sendSongPosition(uint16_t beats, uint8_t cable = 0);
+    void send(uint8_t type, uint8_t d1, uint8_t d2, uint8_t channel, uint8_t cable);
+    void sendNoteOn(uint8_t note, uint8_t vel, uint8_t channel, uint8_t cable = 0) { send(0x90, note, vel, channel, cable); }
+    void sendControlChange(uint8_t cc, uint8_t v, uint8_t channel, uint8_t cable = 0) { send(0xB0, cc, v, channel, cable); }
+    void send_now() {}
+    bool read();
+    uint8_t getType() { return type; }
+    uint8_t getChannel() { return channel; }
+    uint8_t getData1() { return d1; }
+    uint8_t getData2() { return d2; }
+    uint8_t getCable() { return 0; }
+  private:
+    uint8_t type = 0, channel = 1, d1 = 0, d2 = 0;
+};
+extern usb_midi_class usbMIDI;
+
+#endif
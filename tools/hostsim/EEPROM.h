@@ -0,0 +1,28 @@
+#ifndef HOSTSIM_EEPROM_H
+#define HOSTSIM_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+// 4284 bytes, erased (0xFF) at start; the harness can preload or inspect `bytes`
+class EEPROMClass {
+  public:
+    static const uint16_t SIZE = 4284;
+    EEPROMClass() { memset(bytes, 0xFF, sizeof(bytes)); }
+    uint8_t read(int addr) { return valid(addr) ? bytes[addr] : 0xFF; }
+    void write(int addr, uint8_t v) { if (valid(addr)) { bytes[addr] = v; writes++; } }
+    void update(int addr, uint8_t v) { if (valid(addr) && bytes[addr] != v) write(addr, v); }
+    template <class T> T& get(int addr, T& t) { memcpy(&t, bytes + addr, sizeof(T)); return t; }
+    template <class T> const T& put(int addr, const T& t) {
+      for (size_t i = 0; i < sizeof(T); i++) update(addr + (int)i, ((const uint8_t*)&t)[i]);
+      return t;
+    }
+    uint16_t length() { return SIZE; }
+    uint8_t bytes[SIZE];
+    uint32_t writes = 0;
+  private:
+    bool valid(int addr) const { return addr >= 0 && addr < SIZE; }
+};
+extern EEPROMClass EEPROM;
+
+#endif
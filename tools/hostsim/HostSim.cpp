@@ -0,0 +1,250 @@
+// Teensy core stand-in: simulated clock, interrupts and I/O (see HostSim.h)
+
+#include "HostSim.h"
+#include <IntervalTimer.h>
+#include <EEPROM.h>
+#include <SD.h>
+#include <Wire.h>
+#include <deque>
+#include <time.h>
+
+std::vector<HostsimByte> hostsimDinOut;
+std::vector<HostsimByte> hostsimUsbOut;
+std::string hostsimSerialOut;
+bool hostsimEcho = false;
+bool hostsimSdPresent = true;
+std::string hostsimSdRoot = "/tmp";
+uint32_t hostsimSdReadUs = 0;
+
+usb_serial_class Serial;
+HardwareSerial Serial1(1), Serial2(2), Serial3(3), Serial4(4), Serial5(5), Serial6(6), Serial7(7), Serial8(8);
+usb_midi_class usbMIDI;
+EEPROMClass EEPROM;
+SDClass SD;
+TwoWire Wire;
+
+static uint64_t simNow = 0;
+static bool irqOff = false;
+static IntervalTimer* timers = nullptr;
+static void (*pinIsr[64])() = {};
+static int pinIsrMode[64] = {};
+static uint8_t pinLevel[64];
+static bool pinsReady = false;
+static uint32_t rng = 1;
+
+struct TimedByte { uint8_t b; uint32_t atUs; };
+struct TimedMsg { uint8_t status, d1, d2; uint32_t atUs; };
+static std::deque<uint8_t> serialRx;
+static std::deque<TimedByte> dinRx;
+static std::deque<TimedMsg> usbRx;
+
+// --- CLOCK AND INTERRUPTS ---
+
+uint64_t hostsimNow() { return simNow; }
+uint32_t hostsimMicros() { return (uint32_t)simNow; }
+
+uint32_t hostsimCycles() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec) * 3 / 5);
+}
+
+static IntervalTimer* nextTimer(uint64_t until) {
+  IntervalTimer* first = nullptr;
+  for (IntervalTimer* t = timers; t; t = t->next) {
+    if (t->active && t->dueUs <= until && (!first || t->dueUs < first->dueUs)) first = t;
+  }
+  return first;
+}
+
+// Run every timer interrupt due up to `until`, then move the clock there
+static void runTo(uint64_t until) {
+  while (!irqOff) {
+    IntervalTimer* t = nextTimer(until);
+    if (!t) break;
+    if (t->dueUs > simNow) simNow = t->dueUs;
+    uint32_t starts = t->starts;
+    irqOff = true;
+    t->fn();
+    irqOff = false;
+    if (t->active && t->starts == starts) t->dueUs += t->periodUs ? t->periodUs : 1;
+  }
+  if (until > simNow) simNow = until;
+}
+
+void hostsimRun(uint32_t us) { runTo(simNow + us); }
+void hostsimWait(uint32_t us) { runTo(simNow + us); }
+
+// Idle hook: on to the next interrupt, at most 50 us at a time
+void hostsimYield() {
+  uint64_t until = simNow + 50;
+  IntervalTimer* t = irqOff ? nullptr : nextTimer(until);
+  runTo(t && t->dueUs > simNow ? t->dueUs : until);
+}
+
+void hostsimNoInterrupts() { irqOff = true; }
+void hostsimInterrupts() { irqOff = false; }
+uint32_t hostsimIrqSave() { uint32_t was = irqOff; irqOff = true; return was; }
+void hostsimIrqRestore(uint32_t mask) { irqOff = mask != 0; }
+
+IntervalTimer::IntervalTimer() {
+  next = timers;
+  timers = this;
+}
+
+bool IntervalTimer::begin(void (*f)(), uint32_t us) {
+  fn = f;
+  periodUs = us;
+  dueUs = simNow + us;
+  active = true;
+  starts++;
+  return true;
+}
+
+// --- PINS ---
+
+static void initPins() {
+  if (pinsReady) return;
+  memset(pinLevel, HIGH, sizeof(pinLevel)); // pull-ups, nothing pressed
+  pinsReady = true;
+}
+
+int hostsimDigitalRead(uint8_t pin) {
+  initPins();
+  return pin < 64 ? pinLevel[pin] : HIGH;
+}
+
+void hostsimAttachInterrupt(uint8_t pin, void (*fn)(), int mode) {
+  if (pin >= 64) return;
+  pinIsr[pin] = fn;
+  pinIsrMode[pin] = mode;
+}
+
+void hostsimSetPin(uint8_t pin, int level) {
+  initPins();
+  if (pin >= 64 || pinLevel[pin] == level) return;
+  pinLevel[pin] = (uint8_t)level;
+  int mode = pinIsrMode[pin];
+  bool fire = pinIsr[pin] && (mode == CHANGE || (mode == RISING && level == HIGH) || (mode == FALLING && level == LOW));
+  if (!fire || irqOff) return;
+  irqOff = true;
+  pinIsr[pin]();
+  irqOff = false;
+}
+
+long hostsimRandom(long lo, long hi) {
+  if (hi <= lo) return lo;
+  rng = rng * 1664525UL + 1013904223UL;
+  return lo + (long)((rng >> 8) % (uint32_t)(hi - lo));
+}
+void hostsimRandomSeed(unsigned long seed) { rng = (uint32_t)seed | 1; }
+
+// --- USB SERIAL ---
+
+size_t usb_serial_class::write(uint8_t b) {
+  hostsimSerialOut += (char)b;
+  if (hostsimEcho) fputc(b, stderr);
+  return 1;
+}
+int usb_serial_class::available() { return (int)serialRx.size(); }
+int usb_serial_class::read() {
+  if (serialRx.empty()) return -1;
+  uint8_t b = serialRx.front();
+  serialRx.pop_front();
+  return b;
+}
+int usb_serial_class::peek() { return serialRx.empty() ? -1 : serialRx.front(); }
+void hostsimSerialIn(const char* text) { hostsimSerialIn((const uint8_t*)text, strlen(text)); }
+void hostsimSerialIn(const uint8_t* b, size_t n) { serialRx.insert(serialRx.end(), b, b + n); }
+
+// --- UART (DIN on Serial8) ---
+
+static const int UART_TX_BUFFER = 40;
+
+size_t HardwareSerial::write(uint8_t b) {
+  uint64_t start = wireFreeAt > simNow ? wireFreeAt : simNow;
+  wireFreeAt = start + byteUs;
+  if (id == 8) hostsimDinOut.push_back(HostsimByte{b, (uint32_t)wireFreeAt});
+  return 1;
+}
+
+int HardwareSerial::availableForWrite() {
+  if (wireFreeAt <= simNow) return UART_TX_BUFFER;
+  // the byte being shifted out has left the buffer
+  int queued = (int)((wireFreeAt - simNow + byteUs - 1) / byteUs) - 1;
+  return queued >= UART_TX_BUFFER ? 0 : UART_TX_BUFFER - queued;
+}
+
+int HardwareSerial::available() {
+  if (id != 8) return 0;
+  int n = 0;
+  for (const TimedByte& t : dinRx) { if (t.atUs > simNow) break; n++; }
+  return n;
+}
+
+int HardwareSerial::read() {
+  if (id != 8 || dinRx.empty() || dinRx.front().atUs > simNow) return -1;
+  uint8_t b = dinRx.front().b;
+  dinRx.pop_front();
+  return b;
+}
+
+void hostsimDinIn(uint8_t b, uint32_t atUs) { dinRx.push_back(TimedByte{b, atUs}); }
+
+// --- USB MIDI ---
+
+static void usbOut(uint8_t b) { hostsimUsbOut.push_back(HostsimByte{b, (uint32_t)simNow}); }
+
+void usb_midi_class::sendRealTime(uint8_t b) { usbOut(b); }
+
+void usb_midi_class::sendSongPosition(uint16_t beats, uint8_t) {
+  usbOut(0xF2);
+  usbOut(beats & 0x7F);
+  usbOut((beats >> 7) & 0x7F);
+}
+
+void usb_midi_class::send(uint8_t t, uint8_t a, uint8_t b, uint8_t ch, uint8_t) {
+  usbOut((t & 0xF0) | ((ch - 1) & 0x0F));
+  usbOut(a & 0x7F);
+  if ((t & 0xF0) != 0xC0 && (t & 0xF0) != 0xD0) usbOut(b & 0x7F);
+}
+
+bool usb_midi_class::read() {
+  if (usbRx.empty() || usbRx.front().atUs > simNow) return false;
+  TimedMsg m = usbRx.front();
+  usbRx.pop_front();
+  type = m.status < 0xF0 ? (m.status & 0xF0) : m.status;
+  channel = (m.status & 0x0F) + 1;
+  d1 = m.d1;
+  d2 = m.d2;
+  return true;
+}
+
+void hostsimUsbIn(uint8_t status, uint8_t d1, uint8_t d2, uint32_t atUs) { usbRx.push_back(TimedMsg{status, d1, d2, atUs}); }
+
+// --- SD ---
+
+bool SDClass::begin(uint8_t) { return hostsimSdPresent; }
+
+File SDClass::open(const char* path, uint8_t mode) {
+  if (!hostsimSdPresent) return File();
+  std::string full = hostsimSdRoot + (path[0] == '/' ? "" : "/") + path;
+  FILE* f = fopen(full.c_str(), mode == FILE_WRITE ? "r+b" : "rb");
+  if (!f && mode == FILE_WRITE) f = fopen(full.c_str(), "w+b");
+  return File(f);
+}
+
+int File::read(void* dst, size_t n) {
+  if (!f) return -1;
+  hostsimWait(hostsimSdReadUs);
+  return (int)fread(dst, 1, n, f);
+}
+
+uint64_t File::size() {
+  if (!f) return 0;
+  long cur = ftell(f);
+  fseek(f, 0, SEEK_END);
+  long end = ftell(f);
+  fseek(f, cur, SEEK_SET);
+  return (uint64_t)end;
+}
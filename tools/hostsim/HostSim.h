@@ -0,0 +1,45 @@
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+// --- HOST SIMULATION OF THE TEENSY CORE ---
+// The stand-in headers in this directory let the firmware sources (everything in
+// src/ but main.cpp) build and run on a PC, driven by a harness such as
+// tools/enginesim.cpp:
+//
+//   g++ -O2 -DARDUINO -Itools/hostsim -Iinclude harness.cpp tools/hostsim/HostSim.cpp src/<all but main>.cpp
+//
+// Time is simulated and only moves when the firmware waits (yield(), delay(), a
+// slow SD read) or the harness calls hostsimRun(). Timer and pin interrupts run
+// at their due time, to completion, and never inside a noInterrupts() section,
+// so a run is deterministic. MIDI output is logged byte by byte with its time;
+// DIN bytes leave a 31250-baud UART behind the Teensy's 40-byte TX buffer.
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct HostsimByte {
+  uint8_t b;
+  uint32_t atUs;   // DIN: last bit on the wire; USB: handed to the USB stack
+};
+
+extern std::vector<HostsimByte> hostsimDinOut;
+extern std::vector<HostsimByte> hostsimUsbOut;
+extern std::string hostsimSerialOut;   // USB serial console output
+extern bool hostsimEcho;               // also copy the console to stderr
+extern bool hostsimSdPresent;
+extern std::string hostsimSdRoot;      // directory standing in for the card
+extern uint32_t hostsimSdReadUs;       // simulated time per SD read call
+
+uint64_t hostsimNow();
+// Let `us` of simulated time pass in the caller's context, running interrupts
+void hostsimRun(uint32_t us);
+void hostsimSetPin(uint8_t pin, int level);
+void hostsimSerialIn(const char* text);
+void hostsimSerialIn(const uint8_t* b, size_t n);
+// MIDI arriving at `atUs` (DIN: time the byte has been received)
+void hostsimDinIn(uint8_t b, uint32_t atUs);
+void hostsimUsbIn(uint8_t status, uint8_t d1, uint8_t d2, uint32_t atUs);
+
+#endif
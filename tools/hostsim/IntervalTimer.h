@@ -0,0 +1,26 @@
+#ifndef HOSTSIM_INTERVALTIMER_H
+#define HOSTSIM_INTERVALTIMER_H
+
+#include <stdint.h>
+
+// Periodic timer interrupt on the simulated clock. As on the Teensy, update()
+// changes the period from the next interrupt on.
+class IntervalTimer {
+  public:
+    IntervalTimer();
+    bool begin(void (*fn)(), uint32_t us);
+    template <class F> bool begin(F fn, uint32_t us) { return begin(static_cast<void (*)()>(fn), us); }
+    void update(uint32_t us) { periodUs = us; }
+    void end() { active = false; }
+    void priority(uint8_t) {}
+
+    // simulator state
+    void (*fn)() = nullptr;
+    uint32_t periodUs = 0;
+    uint64_t dueUs = 0;
+    bool active = false;
+    uint32_t starts = 0;   // begin() count, to spot a restart from inside the callback
+    IntervalTimer* next = nullptr;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef HOSTSIM_SD_H
+#define HOSTSIM_SD_H
+
+#include <Arduino.h>
+
+#define FILE_READ 0
+#define FILE_WRITE 1
+#define BUILTIN_SDCARD 254
+
+// SD card on a host directory (hostsimSdRoot). Each read() costs
+// hostsimSdReadUs of simulated time, during which interrupts keep firing, so a
+// slow card can be modelled.
+class File {
+  public:
+    File() {}
+    explicit File(FILE* f) : f(f) {}
+    explicit operator bool() const { return f != nullptr; }
+    int read(void* dst, size_t n);
+    size_t write(const void* src, size_t n) { return f ? fwrite(src, 1, n, f) : 0; }
+    bool seek(uint64_t pos) { return f && fseek(f, (long)pos, SEEK_SET) == 0; }
+    uint64_t position() { return f ? (uint64_t)ftell(f) : 0; }
+    uint64_t size();
+    void close() { if (f) { fclose(f); f = nullptr; } }
+  private:
+    FILE* f = nullptr;
+};
+
+class SDClass {
+  public:
+    bool begin(uint8_t);
+    File open(const char* path, uint8_t mode = FILE_READ);
+};
+extern SDClass SD;
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef HOSTSIM_WIRE_H
+#define HOSTSIM_WIRE_H
+
+#include <stdint.h>
+
+// An empty I2C bus: every address NAKs
+class TwoWire {
+  public:
+    void begin() {}
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t) {}
+    uint8_t endTransmission() { return 2; }
+};
+extern TwoWire Wire;
+
+#endif
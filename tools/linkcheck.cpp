@@ -0,0 +1,152 @@
+// Host check of the USB serial link parser (see SerialLink.h).
+//
+//   g++ -O2 -Iinclude tools/linkcheck.cpp src/SerialLink.cpp -o linkcheck && ./linkcheck
+//
+// Feeds LinkParser byte streams with their arrival times, as serviceSerial() does,
+// and checks what comes back. The broken frames carry console command letters in
+// their payload ('c' clears the EEPROM), and none of their bytes may come back as
+// LINK_RX_PASS:
+//   oversize     a header with a length past LINK_MAX_PAYLOAD, then its payload
+//   truncated    a frame cut off mid-payload; the sender resumes 300 ms later
+//   false sync   a cut-off frame whose rest holds A5 followed by a command letter
+// Each case then sends a good frame, which must decode, and a command typed once
+// the line has been quiet, which must reach the console. Plain commands and
+// frames between them are checked too.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "SerialLink.h"
+
+struct TimedByte {
+  uint8_t b;
+  uint32_t atMs;
+};
+
+struct Counts {
+  uint32_t pass = 0, frames = 0, bad = 0;
+  std::vector<uint8_t> passed;
+};
+
+static void feed(LinkParser& p, const std::vector<TimedByte>& bytes, Counts& c){
+  for (const TimedByte& t : bytes){
+    LinkRx rx = p.feed(t.b, t.atMs);
+    if (rx == LINK_RX_PASS) { c.pass++; c.passed.push_back(t.b); }
+    else if (rx == LINK_RX_FRAME) c.frames++;
+    else if (rx == LINK_RX_BAD) c.bad++;
+  }
+}
+
+// A byte a millisecond from `atMs` on; returns the time after the last one
+static uint32_t append(std::vector<TimedByte>& out, const uint8_t* b, uint16_t n, uint32_t atMs){
+  for (uint16_t i = 0; i < n; i++) out.push_back(TimedByte{b[i], atMs++});
+  return atMs;
+}
+
+// Payload of console letters, 'c' included
+static void commandPayload(uint8_t* out, uint16_t n){
+  static const char letters[] = "cCtlLkqsyzZ+-";
+  for (uint16_t i = 0; i < n; i++) out[i] = letters[i % (sizeof(letters) - 1)];
+}
+
+static bool report(const char* name, const Counts& broken, const Counts& after, uint32_t wantFrames){
+  bool ok = broken.pass == 0 && after.frames == wantFrames && after.pass == 1 && after.passed[0] == 'i';
+  printf("%-12s %4u bytes passed to the console from the broken frame, %u frame(s) after it, "
+         "command after quiet line %s: %s\n", name, (unsigned)broken.pass, (unsigned)after.frames,
+         after.pass == 1 ? "passed" : "LOST", ok ? "ok" : "FAILED");
+  if (broken.pass){
+    printf("  passed:");
+    for (uint8_t b : broken.passed) printf(" %02X", b);
+    printf("\n");
+  }
+  return ok;
+}
+
+static uint8_t frameBuf[LINK_MAX_FRAME];
+
+// Good frame, then 'i' once the line has been quiet
+static uint32_t goodFrameThenCommand(std::vector<TimedByte>& out, uint32_t t){
+  uint8_t payload[3] = { 0, 0, 0 };
+  uint16_t n = linkEncode(LINK_GET, 7, payload, sizeof(payload), frameBuf);
+  t = append(out, frameBuf, n, t);
+  t += LINK_DISCARD_IDLE_MS + 100;
+  out.push_back(TimedByte{'i', t});
+  return t + 1;
+}
+
+static bool oversize(){
+  LinkParser p;
+  std::vector<TimedByte> broken, after;
+  uint8_t header[6] = { LINK_SOF1, LINK_SOF2, LINK_PUT, 1, 0xFF, 0xFF };
+  uint32_t t = append(broken, header, sizeof(header), 1000);
+  uint8_t payload[600];
+  commandPayload(payload, sizeof(payload));
+  t = append(broken, payload, sizeof(payload), t);
+  goodFrameThenCommand(after, t);
+  Counts b, a;
+  feed(p, broken, b);
+  feed(p, after, a);
+  return report("oversize", b, a, 1);
+}
+
+static bool truncated(){
+  LinkParser p;
+  std::vector<TimedByte> broken, after;
+  uint8_t payload[200];
+  commandPayload(payload, sizeof(payload));
+  uint16_t n = linkEncode(LINK_PUT, 2, payload, sizeof(payload), frameBuf);
+  uint32_t t = append(broken, frameBuf, 80, 1000);
+  // the sender stalls past the frame timeout, then sends the rest
+  t = append(broken, frameBuf + 80, n - 80, t + LINK_BYTE_TIMEOUT_MS + 50);
+  goodFrameThenCommand(after, t);
+  Counts b, a;
+  feed(p, broken, b);
+  feed(p, after, a);
+  return report("truncated", b, a, 1);
+}
+
+static bool falseSync(){
+  LinkParser p;
+  std::vector<TimedByte> broken, after;
+  uint8_t payload[64];
+  commandPayload(payload, sizeof(payload));
+  payload[40] = LINK_SOF1;
+  payload[41] = 'c';
+  uint16_t n = linkEncode(LINK_PUT, 3, payload, sizeof(payload), frameBuf);
+  uint32_t t = append(broken, frameBuf, 20, 1000);
+  t = append(broken, frameBuf + 20, n - 20, t + LINK_BYTE_TIMEOUT_MS + 50);
+  goodFrameThenCommand(after, t);
+  Counts b, a;
+  feed(p, broken, b);
+  feed(p, after, a);
+  return report("false sync", b, a, 1);
+}
+
+// Commands and frames interleaved: every command byte passes, every frame decodes
+static bool plain(){
+  LinkParser p;
+  std::vector<TimedByte> in;
+  uint32_t t = 1000;
+  uint8_t payload[32];
+  commandPayload(payload, sizeof(payload));
+  for (uint8_t i = 0; i < 5; i++){
+    in.push_back(TimedByte{'f', t++});
+    uint16_t n = linkEncode(LINK_PUT, i, payload, sizeof(payload), frameBuf);
+    t = append(in, frameBuf, n, t);
+    in.push_back(TimedByte{'v', t++});
+  }
+  Counts c;
+  feed(p, in, c);
+  bool ok = c.pass == 10 && c.frames == 5 && c.bad == 0;
+  printf("%-12s %u commands passed, %u frames decoded: %s\n", "plain", (unsigned)c.pass, (unsigned)c.frames, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main(){
+  bool ok = plain();
+  ok &= oversize();
+  ok &= truncated();
+  ok &= falseSync();
+  printf(ok ? "no byte of a broken frame reached the console\n" : "FAILED\n");
+  return ok ? 0 : 1;
+}
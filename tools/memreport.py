@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+# Per-symbol RAM / flash placement report for the Teensy 4.1 firmware (see
+# include/MemPlacement.h).
+#
+#   pio run -t memreport                       builds, then reports (extra_scripts)
+#   python3 tools/memreport.py <firmware.elf> [--nm arm-none-eabi-nm] [--all] [--top N]
+#                                             [--min-stack-kb N]
+#
+# Symbols are sorted into regions by address: ITCM / DTCM (RAM1), RAM2 (DMAMEM),
+# FLASH (PROGMEM, FLASHMEM) and EXTMEM. The report gives region totals, RAM1 as
+# ITCM banks + DTCM + what is left for the stack, and the largest symbols in each
+# region (--all for every one). It fails (exit 1) if an ISR path listed in HOT is
+# not in ITCM, if a buffer or table listed in COLD is back in DTCM, or if the
+# stack would get less than --min-stack-kb, so a placement regression breaks the
+# target instead of showing up as ISR jitter.
+
+import subprocess
+import sys
+
+REGIONS = [
+    # name, start, end (exclusive)
+    ("ITCM", 0x00000000, 0x00080000),
+    ("DTCM", 0x20000000, 0x20080000),
+    ("RAM2", 0x20200000, 0x20280000),
+    ("FLASH", 0x60000000, 0x61000000),
+    ("EXTMEM", 0x70000000, 0x71000000),
+]
+RAM1_BYTES = 512 * 1024
+ITCM_BANK = 32 * 1024
+
+# Code that runs in the clock, engine and button interrupts: must run from ITCM.
+# Matched as prefixes of demangled names; a symbol that isn't found was inlined.
+HOT = [
+    "sendClockISR(",
+    "SimpleSequencer::internalClockTick(",
+    "SimpleSequencer::runEngine(",
+    "SimpleSequencer::handleMidiIn(",
+    "SimpleSequencer::handleClockByte(",
+    "SimpleSequencer::handleButtonIRQ(",
+    "SimpleSequencer::padPress(",
+    "SimpleSequencer::transportFire(",
+    "SimpleSequencer::drainEvents(",
+    "SimpleSequencer::renderChannel(",
+    "SimpleSequencer::midiSendNoteOn(",
+    "MidiRouter::send(",
+    "MidiRouter::put(",
+    "MidiRouter::putThru(",
+    "MidiRouter::pump(",
+    "MidiRouter::sendRealtime(",
+    "MidiRouter::service(",
+    "MidiRouter::thru(",
+    "ClockManager::onRealtime(",
+    "ClockManager::poll(",
+]
+
+# Large buffers and tables kept out of DTCM
+COLD = [
+    "traceRing",
+    "undoLog",
+    "euclidTables",
+    "grooveTables",
+    "BIG_FONT_2",
+    "BIG_FONT_3",
+    "BIG_FONT_4",
+]
+
+
+def region_of(addr):
+    for name, start, end in REGIONS:
+        if start <= addr < end:
+            return name
+    return None
+
+
+def read_symbols(nm, elf):
+    out = subprocess.run([nm, "-S", "-C", "--size-sort", elf], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    syms = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        addr, size, kind, name = parts
+        try:
+            syms.append((int(addr, 16), int(size, 16), kind, name))
+        except ValueError:
+            continue
+    # linker-defined markers carry no size
+    marks = {}
+    out = subprocess.run([nm, elf], check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[2] in ("_ebss", "_itcm_block_count"):
+            marks[parts[2]] = int(parts[0], 16)
+    return syms, marks
+
+
+def kb(n):
+    return "%.1f KB" % (n / 1024.0)
+
+
+def report(elf, nm="arm-none-eabi-nm", top=25, show_all=False, min_stack_kb=32):
+    syms, marks = read_symbols(nm, elf)
+    by_region = {name: [] for name, _, _ in REGIONS}
+    for addr, size, kind, name in syms:
+        r = region_of(addr)
+        if r:
+            by_region[r].append((size, addr, kind, name))
+
+    totals = {r: sum(s[0] for s in v) for r, v in by_region.items()}
+    print("--- Memory placement: %s ---" % elf)
+    for name, start, end in REGIONS:
+        print("%-7s %10s  %5d symbols" % (name, kb(totals[name]), len(by_region[name])))
+
+    banks = marks.get("_itcm_block_count", (totals["ITCM"] + ITCM_BANK - 1) // ITCM_BANK)
+    dtcm = marks["_ebss"] - 0x20000000 if "_ebss" in marks else totals["DTCM"]
+    stack = RAM1_BYTES - banks * ITCM_BANK - dtcm
+    print("RAM1: ITCM %s in %d x 32 KB banks, DTCM %s, stack %s"
+          % (kb(totals["ITCM"]), banks, kb(dtcm), kb(stack)))
+
+    for name, _, _ in REGIONS:
+        rows = sorted(by_region[name], reverse=True)
+        if not rows:
+            continue
+        shown = rows if show_all else rows[:top]
+        print("\n%s, largest first%s:" % (name, "" if show_all or len(rows) <= top else " (top %d)" % top))
+        for size, addr, kind, sym in shown:
+            print("  %08x %7d %s %s" % (addr, size, kind, sym))
+
+    failures = []
+    notes = []
+    for prefix in HOT:
+        hits = [(addr, name) for addr, size, kind, name in syms if name.startswith(prefix) and kind in "tTW"]
+        if not hits:
+            notes.append("%s not found (inlined)" % prefix)
+        for addr, name in hits:
+            if region_of(addr) != "ITCM":
+                failures.append("%s is in %s, not ITCM" % (name, region_of(addr)))
+    for want in COLD:
+        for addr, size, kind, name in syms:
+            if (name == want or name.endswith("::" + want)) and region_of(addr) == "DTCM":
+                failures.append("%s (%d bytes) is in DTCM" % (name, size))
+    if stack < min_stack_kb * 1024:
+        failures.append("stack %s is under %d KB" % (kb(stack), min_stack_kb))
+
+    print("")
+    for n in notes:
+        print("note: " + n)
+    for f in failures:
+        print("FAIL: " + f)
+    print("placement OK" if not failures else "placement FAILED")
+    return 0 if not failures else 1
+
+
+def main(argv):
+    args = argv[1:]
+    opts = {"nm": "arm-none-eabi-nm", "top": 25, "all": False, "min_stack_kb": 32}
+    elf = None
+    i = 0
+    while i < len(args):
+        a = args[i]
+        if a == "--nm" and i + 1 < len(args):
+            opts["nm"] = args[i + 1]
+            i += 1
+        elif a == "--top" and i + 1 < len(args):
+            opts["top"] = int(args[i + 1])
+            i += 1
+        elif a == "--min-stack-kb" and i + 1 < len(args):
+            opts["min_stack_kb"] = int(args[i + 1])
+            i += 1
+        elif a == "--all":
+            opts["all"] = True
+        elif elf is None and not a.startswith("--"):
+            elf = a
+        else:
+            elf = None
+            break
+        i += 1
+    if elf is None:
+        sys.stderr.write("usage: memreport.py <firmware.elf> [--nm <nm>] [--all] [--top N] [--min-stack-kb N]\n")
+        return 2
+    return report(elf, opts["nm"], opts["top"], opts["all"], opts["min_stack_kb"])
+
+
+# Loaded by PlatformIO as an extra script: add the `memreport` target, using the
+# nm next to the toolchain's gcc
+try:
+    Import("env")  # noqa: F821 (SCons builtin)
+except NameError:
+    env = None
+
+if env is not None:
+    nm = env.subst("$CC").replace("gcc", "nm")
+    env.AddCustomTarget(
+        name="memreport",
+        dependencies="$BUILD_DIR/${PROGNAME}.elf",
+        actions='"$PYTHONEXE" "$PROJECT_DIR/tools/memreport.py" "$BUILD_DIR/${PROGNAME}.elf" --nm "%s"' % nm,
+        title="Memory report",
+        description="Per-symbol RAM / flash placement, fails on hot code out of ITCM or cold data in DTCM",
+    )
+elif __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,113 @@
+// Host benchmark of the tick-rate modulation engine (see Modulation.h).
+//
+//   g++ -O2 -Iinclude tools/modbench.cpp src/Modulation.cpp -o modbench && ./modbench
+//
+// Runs ModEngine::tick() for all four tracks at 24 PPQN and 120 BPM, with every
+// message accepted as if the port were idle. The wire is only limited by the
+// engine's own byte budget. Each load is timed over 200 000 ticks (cost per tick,
+// all tracks) and played for 60 s of simulated time (bytes/s actually sent,
+// updates held back by the budget), against the 30 % share of DIN's 3125 B/s.
+//   idle        everything off
+//   lfo cc      a sine LFO at full depth and the fastest rate on CC 74
+//   lfo + env   the same, plus an envelope on pitch bend retriggered every 16th
+//   s&h bend    random S&H on pitch bend at 1/16, plus the envelope on CC 71
+// Also checks that pitch bend driven by an envelope alone rests at the centre
+// (8192) once the envelope has decayed, and that a stop re-centres it.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "Modulation.h"
+
+static double nowUs(){
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t sentBytes = 0;
+static int32_t lastBend[NUM_CHANNELS];
+
+static bool countSend(uint8_t track, uint8_t dest, uint16_t value){
+  sentBytes += 3;
+  if (dest == MOD_DEST_PITCHBEND) lastBend[track] = value;
+  return true;
+}
+
+struct Load {
+  const char* name;
+  LfoParams lfo;
+  EnvParams env;
+};
+
+static const uint32_t TICK_US = 60000000UL / 120 / 24;
+static const uint32_t TICKS_PER_16TH = 6;
+
+static void run(const Load& load){
+  LfoParams lfo[NUM_CHANNELS];
+  EnvParams env[NUM_CHANNELS];
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++) { lfo[t] = load.lfo; env[t] = load.env; }
+  ModEngine mod;
+  mod.init();
+
+  // cost: simulated time still advances, so the budget behaves as on the device
+  const uint32_t timedTicks = 200000;
+  uint32_t now = 0;
+  double t0 = nowUs();
+  for (uint32_t i = 0; i < timedTicks; i++){
+    if (i % TICKS_PER_16TH == 0) for (uint8_t t = 0; t < NUM_CHANNELS; t++) mod.noteOn(t);
+    mod.tick(lfo, env, now, countSend);
+    now += TICK_US;
+  }
+  double nsPerTick = (nowUs() - t0) * 1000.0 / timedTicks;
+
+  // wire: 60 s from a fresh engine
+  mod.init();
+  mod.bytesSent = mod.deferred = 0;
+  sentBytes = 0;
+  const uint32_t seconds = 60;
+  now = 0;
+  for (uint32_t i = 0; i < seconds * 1000000UL / TICK_US; i++){
+    if (i % TICKS_PER_16TH == 0) for (uint8_t t = 0; t < NUM_CHANNELS; t++) mod.noteOn(t);
+    mod.tick(lfo, env, now, countSend);
+    now += TICK_US;
+  }
+  double bps = (double)mod.bytesSent / seconds;
+  printf("%-10s %7.1f ns/tick  %6.1f B/s (%4.1f %% of the wire)  %6.1f updates/s held back\n",
+         load.name, nsPerTick, bps, bps * 100.0 / MIDI_WIRE_BYTES_PER_SEC, (double)mod.deferred / seconds);
+}
+
+// An envelope alone on pitch bend must come back to the centre, not to 0
+static bool checkEnvBendRest(){
+  LfoParams lfo[NUM_CHANNELS];
+  EnvParams env[NUM_CHANNELS];
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    lfo[t] = LFO_DEFAULT_PARAMS;
+    env[t] = EnvParams{1, 3, 127, MOD_DEST_PITCHBEND};
+    lastBend[t] = -1;
+  }
+  ModEngine mod;
+  mod.init();
+  uint32_t now = 0;
+  bool ok = true;
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++) mod.noteOn(t);
+  // a second of ticks: the budget covers it and the envelope (4 ticks) is over
+  for (uint32_t i = 0; i < 48; i++) { mod.tick(lfo, env, now, countSend); now += TICK_US; }
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++) ok &= lastBend[t] == 8192;
+  printf("env-only pitch bend rests at %ld (want 8192): %s\n", (long)lastBend[0], ok ? "yes" : "NO");
+  return ok;
+}
+
+int main(){
+  const uint32_t budget = MIDI_WIRE_BYTES_PER_SEC * MOD_WIRE_SHARE_PCT / 100;
+  printf("4 tracks, 24 PPQN at 120 BPM (%u us/tick), budget %u B/s (%u %% of %u B/s)\n",
+         (unsigned)TICK_US, (unsigned)budget, (unsigned)MOD_WIRE_SHARE_PCT, (unsigned)MIDI_WIRE_BYTES_PER_SEC);
+  const Load loads[] = {
+    {"idle",      LFO_DEFAULT_PARAMS, ENV_DEFAULT_PARAMS},
+    {"lfo cc",    {LFO_SINE, 0, 127, 74}, ENV_DEFAULT_PARAMS},
+    {"lfo + env", {LFO_SINE, 0, 127, 74}, {1, 3, 127, MOD_DEST_PITCHBEND}},
+    {"s&h bend",  {LFO_RANDOM, 0, 127, MOD_DEST_PITCHBEND}, {1, 3, 127, 71}},
+  };
+  for (const Load& l : loads) run(l);
+  return checkEnvBendRest() ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// Host benchmark for the big OLED text path (see include/BigFont.h).
+//
+//   g++ -O2 -Iinclude tools/oledbench.cpp -o oledbench
+//
+//   oledbench [iterations]
+//
+// Renders the big-text parts of the full-screen views into a 128x64 page buffer
+// two ways and times each screen: through a model of the Adafruit_GFX text path
+// (drawChar -> fillRect per font pixel -> drawFastVLine -> writeLine -> virtual
+// drawPixel with bounds and rotation checks, as in Adafruit_GFX / Adafruit_GrayOLED)
+// and through the glyph cache. Both buffers must come out identical.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "BigFont.h"
+
+static const int16_t OLED_W = 128;
+static const int16_t OLED_H = 64;
+
+static double nowNs(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// The GFX calls the firmware's text goes through, on the same page layout
+class GfxModel {
+  public:
+    explicit GfxModel(uint8_t* b) : buffer(b) {}
+    virtual ~GfxModel() {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color){
+      if (x < 0 || x >= OLED_W || y < 0 || y >= OLED_H) return;
+      switch (rotation){
+        case 1: { int16_t t = x; x = OLED_W - y - 1; y = t; break; }
+        case 2: x = OLED_W - x - 1; y = OLED_H - y - 1; break;
+        case 3: { int16_t t = x; x = y; y = OLED_H - t - 1; break; }
+      }
+      uint8_t* p = &buffer[x + (y / 8) * OLED_W];
+      if (color) *p |= (1 << (y & 7)); else *p &= ~(1 << (y & 7));
+    }
+
+    void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+      bool steep = abs(y1 - y0) > abs(x1 - x0);
+      if (steep) { int16_t t = x0; x0 = y0; y0 = t; t = x1; x1 = y1; y1 = t; }
+      if (x0 > x1) { int16_t t = x0; x0 = x1; x1 = t; t = y0; y0 = y1; y1 = t; }
+      int16_t dx = x1 - x0, dy = abs(y1 - y0);
+      int16_t err = dx / 2;
+      int16_t ystep = (y0 < y1) ? 1 : -1;
+      for (; x0 <= x1; x0++){
+        if (steep) drawPixel(y0, x0, color); else drawPixel(x0, y0, color);
+        err -= dy;
+        if (err < 0) { y0 += ystep; err += dx; }
+      }
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color){
+      for (int16_t i = x; i < x + w; i++) writeLine(i, y, i, y + h - 1, color);
+    }
+
+    void drawChar(int16_t x, int16_t y, char c, uint8_t size){
+      if (!bigFontHas(c)) return;
+      const uint8_t* glyph = BIG_FONT_5X7[BIG_FONT_MAP.index[(uint8_t)c]];
+      for (int8_t i = 0; i < BIG_FONT_GLYPH_COLS; i++){
+        uint8_t line = glyph[i];
+        for (int8_t j = 0; j < 8; j++, line >>= 1){
+          if (line & 1) fillRect(x + i * size, y + j * size, size, size, 1);
+        }
+      }
+    }
+
+    uint8_t rotation = 0;
+
+  private:
+    uint8_t* buffer;
+};
+
+struct BigText {
+  int16_t x, y;
+  uint8_t size;
+  const char* text;
+};
+
+struct Screen {
+  const char* name;
+  BigText items[3];
+  uint8_t count;
+};
+
+// Label and value of each big view, at the firmware's positions
+static const Screen SCREENS[] = {
+  { "bpm",      { {4, 2, 2, "BPM"},    {4, 26, 4, "128"} },   2 },
+  { "note",     { {4, 2, 2, "NOTE"},   {4, 26, 4, "C#3"} },   2 },
+  { "gate",     { {4, 2, 2, "GATE"},   {4, 26, 4, "1/16"} },  2 },
+  { "prob",     { {4, 2, 2, "PROB"},   {4, 26, 4, "100%"} },  2 },
+  { "retrig",   { {4, 2, 2, "RETRIG"}, {4, 26, 4, "1/32"} },  2 },
+  { "route",    { {4, 2, 2, "ROUTE"},  {4, 28, 3, "USB 16"} }, 2 },
+  { "overview", { {4, 16, 3, "G#4"},   {76, 18, 2, "1/8"} },  2 },
+};
+static const uint8_t NUM_SCREENS = sizeof(SCREENS) / sizeof(SCREENS[0]);
+
+static void drawGfx(GfxModel& gfx, const Screen& s){
+  for (uint8_t i = 0; i < s.count; i++){
+    const BigText& t = s.items[i];
+    int16_t x = t.x;
+    for (const char* c = t.text; *c; c++, x += 6 * t.size) gfx.drawChar(x, t.y, *c, t.size);
+  }
+}
+
+static void drawCached(uint8_t* buf, const Screen& s){
+  for (uint8_t i = 0; i < s.count; i++){
+    const BigText& t = s.items[i];
+    int16_t x = t.x;
+    for (const char* c = t.text; *c; c++, x += 6 * t.size) bigFontBlit(buf, OLED_W, OLED_H, x, t.y, *c, t.size);
+  }
+}
+
+int main(int argc, char** argv){
+  int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+  if (iterations < 1) iterations = 1;
+  static uint8_t gfxBuf[OLED_W * OLED_H / 8], cacheBuf[OLED_W * OLED_H / 8];
+  GfxModel gfx(gfxBuf);
+  bool same = true;
+  double gfxTotal = 0, cacheTotal = 0;
+
+  printf("%d renders per screen, us per screen (buffer clear included)\n", iterations);
+  printf("screen       gfx      cache   speedup  pixels\n");
+  for (uint8_t n = 0; n < NUM_SCREENS; n++){
+    const Screen& s = SCREENS[n];
+    double t0 = nowNs();
+    for (int i = 0; i < iterations; i++){
+      memset(gfxBuf, 0, sizeof(gfxBuf));
+      drawGfx(gfx, s);
+    }
+    double gfxUs = (nowNs() - t0) / iterations / 1000;
+    t0 = nowNs();
+    for (int i = 0; i < iterations; i++){
+      memset(cacheBuf, 0, sizeof(cacheBuf));
+      drawCached(cacheBuf, s);
+    }
+    double cacheUs = (nowNs() - t0) / iterations / 1000;
+    bool match = memcmp(gfxBuf, cacheBuf, sizeof(gfxBuf)) == 0;
+    same &= match;
+    uint32_t lit = 0;
+    for (uint16_t b = 0; b < sizeof(cacheBuf); b++) lit += __builtin_popcount(cacheBuf[b]);
+    printf("%-9s %7.2f  %7.2f  %7.1fx  %5u%s\n", s.name, gfxUs, cacheUs, gfxUs / cacheUs, (unsigned)lit,
+           match ? "" : "  MISMATCH");
+    gfxTotal += gfxUs;
+    cacheTotal += cacheUs;
+  }
+  printf("all       %7.2f  %7.2f  %7.1fx\n", gfxTotal, cacheTotal, gfxTotal / cacheTotal);
+  printf(same ? "buffers identical\n" : "buffers differ\n");
+  return same ? 0 : 1;
+}
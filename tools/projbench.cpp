@@ -0,0 +1,150 @@
+// Host benchmark of the SD project store (see ProjectStore.h) on its POSIX
+// backend.
+//
+//   g++ -O2 -Iinclude tools/projbench.cpp src/ProjectStore.cpp -o projbench
+//
+//   projbench [path] [passes]
+//
+// Builds a project file at `path` (default /tmp/projbench.sqp, removed
+// afterwards) holding all PROJECT_BANKS x PROJECT_PATTERNS_PER_BANK records, at
+// the stride the firmware uses and filled with valid save records (header, random
+// payload, CRC). It then measures:
+//   save     writeRecord() of every record, as the Fn + Enc1 project save does
+//   load     readRecord() of every record, a blocking whole-record read
+//   stream   requestRecord() + service() until ready + takeRecord(), in random
+//            order, as a cue does. service() reads PROJECT_READ_CHUNK bytes per
+//            call, so the report gives the calls per record (loop passes to stream
+//            one pattern) and the worst single call, which bounds the time one
+//            storage task run can take.
+// Every streamed record is checked against what was written, and its header and
+// CRC must pass saveRecordBytes(). A Linux page cache is far faster than a Teensy
+// SD card, so the times here are the store's own overhead, not the card's.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include "ProjectStore.h"
+#include "SaveFormat.h"
+
+static double nowUs(){
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t rng = 0x2545F491UL;
+static uint32_t nextRandom(){
+  rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+  return rng;
+}
+
+// A valid record of `payloadBytes` random bytes
+static uint16_t makeRecord(uint8_t* rec, uint16_t payloadBytes){
+  uint8_t* payload = rec + sizeof(SaveSlotHeader);
+  for (uint16_t i = 0; i < payloadBytes; i++) payload[i] = (uint8_t)nextRandom();
+  SaveSlotHeader h;
+  h.version = SAVE_VERSION;
+  h.reserved = 0;
+  h.payloadBytes = payloadBytes;
+  h.crc = crc16(payload, payloadBytes);
+  memcpy(rec, &h, sizeof(h));
+  return sizeof(h) + payloadBytes;
+}
+
+static void report(const char* name, uint32_t records, uint32_t bytes, double us){
+  printf("%-7s %5u records  %8.1f us  %7.2f us/record  %8.2f MB/s\n",
+         name, (unsigned)records, us, us / records, bytes / us);
+}
+
+int main(int argc, char** argv){
+  const char* path = argc > 1 ? argv[1] : "/tmp/projbench.sqp";
+  int passes = argc > 2 ? atoi(argv[2]) : 20;
+  if (passes < 1) passes = 1;
+  remove(path);
+
+  ProjectStore store;
+  // The firmware opens projects at the fixed maximum stride (see beginProject())
+  const uint16_t stride = PROJECT_MAX_RECORD_BYTES;
+  if (!store.begin() || !store.open(path, stride)){
+    fprintf(stderr, "projbench: can't create %s\n", path);
+    return 1;
+  }
+  const uint16_t n = store.recordCount();
+  printf("%u records, %u B stride, %u B payload max, %u B per service() call, %d passes\n",
+         (unsigned)n, (unsigned)stride, (unsigned)SAVE_PAYLOAD_MAX_BYTES, (unsigned)PROJECT_READ_CHUNK, passes);
+
+  // Payload sizes vary like real patterns: from nearly empty to a full slot
+  std::vector<std::vector<uint8_t>> written(n, std::vector<uint8_t>(stride, 0xFF));
+  std::vector<uint16_t> lens(n);
+  for (uint16_t i = 0; i < n; i++){
+    uint16_t payload = (uint16_t)(64 + nextRandom() % (SAVE_PAYLOAD_MAX_BYTES - 63));
+    lens[i] = makeRecord(written[i].data(), payload);
+  }
+
+  double saveUs = 0;
+  for (int p = 0; p < passes; p++){
+    double t0 = nowUs();
+    for (uint16_t i = 0; i < n; i++){
+      if (!store.writeRecord(i, written[i].data(), lens[i])) { fprintf(stderr, "projbench: write %u failed\n", i); return 1; }
+    }
+    saveUs += nowUs() - t0;
+  }
+  report("save", n * passes, (uint32_t)n * stride * passes, saveUs);
+
+  uint8_t rec[PROJECT_MAX_RECORD_BYTES];
+  double loadUs = 0;
+  for (int p = 0; p < passes; p++){
+    double t0 = nowUs();
+    for (uint16_t i = 0; i < n; i++) store.readRecord(i, rec);
+    loadUs += nowUs() - t0;
+  }
+  report("load", n * passes, (uint32_t)n * stride * passes, loadUs);
+
+  std::vector<uint16_t> order(n);
+  for (uint16_t i = 0; i < n; i++) order[i] = i;
+  double streamUs = 0, worstCallUs = 0;
+  uint32_t calls = 0, maxCalls = 0, bad = 0;
+  for (int p = 0; p < passes; p++){
+    for (uint16_t i = n - 1; i > 0; i--) std::swap(order[i], order[nextRandom() % (i + 1)]);
+    for (uint16_t k = 0; k < n; k++){
+      uint16_t idx = order[k];
+      double t0 = nowUs();
+      store.requestRecord(idx);
+      uint32_t c = 0;
+      while (!store.recordReady()){
+        double c0 = nowUs();
+        store.service();
+        double dt = nowUs() - c0;
+        if (dt > worstCallUs) worstCallUs = dt;
+        c++;
+      }
+      const uint8_t* got = store.takeRecord();
+      streamUs += nowUs() - t0;
+      calls += c;
+      if (c > maxCalls) maxCalls = c;
+      if (!got || store.readyIndex() != -1 || memcmp(got, written[idx].data(), stride) != 0 ||
+          saveRecordBytes(got, stride) != lens[idx]) bad++;
+    }
+  }
+  report("stream", n * passes, (uint32_t)n * stride * passes, streamUs);
+  printf("stream  %.1f service() calls/record (max %u), worst call %.2f us\n",
+         (double)calls / (n * passes), (unsigned)maxCalls, worstCallUs);
+  printf("stream  %u of %u records differ from what was written or fail the CRC\n",
+         (unsigned)bad, (unsigned)(n * passes));
+
+  // Past EOF (a fresh project where the record was never written) reads as empty
+  store.close();
+  remove(path);
+  if (!store.open(path, stride)) return 1;
+  store.requestRecord(n - 1);
+  while (!store.recordReady()) store.service();
+  const uint8_t* empty = store.takeRecord();
+  bool emptyOk = empty && saveRecordBytes(empty, stride) == 0;
+  printf("unwritten record reads as empty: %s\n", emptyOk ? "yes" : "NO");
+  store.close();
+  remove(path);
+  return (bad == 0 && emptyOk) ? 0 : 1;
+}
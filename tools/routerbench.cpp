@@ -0,0 +1,164 @@
+// Host benchmark of the multi-port output router (see MidiRouter.h).
+//
+//   g++ -O2 -Iinclude tools/routerbench.cpp src/MidiRouter.cpp -o routerbench
+//
+//   routerbench [seconds]
+//
+// Throughput: the cost of one send() on the PC, straight through to a port with
+// room, and through the queue (the port is full, service() moves it on later).
+//
+// Isolation: 16 tracks play at 300 BPM, as the clock ISR sends them, into two
+// FakeMidiPorts: DIN (3125 B/s behind the 8-byte UART_MIDI_WINDOW) and USB
+// (100 kB/s, 64-byte buffer). service() runs every 1 ms. Three loads:
+//   light      DIN tracks 1-4 and USB tracks 5-8 send a note-off / note-on per step
+//   din flood  as light, plus DIN tracks 9-16 ratcheting with a CC on every tick:
+//              more than DIN carries, so its queue fills and drops
+//   usb flood  as light, plus USB tracks 9-16 ratcheting with a CC on every tick:
+//              72 bytes a tick, more than the USB buffer takes at once
+// For each port: messages sent, how many waited in the queue, their average and
+// worst wait (queue to backend), drops and the line load. The run fails unless
+// each port's worst wait is the same whether or not the other port is flooded.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "MidiRouter.h"
+
+static const uint32_t BPM = 300;
+static const uint32_t TICK_US = 60000000UL / BPM / 24;
+static const uint32_t ENGINE_US = 1000;
+static const uint32_t DIN_BYTES_PER_SEC = 3125;
+static const uint32_t USB_BYTES_PER_SEC = 100000;
+
+static uint32_t simNow = 0;
+static uint32_t clockFn() { return simNow; }
+
+static double nowUs(){
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Always has room (straight-through path) or never (queue path)
+class NullPort : public MidiPortBackend {
+  public:
+    int availableForWrite() override { return room; }
+    void write(const uint8_t*, uint8_t len) override { bytes += len; }
+    int room = 64;
+    uint32_t bytes = 0;
+};
+
+// FakeMidiPort behind a UART-style window of `window` bytes ahead of the wire
+class WindowPort : public MidiPortBackend {
+  public:
+    WindowPort(uint32_t bytesPerSec, uint16_t buffer, uint16_t window) : port(bytesPerSec, buffer), buffer(buffer), window(window) {}
+    int availableForWrite() override {
+      port.advance(simNow);
+      int free = port.availableForWrite();
+      int room = window - (buffer - free);
+      return room > 0 ? room : 0;
+    }
+    void write(const uint8_t* b, uint8_t len) override { port.write(b, len); }
+    uint32_t bytes() const { return port.bytes; }
+  private:
+    FakeMidiPort port;
+    uint16_t buffer, window;
+};
+
+static void throughput(){
+  const uint32_t n = 10000000;
+  MidiRouter router;
+  NullPort null;
+  router.begin(clockFn);
+  router.addPort(MIDI_PORT_DIN, &null, true);
+  double t0 = nowUs();
+  for (uint32_t i = 0; i < n; i++) router.send(i & 15, 0x90, i & 0x7F, 100);
+  double direct = (nowUs() - t0) * 1000.0 / n;
+
+  // queue path: fill the queue while the port has no room, then drain it
+  uint32_t queued = 0;
+  t0 = nowUs();
+  for (uint32_t i = 0; i < n / MIDI_PORT_QUEUE; i++){
+    null.room = 0;
+    for (uint8_t k = 0; k < MIDI_PORT_QUEUE; k++) router.send(k & 15, 0x90, k, 100);
+    null.room = 3 * MIDI_PORT_QUEUE;
+    router.service();
+    queued += MIDI_PORT_QUEUE;
+  }
+  double viaQueue = (nowUs() - t0) * 1000.0 / queued;
+  printf("send() straight through  %6.1f ns/msg  (%5.1f M msgs/s)\n", direct, 1000.0 / direct);
+  printf("send() + queue + service %6.1f ns/msg  (%5.1f M msgs/s)\n", viaQueue, 1000.0 / viaQueue);
+}
+
+struct PortResult {
+  MidiPortStats stats;
+  uint32_t loadPct;
+};
+
+static void run(uint8_t load, uint32_t seconds, PortResult& din, PortResult& usb){
+  simNow = 0;
+  MidiRouter router;
+  WindowPort dinPort(DIN_BYTES_PER_SEC, 40, UART_MIDI_WINDOW);
+  WindowPort usbPort(USB_BYTES_PER_SEC, 64, 64);
+  router.begin(clockFn);
+  router.addPort(MIDI_PORT_DIN, &dinPort, true);
+  router.addPort(MIDI_PORT_USB, &usbPort, true);
+  for (uint8_t t = 0; t < MIDI_MAX_TRACKS; t++){
+    bool toUsb = (t >= 4 && t < 8) || (t >= 8 && load == 2);
+    router.route[t] = TrackRoute{(uint8_t)(toUsb ? MIDI_PORT_USB : MIDI_PORT_DIN), (uint8_t)t};
+  }
+
+  uint32_t nextTick = 0, nextEngine = 300, tick = 0;
+  uint32_t end = seconds * 1000000UL;
+  for (simNow = 0; simNow < end; simNow += 10){
+    if (simNow >= nextTick){
+      router.sendRealtime(0xF8);
+      bool stepStart = tick % 6 == 0;
+      for (uint8_t t = 0; t < MIDI_MAX_TRACKS; t++){
+        bool flood = t >= 8 && load != 0;
+        if (!flood && !(t < 8 && stepStart)) continue;
+        if (flood) router.send(t, 0xB0, 74, tick & 0x7F);
+        router.send(t, 0x90, 60 + t, 0);
+        router.send(t, 0x90, 60 + t, 100);
+      }
+      tick++;
+      nextTick += TICK_US;
+    }
+    if (simNow >= nextEngine){
+      router.service();
+      nextEngine += ENGINE_US;
+    }
+  }
+  din.stats = router.stats(MIDI_PORT_DIN);
+  usb.stats = router.stats(MIDI_PORT_USB);
+  din.loadPct = (uint32_t)((uint64_t)dinPort.bytes() * 100 / ((uint64_t)DIN_BYTES_PER_SEC * seconds));
+  usb.loadPct = (uint32_t)((uint64_t)usbPort.bytes() * 100 / ((uint64_t)USB_BYTES_PER_SEC * seconds));
+}
+
+static void print(const char* load, const char* port, const PortResult& r){
+  const MidiPortStats& s = r.stats;
+  printf("%-10s %-4s %7u %7u  %6u %6u  %7u  %3u%%\n", load, port, (unsigned)s.sent, (unsigned)s.queued,
+         (unsigned)(s.queued ? s.totalLatencyUs / s.queued : 0), (unsigned)s.maxLatencyUs, (unsigned)s.dropped,
+         (unsigned)r.loadPct);
+}
+
+int main(int argc, char** argv){
+  uint32_t seconds = argc > 1 ? (uint32_t)atol(argv[1]) : 60;
+  if (seconds < 1) seconds = 1;
+  throughput();
+
+  const char* names[] = {"light", "din flood", "usb flood"};
+  PortResult din[3], usb[3];
+  printf("\n%u s per load at %u BPM, waits in us from send() to the backend\n", (unsigned)seconds, (unsigned)BPM);
+  printf("load       port    sent  queued  avg wait  max   dropped  line\n");
+  for (uint8_t load = 0; load < 3; load++){
+    run(load, seconds, din[load], usb[load]);
+    print(names[load], "DIN", din[load]);
+    print(names[load], "USB", usb[load]);
+  }
+  // a flood on one port must not change what the other one sees
+  bool ok = usb[1].stats.maxLatencyUs == usb[0].stats.maxLatencyUs && usb[1].stats.dropped == 0 &&
+            din[2].stats.maxLatencyUs == din[0].stats.maxLatencyUs && din[2].stats.dropped == 0;
+  printf(ok ? "each port unaffected by a flood on the other\n" : "FAILED: a flood on one port delayed the other\n");
+  return ok ? 0 : 1;
+}
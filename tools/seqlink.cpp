@@ -0,0 +1,682 @@
+// Host side of the USB serial link (see include/SerialLink.h).
+//
+//   g++ -O2 -Iinclude tools/seqlink.cpp src/SerialLink.cpp -o seqlink
+//
+//   seqlink <port> ping
+//   seqlink <port> get|put pattern <file>
+//   seqlink <port> get|put settings <file>
+//   seqlink <port> get|put slot <n> <file>         n = 1..slots
+//   seqlink <port> get|put project <n> <file>      n = 1..256 (bank * 16 + pattern)
+//   seqlink <port> get-bank|put-bank <bank> <dir>  bank = 1..16, files 01.bin..16.bin
+//   seqlink <port> bench [count]                   PUT / GET round trips of one pattern
+//   seqlink <port> telemetry [csv|json] [seconds]  decode the engine telemetry stream
+//   seqlink <port> trace <file.bin>                freeze and dump the event trace
+//   seqlink decode <file.bin>                      trace as text
+//   seqlink chrome <file.bin> <file.json>          trace for chrome://tracing / Perfetto
+//   seqlink serve                                  device stand-in on a new pty
+//
+// <port> is the Teensy's serial device (/dev/ttyACM0), or "pty" to run the command
+// against a stand-in forked on a pseudo terminal, e.g. `seqlink pty bench 2000`.
+// Text the firmware prints between frames is copied to stderr.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "SerialLink.h"
+#include "SaveFormat.h"
+#include "Telemetry.h"
+#include "Trace.h"
+
+static const int REPLY_TIMEOUT_MS = 1000;
+static const int RETRIES = 3;
+static const uint8_t RECORD_HEADER_BYTES = sizeof(SaveSlotHeader);
+static const uint8_t BANK_PATTERNS = 16;
+static const uint16_t PROJECT_RECORDS = 256;
+static const uint16_t RECORD_MAX_BYTES = SAVE_SLOT_MAX_BYTES;
+
+static const char* const ERROR_NAMES[] = { "none", "bad type", "index out of range", "empty",
+                                           "record rejected", "busy", "I/O error", "no SD project", "EEPROM full" };
+
+static uint32_t nowMs(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static double nowSeconds(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool writeAll(int fd, const uint8_t* p, size_t n){
+  while (n){
+    ssize_t w = write(fd, p, n);
+    if (w < 0) { if (errno == EINTR || errno == EAGAIN) continue; return false; }
+    p += w;
+    n -= w;
+  }
+  return true;
+}
+
+static bool setRaw(int fd){
+  struct termios t;
+  if (tcgetattr(fd, &t) != 0) return false;
+  cfmakeraw(&t);
+  cfsetispeed(&t, B115200); // ignored by USB CDC, which always runs at full USB speed
+  cfsetospeed(&t, B115200);
+  t.c_cc[VMIN] = 0;
+  t.c_cc[VTIME] = 0;
+  return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+// Same check the firmware applies before storing a record
+static uint16_t recordBytes(const uint8_t* rec, size_t avail){
+  if (avail < RECORD_HEADER_BYTES) return 0;
+  uint8_t version = rec[0];
+  uint16_t payload = rec[2] | (rec[3] << 8);
+  uint16_t crc = rec[4] | (rec[5] << 8);
+  if (version == 0 || version == 0xFF || payload == 0 || (size_t)RECORD_HEADER_BYTES + payload > avail) return 0;
+  if (crc16(rec + RECORD_HEADER_BYTES, payload) != crc) return 0;
+  return RECORD_HEADER_BYTES + payload;
+}
+
+// --- DEVICE STAND-IN ---
+// Answers like the firmware, with every object held in RAM, so the protocol and the
+// host side can be exercised (and timed) without hardware.
+struct StandIn {
+  static const uint8_t SLOTS = SAVE_NUM_SLOTS;
+  uint8_t pattern[RECORD_MAX_BYTES];
+  uint8_t slots[SLOTS][RECORD_MAX_BYTES];
+  uint8_t project[PROJECT_RECORDS][RECORD_MAX_BYTES];
+  uint8_t settings[64];
+  uint16_t settingsLen = 16;
+  uint8_t tx[LINK_MAX_FRAME];
+  bool streaming = false;
+  TraceRecord trace[1000];
+  uint16_t traceCount = 0;
+
+  StandIn(){
+    memset(pattern, 0xFF, sizeof(pattern));
+    memset(slots, 0xFF, sizeof(slots));
+    memset(project, 0xFF, sizeof(project));
+    memset(settings, 0, sizeof(settings));
+    settings[0] = 1;
+    // two bars at 120 BPM on a 600 MHz cycle counter, wrapping part way through
+    uint32_t t = 0xFFFFFFFFUL - 600000000UL;
+    const uint32_t tickCycles = 600000000UL / 48;
+    for (uint16_t tick = 0; traceCount + 6 <= 1000; tick++){
+      t += tickCycles;
+      trace[traceCount++] = { t, TR_TICK, 0, tick };
+      trace[traceCount++] = { t + 5000, TR_CLOCK_ISR, 0, 300 };
+      if (tick % 6 == 0){
+        trace[traceCount++] = { t + 9000, TR_STEP, (uint8_t)(tick / 6 % 16), (uint16_t)(tick / 96) };
+        trace[traceCount++] = { t + 12000, TR_NOTE_ON, (uint8_t)(tick / 6 % 4), (uint16_t)(36 | (100 << 8)) };
+        trace[traceCount++] = { t + 15000, TR_ENGINE_ISR, 2, 400 };
+      }
+      if (tick % 6 == 3) trace[traceCount++] = { t + 12000, TR_NOTE_OFF, (uint8_t)(tick / 6 % 4), 36 };
+    }
+  }
+
+  void reply(int fd, uint8_t type, uint8_t seq, const uint8_t* p, uint16_t len){
+    writeAll(fd, tx, linkEncode(type, seq, p, len, tx));
+  }
+  void nak(int fd, uint8_t seq, uint8_t err){ reply(fd, LINK_NAK, seq, &err, 1); }
+
+  uint8_t* object(uint8_t obj, uint16_t index){
+    if (obj == LINK_OBJ_PATTERN) return pattern;
+    if (obj == LINK_OBJ_SLOT) return index < SLOTS ? slots[index] : nullptr;
+    if (obj == LINK_OBJ_PROJECT) return index < PROJECT_RECORDS ? project[index] : nullptr;
+    return nullptr;
+  }
+
+  void handle(int fd, const LinkParser& f){
+    if (f.type == LINK_PING){
+      uint8_t info[8] = { LINK_PROTOCOL_VERSION, SAVE_VERSION, SLOTS, LINK_MAX_PAYLOAD & 0xFF, LINK_MAX_PAYLOAD >> 8,
+                          PROJECT_RECORDS & 0xFF, PROJECT_RECORDS >> 8, 1 };
+      reply(fd, LINK_ACK, f.seq, info, sizeof(info));
+      return;
+    }
+    if (f.type == LINK_STREAM && f.len == 1){
+      streaming = f.payload[0] != 0;
+      reply(fd, LINK_ACK, f.seq, nullptr, 0);
+      return;
+    }
+    if ((f.type != LINK_GET && f.type != LINK_PUT) || f.len < 3 || f.payload[0] > LINK_OBJ_TRACE) { nak(fd, f.seq, LINK_ERR_TYPE); return; }
+    uint8_t obj = f.payload[0];
+    uint16_t index = f.payload[1] | (f.payload[2] << 8);
+    uint8_t* rec = object(obj, index);
+    if (obj < LINK_OBJ_SETTINGS && !rec) { nak(fd, f.seq, LINK_ERR_RANGE); return; }
+    const uint8_t* data = f.payload + 3;
+    uint16_t dataLen = f.len - 3;
+
+    if (obj == LINK_OBJ_TRACE){
+      if (f.type == LINK_PUT) { reply(fd, LINK_ACK, f.seq, nullptr, 0); return; }
+      uint32_t first = (uint32_t)index * TRACE_CHUNK_RECORDS;
+      if (first > traceCount) { nak(fd, f.seq, LINK_ERR_RANGE); return; }
+      uint16_t n = traceCount - first < TRACE_CHUNK_RECORDS ? traceCount - first : TRACE_CHUNK_RECORDS;
+      uint8_t out[LINK_MAX_PAYLOAD] = { f.payload[0], f.payload[1], f.payload[2],
+                                        (uint8_t)(traceCount & 0xFF), (uint8_t)(traceCount >> 8), 600 & 0xFF, 600 >> 8,
+                                        (uint8_t)(first & 0xFF), (uint8_t)(first >> 8), 0, 0 };
+      for (uint16_t i = 0; i < n; i++) tracePack(trace[first + i], out + 3 + TRACE_CHUNK_HEADER + i * TRACE_RECORD_BYTES);
+      reply(fd, LINK_DATA, f.seq, out, 3 + TRACE_CHUNK_HEADER + n * TRACE_RECORD_BYTES);
+      return;
+    }
+
+    if (f.type == LINK_GET){
+      uint8_t out[3 + RECORD_MAX_BYTES];
+      memcpy(out, f.payload, 3);
+      uint16_t len = obj == LINK_OBJ_SETTINGS ? settingsLen : recordBytes(rec, RECORD_MAX_BYTES);
+      if (len == 0) { nak(fd, f.seq, LINK_ERR_EMPTY); return; }
+      memcpy(out + 3, obj == LINK_OBJ_SETTINGS ? settings : rec, len);
+      reply(fd, LINK_DATA, f.seq, out, 3 + len);
+      return;
+    }
+    if (obj == LINK_OBJ_SETTINGS){
+      if (dataLen == 0 || dataLen > sizeof(settings)) { nak(fd, f.seq, LINK_ERR_RECORD); return; }
+      memcpy(settings, data, dataLen);
+      settingsLen = dataLen;
+    } else {
+      uint16_t len = recordBytes(data, dataLen);
+      if (len == 0 || len != dataLen || len > RECORD_MAX_BYTES) { nak(fd, f.seq, LINK_ERR_RECORD); return; }
+      if (obj == LINK_OBJ_SLOT){
+        // slots share the EEPROM data area at their actual lengths
+        uint32_t used = len;
+        for (uint8_t i = 0; i < SLOTS; i++) if (i != index) used += recordBytes(slots[i], RECORD_MAX_BYTES);
+        if (used > SAVE_DATA_BYTES) { nak(fd, f.seq, LINK_ERR_FULL); return; }
+      }
+      memset(rec, 0xFF, RECORD_MAX_BYTES);
+      memcpy(rec, data, len);
+    }
+    reply(fd, LINK_ACK, f.seq, nullptr, 0);
+  }
+
+  // Synthetic 120 BPM playback while streaming: a step every 125 ms, a kick on
+  // every beat, tempo / queue samples every TELEMETRY_STATUS_MS
+  void stream(int fd, TelemetryRing& ring, uint32_t& nextStepMs, uint32_t& nextStatusMs, uint8_t& step, uint8_t& frameSeq){
+    uint32_t now = nowMs();
+    if ((int32_t)(now - nextStepMs) >= 0){
+      nextStepMs += 125;
+      step = (step + 1) % 16;
+      ring.push(TEL_STEP, now * 1000, step, 2);
+      if (step % 4 == 0) ring.push(TEL_NOTE, now * 1000, 0, 36, 100);
+    }
+    if ((int32_t)(now - nextStatusMs) >= 0){
+      nextStatusMs += TELEMETRY_STATUS_MS;
+      ring.push(TEL_TEMPO, now * 1000, 2, 0, 0, 1200);
+      ring.push(TEL_QUEUE, now * 1000, 0, 0, 0, 8);
+    }
+    uint8_t payload[TELEMETRY_FRAME_RECORDS * TELEMETRY_RECORD_BYTES];
+    uint8_t n = 0;
+    TelemetryRecord r;
+    while (n < TELEMETRY_FRAME_RECORDS && ring.pop(r)) telemetryPack(r, payload + TELEMETRY_RECORD_BYTES * n++);
+    if (n) writeAll(fd, tx, linkEncode(LINK_TELEMETRY, frameSeq++, payload, n * TELEMETRY_RECORD_BYTES, tx));
+  }
+
+  void serve(int fd){
+    LinkParser rx;
+    TelemetryRing ring;
+    uint32_t nextStepMs = nowMs(), nextStatusMs = nowMs();
+    uint8_t step = 15, frameSeq = 0;
+    uint8_t buf[4096];
+    for (;;){
+      if (streaming) stream(fd, ring, nextStepMs, nextStatusMs, step, frameSeq);
+      else nextStepMs = nextStatusMs = nowMs();
+      struct pollfd p = { fd, POLLIN, 0 };
+      if (poll(&p, 1, TELEMETRY_FRAME_MS) <= 0) continue;
+      ssize_t n = read(fd, buf, sizeof(buf));
+      if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+      if (n < 0) { usleep(1000); continue; } // EIO until the slave side is opened
+      for (ssize_t i = 0; i < n; i++){
+        if (rx.feed(buf[i], nowMs()) == LINK_RX_FRAME) handle(fd, rx);
+      }
+    }
+  }
+};
+
+static int openPty(char* slaveName, size_t nameLen){
+  int m = posix_openpt(O_RDWR | O_NOCTTY);
+  if (m < 0 || grantpt(m) != 0 || unlockpt(m) != 0) return -1;
+  const char* name = ptsname(m);
+  if (!name) return -1;
+  snprintf(slaveName, nameLen, "%s", name);
+  return m;
+}
+
+// --- REQUESTS ---
+struct Link {
+  int fd = -1;
+  uint8_t seq = 0;
+  LinkParser rx;
+  uint8_t tx[LINK_MAX_FRAME];
+  uint8_t in[2048];
+  ssize_t inLen = 0, inPos = 0;
+
+  // Next received byte; bytes after a reply stay buffered for the next reader
+  bool nextByte(uint8_t& b, int timeoutMs){
+    if (inPos >= inLen){
+      struct pollfd p = { fd, POLLIN, 0 };
+      if (poll(&p, 1, timeoutMs) <= 0) return false;
+      inLen = read(fd, in, sizeof(in));
+      inPos = 0;
+      if (inLen <= 0) return false;
+    }
+    b = in[inPos++];
+    return true;
+  }
+
+  // Send one request and wait for the reply with the same seq. Retries on timeout
+  // or a corrupt reply; returns the reply type (rx holds it) or 0.
+  uint8_t request(uint8_t type, const uint8_t* payload, uint16_t len){
+    seq++;
+    uint16_t n = linkEncode(type, seq, payload, len, tx);
+    for (int attempt = 0; attempt < RETRIES; attempt++){
+      if (!writeAll(fd, tx, n)) return 0;
+      uint32_t start = nowMs();
+      while (nowMs() - start < (uint32_t)REPLY_TIMEOUT_MS){
+        uint8_t b;
+        if (!nextByte(b, 10)) continue;
+        LinkRx r = rx.feed(b, nowMs());
+        if (r == LINK_RX_PASS) fputc(b, stderr);
+        else if (r == LINK_RX_FRAME && rx.seq == seq && rx.type != LINK_TELEMETRY) return rx.type;
+      }
+      fprintf(stderr, "timeout, retrying (%d)\n", attempt + 1);
+    }
+    return 0;
+  }
+
+  bool expect(uint8_t got, uint8_t want){
+    if (got == want) return true;
+    if (got == LINK_NAK && rx.len == 1) {
+      uint8_t e = rx.payload[0];
+      fprintf(stderr, "device: %s\n", e < sizeof(ERROR_NAMES) / sizeof(ERROR_NAMES[0]) ? ERROR_NAMES[e] : "error");
+    } else if (got == 0) {
+      fprintf(stderr, "no reply\n");
+    } else {
+      fprintf(stderr, "unexpected reply 0x%02X\n", got);
+    }
+    return false;
+  }
+
+  // GET: bytes after the object / index echo land in `out`; returns their count or -1
+  int get(uint8_t obj, uint16_t index, uint8_t* out, bool quietEmpty = false){
+    uint8_t req[3] = { obj, (uint8_t)(index & 0xFF), (uint8_t)(index >> 8) };
+    uint8_t t = request(LINK_GET, req, sizeof(req));
+    if (quietEmpty && t == LINK_NAK && rx.len == 1 && rx.payload[0] == LINK_ERR_EMPTY) return 0;
+    if (!expect(t, LINK_DATA) || rx.len < 3) return -1;
+    memcpy(out, rx.payload + 3, rx.len - 3);
+    return rx.len - 3;
+  }
+
+  bool put(uint8_t obj, uint16_t index, const uint8_t* data, uint16_t len){
+    if (len + 3 > LINK_MAX_PAYLOAD) { fprintf(stderr, "object too large\n"); return false; }
+    uint8_t req[LINK_MAX_PAYLOAD];
+    req[0] = obj;
+    req[1] = index & 0xFF;
+    req[2] = index >> 8;
+    memcpy(req + 3, data, len);
+    return expect(request(LINK_PUT, req, len + 3), LINK_ACK);
+  }
+};
+
+static int readFile(const char* path, uint8_t* buf, size_t max){
+  FILE* f = fopen(path, "rb");
+  if (!f) return -1;
+  size_t n = fread(buf, 1, max, f);
+  fclose(f);
+  return (int)n;
+}
+
+static bool writeFile(const char* path, const uint8_t* buf, size_t n){
+  FILE* f = fopen(path, "wb");
+  if (!f) { perror(path); return false; }
+  bool ok = fwrite(buf, 1, n, f) == n;
+  fclose(f);
+  return ok;
+}
+
+static bool parseObject(const char* name, uint8_t* obj){
+  if (!strcmp(name, "pattern")) *obj = LINK_OBJ_PATTERN;
+  else if (!strcmp(name, "slot")) *obj = LINK_OBJ_SLOT;
+  else if (!strcmp(name, "project")) *obj = LINK_OBJ_PROJECT;
+  else if (!strcmp(name, "settings")) *obj = LINK_OBJ_SETTINGS;
+  else return false;
+  return true;
+}
+
+static int usage(){
+  fprintf(stderr,
+    "usage: seqlink <port|pty> ping\n"
+    "       seqlink <port|pty> get|put pattern|settings <file>\n"
+    "       seqlink <port|pty> get|put slot|project <n> <file>\n"
+    "       seqlink <port|pty> get-bank|put-bank <bank> <dir>\n"
+    "       seqlink <port|pty> bench [count]\n"
+    "       seqlink <port|pty> telemetry [csv|json] [seconds]\n"
+    "       seqlink <port|pty> trace <file.bin>\n"
+    "       seqlink decode <file.bin>\n"
+    "       seqlink chrome <file.bin> <file.json>\n"
+    "       seqlink serve\n");
+  return 2;
+}
+
+static int bench(Link& link, int count){
+  // a synthetic record of the largest size
+  uint8_t rec[SAVE_SLOT_BYTES];
+  for (size_t i = RECORD_HEADER_BYTES; i < sizeof(rec); i++) rec[i] = (uint8_t)(i * 37);
+  uint16_t payload = sizeof(rec) - RECORD_HEADER_BYTES;
+  uint16_t crc = crc16(rec + RECORD_HEADER_BYTES, payload);
+  rec[0] = SAVE_VERSION; rec[1] = 0;
+  rec[2] = payload & 0xFF; rec[3] = payload >> 8;
+  rec[4] = crc & 0xFF; rec[5] = crc >> 8;
+
+  // upload to an EEPROM slot (the live pattern would be replaced by noise)
+  double t0 = nowSeconds();
+  for (int i = 0; i < count; i++) if (!link.put(LINK_OBJ_SLOT, 0, rec, sizeof(rec))) return 1;
+  double up = nowSeconds() - t0;
+  uint8_t back[RECORD_MAX_BYTES];
+  t0 = nowSeconds();
+  for (int i = 0; i < count; i++){
+    if (link.get(LINK_OBJ_SLOT, 0, back) != (int)sizeof(rec) || memcmp(back, rec, sizeof(rec))) { fprintf(stderr, "readback mismatch\n"); return 1; }
+  }
+  double down = nowSeconds() - t0;
+  printf("%d x %u byte records\n", count, (unsigned)sizeof(rec));
+  printf("put: %8.1f records/s %8.1f KB/s  %6.3f ms/round trip\n", count / up, count * sizeof(rec) / up / 1024, up * 1000 / count);
+  printf("get: %8.1f records/s %8.1f KB/s  %6.3f ms/round trip\n", count / down, count * sizeof(rec) / down / 1024, down * 1000 / count);
+  printf("crc errors %u, timeouts %u\n", (unsigned)link.rx.crcErrors, (unsigned)link.rx.timeouts);
+  return 0;
+}
+
+// --- TELEMETRY DECODER ---
+static volatile sig_atomic_t stopRequested = 0;
+static void onSigint(int){ stopRequested = 1; }
+
+static void printRecord(const TelemetryRecord& r, bool json){
+  const char* kind = r.kind < TEL_NUM_KINDS ? TELEMETRY_KIND_NAMES[r.kind] : "?";
+  if (!json){
+    printf("%u,%u,%s,%u,%u,%u,%u\n", r.seq, r.timeUs, kind, r.a, r.b, r.c, r.d);
+    return;
+  }
+  printf("{\"seq\":%u,\"t_us\":%u,\"kind\":\"%s\"", r.seq, r.timeUs, kind);
+  switch (r.kind){
+    case TEL_STEP:  printf(",\"step\":%u,\"state\":%u,\"loop\":%u", r.a, r.b, r.d); break;
+    case TEL_NOTE:  printf(",\"track\":%u,\"note\":%u,\"velocity\":%u", r.a, r.b, r.c); break;
+    case TEL_TEMPO: printf(",\"source\":%u,\"locked\":%u,\"priority\":%u,\"bpm\":%.1f", r.a, r.b, r.c, r.d / 10.0); break;
+    case TEL_QUEUE: printf(",\"din_depth\":%u,\"usb_depth\":%u,\"drops\":%u,\"events\":%u", r.a, r.b, r.c, r.d); break;
+    case TEL_EDIT:  printf(",\"track\":%u,\"step\":%u,\"on\":%u", r.a, r.b, r.c); break;
+    default:        printf(",\"a\":%u,\"b\":%u,\"c\":%u,\"d\":%u", r.a, r.b, r.c, r.d); break;
+  }
+  printf("}\n");
+}
+
+// Streams until Ctrl-C or `seconds`; lost records are counted from sequence gaps
+static int telemetry(Link& link, bool json, int seconds){
+  uint8_t on = 1;
+  if (!link.expect(link.request(LINK_STREAM, &on, 1), LINK_ACK)) return 1;
+  signal(SIGINT, onSigint);
+  if (!json) printf("seq,time_us,kind,a,b,c,d\n");
+  uint32_t start = nowMs(), records = 0, lost = 0;
+  int32_t expected = -1;
+  while (!stopRequested && (seconds <= 0 || nowMs() - start < (uint32_t)seconds * 1000)){
+    uint8_t b;
+    if (!link.nextByte(b, 50)) { fflush(stdout); continue; }
+    LinkRx r = link.rx.feed(b, nowMs());
+    if (r == LINK_RX_PASS) { fputc(b, stderr); continue; }
+    if (r != LINK_RX_FRAME || link.rx.type != LINK_TELEMETRY) continue;
+    for (uint16_t o = 0; o + TELEMETRY_RECORD_BYTES <= link.rx.len; o += TELEMETRY_RECORD_BYTES){
+      TelemetryRecord rec;
+      telemetryUnpack(link.rx.payload + o, rec);
+      if (expected >= 0) lost += (uint16_t)(rec.seq - expected);
+      expected = (uint16_t)(rec.seq + 1);
+      records++;
+      printRecord(rec, json);
+    }
+  }
+  on = 0;
+  link.request(LINK_STREAM, &on, 1);
+  fprintf(stderr, "%u records, %u lost, %u bad frames\n", records, lost, link.rx.crcErrors);
+  return 0;
+}
+
+// --- EVENT TRACE ---
+// File: "SQTR", cycles per us (2), record count (4), then 8-byte records oldest first
+static const char TRACE_FILE_MAGIC[4] = { 'S', 'Q', 'T', 'R' };
+
+static int dumpTrace(Link& link, const char* path){
+  uint8_t req[4] = { LINK_OBJ_TRACE, 0, 0, 1 };
+  // frozen, the ring holds still while it is read out
+  if (!link.expect(link.request(LINK_PUT, req, sizeof(req)), LINK_ACK)) return 1;
+  static uint8_t records[TRACE_RING * TRACE_RECORD_BYTES];
+  uint32_t total = 0, got = 0;
+  uint16_t mhz = 0;
+  for (uint16_t chunk = 0; got < total || chunk == 0; chunk++){
+    uint8_t buf[LINK_MAX_PAYLOAD];
+    int n = link.get(LINK_OBJ_TRACE, chunk, buf);
+    if (n < TRACE_CHUNK_HEADER) return 1;
+    total = buf[0] | (buf[1] << 8);
+    mhz = buf[2] | (buf[3] << 8);
+    uint16_t count = (n - TRACE_CHUNK_HEADER) / TRACE_RECORD_BYTES;
+    if (count == 0 || got + count > TRACE_RING) break;
+    memcpy(records + got * TRACE_RECORD_BYTES, buf + TRACE_CHUNK_HEADER, count * TRACE_RECORD_BYTES);
+    got += count;
+  }
+  req[3] = 0; // recording resumes
+  link.expect(link.request(LINK_PUT, req, sizeof(req)), LINK_ACK);
+  FILE* f = fopen(path, "wb");
+  if (!f) { perror(path); return 1; }
+  uint8_t header[10] = { 'S', 'Q', 'T', 'R', (uint8_t)(mhz & 0xFF), (uint8_t)(mhz >> 8),
+                         (uint8_t)(got & 0xFF), (uint8_t)((got >> 8) & 0xFF), (uint8_t)((got >> 16) & 0xFF), (uint8_t)(got >> 24) };
+  fwrite(header, 1, sizeof(header), f);
+  fwrite(records, TRACE_RECORD_BYTES, got, f);
+  fclose(f);
+  printf("%u trace records (%u MHz) -> %s\n", got, mhz, path);
+  return 0;
+}
+
+struct TraceFile {
+  uint16_t mhz = 0;
+  uint32_t count = 0;
+  TraceRecord* records = nullptr;
+  double* us = nullptr;   // unwrapped timestamps relative to the first record
+
+  bool load(const char* path){
+    FILE* f = fopen(path, "rb");
+    if (!f) { perror(path); return false; }
+    uint8_t header[10];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) || memcmp(header, TRACE_FILE_MAGIC, 4)) { fprintf(stderr, "%s: not a trace file\n", path); fclose(f); return false; }
+    mhz = header[4] | (header[5] << 8);
+    count = header[6] | (header[7] << 8) | ((uint32_t)header[8] << 16) | ((uint32_t)header[9] << 24);
+    if (mhz == 0 || count > TRACE_RING) { fclose(f); return false; }
+    records = new TraceRecord[count];
+    us = new double[count];
+    uint64_t cycles = 0;
+    for (uint32_t i = 0; i < count; i++){
+      uint8_t raw[TRACE_RECORD_BYTES];
+      if (fread(raw, 1, sizeof(raw), f) != sizeof(raw)) { count = i; break; }
+      traceUnpack(raw, records[i]);
+      // the counter wraps every 2^32 cycles; the heartbeat keeps gaps shorter than that
+      if (i) cycles += (uint32_t)(records[i].cycles - records[i - 1].cycles);
+      us[i] = (double)cycles / mhz;
+    }
+    fclose(f);
+    return true;
+  }
+};
+
+// Expands a trace format: %N$<spec> takes argument N (a, b, b low byte, b high byte)
+static void formatTrace(const TraceRecord& r, char* out, size_t size){
+  const char* fmt = r.id < TR_NUM_IDS ? TRACE_INFO_TABLE[r.id].format : "id %1$u %2$u";
+  unsigned args[4] = { r.a, r.b, (unsigned)(r.b & 0xFF), (unsigned)(r.b >> 8) };
+  size_t o = 0;
+  while (*fmt && o + 1 < size){
+    if (fmt[0] == '%' && fmt[1] >= '1' && fmt[1] <= '4' && fmt[2] == '$'){
+      char spec[16] = "%";
+      size_t k = 1;
+      const char* p = fmt + 3;
+      while (*p && !strchr("uxXd", *p) && k < sizeof(spec) - 2) spec[k++] = *p++;
+      spec[k++] = *p ? *p++ : 'u';
+      spec[k] = 0;
+      o += snprintf(out + o, size - o, spec, args[fmt[1] - '1']);
+      if (o >= size) o = size - 1;
+      fmt = p;
+    } else {
+      out[o++] = *fmt++;
+    }
+  }
+  out[o] = 0;
+}
+
+static int decodeTrace(const char* path){
+  TraceFile t;
+  if (!t.load(path)) return 1;
+  for (uint32_t i = 0; i < t.count; i++){
+    char text[96];
+    formatTrace(t.records[i], text, sizeof(text));
+    printf("%12.3f us  %-11s %s\n", t.us[i], t.records[i].id < TR_NUM_IDS ? TRACE_INFO_TABLE[t.records[i].id].name : "?", text);
+  }
+  return 0;
+}
+
+// Chrome trace event format: ISR / render records become complete ("X") slices
+// that end at their timestamp, everything else an instant on its thread
+static int chromeTrace(const char* in, const char* outPath){
+  TraceFile t;
+  if (!t.load(in)) return 1;
+  FILE* f = fopen(outPath, "w");
+  if (!f) { perror(outPath); return 1; }
+  static const char* const threads[][2] = { { "1", "clock isr" }, { "2", "engine" }, { "3", "render / ui" },
+                                            { "4", "midi in" }, { "5", "midi out" }, { "6", "transport" } };
+  fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  for (auto& th : threads) fprintf(f, "{\"ph\":\"M\",\"pid\":1,\"tid\":%s,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}},\n", th[0], th[1]);
+  for (uint8_t tr = 0; tr < 16; tr++) fprintf(f, "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"track %u\"}},\n", 10 + tr, tr + 1);
+  for (uint32_t i = 0; i < t.count; i++){
+    const TraceRecord& r = t.records[i];
+    if (r.id == TR_NONE || r.id >= TR_NUM_IDS) continue;
+    const TraceInfo& info = TRACE_INFO_TABLE[r.id];
+    unsigned tid = info.thread == 10 ? 10 + r.a : info.thread;
+    char text[96];
+    formatTrace(r, text, sizeof(text));
+    bool slice = r.id == TR_CLOCK_ISR || r.id == TR_ENGINE_ISR || r.id == TR_RENDER;
+    if (slice){
+      double dur = r.b * 16.0 / t.mhz;
+      fprintf(f, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"msg\":\"%s\"}}",
+              tid, info.name, t.us[i] - dur, dur, text);
+    } else {
+      fprintf(f, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"args\":{\"msg\":\"%s\"}}",
+              tid, info.name, t.us[i], text);
+    }
+    fprintf(f, i + 1 < t.count ? ",\n" : "\n");
+  }
+  fprintf(f, "]}\n");
+  fclose(f);
+  printf("%u events -> %s\n", t.count, outPath);
+  return 0;
+}
+
+static int run(Link& link, int argc, char** argv){
+  const char* cmd = argv[0];
+  uint8_t buf[RECORD_MAX_BYTES];
+  if (!strcmp(cmd, "ping")){
+    if (!link.expect(link.request(LINK_PING, nullptr, 0), LINK_ACK) || link.rx.len < 8) return 1;
+    const uint8_t* p = link.rx.payload;
+    printf("protocol %u, save version %u, %u EEPROM slots, max payload %u, %u project records, SD %s\n",
+           p[0], p[1], p[2], p[3] | (p[4] << 8), p[5] | (p[6] << 8), p[7] ? "ready" : "missing");
+    return 0;
+  }
+  if (!strcmp(cmd, "bench")) return bench(link, argc > 1 ? atoi(argv[1]) : 1000);
+  if (!strcmp(cmd, "trace")) return argc > 1 ? dumpTrace(link, argv[1]) : usage();
+  if (!strcmp(cmd, "telemetry")){
+    bool json = argc > 1 && !strcmp(argv[1], "json");
+    return telemetry(link, json, argc > 2 ? atoi(argv[2]) : 0);
+  }
+  if (!strcmp(cmd, "get-bank") || !strcmp(cmd, "put-bank")){
+    if (argc < 3) return usage();
+    int bank = atoi(argv[1]);
+    if (bank < 1 || bank > PROJECT_RECORDS / BANK_PATTERNS) return usage();
+    bool up = !strcmp(cmd, "put-bank");
+    int moved = 0;
+    for (uint8_t i = 0; i < BANK_PATTERNS; i++){
+      char path[512];
+      snprintf(path, sizeof(path), "%s/%02u.bin", argv[2], i + 1);
+      uint16_t index = (bank - 1) * BANK_PATTERNS + i;
+      if (up){
+        int n = readFile(path, buf, sizeof(buf));
+        if (n < 0) continue; // no file: leave that pattern alone
+        if (!link.put(LINK_OBJ_PROJECT, index, buf, n)) return 1;
+      } else {
+        int n = link.get(LINK_OBJ_PROJECT, index, buf, true);
+        if (n < 0) return 1;
+        if (n == 0) continue;
+        if (!writeFile(path, buf, n)) return 1;
+      }
+      moved++;
+    }
+    printf("%d patterns %s\n", moved, up ? "uploaded" : "downloaded");
+    return 0;
+  }
+  if (strcmp(cmd, "get") && strcmp(cmd, "put")) return usage();
+  uint8_t obj;
+  if (argc < 3 || !parseObject(argv[1], &obj)) return usage();
+  bool indexed = obj == LINK_OBJ_SLOT || obj == LINK_OBJ_PROJECT;
+  if (indexed && argc < 4) return usage();
+  uint16_t index = indexed ? (uint16_t)(atoi(argv[2]) - 1) : 0;
+  const char* path = argv[indexed ? 3 : 2];
+  if (!strcmp(cmd, "get")){
+    int n = link.get(obj, index, buf);
+    if (n < 0 || !writeFile(path, buf, n)) return 1;
+    printf("%d bytes -> %s\n", n, path);
+    return 0;
+  }
+  int n = readFile(path, buf, sizeof(buf));
+  if (n < 0) { perror(path); return 1; }
+  if (obj != LINK_OBJ_SETTINGS && recordBytes(buf, n) != n) { fprintf(stderr, "%s: not a pattern record\n", path); return 1; }
+  if (!link.put(obj, index, buf, n)) return 1;
+  printf("%d bytes <- %s\n", n, path);
+  return 0;
+}
+
+int main(int argc, char** argv){
+  if (argc < 2) return usage();
+  static StandIn standIn; // large: keep it off the stack
+  if (!strcmp(argv[1], "decode")) return argc > 2 ? decodeTrace(argv[2]) : usage();
+  if (!strcmp(argv[1], "chrome")) return argc > 3 ? chromeTrace(argv[2], argv[3]) : usage();
+  if (!strcmp(argv[1], "serve")){
+    char name[128];
+    int m = openPty(name, sizeof(name));
+    if (m < 0) { perror("pty"); return 1; }
+    printf("device stand-in on %s\n", name);
+    fflush(stdout);
+    standIn.serve(m);
+    return 0;
+  }
+  if (argc < 3) return usage();
+
+  Link link;
+  pid_t child = -1;
+  if (!strcmp(argv[1], "pty")){
+    char name[128];
+    int m = openPty(name, sizeof(name));
+    if (m < 0) { perror("pty"); return 1; }
+    child = fork();
+    if (child == 0) { standIn.serve(m); _exit(0); }
+    close(m);
+    link.fd = open(name, O_RDWR | O_NOCTTY);
+  } else {
+    link.fd = open(argv[1], O_RDWR | O_NOCTTY);
+  }
+  if (link.fd < 0) { perror(argv[1]); return 1; }
+  if (!setRaw(link.fd)) { perror("termios"); return 1; }
+  tcflush(link.fd, TCIOFLUSH);
+
+  int rc = run(link, argc - 2, argv + 2);
+  close(link.fd);
+  if (child > 0) { kill(child, SIGTERM); waitpid(child, nullptr, 0); }
+  return rc;
+}
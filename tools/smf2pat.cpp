@@ -0,0 +1,475 @@
+// Converts a Standard MIDI File into sequencer patterns: save records in the
+// format of include/SaveFormat.h, ready for `seqlink put pattern|slot|project`.
+//
+//   g++ -O2 -Iinclude tools/smf2pat.cpp -o smf2pat
+//
+//   smf2pat [options] <file.mid> -o <pattern.bin>     one bar, one record
+//   smf2pat [options] <file.mid> --bank <dir>         up to 16 bars as <dir>/01.bin..16.bin
+//     -t N=C[:NOTE]  sequencer track N (1-4) takes MIDI channel C (1-16), or only
+//                    note NOTE on it (a drum voice). Default: the first four
+//                    channels that have notes, in order.
+//     --bar N        first bar to import (default 1)
+//     --bars N       bars for --bank (default: to the end of the file, at most 16)
+//     --grid N       steps per quarter note (default 4: 16ths); a bar is 16 steps
+//     --bpm N        pattern tempo (default: the file's first tempo)
+//     -q             summary only, no per-note report
+//
+// Each track is monophonic with one note per step. A note goes to the nearest
+// step; when a step gets notes of several pitches the loudest is kept. Repeats of
+// one note closer than 3/4 of a step are a ratchet on the step of the first one
+// (2, 3 or 6 hits, the firmware's ratchet rates). The note length picks the
+// nearest gate (1/16 to 1); a note still sounding when the track's next note
+// starts slides into it. The most common note, velocity and gate of each pattern
+// become the track / pattern defaults, so only the steps that differ store one.
+// Everything else (Euclid, scales, modulation, routing, arp, groove) is left at
+// the firmware defaults.
+//
+// Every imported note is reported with its quantisation error in ticks of the
+// file, percent of a step and milliseconds at the file's first tempo.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "SaveFormat.h"
+#include "Scales.h"
+#include "TrigCondition.h"
+#include "EuclidTables.h"
+#include "SmfReader.h"
+
+static_assert(SAVE_VERSION == 14, "smf2pat writes v14 records: add the new fields to encodePattern() below");
+
+static const uint8_t NOTE_LEN_TICKS[] = { 96, 48, 24, 12, 6 };  // noteLenTicks in SimpleSequencer.cpp
+static const uint8_t NUM_NOTE_LENS = sizeof(NOTE_LEN_TICKS);
+static const uint8_t DEFAULT_NOTE_LEN_IDX = 4;
+static const uint32_t DEFAULT_SEED = 0x23A5F00DUL;
+static const uint8_t MAX_BANK_BARS = 16;
+static const double RATCHET_GAP_STEPS = 0.75;   // repeats closer than this are one step's ratchet
+
+// Ratchet index by hits in the step: stepRatchet 3 = 2 hits, 4 = 3 hits, 5 = 6 hits
+static uint8_t ratchetFor(uint32_t hits, uint8_t& played){
+  if (hits <= 1) { played = 1; return 0; }
+  if (hits == 2) { played = 2; return 3; }
+  if (hits <= 4) { played = 3; return 4; }
+  played = 6;
+  return 5;
+}
+
+// The pattern model of SimpleSequencer, only what an import fills in
+struct Pattern {
+  uint16_t bpm = 120;
+  uint8_t noteLenIdx = DEFAULT_NOTE_LEN_IDX;
+  uint8_t channelPitch[NUM_CHANNELS];
+  uint8_t channelVelocity[NUM_CHANNELS];
+  bool steps[NUM_CHANNELS][NUM_STEPS] = {};
+  uint8_t pitch[NUM_CHANNELS][NUM_STEPS];
+  uint8_t noteLen[NUM_CHANNELS][NUM_STEPS];
+  uint8_t stepRatchet[NUM_CHANNELS][NUM_STEPS] = {};
+  uint8_t stepVelocity[NUM_CHANNELS][NUM_STEPS];
+  bool stepSlide[NUM_CHANNELS][NUM_STEPS] = {};
+  Pattern(){
+    for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+      channelPitch[c] = 36;
+      channelVelocity[c] = 96;
+      memset(pitch[c], 255, NUM_STEPS);
+      memset(noteLen[c], 255, NUM_STEPS);
+      memset(stepVelocity[c], 255, NUM_STEPS);
+    }
+  }
+};
+
+// Same field order as SimpleSequencer::encodePattern(); fields an import doesn't
+// set get the values of a blank pattern (Pattern::init() in include/Pattern.h)
+static void encodePattern(const Pattern& p, BitWriter& w){
+  w.put(p.bpm, SAVE_BITS_BPM);
+  w.put(p.noteLenIdx, SAVE_BITS_LEN_IDX);
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    w.put(p.channelPitch[c], SAVE_BITS_NOTE);
+    w.putBool(false);                       // muted
+    w.putBool(false);                       // euclidEnabled
+    w.put(4, SAVE_BITS_PULSES);
+    w.put(0, SAVE_BITS_OFFSET);
+    w.put(SCALE_OFF, SAVE_BITS_SCALE);
+    w.put(p.channelVelocity[c], SAVE_BITS_VEL);
+    w.put(EUCLID_BRESENHAM, 1);
+    w.put(0, SAVE_BITS_ROOT);
+    w.put(SCALE_MASK_CHROMATIC, SAVE_BITS_SCALE_MASK);
+    w.putBool(false);                       // quantizeEnabled
+  }
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    for (uint8_t s = 0; s < NUM_STEPS; s++){
+      w.putBool(p.steps[c][s]);
+      w.putOpt(p.pitch[c][s], SAVE_BITS_NOTE);
+      w.putOpt(p.noteLen[c][s], SAVE_BITS_LEN_IDX);
+      w.put(0, SAVE_BITS_FILL);
+      w.put(p.stepRatchet[c][s], SAVE_BITS_RATCHET);
+      w.putOpt(p.stepVelocity[c][s], SAVE_BITS_VEL);
+      w.putBool(p.stepSlide[c][s]);
+    }
+  }
+  // v7: seed, 100 % / ALWAYS on every step
+  w.put(DEFAULT_SEED, SAVE_BITS_SEED);
+  for (uint16_t i = 0; i < NUM_CHANNELS * NUM_STEPS; i++) { w.putBool(false); w.putBool(false); }
+  // v8: no p-locks
+  w.put(0, SAVE_BITS_PLOCK_COUNT);
+  // v9: modulation off
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    w.put(LFO_SINE, SAVE_BITS_LFO_SHAPE);
+    w.put(4, SAVE_BITS_LFO_RATE);
+    w.put(0, 7);
+    w.put(MOD_DEST_OFF, SAVE_BITS_MOD_DEST);
+    w.put(0, SAVE_BITS_ENV_TIME);
+    w.put(4, SAVE_BITS_ENV_TIME);
+    w.put(0, 7);
+    w.put(MOD_DEST_OFF, SAVE_BITS_MOD_DEST);
+  }
+  // v10: no track delay
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++) w.put(TRACK_DELAY_MAX_MS, SAVE_BITS_TRACK_DELAY);
+  // v11: track n on DIN channel n, clock out on DIN and USB
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    w.put(MIDI_PORT_DIN, SAVE_BITS_PORT);
+    w.put(c, SAVE_BITS_MIDI_CH);
+  }
+  for (uint8_t i = 0; i < MIDI_MAX_PORTS; i++) w.putBool(i < MIDI_NUM_DEFAULT_PORTS);
+  // v12: default clock priority
+  w.put(0, SAVE_BITS_CLOCK_PRIO);
+  // v13: arp off
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    w.put(ARP_OFF, SAVE_BITS_ARP_MODE);
+    w.put(ARP_SRC_CHORD, 1);
+    w.put(0, SAVE_BITS_ARP_OCTAVES);
+    w.put(3, SAVE_BITS_ARP_RATE);
+    w.put(ARP_CHORD_MAJ, SAVE_BITS_ARP_CHORD);
+  }
+  // v14: no groove
+  for (uint8_t c = 0; c < NUM_CHANNELS; c++){
+    w.put(0, SAVE_BITS_GROOVE);
+    w.put(100, SAVE_BITS_GROOVE_AMOUNT);
+  }
+}
+
+// SaveSlotHeader + payload, as SimpleSequencer::buildSlotRecord() writes it
+static uint16_t buildSlotRecord(const Pattern& p, uint8_t* rec){
+  uint8_t* payload = rec + sizeof(SaveSlotHeader);
+  BitWriter w(payload, SAVE_PAYLOAD_MAX_BYTES);
+  encodePattern(p, w);
+  if (!w.ok()) return 0;
+  SaveSlotHeader h;
+  h.version = SAVE_VERSION;
+  h.reserved = 0;
+  h.payloadBytes = w.bytes();
+  h.crc = crc16(payload, h.payloadBytes);
+  memcpy(rec, &h, sizeof(h));
+  return sizeof(SaveSlotHeader) + h.payloadBytes;
+}
+
+struct Source {
+  int ch = -1;     // 0-15, -1 = track unused
+  int note = -1;   // -1 = every note on the channel
+};
+
+// One imported note, on the global step grid (step 0 = first step of bar 1)
+struct Placed {
+  uint32_t note;     // index into SmfFile::notes
+  uint32_t step;
+  double errTicks;   // from its grid position (a ratchet hit's own slot)
+  uint8_t hit;       // 0 = the step's note, 1.. = ratchet repeats
+  bool kept;
+};
+
+struct Step {
+  uint32_t first = 0, last = 0;    // range in the track's placed list, notes of other steps may be between
+  uint8_t pitch = 0, vel = 0, lenIdx = 0, ratchet = 0, hits = 0, played = 0;
+  bool used = false, slide = false;
+  uint32_t onTick = 0, offTick = 0;
+};
+
+struct Stats {
+  uint32_t placed = 0, ratchetHits = 0, droppedPoly = 0, droppedRatchet = 0, outside = 0;
+  double sumAbs = 0, maxAbs = 0;
+  uint32_t maxNote = 0;
+};
+
+static uint8_t nearestLenIdx(double ticks24){
+  uint8_t best = DEFAULT_NOTE_LEN_IDX;
+  double bestD = 1e9;
+  for (uint8_t i = 0; i < NUM_NOTE_LENS; i++){
+    double d = fabs(log(ticks24 > 1 ? ticks24 : 1) - log((double)NOTE_LEN_TICKS[i]));
+    if (d < bestD) { bestD = d; best = i; }
+  }
+  return best;
+}
+
+template <size_t N> static uint8_t mostCommon(const uint32_t (&hist)[N], uint8_t fallback){
+  uint8_t best = fallback;
+  uint32_t n = 0;
+  for (size_t i = 0; i < N; i++) if (hist[i] > n) { n = hist[i]; best = (uint8_t)i; }
+  return best;
+}
+
+static int usage(){
+  fprintf(stderr,
+    "usage: smf2pat [-t N=C[:NOTE]]... [--bar N] [--bars N] [--grid N] [--bpm N] [-q]\n"
+    "               <file.mid> -o <pattern.bin> | --bank <dir>\n");
+  return 2;
+}
+
+static double nowSeconds(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv){
+  Source src[NUM_CHANNELS];
+  bool mapped = false;
+  int bar0 = 1, bars = 0, grid = 4, bpm = 0;
+  bool quiet = false;
+  const char* in = nullptr;
+  const char* out = nullptr;
+  const char* bank = nullptr;
+
+  for (int i = 1; i < argc; i++){
+    std::string a = argv[i];
+    bool hasVal = i + 1 < argc;
+    if (a == "-t" && hasVal){
+      int t = 0, c = 0, n = -1;
+      const char* v = argv[++i];
+      if (sscanf(v, "%d=%d:%d", &t, &c, &n) < 2 || t < 1 || t > NUM_CHANNELS || c < 1 || c > 16 || n > 127){
+        fprintf(stderr, "smf2pat: bad track map '%s'\n", v);
+        return usage();
+      }
+      src[t - 1].ch = c - 1;
+      src[t - 1].note = n;
+      mapped = true;
+    }
+    else if (a == "--bar" && hasVal) bar0 = atoi(argv[++i]);
+    else if (a == "--bars" && hasVal) bars = atoi(argv[++i]);
+    else if (a == "--grid" && hasVal) grid = atoi(argv[++i]);
+    else if (a == "--bpm" && hasVal) bpm = atoi(argv[++i]);
+    else if (a == "-o" && hasVal) out = argv[++i];
+    else if (a == "--bank" && hasVal) bank = argv[++i];
+    else if (a == "-q") quiet = true;
+    else if (a[0] != '-' && !in) in = argv[i];
+    else return usage();
+  }
+  if (!in || !out == !bank || bar0 < 1 || grid < 1 || bars < 0 || bars > MAX_BANK_BARS || (bpm && (bpm < 20 || bpm > 300))) return usage();
+
+  double t0 = nowSeconds();
+  SmfFile f;
+  std::string err;
+  if (!smfRead(in, f, err)) { fprintf(stderr, "smf2pat: %s: %s\n", in, err.c_str()); return 1; }
+  double t1 = nowSeconds();
+
+  if (!mapped){
+    // the first channels that have notes, in channel order
+    bool used[16] = {};
+    for (const SmfNote& n : f.notes) used[n.ch] = true;
+    uint8_t t = 0;
+    for (uint8_t c = 0; c < 16 && t < NUM_CHANNELS; c++) if (used[c]) src[t++].ch = c;
+  }
+
+  double stepTicks = (double)f.division / grid;
+  double tickMs = f.tempoUs / 1000.0 / f.division;
+  uint32_t firstStep = (uint32_t)(bar0 - 1) * NUM_STEPS;
+  std::vector<Placed> placed[NUM_CHANNELS];
+  uint32_t lastStep = 0;
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    if (src[t].ch < 0) continue;
+    std::vector<Placed>& pl = placed[t];
+    // 1. steps: a note starts a run on its nearest step; repeats of its pitch
+    // closer than RATCHET_GAP_STEPS join the run and are counted off from its start
+    int lastPitch = -1;
+    double lastTick = 0, runTick = 0;
+    uint32_t runStep = 0;
+    for (uint32_t i = 0; i < f.notes.size(); i++){
+      const SmfNote& n = f.notes[i];
+      if (n.ch != src[t].ch || (src[t].note >= 0 && n.note != src[t].note)) continue;
+      double gap = n.tick - lastTick;
+      Placed p{ i, 0, 0, 0, true };
+      if (n.note == lastPitch && gap < RATCHET_GAP_STEPS * stepTicks && gap > 0){
+        // half a repeat early still counts as the next step
+        p.step = runStep + (uint32_t)floor((n.tick - runTick + gap / 2) / stepTicks);
+      } else {
+        p.step = (uint32_t)floor(n.tick / stepTicks + 0.5);
+        runStep = p.step;
+        runTick = n.tick;
+      }
+      lastPitch = n.note;
+      lastTick = n.tick;
+      if (p.step > lastStep) lastStep = p.step;
+      pl.push_back(p);
+    }
+  }
+  if (!bars){
+    bars = bank ? (int)((lastStep + 1 + NUM_STEPS - 1) / NUM_STEPS) - (bar0 - 1) : 1;
+    if (bars > MAX_BANK_BARS) bars = MAX_BANK_BARS;
+    if (bars < 1) bars = 1;
+  }
+  if (out) bars = 1;
+  uint32_t endStep = firstStep + (uint32_t)bars * NUM_STEPS;
+  long fileBpm = lround(60000000.0 / f.tempoUs);
+  uint16_t patternBpm = bpm ? bpm : (uint16_t)(fileBpm < 20 ? 20 : fileBpm > 300 ? 300 : fileBpm);
+
+  std::vector<Pattern> patterns(bars);
+  for (Pattern& p : patterns) p.bpm = patternBpm;
+  std::vector<Step> trackSteps[NUM_CHANNELS];
+  Stats stats[NUM_CHANNELS];
+
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    if (src[t].ch < 0) continue;
+    std::vector<Placed>& pl = placed[t];
+    // 2. one note per step: the loudest pitch that starts in it
+    std::vector<Step>& g = trackSteps[t];
+    g.assign(endStep - firstStep, Step());
+    for (uint32_t i = 0; i < pl.size(); i++){
+      if (pl[i].step < firstStep || pl[i].step >= endStep) { pl[i].kept = false; stats[t].outside++; continue; }
+      Step& st = g[pl[i].step - firstStep];
+      const SmfNote& n = f.notes[pl[i].note];
+      if (!st.used) st.first = i;
+      st.last = i;
+      if (!st.used || (n.vel > st.vel && n.note != st.pitch)) { st.used = true; st.pitch = n.note; st.vel = n.vel; }
+    }
+    for (uint32_t s = 0; s < g.size(); s++){
+      Step& st = g[s];
+      if (!st.used) continue;
+      uint32_t hits = 0;
+      for (uint32_t i = st.first; i <= st.last; i++){
+        Placed& p = pl[i];
+        if (p.step != firstStep + s) continue;
+        const SmfNote& n = f.notes[p.note];
+        if (n.note != st.pitch) { p.kept = false; stats[t].droppedPoly++; continue; }
+        if (!hits) { st.onTick = n.tick; st.offTick = n.tick + n.length; st.vel = n.vel; }
+        p.hit = (uint8_t)(hits < 255 ? hits : 255);
+        hits++;
+      }
+      st.hits = (uint8_t)(hits < 255 ? hits : 255);
+      st.ratchet = ratchetFor(hits, st.played);
+      st.lenIdx = nearestLenIdx((st.offTick - st.onTick) * 24.0 / f.division);
+      // quantisation error: each kept hit against its slot in the step
+      for (uint32_t i = st.first; i <= st.last; i++){
+        Placed& p = pl[i];
+        if (p.step != firstStep + s || !p.kept) continue;
+        if (p.hit >= st.played) { p.kept = false; stats[t].droppedRatchet++; continue; }
+        double slot = (firstStep + s) * stepTicks + p.hit * stepTicks / st.played;
+        p.errTicks = f.notes[p.note].tick - slot;
+        double pct = fabs(p.errTicks) * 100 / stepTicks;
+        stats[t].placed++;
+        if (p.hit) stats[t].ratchetHits++;
+        stats[t].sumAbs += pct;
+        if (pct > stats[t].maxAbs) { stats[t].maxAbs = pct; stats[t].maxNote = i; }
+      }
+    }
+    // 3. slides: the note is still sounding when the track's next note starts
+    for (uint32_t s = 0, next = 0; s < g.size(); s++){
+      if (!g[s].used || g[s].ratchet) continue;
+      for (next = s + 1; next < g.size() && !g[next].used; next++) {}
+      if (next < g.size() && g[s].offTick > g[next].onTick) g[s].slide = true;
+    }
+
+    // 4. into the patterns
+    for (int b = 0; b < bars; b++){
+      Pattern& pat = patterns[b];
+      uint32_t pitchHist[128] = {}, velHist[128] = {};
+      for (uint8_t s = 0; s < NUM_STEPS; s++){
+        const Step& st = g[b * NUM_STEPS + s];
+        if (st.used) { pitchHist[st.pitch]++; velHist[st.vel & 0x7F]++; }
+      }
+      pat.channelPitch[t] = mostCommon(pitchHist, 36);
+      pat.channelVelocity[t] = mostCommon(velHist, 96);
+      for (uint8_t s = 0; s < NUM_STEPS; s++){
+        const Step& st = g[b * NUM_STEPS + s];
+        if (!st.used) continue;
+        pat.steps[t][s] = true;
+        pat.pitch[t][s] = st.pitch == pat.channelPitch[t] ? 255 : st.pitch;
+        pat.stepVelocity[t][s] = st.vel == pat.channelVelocity[t] ? 255 : (st.vel & 0x7F);
+        pat.stepRatchet[t][s] = st.ratchet;
+        pat.noteLen[t][s] = st.lenIdx;
+        pat.stepSlide[t][s] = st.slide;
+      }
+    }
+  }
+  // the pattern's default gate: the most common one, the rest stay per step
+  for (int b = 0; b < bars; b++){
+    Pattern& pat = patterns[b];
+    uint32_t lenHist[NUM_NOTE_LENS] = {};
+    for (uint8_t t = 0; t < NUM_CHANNELS; t++)
+      for (uint8_t s = 0; s < NUM_STEPS; s++) if (pat.steps[t][s] && !pat.stepRatchet[t][s]) lenHist[pat.noteLen[t][s]]++;
+    pat.noteLenIdx = mostCommon(lenHist, DEFAULT_NOTE_LEN_IDX);
+    for (uint8_t t = 0; t < NUM_CHANNELS; t++)
+      for (uint8_t s = 0; s < NUM_STEPS; s++)
+        if (pat.noteLen[t][s] == pat.noteLenIdx || pat.stepRatchet[t][s]) pat.noteLen[t][s] = 255;
+  }
+  double t2 = nowSeconds();
+
+  // --- report ---
+  printf("%s: %u tracks, %u notes, %u ticks/quarter, %.1f BPM; %d x %d steps from bar %d at %d per quarter\n",
+         in, f.tracks, (unsigned)f.notes.size(), f.division, 60000000.0 / f.tempoUs, bars, NUM_STEPS, bar0, grid);
+  if (!quiet){
+    printf("\n bar step trk  note vel     tick   err ticks  err %%step   err ms\n");
+    for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+      for (const Placed& p : placed[t]){
+        if (p.step < firstStep || p.step >= endStep) continue;
+        const SmfNote& n = f.notes[p.note];
+        const Step& st = trackSteps[t][p.step - firstStep];
+        uint32_t local = p.step - firstStep;
+        printf("%4u %4u %3u  %4u %3u %8u", local / NUM_STEPS + bar0, local % NUM_STEPS + 1, t + 1, n.note, n.vel, n.tick);
+        if (!p.kept){
+          printf("   dropped: %s\n", n.note != st.pitch ? "another note on this step" : "more hits than the ratchet plays");
+          continue;
+        }
+        printf("  %+10.1f  %+9.1f  %+7.1f", p.errTicks, p.errTicks * 100 / stepTicks, p.errTicks * tickMs);
+        if (st.played > 1) printf("  ratchet %u/%u", p.hit + 1, st.played);
+        if (!p.hit && st.slide) printf("  slide");
+        printf("\n");
+      }
+    }
+    for (int b = 0; b < bars; b++){
+      const Pattern& pat = patterns[b];
+      printf("\nbar %d, %u BPM, gate %u ticks\n", bar0 + b, pat.bpm, NOTE_LEN_TICKS[pat.noteLenIdx]);
+      for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+        if (src[t].ch < 0) continue;
+        char row[NUM_STEPS + 1];
+        for (uint8_t s = 0; s < NUM_STEPS; s++)
+          row[s] = !pat.steps[t][s] ? '.' : pat.stepRatchet[t][s] ? 'r' : pat.stepSlide[t][s] ? 's' : 'x';
+        row[NUM_STEPS] = 0;
+        printf("  T%u %s  note %3u vel %3u\n", t + 1, row, pat.channelPitch[t], pat.channelVelocity[t]);
+      }
+    }
+  }
+  printf("\n");
+  for (uint8_t t = 0; t < NUM_CHANNELS; t++){
+    if (src[t].ch < 0) { printf("T%u unused\n", t + 1); continue; }
+    const Stats& s = stats[t];
+    printf("T%u ch %2d", t + 1, src[t].ch + 1);
+    if (src[t].note >= 0) printf(" note %3d", src[t].note); else printf("         ");
+    printf(": %5u notes, %4u ratchet hits, mean |err| %4.1f%% max %4.1f%% of a step",
+           s.placed, s.ratchetHits, s.placed ? s.sumAbs / s.placed : 0.0, s.maxAbs);
+    if (s.placed) printf(" (tick %u)", f.notes[placed[t][s.maxNote].note].tick);
+    if (s.droppedPoly || s.droppedRatchet) printf(", dropped %u chord + %u ratchet", s.droppedPoly, s.droppedRatchet);
+    if (s.outside) printf(", %u outside the bars", s.outside);
+    printf("\n");
+  }
+  printf("read %.1f ms, converted %.1f ms\n", (t1 - t0) * 1000, (t2 - t1) * 1000);
+
+  // --- records ---
+  uint8_t rec[SAVE_SLOT_BYTES];
+  for (int b = 0; b < bars; b++){
+    uint16_t n = buildSlotRecord(patterns[b], rec);
+    if (!n) { fprintf(stderr, "smf2pat: bar %d does not fit a save slot\n", bar0 + b); return 1; }
+    char path[512];
+    if (bank) {
+      mkdir(bank, 0777);
+      snprintf(path, sizeof(path), "%s/%02d.bin", bank, b + 1);
+    } else snprintf(path, sizeof(path), "%s", out);
+    FILE* fp = fopen(path, "wb");
+    if (!fp || fwrite(rec, 1, n, fp) != n) { fprintf(stderr, "smf2pat: can't write %s\n", path); if (fp) fclose(fp); return 1; }
+    fclose(fp);
+    printf("%s: %u bytes\n", path, n);
+  }
+  return 0;
+}
@@ -0,0 +1,199 @@
+// Host simulation of the soft MIDI thru (see MidiRouter::thru()).
+//
+//   g++ -O2 -Iinclude tools/thrubench.cpp src/MidiRouter.cpp -o thrubench
+//
+//   thrubench [seconds]
+//
+// A keyboard plays into the DIN input at 31250 baud. As on the Teensy, the engine
+// pass reads and forwards input every 1 ms, while the clock ISR sends MIDI clock
+// and the step events on each tick. Everything goes out through the same
+// MidiRouter DIN queue into a modelled UART (40-byte TX buffer, 320 us per byte),
+// once with the router allowed to fill the whole buffer and once with it kept to
+// UART_MIDI_WINDOW bytes ahead of the wire, as UartMidiPort does.
+// The sequencer runs at 300 BPM in four load cases:
+//   idle     clock only
+//   notes    4 tracks, a note-off / note-on per track per step
+//   ratchet  4 tracks ratcheting every other tick plus a CC lock per step
+//   full     4 tracks ratcheting on every tick plus a CC lock per step: with the
+//            keyboard, more than the DIN line carries, so sequencer output queues up
+// For every thru message the report gives two times, both measured from when its
+// last byte arrived at the input:
+//   handoff  until it is written to the UART buffer (poll wait plus queueing)
+//   out      until its last byte is on the output wire. A message can't beat 960 us,
+//            the time to retransmit three bytes, so out - 960 is the added delay.
+// It also gives the worst delay of a clock byte behind its tick (beyond its own
+// 320 us), and checks that no message on the wire is split by another.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "MidiRouter.h"
+
+static const uint32_t BYTE_US = 320;           // 10 bits at 31250 baud
+static const uint16_t UART_TX_BUFFER = 40;     // Teensy 4 Serial8 default
+static const uint32_t ENGINE_US = 1000;
+static const uint32_t BPM = 300;
+static const uint32_t TICK_US = 60000000UL / BPM / 24;
+static const uint8_t THRU_CHANNEL = 15;        // keyboard on channel 16, sequencer on 1-4
+
+static uint32_t simNow = 0;
+static uint32_t clockFn() { return simNow; }
+
+// UART with a TX buffer: each byte takes BYTE_US on the wire after the one before
+class UartSim : public MidiPortBackend {
+  public:
+    explicit UartSim(uint8_t w) : window(w) {}
+    int availableForWrite() override {
+      uint32_t pending = busyUntil > simNow ? (busyUntil - simNow + BYTE_US - 1) / BYTE_US : 0;
+      return pending >= window ? 0 : window - pending;
+    }
+    void write(const uint8_t* b, uint8_t len) override {
+      for (uint8_t i = 0; i < len; i++){
+        busyUntil = std::max(busyUntil, simNow) + BYTE_US;
+        wire.push_back(b[i]);
+        if (b[i] == 0xF8 && busyUntil - tickAt > clockLate) clockLate = busyUntil - tickAt;
+      }
+      if (len == 3 && (b[0] & 0x0F) == THRU_CHANNEL){
+        handoffAt[b[1]] = simNow;
+        doneAt[b[1]] = busyUntil;
+        outDone[b[1]] = true;
+      }
+    }
+    uint8_t window;
+    uint32_t busyUntil = 0;
+    std::vector<uint8_t> wire;
+    uint32_t tickAt = 0, clockLate = 0;
+    uint32_t handoffAt[128], doneAt[128];
+    bool outDone[128] = {};
+};
+
+struct Result {
+  std::vector<uint32_t> handoff, out;
+  uint32_t dropped = 0;
+  bool split = false;
+  uint32_t utilPct = 0;
+  uint32_t clockJitter = 0;   // worst clock byte wire time - tick time
+};
+
+static uint32_t pct(std::vector<uint32_t>& v, uint32_t p){
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[std::min<size_t>(v.size() - 1, v.size() * p / 100)];
+}
+
+static Result run(uint8_t load, uint8_t window, uint32_t seconds){
+  simNow = 0;
+  MidiRouter router;
+  UartSim uart(window);
+  router.begin(clockFn);
+  router.addPort(MIDI_PORT_DIN, &uart, true);
+  router.thruConfig.mode = MIDI_THRU_ON;
+  MidiInParser parser;
+
+  // keyboard: a message every 5-60 ms, note numbers used as message ids
+  struct InByte { uint32_t at; uint8_t b; };
+  std::vector<InByte> input;
+  uint32_t inDone[128];
+  uint32_t lineFree = 0;
+  uint8_t id = 0;
+  srand(7);
+  for (uint32_t t = 5000; t < seconds * 1000000UL; t += 5000 + rand() % 55000){
+    uint32_t start = std::max(t, lineFree);
+    uint8_t msg[3] = { (uint8_t)(((id & 1) ? 0x80 : 0x90) | THRU_CHANNEL), (uint8_t)(id & 0x7F), 100 };
+    for (uint8_t i = 0; i < 3; i++) input.push_back(InByte{ start + (i + 1) * BYTE_US, msg[i] });
+    lineFree = start + 3 * BYTE_US;
+    id++;
+  }
+
+  Result r;
+  size_t next = 0;
+  uint32_t nextEngine = 300;   // engine pass phase is unrelated to the input
+  uint32_t nextTick = 0;
+  uint32_t tick = 0;
+  uint32_t end = seconds * 1000000UL;
+  for (simNow = 0; simNow < end; simNow += 10){
+    if (simNow >= nextTick){
+      // clock ISR: clock byte, then the events due on this tick
+      uart.tickAt = simNow;
+      router.sendRealtime(0xF8);
+      bool stepStart = tick % 6 == 0;
+      for (uint8_t tr = 0; tr < 4; tr++){
+        if (load == 1 && stepStart){
+          router.send(tr, 0x90, 60 + tr, 0);
+          router.send(tr, 0x90, 60 + tr, 100);
+        } else if (load >= 2 && (load == 3 || tick % 2 == 0)){
+          if (stepStart) router.send(tr, 0xB0, 74, tick & 0x7F);
+          router.send(tr, 0x90, 60 + tr, 0);
+          router.send(tr, 0x90, 60 + tr, 100);
+        }
+      }
+      tick++;
+      nextTick += TICK_US;
+    }
+    if (simNow >= nextEngine){
+      // engine pass: read what has arrived, forward it, then move queues on
+      while (next < input.size() && input[next].at <= simNow){
+        uint8_t msg[3];
+        uint8_t len = parser.feed(input[next].b, msg);
+        if (len == 3){
+          inDone[msg[1]] = input[next].at;
+          uart.outDone[msg[1]] = false;
+          if (!router.thru(MIDI_PORT_DIN, msg, len, 0)) r.dropped++;
+        }
+        next++;
+      }
+      router.service();
+      nextEngine += ENGINE_US;
+    }
+    // collect finished thru messages
+    for (uint8_t n = 0; n < 128; n++){
+      if (uart.outDone[n]){
+        r.handoff.push_back(uart.handoffAt[n] - inDone[n]);
+        r.out.push_back(uart.doneAt[n] - inDone[n]);
+        uart.outDone[n] = false;
+      }
+    }
+  }
+  r.utilPct = (uint32_t)((uint64_t)uart.wire.size() * BYTE_US * 100 / end);
+  r.clockJitter = uart.clockLate - BYTE_US;
+
+  // message boundaries: walk the output stream, realtime bytes may sit anywhere
+  uint8_t need = 0;
+  for (uint8_t b : uart.wire){
+    if (b >= 0xF8) continue;
+    if (b & 0x80) { if (need) r.split = true; need = midiDataBytes(b); }
+    else if (need) need--;
+    else r.split = true;
+  }
+  return r;
+}
+
+int main(int argc, char** argv){
+  uint32_t seconds = argc > 1 ? (uint32_t)atol(argv[1]) : 60;
+  if (seconds < 1) seconds = 1;
+  const char* names[] = { "idle", "notes", "ratchet", "full" };
+  bool ok = true;
+  printf("%u s per case at %u BPM, 1 ms engine poll, us from input message complete\n", (unsigned)seconds, (unsigned)BPM);
+  printf("load     buffer  line  msgs   handoff avg/p99/max     out avg/p99/max        added max  clock max  drops\n");
+  const uint8_t windows[] = { UART_TX_BUFFER, UART_MIDI_WINDOW };
+  for (uint8_t load = 0; load < 4; load++)
+  for (uint8_t window : windows){
+    Result r = run(load, window, seconds);
+    uint64_t hs = 0, os = 0;
+    for (uint32_t v : r.handoff) hs += v;
+    for (uint32_t v : r.out) os += v;
+    size_t n = r.out.size();
+    uint32_t hmax = n ? *std::max_element(r.handoff.begin(), r.handoff.end()) : 0;
+    uint32_t omax = n ? *std::max_element(r.out.begin(), r.out.end()) : 0;
+    printf("%-7s  %4u B  %3u%%  %5u  %5u/%5u/%5u     %5u/%5u/%5u     %6u     %6u  %5u%s\n", names[load], (unsigned)window,
+           (unsigned)r.utilPct, (unsigned)n,
+           (unsigned)(n ? hs / n : 0), (unsigned)pct(r.handoff, 99), (unsigned)hmax,
+           (unsigned)(n ? os / n : 0), (unsigned)pct(r.out, 99), (unsigned)omax,
+           (unsigned)(omax > 3 * BYTE_US ? omax - 3 * BYTE_US : 0), (unsigned)r.clockJitter,
+           (unsigned)r.dropped, r.split ? "  SPLIT" : "");
+    ok &= !r.split && r.dropped == 0;
+  }
+  printf(ok ? "messages whole, nothing dropped\n" : "FAILED\n");
+  return ok ? 0 : 1;
+}